@@ -51,7 +51,9 @@ enum class context_option : int
     msg_t_size = ZLINK_MSG_T_SIZE,
     thread_affinity_cpu_add = ZLINK_THREAD_AFFINITY_CPU_ADD,
     thread_affinity_cpu_remove = ZLINK_THREAD_AFFINITY_CPU_REMOVE,
-    thread_name_prefix = ZLINK_THREAD_NAME_PREFIX
+    thread_name_prefix = ZLINK_THREAD_NAME_PREFIX,
+    msg_allocator = ZLINK_MSG_ALLOCATOR,
+    io_uring = ZLINK_IO_URING
 };
 
 enum class socket_option : int
@@ -120,7 +122,9 @@ enum class socket_option : int
     xpub_manual_last_value = ZLINK_XPUB_MANUAL_LAST_VALUE,
     only_first_subscribe = ZLINK_ONLY_FIRST_SUBSCRIBE,
     topics_count = ZLINK_TOPICS_COUNT,
-    zmp_metadata = ZLINK_ZMP_METADATA
+    zmp_metadata = ZLINK_ZMP_METADATA,
+    in_batch_max = ZLINK_IN_BATCH_MAX,
+    xpub_last_value_cache = ZLINK_XPUB_LAST_VALUE_CACHE
 };
 
 enum class send_flag : int
@@ -203,7 +207,9 @@ enum class service_type : int
 enum class gateway_lb_strategy : int
 {
     round_robin = ZLINK_GATEWAY_LB_ROUND_ROBIN,
-    weighted = ZLINK_GATEWAY_LB_WEIGHTED
+    weighted = ZLINK_GATEWAY_LB_WEIGHTED,
+    least_outstanding = ZLINK_GATEWAY_LB_LEAST_OUTSTANDING,
+    p2c_ewma = ZLINK_GATEWAY_LB_P2C_EWMA
 };
 
 enum class registry_socket_role : int
@@ -916,6 +922,14 @@ class gateway_t
         : _gw (zlink_gateway_new (ctx_.handle (), disc_.handle (), routing_id_))
     {
     }
+    gateway_t (context_t &ctx_,
+               discovery_t &disc_,
+               const char *routing_id_,
+               int shards_)
+        : _gw (zlink_gateway_new_sharded (ctx_.handle (), disc_.handle (),
+                                          routing_id_, shards_))
+    {
+    }
     ~gateway_t () { destroy (); }
 
     gateway_t (gateway_t &&other) noexcept : _gw (other._gw) { other._gw = NULL; }
@@ -945,6 +959,24 @@ class gateway_t
         return zlink_gateway_send (_gw, service_, tmp.data (), tmp.size (), 0);
     }
 
+    zlink_gateway_service_t *service (const char *service_)
+    {
+        return zlink_gateway_service (_gw, service_);
+    }
+
+    int send (zlink_gateway_service_t *service_, std::vector<message_t> &parts_)
+    {
+        if (parts_.empty ())
+            return -1;
+        std::vector<zlink_msg_t> tmp;
+        tmp.resize (parts_.size ());
+        for (size_t i = 0; i < parts_.size (); ++i) {
+            if (parts_[i].move_to (&tmp[i]) != 0)
+                return -1;
+        }
+        return zlink_gateway_send_service (_gw, service_, tmp.data (), tmp.size (), 0);
+    }
+
     int recv (msgv_t &out_, std::string &service_, recv_flag flags_ = recv_flag::none)
     {
         zlink_msg_t *parts = NULL;
@@ -59,6 +59,8 @@ int main()
     // gateway_lb_strategy values
     assert(static_cast<int>(zlink::gateway_lb_strategy::round_robin) == ZLINK_GATEWAY_LB_ROUND_ROBIN);
     assert(static_cast<int>(zlink::gateway_lb_strategy::weighted) == ZLINK_GATEWAY_LB_WEIGHTED);
+    assert(static_cast<int>(zlink::gateway_lb_strategy::least_outstanding) == ZLINK_GATEWAY_LB_LEAST_OUTSTANDING);
+    assert(static_cast<int>(zlink::gateway_lb_strategy::p2c_ewma) == ZLINK_GATEWAY_LB_P2C_EWMA);
 
     // socket role values
     assert(static_cast<int>(zlink::registry_socket_role::pub) == ZLINK_REGISTRY_SOCKET_PUB);
@@ -158,7 +158,9 @@ public enum PollEvents
 public enum GatewayLoadBalancing
 {
     RoundRobin = 0,
-    Weighted = 1
+    Weighted = 1,
+    LeastOutstanding = 2,
+    P2cEwma = 3
 }
 
 public enum RegistrySocketRole
@@ -89,6 +89,8 @@ public class EnumTests
     {
         Assert.Equal(0, (int)GatewayLoadBalancing.RoundRobin);
         Assert.Equal(1, (int)GatewayLoadBalancing.Weighted);
+        Assert.Equal(2, (int)GatewayLoadBalancing.LeastOutstanding);
+        Assert.Equal(3, (int)GatewayLoadBalancing.P2cEwma);
     }
 
     [Fact]
@@ -3,7 +3,7 @@
 package io.ulalax.zlink;
 
 public enum GatewayLbStrategy {
-    ROUND_ROBIN(0), WEIGHTED(1);
+    ROUND_ROBIN(0), WEIGHTED(1), LEAST_OUTSTANDING(2), P2C_EWMA(3);
 
     private final int value;
     GatewayLbStrategy(int v) { this.value = v; }
@@ -78,6 +78,8 @@ public class EnumTest {
     public void gatewayLbStrategyValues() {
         assertEquals(0, GatewayLbStrategy.ROUND_ROBIN.getValue());
         assertEquals(1, GatewayLbStrategy.WEIGHTED.getValue());
+        assertEquals(2, GatewayLbStrategy.LEAST_OUTSTANDING.getValue());
+        assertEquals(3, GatewayLbStrategy.P2C_EWMA.getValue());
     }
 
     @Test
@@ -93,6 +93,7 @@ export declare const SERVICE_TYPE_SPOT: 2;
 
 export declare const GatewayLbStrategy: {
   readonly ROUND_ROBIN: 0; readonly WEIGHTED: 1;
+  readonly LEAST_OUTSTANDING: 2; readonly P2C_EWMA: 3;
 };
 
 export declare const RegistrySocketRole: {
@@ -125,7 +125,7 @@ const ServiceType = Object.freeze({
 });
 
 const GatewayLbStrategy = Object.freeze({
-  ROUND_ROBIN: 0, WEIGHTED: 1
+  ROUND_ROBIN: 0, WEIGHTED: 1, LEAST_OUTSTANDING: 2, P2C_EWMA: 3
 });
 
 const RegistrySocketRole = Object.freeze({
@@ -67,6 +67,8 @@ test('ServiceType values match C defines', () => {
 test('GatewayLbStrategy values match C defines', () => {
   assert.strictEqual(zlink.GatewayLbStrategy.ROUND_ROBIN, 0);
   assert.strictEqual(zlink.GatewayLbStrategy.WEIGHTED, 1);
+  assert.strictEqual(zlink.GatewayLbStrategy.LEAST_OUTSTANDING, 2);
+  assert.strictEqual(zlink.GatewayLbStrategy.P2C_EWMA, 3);
 });
 
 test('socket role values match C defines', () => {
@@ -149,6 +149,8 @@ class ServiceType(IntEnum):
 class GatewayLbStrategy(IntEnum):
     ROUND_ROBIN = 0
     WEIGHTED = 1
+    LEAST_OUTSTANDING = 2
+    P2C_EWMA = 3
 
 
 class RegistrySocketRole(IntEnum):
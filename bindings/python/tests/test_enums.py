@@ -62,6 +62,8 @@ class EnumValueTests(unittest.TestCase):
     def test_gateway_lb_strategy_values(self):
         self.assertEqual(int(zlink.GatewayLbStrategy.ROUND_ROBIN), 0)
         self.assertEqual(int(zlink.GatewayLbStrategy.WEIGHTED), 1)
+        self.assertEqual(int(zlink.GatewayLbStrategy.LEAST_OUTSTANDING), 2)
+        self.assertEqual(int(zlink.GatewayLbStrategy.P2C_EWMA), 3)
 
     def test_registry_socket_role_values(self):
         self.assertEqual(int(zlink.RegistrySocketRole.PUB), 1)
@@ -177,12 +177,32 @@ ZLINK_EXPORT void zlink_version (int *major_, int *minor_, int *patch_);
 #define ZLINK_THREAD_AFFINITY_CPU_ADD 7
 #define ZLINK_THREAD_AFFINITY_CPU_REMOVE 8
 #define ZLINK_THREAD_NAME_PREFIX 9
+#define ZLINK_MSG_ALLOCATOR 10
+#define ZLINK_IO_URING 11
+#define ZLINK_IO_THREAD_BALANCE 12
 
 #define ZLINK_IO_THREADS_DFLT 2
 #define ZLINK_MAX_SOCKETS_DFLT 1023
 #define ZLINK_THREAD_PRIORITY_DFLT -1
 #define ZLINK_THREAD_SCHED_POLICY_DFLT -1
 
+/*  ZLINK_MSG_ALLOCATOR values. The allocator is process-wide: it applies to
+    message content, long groups and decoder buffers of every context.      */
+#define ZLINK_MSG_ALLOCATOR_MALLOC 0
+#define ZLINK_MSG_ALLOCATOR_POOL 1
+
+/*  ZLINK_IO_URING drives TCP and IPC connections through io_uring instead of
+    epoll where the kernel supports it (Linux 6.0 or later). It must be set
+    before the first socket is created; unsupported kernels silently keep
+    the default path.                                                       */
+
+/*  ZLINK_IO_THREAD_BALANCE: 1 (default) enables migration of busy
+    connections between I/O threads; 0 disables it. With migration on, an
+    I/O thread whose traffic stays well above that of the least loaded I/O
+    thread moves TCP and IPC connections over to it. Each connection moves
+    at most once, away from the thread it was placed on. Must be set before
+    the first socket is created.                                            */
+
 /**
  * @brief Create a new zlink context.
  *
@@ -231,6 +251,34 @@ ZLINK_EXPORT int zlink_ctx_set (void *context_, int option_, int optval_);
  */
 ZLINK_EXPORT int zlink_ctx_get (void *context_, int option_);
 
+typedef struct {
+    uint64_t bytes_in;      /**< Bytes read from connections. */
+    uint64_t bytes_out;     /**< Bytes written to connections. */
+    uint64_t msgs_in;       /**< Messages received. */
+    uint64_t msgs_out;      /**< Messages sent. */
+    uint64_t load;          /**< Traffic load in bytes per second. */
+    uint32_t sessions;      /**< Connections handled by the thread. */
+    uint32_t migrations;    /**< Connections moved to other threads. */
+} zlink_io_thread_stats_t;
+
+/**
+ * @brief Get the traffic figures of the context's I/O threads.
+ *
+ * Counters are totals since the threads were started, updated every
+ * 100 ms. The load is the traffic per second of the last few 100 ms
+ * intervals, with every message counted as 64 bytes on top of its
+ * size; new connections go to the thread with the lowest load.
+ *
+ * @param context_    Context handle.
+ * @param[out] stats_ Array of *count_ entries, or NULL to query the count.
+ * @param[in,out] count_ Array size on input, entries filled on output.
+ *                       0 until the first socket has been created.
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+ZLINK_EXPORT int zlink_ctx_io_thread_stats (void *context_,
+                                            zlink_io_thread_stats_t *stats_,
+                                            size_t *count_);
+
 /******************************************************************************/
 /*  0MQ message definition.                                                   */
 /******************************************************************************/
@@ -378,6 +426,8 @@ ZLINK_EXPORT const char *zlink_msg_gets (const zlink_msg_t *msg_,
 #define ZLINK_ONLY_FIRST_SUBSCRIBE 108
 #define ZLINK_TOPICS_COUNT 116
 #define ZLINK_ZMP_METADATA 117
+#define ZLINK_IN_BATCH_MAX 118
+#define ZLINK_XPUB_LAST_VALUE_CACHE 119
 
 //  TLS protocol options
 #define ZLINK_TLS_CERT 95
@@ -501,6 +551,42 @@ zlink_send_const (void *s_, const void *buf_, size_t len_, int flags_);
  */
 ZLINK_EXPORT int zlink_recv (void *s_, void *buf_, size_t len_, int flags_);
 
+/**
+ * @brief Send a batch of messages on a socket.
+ *
+ * Equivalent to calling zlink_msg_send() for each element, except that
+ * pending commands are processed once and each pipe is flushed (and its
+ * peer woken up) once per batch instead of once per message.
+ * Without ZLINK_SNDMORE every element is sent as a single-part message;
+ * with ZLINK_SNDMORE the elements form the parts of one multipart message.
+ * On success, ownership of each sent message is transferred.
+ *
+ * @param msgs_   Array of initialized messages.
+ * @param count_  Number of elements in @p msgs_.
+ * @param flags_  0, ZLINK_DONTWAIT, ZLINK_SNDMORE, or a combination.
+ * @return Number of messages sent, which may be less than @p count_ with
+ *         ZLINK_DONTWAIT or when the send timeout expires, or -1 if none
+ *         could be sent (errno is set).
+ */
+ZLINK_EXPORT int
+zlink_sendmmsg (void *s_, zlink_msg_t *msgs_, size_t count_, int flags_);
+
+/**
+ * @brief Receive a batch of messages from a socket.
+ *
+ * Waits for the first message like zlink_msg_recv(), then takes whatever
+ * else is already queued, up to @p count_ messages, without blocking.
+ * Each element holds one frame; use zlink_msg_more() to find multipart
+ * boundaries.
+ *
+ * @param msgs_   Array of initialized messages.
+ * @param count_  Number of elements in @p msgs_.
+ * @param flags_  0 or ZLINK_DONTWAIT.
+ * @return Number of messages received, or -1 on failure (errno is set).
+ */
+ZLINK_EXPORT int
+zlink_recvmmsg (void *s_, zlink_msg_t *msgs_, size_t count_, int flags_);
+
 /**
  * @brief Start a socket monitor via an inproc address (legacy).
  * @param addr_    Monitor inproc endpoint.
@@ -714,6 +800,24 @@ ZLINK_EXPORT void *zlink_gateway_new (void *ctx,
                                       void *discovery,
                                       const char *routing_id);
 
+/**
+ * @brief Create a Gateway whose sends are spread over several shards.
+ *
+ * Each shard owns its own ROUTER socket, provider connections and lock.
+ * A sending thread always uses the same shard, so threads on different
+ * shards never contend. Replies are received from all shards.
+ *
+ * @param ctx         Context handle.
+ * @param discovery   Discovery handle (ZLINK_SERVICE_TYPE_GATEWAY type).
+ * @param routing_id  Unique identifier for this Gateway.
+ * @param shards      Number of shards (1 behaves like zlink_gateway_new).
+ * @return Gateway handle, or NULL on failure.
+ */
+ZLINK_EXPORT void *zlink_gateway_new_sharded (void *ctx,
+                                              void *discovery,
+                                              const char *routing_id,
+                                              int shards);
+
 /**
  * @brief Send a message to a service (load-balanced).
  * @param service_name  Target service name.
@@ -740,6 +844,31 @@ ZLINK_EXPORT int zlink_gateway_recv (void *gateway,
                                      int flags,
                                      char *service_name_out);
 
+/** @brief Opaque handle of a service resolved by a Gateway. */
+typedef struct zlink_gateway_service_t zlink_gateway_service_t;
+
+/**
+ * @brief Resolve a service once for repeated sends.
+ *
+ * The handle is owned by the Gateway. It stays valid across discovery
+ * refreshes until the Gateway is destroyed, and resolving the same name
+ * again returns the same handle.
+ * @return Service handle, or NULL on failure.
+ */
+ZLINK_EXPORT zlink_gateway_service_t *
+zlink_gateway_service (void *gateway, const char *service_name);
+
+/**
+ * @brief Send a message to a resolved service (load-balanced).
+ *
+ * Same as zlink_gateway_send() without the lookup of the service name.
+ */
+ZLINK_EXPORT int zlink_gateway_send_service (void *gateway,
+                                             zlink_gateway_service_t *service,
+                                             zlink_msg_t *parts,
+                                             size_t part_count,
+                                             int flags);
+
 /** @brief Send a message directly to a specific Receiver by routing_id. */
 ZLINK_EXPORT int zlink_gateway_send_rid (void *gateway,
                                          const char *service_name,
@@ -748,10 +877,70 @@ ZLINK_EXPORT int zlink_gateway_send_rid (void *gateway,
                                          size_t part_count,
                                      int flags);
 
+/**
+ * @brief Send a message to the Receiver that owns a key.
+ *
+ * Requests with the same key go to the same Receiver for as long as it
+ * is available, whatever the load-balancing strategy. Keys are spread
+ * over the Receivers by rendezvous hashing of their routing ids, so a
+ * Receiver joining or leaving moves only the keys it takes or held.
+ * @param key      Application shard key (e.g. a player id).
+ * @param key_len  Key size in bytes, greater than 0.
+ */
+ZLINK_EXPORT int zlink_gateway_send_keyed (void *gateway,
+                                           const char *service_name,
+                                           const void *key,
+                                           size_t key_len,
+                                           zlink_msg_t *parts,
+                                           size_t part_count,
+                                           int flags);
+
+/**
+ * @brief Completion of an asynchronous request.
+ *
+ * @param status      0 when the reply arrived, ETIMEDOUT when the deadline
+ *                    passed first, ECANCELED when the Gateway was destroyed.
+ * @param parts       Reply parts after the correlation frame, or NULL.
+ *                    Closed by the Gateway when the callback returns; use
+ *                    zlink_msg_move() to keep a part.
+ * @param part_count  Number of parts.
+ * @param userdata    Value passed to zlink_gateway_request_async().
+ */
+typedef void (zlink_gateway_completion_fn) (int status,
+                                            zlink_msg_t *parts,
+                                            size_t part_count,
+                                            void *userdata);
+
+/**
+ * @brief Send a request and get its reply through a callback.
+ *
+ * The request is sent like zlink_gateway_send() with an 8-byte
+ * correlation frame in front of the parts. The Receiver must send that
+ * frame back as the first frame of its reply. Any number of requests may
+ * be in flight. Callbacks run on a completion thread of the Gateway and
+ * must not destroy it; they may send further requests.
+ *
+ * @param timeout_ms  Deadline in milliseconds from now. 0 uses the
+ *                    ZLINK_REQUEST_TIMEOUT of the Gateway (5000 unless
+ *                    set), -1 waits without a deadline.
+ * @return 0 once the request is sent, -1 on failure (the callback is
+ *         not called and the parts stay with the caller).
+ */
+ZLINK_EXPORT int
+zlink_gateway_request_async (void *gateway,
+                             const char *service_name,
+                             zlink_msg_t *parts,
+                             size_t part_count,
+                             int timeout_ms,
+                             zlink_gateway_completion_fn *callback,
+                             void *userdata);
+
 /** @name Load-balancing strategies */
 /** @{ */
 #define ZLINK_GATEWAY_LB_ROUND_ROBIN 0  /**< Round-robin (default) */
-#define ZLINK_GATEWAY_LB_WEIGHTED 1     /**< Weighted */
+#define ZLINK_GATEWAY_LB_WEIGHTED 1     /**< Smooth weighted round-robin */
+#define ZLINK_GATEWAY_LB_LEAST_OUTSTANDING 2 /**< Fewest pending requests */
+#define ZLINK_GATEWAY_LB_P2C_EWMA 3     /**< Power of two choices on latency */
 /** @} */
 
 /** @brief Set the load-balancing strategy for a service. */
@@ -759,6 +948,21 @@ ZLINK_EXPORT int zlink_gateway_set_lb_strategy (void *gateway,
                                                 const char *service_name,
                                                 int strategy);
 
+/**
+ * @brief Set the hedging and retry policy for a service.
+ *
+ * hedge_budget is the share of zlink_gateway_request_async calls, in
+ * percent (0..100), that may be sent again to a second provider once they
+ * have waited longer than the service's observed p95 latency; the first
+ * reply wins. max_retries bounds how many other providers a request is
+ * sent to when its provider is unreachable or disconnects. Both default
+ * to 0 (off).
+ */
+ZLINK_EXPORT int zlink_gateway_set_request_policy (void *gateway,
+                                                   const char *service_name,
+                                                   int hedge_budget,
+                                                   int max_retries);
+
 /** @brief Set a Gateway socket option. */
 ZLINK_EXPORT int zlink_gateway_setsockopt (void *gateway,
                                            int option,
@@ -0,0 +1,139 @@
+#include "bench_common.hpp"
+#include <zlink.h>
+#include <thread>
+#include <vector>
+#include <cstring>
+
+// Compares ZLINK_MSG_ALLOCATOR_MALLOC against ZLINK_MSG_ALLOCATOR_POOL.
+//
+// alloc: each thread creates and closes LMSGs of the given size locally.
+// xthread: one thread allocates, another closes (the content is returned
+//          to the pool from a different thread, as with I/O thread decoding).
+// PAIR: end-to-end throughput over each transport.
+
+static const char *allocator_name(int allocator) {
+    return allocator == ZLINK_MSG_ALLOCATOR_POOL ? "pool" : "malloc";
+}
+
+static void run_alloc_local(int allocator, size_t msg_size, int threads,
+                            int msg_count) {
+    stopwatch_t sw;
+    std::vector<std::thread> workers;
+    sw.start();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            zlink_msg_t msgs[16];
+            for (int i = 0; i < msg_count; i += 16) {
+                for (int j = 0; j < 16; ++j)
+                    zlink_msg_init_size(&msgs[j], msg_size);
+                for (int j = 0; j < 16; ++j)
+                    zlink_msg_close(&msgs[j]);
+            }
+        });
+    }
+    for (auto &w : workers)
+        w.join();
+    double elapsed = sw.elapsed_ms();
+    double throughput = (double)msg_count * threads / (elapsed / 1000.0);
+    double latency = (elapsed * 1000.0) / ((double)msg_count * threads);
+    print_result(allocator_name(allocator),
+                 "ALLOC_" + std::to_string(threads) + "T", "local", msg_size,
+                 throughput, latency);
+}
+
+static void run_alloc_xthread(int allocator, size_t msg_size, int msg_count) {
+    void *ctx = zlink_ctx_new();
+    void *s_bind = zlink_socket(ctx, ZLINK_PAIR);
+    void *s_conn = zlink_socket(ctx, ZLINK_PAIR);
+    int hwm = msg_count * 2;
+    zlink_setsockopt(s_bind, ZLINK_RCVHWM, &hwm, sizeof(hwm));
+    zlink_setsockopt(s_conn, ZLINK_SNDHWM, &hwm, sizeof(hwm));
+    zlink_bind(s_bind, "inproc://bench_alloc");
+    zlink_connect(s_conn, "inproc://bench_alloc");
+
+    stopwatch_t sw;
+    std::thread receiver([&]() {
+        zlink_msg_t msg;
+        zlink_msg_init(&msg);
+        for (int i = 0; i < msg_count; ++i)
+            zlink_msg_recv(&msg, s_bind, 0);
+        zlink_msg_close(&msg);
+    });
+
+    sw.start();
+    for (int i = 0; i < msg_count; ++i) {
+        zlink_msg_t msg;
+        zlink_msg_init_size(&msg, msg_size);
+        zlink_msg_send(&msg, s_conn, 0);
+    }
+    receiver.join();
+    double elapsed = sw.elapsed_ms();
+    double throughput = (double)msg_count / (elapsed / 1000.0);
+    double latency = (elapsed * 1000.0) / msg_count;
+    print_result(allocator_name(allocator), "ALLOC_XTHREAD", "inproc",
+                 msg_size, throughput, latency);
+
+    zlink_close(s_bind);
+    zlink_close(s_conn);
+    zlink_ctx_term(ctx);
+}
+
+static void run_pair(int allocator, const std::string &transport,
+                     size_t msg_size, int msg_count) {
+    void *ctx = zlink_ctx_new();
+    zlink_ctx_set(ctx, ZLINK_MSG_ALLOCATOR, allocator);
+    void *s_bind = zlink_socket(ctx, ZLINK_PAIR);
+    void *s_conn = zlink_socket(ctx, ZLINK_PAIR);
+    int hwm = msg_count * 2;
+    zlink_setsockopt(s_bind, ZLINK_RCVHWM, &hwm, sizeof(hwm));
+    zlink_setsockopt(s_conn, ZLINK_SNDHWM, &hwm, sizeof(hwm));
+
+    std::string endpoint = make_endpoint(transport, "bench_alloc_pair");
+    zlink_bind(s_bind, endpoint.c_str());
+    zlink_connect(s_conn, endpoint.c_str());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::vector<char> buffer(msg_size, 'a');
+    std::vector<char> recv_buf(msg_size);
+    stopwatch_t sw;
+    std::thread receiver([&]() {
+        for (int i = 0; i < msg_count; ++i)
+            zlink_recv(s_bind, recv_buf.data(), msg_size, 0);
+    });
+
+    sw.start();
+    for (int i = 0; i < msg_count; ++i)
+        zlink_send(s_conn, buffer.data(), msg_size, 0);
+    receiver.join();
+    double elapsed = sw.elapsed_ms();
+    double throughput = (double)msg_count / (elapsed / 1000.0);
+    double latency = (elapsed * 1000.0) / msg_count;
+    print_result(allocator_name(allocator), "PAIR", transport, msg_size,
+                 throughput, latency);
+
+    zlink_close(s_bind);
+    zlink_close(s_conn);
+    zlink_ctx_term(ctx);
+}
+
+int main() {
+    const std::vector<size_t> sizes = {64, 256, 1024};
+    const int allocators[] = {ZLINK_MSG_ALLOCATOR_MALLOC,
+                              ZLINK_MSG_ALLOCATOR_POOL};
+
+    for (int allocator : allocators) {
+        // The allocator is process-wide; a throwaway context selects it.
+        void *ctx = zlink_ctx_new();
+        zlink_ctx_set(ctx, ZLINK_MSG_ALLOCATOR, allocator);
+        zlink_ctx_term(ctx);
+
+        for (size_t sz : sizes) {
+            run_alloc_local(allocator, sz, 1, 1000000);
+            run_alloc_local(allocator, sz, 4, 1000000);
+            run_alloc_xthread(allocator, sz, 200000);
+            for (const auto &tr : TRANSPORTS)
+                run_pair(allocator, tr, sz, 200000);
+        }
+    }
+    return 0;
+}
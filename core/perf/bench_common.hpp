@@ -11,11 +11,15 @@
 // --- Configuration ---
 const std::vector<size_t> MSG_SIZES = {64, 256, 1024, 65536, 131072, 262144};
 #if defined(ZLINK_HAVE_ASIO_WS)
-const std::vector<std::string> TRANSPORTS = {"tcp", "ws", "inproc", "ipc"};
+const std::vector<std::string> TRANSPORTS = {"tcp", "ws", "inproc", "ipc",
+                                             "shm"};
 #else
-const std::vector<std::string> TRANSPORTS = {"tcp", "inproc", "ipc"};
+const std::vector<std::string> TRANSPORTS = {"tcp", "inproc", "ipc", "shm"};
 #endif
 
+// Messages per zlink_sendmmsg / zlink_recvmmsg call in the batched runs.
+const size_t BATCH_SIZE = 64;
+
 // --- Stopwatch ---
 class stopwatch_t {
 public:
@@ -52,6 +56,8 @@ inline std::string make_endpoint(const std::string& transport, const std::string
         return "inproc://" + id;
     } else if (transport == "ipc") {
         return "ipc:///tmp/bench_" + id + ".ipc";
+    } else if (transport == "shm") {
+        return "shm:///tmp/bench_" + id + ".shm";
     } else if (transport == "ws") {
         static int ws_port = 6555;
         return "ws://127.0.0.1:" + std::to_string(ws_port++);
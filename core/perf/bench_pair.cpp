@@ -3,6 +3,7 @@
 #include <thread>
 #include <vector>
 #include <cstring>
+#include <algorithm>
 
 #ifndef ZLINK_TCP_NODELAY
 #define ZLINK_TCP_NODELAY 26
@@ -64,6 +65,70 @@ void run_pair(const std::string& transport, size_t msg_size, int msg_count) {
     zlink_ctx_term(ctx);
 }
 
+// Same as run_pair, but moves BATCH_SIZE messages per call through
+// zlink_sendmmsg / zlink_recvmmsg.
+void run_pair_batch(const std::string& transport, size_t msg_size, int msg_count) {
+    void *ctx = zlink_ctx_new();
+    void *s_bind = zlink_socket(ctx, ZLINK_PAIR);
+    void *s_conn = zlink_socket(ctx, ZLINK_PAIR);
+
+    int nodelay = 1;
+    zlink_setsockopt(s_bind, ZLINK_TCP_NODELAY, &nodelay, sizeof(nodelay));
+    zlink_setsockopt(s_conn, ZLINK_TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    int hwm = msg_count * 2;
+    zlink_setsockopt(s_bind, ZLINK_SNDHWM, &hwm, sizeof(hwm));
+    zlink_setsockopt(s_conn, ZLINK_RCVHWM, &hwm, sizeof(hwm));
+
+    std::string endpoint = make_endpoint(transport, "zlink_pair_batch");
+    zlink_bind(s_bind, endpoint.c_str());
+    zlink_connect(s_conn, endpoint.c_str());
+
+    std::vector<char> buffer(msg_size, 'a');
+    stopwatch_t sw;
+
+    // Warmup
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::thread receiver([&]() {
+        zlink_msg_t msgs[BATCH_SIZE];
+        for (size_t j = 0; j < BATCH_SIZE; ++j)
+            zlink_msg_init(&msgs[j]);
+        int received = 0;
+        while (received < msg_count) {
+            int rc = zlink_recvmmsg(s_bind, msgs, BATCH_SIZE, 0);
+            if (rc > 0)
+                received += rc;
+        }
+        for (size_t j = 0; j < BATCH_SIZE; ++j)
+            zlink_msg_close(&msgs[j]);
+    });
+
+    sw.start();
+    zlink_msg_t msgs[BATCH_SIZE];
+    int sent = 0;
+    while (sent < msg_count) {
+        size_t n = std::min(BATCH_SIZE, (size_t)(msg_count - sent));
+        for (size_t j = 0; j < n; ++j) {
+            zlink_msg_init_size(&msgs[j], msg_size);
+            memcpy(zlink_msg_data(&msgs[j]), buffer.data(), msg_size);
+        }
+        int rc = zlink_sendmmsg(s_conn, msgs, n, 0);
+        for (size_t j = 0; j < n; ++j)
+            zlink_msg_close(&msgs[j]);
+        if (rc > 0)
+            sent += rc;
+    }
+    receiver.join();
+    double throughput = (double)msg_count / (sw.elapsed_ms() / 1000.0);
+
+    print_result("libzlink", "PAIR_BATCH", transport, msg_size, throughput, 0);
+
+    zlink_close(s_bind);
+    zlink_close(s_conn);
+    zlink_ctx_term(ctx);
+}
+
 int main() {
     auto get_count = [](size_t size) {
         if (size <= 1024) return 100000;
@@ -75,6 +140,8 @@ int main() {
         for (size_t sz : MSG_SIZES) {
             run_pair(tr, sz, get_count(sz));
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            run_pair_batch(tr, sz, get_count(sz));
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
     }
     return 0;
@@ -3,6 +3,7 @@
 #include <thread>
 #include <vector>
 #include <cstring>
+#include <algorithm>
 
 #ifndef ZLINK_TCP_NODELAY
 #define ZLINK_TCP_NODELAY 26
@@ -79,6 +80,70 @@ void run_router(const std::string& transport, size_t msg_size, int msg_count) {
     zlink_ctx_term(ctx);
 }
 
+// DEALER -> ROUTER throughput with BATCH_SIZE messages per zlink_sendmmsg
+// call; the ROUTER drains [routing id, body] frames with zlink_recvmmsg.
+void run_dealer_router_batch(const std::string& transport, size_t msg_size, int msg_count) {
+    void *ctx = zlink_ctx_new();
+    void *server = zlink_socket(ctx, ZLINK_ROUTER);
+    void *client = zlink_socket(ctx, ZLINK_DEALER);
+
+    int nodelay = 1;
+    zlink_setsockopt(server, ZLINK_TCP_NODELAY, &nodelay, sizeof(nodelay));
+    zlink_setsockopt(client, ZLINK_TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    int hwm = msg_count * 2;
+    zlink_setsockopt(server, ZLINK_RCVHWM, &hwm, sizeof(hwm));
+    zlink_setsockopt(client, ZLINK_SNDHWM, &hwm, sizeof(hwm));
+
+    std::string endpoint = make_endpoint(transport, "zlink_router_batch");
+    zlink_bind(server, endpoint.c_str());
+    zlink_connect(client, endpoint.c_str());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::vector<char> payload(msg_size, 'x');
+    stopwatch_t sw;
+
+    std::thread receiver([&]() {
+        const size_t frames = 2 * BATCH_SIZE;
+        std::vector<zlink_msg_t> msgs(frames);
+        for (size_t j = 0; j < frames; ++j)
+            zlink_msg_init(&msgs[j]);
+        int received = 0;
+        while (received < msg_count * 2) {
+            int rc = zlink_recvmmsg(server, msgs.data(), frames, 0);
+            if (rc > 0)
+                received += rc;
+        }
+        for (size_t j = 0; j < frames; ++j)
+            zlink_msg_close(&msgs[j]);
+    });
+
+    sw.start();
+    zlink_msg_t msgs[BATCH_SIZE];
+    int sent = 0;
+    while (sent < msg_count) {
+        size_t n = std::min(BATCH_SIZE, (size_t)(msg_count - sent));
+        for (size_t j = 0; j < n; ++j) {
+            zlink_msg_init_size(&msgs[j], msg_size);
+            memcpy(zlink_msg_data(&msgs[j]), payload.data(), msg_size);
+        }
+        int rc = zlink_sendmmsg(client, msgs, n, 0);
+        for (size_t j = 0; j < n; ++j)
+            zlink_msg_close(&msgs[j]);
+        if (rc > 0)
+            sent += rc;
+    }
+    receiver.join();
+    double throughput = (double)msg_count / (sw.elapsed_ms() / 1000.0);
+
+    print_result("libzlink", "DEALER_ROUTER_BATCH", transport, msg_size, throughput, 0);
+
+    zlink_close(server);
+    zlink_close(client);
+    zlink_ctx_term(ctx);
+}
+
 int main() {
     auto get_count = [](size_t size) {
         if (size <= 1024) return 100000;
@@ -90,6 +155,8 @@ int main() {
         for (size_t sz : MSG_SIZES) {
             run_router(tr, sz, get_count(sz));
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            run_dealer_router_batch(tr, sz, get_count(sz));
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
     }
     return 0;
@@ -0,0 +1,278 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include <zlink.h>
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+//  Keyed routing of one gateway over inproc providers. Every key is sent
+//  once per phase with zlink_gateway_send_keyed and the provider that gets
+//  it is recorded, which gives the spread of the keys over the providers
+//  and, between phases, the share of keys that moved:
+//
+//  - start:  8 providers.
+//  - leave:  one provider is destroyed; only its keys should move (1/8).
+//  - join:   a new provider comes up; it should take about 1/8 of the keys
+//            and nothing else should move.
+//
+//  For scale, the share a plain hash-modulo-provider-count mapping would
+//  move on the same change is printed alongside. The send rate of keyed
+//  sends is compared with zlink_gateway_send (round robin).
+
+const char *service_name = "bench-keyed";
+const std::size_t keys = 100000;
+const int initial_providers = 8;
+
+struct provider_t
+{
+    void *receiver;
+    void *router;
+};
+
+static provider_t start_provider (void *ctx_, int id_)
+{
+    provider_t provider;
+    char endpoint[64];
+    std::snprintf (endpoint, sizeof endpoint, "inproc://keyed-prov-%d", id_);
+    char rid[32];
+    std::snprintf (rid, sizeof rid, "KEYED-%d", id_);
+    provider.receiver = zlink_receiver_new (ctx_, NULL);
+    zlink_receiver_bind (provider.receiver, endpoint);
+    provider.router = zlink_receiver_router (provider.receiver);
+    zlink_setsockopt (provider.router, ZLINK_ROUTING_ID, rid, strlen (rid));
+    zlink_receiver_connect_registry (provider.receiver,
+                                     "inproc://keyed-reg-router");
+    zlink_receiver_register (provider.receiver, service_name, endpoint, 1);
+    return provider;
+}
+
+static void wait_connections (void *gateway_, int count_)
+{
+    while (zlink_gateway_connection_count (gateway_, service_name) != count_)
+        std::this_thread::sleep_for (std::chrono::milliseconds (5));
+}
+
+//  Reads requests off every provider until each key has been seen once,
+//  recording for each key the provider it reached.
+static void drain_run (std::vector<provider_t> providers_,
+                       std::vector<int> *owner_)
+{
+    std::vector<zlink_pollitem_t> items (providers_.size ());
+    std::size_t seen = 0;
+    while (seen < keys) {
+        for (std::size_t i = 0; i < items.size (); ++i) {
+            items[i].socket = providers_[i].router;
+            items[i].fd = 0;
+            items[i].events = ZLINK_POLLIN;
+            items[i].revents = 0;
+        }
+        if (zlink_poll (&items[0], static_cast<int> (items.size ()), 5000)
+            <= 0) {
+            std::fprintf (stderr, "lost %zu requests\n", keys - seen);
+            return;
+        }
+        for (std::size_t i = 0; i < items.size (); ++i) {
+            if (!(items[i].revents & ZLINK_POLLIN))
+                continue;
+            while (true) {
+                zlink_msg_t rid;
+                zlink_msg_init (&rid);
+                if (zlink_msg_recv (&rid, providers_[i].router,
+                                    ZLINK_DONTWAIT)
+                    < 0) {
+                    zlink_msg_close (&rid);
+                    break;
+                }
+                zlink_msg_t body;
+                zlink_msg_init (&body);
+                zlink_msg_recv (&body, providers_[i].router, 0);
+                if (zlink_msg_size (&body) == sizeof (uint32_t)) {
+                    uint32_t key;
+                    memcpy (&key, zlink_msg_data (&body), sizeof key);
+                    (*owner_)[key] = static_cast<int> (i);
+                    ++seen;
+                }
+                zlink_msg_close (&body);
+                zlink_msg_close (&rid);
+            }
+        }
+    }
+}
+
+//  Sends every key once and returns the send rate; owner_ gets the index
+//  of the provider each key reached.
+static double run_phase (void *gateway_,
+                         const std::vector<provider_t> &providers_,
+                         bool keyed_,
+                         std::vector<int> *owner_)
+{
+    owner_->assign (keys, -1);
+    std::thread drain (drain_run, providers_, owner_);
+    const auto start = std::chrono::steady_clock::now ();
+    for (uint32_t key = 0; key < keys; ++key) {
+        zlink_msg_t part;
+        zlink_msg_init_size (&part, sizeof key);
+        memcpy (zlink_msg_data (&part), &key, sizeof key);
+        while ((keyed_ ? zlink_gateway_send_keyed (gateway_, service_name,
+                                                   &key, sizeof key, &part, 1,
+                                                   0)
+                       : zlink_gateway_send (gateway_, service_name, &part, 1,
+                                             0))
+               != 0) {
+            if (errno != EAGAIN && errno != EHOSTUNREACH) {
+                std::fprintf (stderr, "send failed: %s\n",
+                              zlink_strerror (errno));
+                std::exit (1);
+            }
+            std::this_thread::yield ();
+        }
+    }
+    const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now () - start;
+    drain.join ();
+    return keys / elapsed.count ();
+}
+
+//  Keys per provider: lowest and highest as a share of the mean, and the
+//  coefficient of variation.
+static void report_spread (const char *phase_,
+                           const std::vector<provider_t> &providers_,
+                           const std::vector<int> &owner_)
+{
+    std::vector<std::size_t> counts (providers_.size (), 0);
+    for (std::size_t k = 0; k < owner_.size (); ++k)
+        if (owner_[k] >= 0)
+            ++counts[owner_[k]];
+    const double mean = static_cast<double> (keys) / counts.size ();
+    std::size_t low = keys;
+    std::size_t high = 0;
+    double variance = 0;
+    for (std::size_t i = 0; i < counts.size (); ++i) {
+        low = counts[i] < low ? counts[i] : low;
+        high = counts[i] > high ? counts[i] : high;
+        variance += (counts[i] - mean) * (counts[i] - mean);
+    }
+    variance /= counts.size ();
+    std::printf ("%-6s providers=%zu  keys/provider min %.2f max %.2f of mean"
+                 "  cv %.3f\n",
+                 phase_, counts.size (), low / mean, high / mean,
+                 std::sqrt (variance) / mean);
+}
+
+//  Share of keys whose provider changed; providers are compared by their
+//  position in the previous and next provider lists.
+static double moved_share (const std::vector<int> &before_,
+                           const std::vector<void *> &before_routers_,
+                           const std::vector<int> &after_,
+                           const std::vector<void *> &after_routers_)
+{
+    std::size_t moved = 0;
+    for (std::size_t k = 0; k < keys; ++k)
+        if (before_[k] < 0 || after_[k] < 0
+            || before_routers_[before_[k]] != after_routers_[after_[k]])
+            ++moved;
+    return static_cast<double> (moved) / keys;
+}
+
+static double modulo_moved_share (std::size_t from_, std::size_t to_)
+{
+    std::size_t moved = 0;
+    for (uint32_t key = 0; key < keys; ++key) {
+        const uint64_t hash = key * 0x9e3779b97f4a7c15ULL;
+        if (hash % from_ != hash % to_)
+            ++moved;
+    }
+    return static_cast<double> (moved) / keys;
+}
+
+static std::vector<void *> routers_of (const std::vector<provider_t> &p_)
+{
+    std::vector<void *> routers;
+    for (std::size_t i = 0; i < p_.size (); ++i)
+        routers.push_back (p_[i].router);
+    return routers;
+}
+
+int main ()
+{
+    void *ctx = zlink_ctx_new ();
+    void *registry = zlink_registry_new (ctx);
+    zlink_registry_set_endpoints (registry, "inproc://keyed-reg-pub",
+                                  "inproc://keyed-reg-router");
+    zlink_registry_start (registry);
+
+    std::vector<provider_t> providers;
+    for (int i = 0; i < initial_providers; ++i)
+        providers.push_back (start_provider (ctx, i));
+
+    void *discovery = zlink_discovery_new_typed (ctx, ZLINK_SERVICE_TYPE_GATEWAY);
+    zlink_discovery_connect_registry (discovery, "inproc://keyed-reg-pub");
+    zlink_discovery_subscribe (discovery, service_name);
+    void *gateway = zlink_gateway_new (ctx, discovery, NULL);
+    wait_connections (gateway, initial_providers);
+
+    std::vector<int> start_owner;
+    const double round_robin_rate =
+      run_phase (gateway, providers, false, &start_owner);
+    const double keyed_rate = run_phase (gateway, providers, true, &start_owner);
+    std::printf ("send   round robin %10.0lf req/s  keyed %10.0lf req/s\n",
+                 round_robin_rate, keyed_rate);
+    report_spread ("start", providers, start_owner);
+    const std::vector<void *> start_routers = routers_of (providers);
+
+    //  One provider leaves.
+    zlink_receiver_unregister (providers[initial_providers / 2].receiver,
+                               service_name);
+    zlink_receiver_destroy (&providers[initial_providers / 2].receiver);
+    providers.erase (providers.begin () + initial_providers / 2);
+    wait_connections (gateway, initial_providers - 1);
+    std::vector<int> leave_owner;
+    run_phase (gateway, providers, true, &leave_owner);
+    report_spread ("leave", providers, leave_owner);
+    const std::vector<void *> leave_routers = routers_of (providers);
+    std::printf ("       moved %.3f  (ideal %.3f, hash modulo %.3f)\n",
+                 moved_share (start_owner, start_routers, leave_owner,
+                              leave_routers),
+                 1.0 / initial_providers,
+                 modulo_moved_share (initial_providers,
+                                     initial_providers - 1));
+
+    //  A new provider joins.
+    providers.push_back (start_provider (ctx, initial_providers));
+    wait_connections (gateway, initial_providers);
+    std::vector<int> join_owner;
+    run_phase (gateway, providers, true, &join_owner);
+    report_spread ("join", providers, join_owner);
+    std::printf ("       moved %.3f  (ideal %.3f, hash modulo %.3f)\n",
+                 moved_share (leave_owner, leave_routers, join_owner,
+                              routers_of (providers)),
+                 1.0 / initial_providers,
+                 modulo_moved_share (initial_providers - 1,
+                                     initial_providers));
+
+    zlink_gateway_destroy (&gateway);
+    for (std::size_t i = 0; i < providers.size (); ++i)
+        zlink_receiver_destroy (&providers[i].receiver);
+    zlink_discovery_destroy (&discovery);
+    zlink_registry_destroy (&registry);
+    zlink_ctx_term (ctx);
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
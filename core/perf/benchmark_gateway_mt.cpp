@@ -0,0 +1,178 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include <zlink.h>
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+//  Request throughput of one gateway shared by many sending threads.
+//  A provider echoes every request over tcp, and one thread drains the
+//  replies from the gateway while the senders run. Send throughput is
+//  taken when the last sender is done, round trip when the last reply is in.
+//
+//  - shards=1: every thread sends through the one ROUTER socket and lock.
+//  - shards=N: each thread sends through the shard it is assigned to.
+
+const char *service_name = "bench-svc";
+const std::size_t requests_per_thread = 50000;
+const std::size_t payload_size = 64;
+
+struct result_t
+{
+    double send_seconds;
+    double seconds;
+    std::size_t requests;
+};
+
+static void echo_run (void *router_, std::size_t total_)
+{
+    for (std::size_t n = 0; n < total_;) {
+        zlink_msg_t rid;
+        zlink_msg_init (&rid);
+        if (zlink_msg_recv (&rid, router_, 0) < 0) {
+            zlink_msg_close (&rid);
+            return;
+        }
+        zlink_msg_t body;
+        zlink_msg_init (&body);
+        zlink_msg_recv (&body, router_, 0);
+        if (zlink_msg_size (&body) == 0) {
+            //  Probe from a gateway shard that connected
+            zlink_msg_close (&body);
+            zlink_msg_close (&rid);
+            continue;
+        }
+        zlink_msg_send (&rid, router_, ZLINK_SNDMORE);
+        zlink_msg_send (&body, router_, 0);
+        ++n;
+    }
+}
+
+static void send_run (void *gateway_)
+{
+    for (std::size_t i = 0; i < requests_per_thread; ++i) {
+        zlink_msg_t msg;
+        zlink_msg_init_size (&msg, payload_size);
+        memset (zlink_msg_data (&msg), 'x', payload_size);
+        while (zlink_gateway_send (gateway_, service_name, &msg, 1,
+                                   ZLINK_DONTWAIT)
+               != 0) {
+            if (errno != EAGAIN && errno != EHOSTUNREACH) {
+                std::fprintf (stderr, "send failed: %s\n",
+                              zlink_strerror (errno));
+                std::exit (1);
+            }
+            std::this_thread::yield ();
+        }
+    }
+}
+
+static result_t run (int shards_, int threads_)
+{
+    void *ctx = zlink_ctx_new ();
+    void *registry = zlink_registry_new (ctx);
+    zlink_registry_set_endpoints (registry, "inproc://bench-reg-pub",
+                                  "inproc://bench-reg-router");
+    zlink_registry_start (registry);
+
+    void *provider = zlink_receiver_new (ctx, NULL);
+    zlink_receiver_bind (provider, "tcp://127.0.0.1:*");
+    void *router = zlink_receiver_router (provider);
+    int probe = 1;
+    zlink_setsockopt (router, ZLINK_PROBE_ROUTER, &probe, sizeof (probe));
+    zlink_setsockopt (router, ZLINK_ROUTING_ID, "PROV", 4);
+    char ep[256] = {0};
+    std::size_t len = sizeof (ep);
+    zlink_getsockopt (router, ZLINK_LAST_ENDPOINT, ep, &len);
+    zlink_receiver_connect_registry (provider, "inproc://bench-reg-router");
+    zlink_receiver_register (provider, service_name, ep, 1);
+
+    void *discovery = zlink_discovery_new_typed (ctx, ZLINK_SERVICE_TYPE_GATEWAY);
+    zlink_discovery_connect_registry (discovery, "inproc://bench-reg-pub");
+    zlink_discovery_subscribe (discovery, service_name);
+    void *gateway = zlink_gateway_new_sharded (ctx, discovery, NULL, shards_);
+    while (zlink_gateway_connection_count (gateway, service_name) < 1)
+        std::this_thread::sleep_for (std::chrono::milliseconds (5));
+    int timeout_ms = 5000;
+    zlink_gateway_setsockopt (gateway, ZLINK_RCVTIMEO, &timeout_ms,
+                              sizeof (timeout_ms));
+
+    const std::size_t total = requests_per_thread * threads_;
+    std::thread echo (echo_run, router, total);
+
+    const auto start = std::chrono::steady_clock::now ();
+    std::atomic<int> sending (threads_);
+    std::chrono::steady_clock::time_point sent;
+    std::vector<std::thread> senders;
+    for (int t = 0; t < threads_; ++t)
+        senders.push_back (std::thread ([&] () {
+            send_run (gateway);
+            if (--sending == 0)
+                sent = std::chrono::steady_clock::now ();
+        }));
+    std::size_t replies = 0;
+    while (replies < total) {
+        zlink_msg_t *parts = NULL;
+        std::size_t part_count = 0;
+        if (zlink_gateway_recv (gateway, &parts, &part_count, 0, NULL) != 0)
+            break;
+        if (part_count == 1 && zlink_msg_size (&parts[0]) == payload_size)
+            ++replies;
+        zlink_msgv_close (parts, part_count);
+    }
+    const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now () - start;
+    for (std::size_t t = 0; t < senders.size (); ++t)
+        senders[t].join ();
+    echo.join ();
+    const std::chrono::duration<double> send_elapsed = sent - start;
+
+    zlink_gateway_destroy (&gateway);
+    zlink_receiver_destroy (&provider);
+    zlink_discovery_destroy (&discovery);
+    zlink_registry_destroy (&registry);
+    zlink_ctx_term (ctx);
+
+    if (replies < total)
+        std::fprintf (stderr, "lost %llu replies\n",
+                      static_cast<unsigned long long> (total - replies));
+    const result_t result = {send_elapsed.count (), elapsed.count (),
+                             replies};
+    return result;
+}
+
+static void report (int shards_, int threads_, const result_t &result_)
+{
+    std::printf ("shards=%-2d threads=%-2d  send %10.0lf req/s  "
+                 "round trip %10.0lf req/s  total %.3lf s\n",
+                 shards_, threads_, result_.requests / result_.send_seconds,
+                 result_.requests / result_.seconds, result_.seconds);
+}
+
+int main ()
+{
+    const int thread_counts[] = {1, 2, 4, 8};
+    for (std::size_t i = 0; i < sizeof thread_counts / sizeof *thread_counts;
+         ++i) {
+        const int threads = thread_counts[i];
+        report (1, threads, run (1, threads));
+        report (threads, threads, run (threads, threads));
+    }
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
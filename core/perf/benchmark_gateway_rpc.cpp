@@ -0,0 +1,250 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include <zlink.h>
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+//  Request/reply throughput of one gateway thread talking to one provider
+//  over tcp and over inproc. The provider echoes every request part by
+//  part. The gateway keeps a window of requests in flight and sends a new
+//  one for every reply, so the run measures the framing cost on both sides of the
+//  gateway rather than the round trip latency alone; inproc leaves out
+//  the I/O threads and shows that cost most plainly.
+//
+//  - window=1: strict request/reply, one request in flight.
+//  - window=N: N requests in flight.
+//  - sync:  zlink_gateway_send and zlink_gateway_recv on one thread.
+//  - async: zlink_gateway_request_async; each completion sends the next
+//           request from the completion thread of the gateway.
+
+const char *service_name = "bench-rpc";
+const std::size_t requests = 200000;
+const std::size_t payload_size = 64;
+
+static void echo_run (void *router_, std::size_t total_)
+{
+    zlink_msg_t parts[16];
+    for (std::size_t n = 0; n < total_;) {
+        std::size_t count = 0;
+        bool more = true;
+        while (more && count < 16) {
+            zlink_msg_init (&parts[count]);
+            if (zlink_msg_recv (&parts[count], router_, 0) < 0) {
+                zlink_msg_close (&parts[count]);
+                return;
+            }
+            more = zlink_msg_more (&parts[count]) != 0;
+            ++count;
+        }
+        if (count == 2 && zlink_msg_size (&parts[1]) == 0) {
+            //  Probe from the gateway that connected
+            zlink_msg_close (&parts[1]);
+            zlink_msg_close (&parts[0]);
+            continue;
+        }
+        for (std::size_t i = 0; i < count; ++i)
+            zlink_msg_send (&parts[i], router_,
+                            i + 1 < count ? ZLINK_SNDMORE : 0);
+        ++n;
+    }
+}
+
+static void send_request (void *gateway_, std::size_t part_count_)
+{
+    zlink_msg_t parts[16];
+    for (std::size_t i = 0; i < part_count_; ++i) {
+        zlink_msg_init_size (&parts[i], payload_size);
+        memset (zlink_msg_data (&parts[i]), 'x', payload_size);
+    }
+    while (zlink_gateway_send (gateway_, service_name, parts, part_count_, 0)
+           != 0) {
+        if (errno != EAGAIN && errno != EHOSTUNREACH) {
+            std::fprintf (stderr, "send failed: %s\n",
+                          zlink_strerror (errno));
+            std::exit (1);
+        }
+        std::this_thread::yield ();
+    }
+}
+
+struct async_state_t
+{
+    void *gateway;
+    std::size_t part_count;
+    std::atomic<std::size_t> sent;
+    std::atomic<std::size_t> replies;
+};
+
+static void send_async (async_state_t *state_);
+
+static void async_done (int status_,
+                        zlink_msg_t *,
+                        std::size_t part_count_,
+                        void *userdata_)
+{
+    async_state_t *state = static_cast<async_state_t *> (userdata_);
+    if (status_ == 0 && part_count_ == state->part_count)
+        ++state->replies;
+    else
+        std::fprintf (stderr, "request failed: %s\n", zlink_strerror (status_));
+    if (state->sent.fetch_add (1) < requests)
+        send_async (state);
+}
+
+static void send_async (async_state_t *state_)
+{
+    zlink_msg_t parts[16];
+    for (std::size_t i = 0; i < state_->part_count; ++i) {
+        zlink_msg_init_size (&parts[i], payload_size);
+        memset (zlink_msg_data (&parts[i]), 'x', payload_size);
+    }
+    while (zlink_gateway_request_async (state_->gateway, service_name, parts,
+                                        state_->part_count, 0, async_done,
+                                        state_)
+           != 0) {
+        if (errno != EAGAIN && errno != EHOSTUNREACH) {
+            std::fprintf (stderr, "send failed: %s\n",
+                          zlink_strerror (errno));
+            std::exit (1);
+        }
+        std::this_thread::yield ();
+    }
+}
+
+static std::size_t run_sync (void *gateway_,
+                             std::size_t part_count_,
+                             std::size_t window_)
+{
+    std::size_t sent = 0;
+    std::size_t replies = 0;
+    for (; sent < window_ && sent < requests; ++sent)
+        send_request (gateway_, part_count_);
+    while (replies < requests) {
+        zlink_msg_t *parts = NULL;
+        std::size_t count = 0;
+        if (zlink_gateway_recv (gateway_, &parts, &count, 0, NULL) != 0)
+            break;
+        if (count == part_count_)
+            ++replies;
+        zlink_msgv_close (parts, count);
+        if (sent < requests) {
+            send_request (gateway_, part_count_);
+            ++sent;
+        }
+    }
+    return replies;
+}
+
+static std::size_t run_async (void *gateway_,
+                              std::size_t part_count_,
+                              std::size_t window_)
+{
+    async_state_t state;
+    state.gateway = gateway_;
+    state.part_count = part_count_;
+    state.sent = window_;
+    state.replies = 0;
+    for (std::size_t i = 0; i < window_; ++i)
+        send_async (&state);
+    const auto deadline =
+      std::chrono::steady_clock::now () + std::chrono::seconds (30);
+    while (state.replies < requests
+           && std::chrono::steady_clock::now () < deadline)
+        std::this_thread::sleep_for (std::chrono::microseconds (200));
+    return state.replies;
+}
+
+static double run (const char *bind_endpoint_,
+                   bool async_,
+                   std::size_t part_count_,
+                   std::size_t window_)
+{
+    void *ctx = zlink_ctx_new ();
+    void *registry = zlink_registry_new (ctx);
+    zlink_registry_set_endpoints (registry, "inproc://rpc-reg-pub",
+                                  "inproc://rpc-reg-router");
+    zlink_registry_start (registry);
+
+    void *provider = zlink_receiver_new (ctx, NULL);
+    zlink_receiver_bind (provider, bind_endpoint_);
+    void *router = zlink_receiver_router (provider);
+    int probe = 1;
+    zlink_setsockopt (router, ZLINK_PROBE_ROUTER, &probe, sizeof (probe));
+    zlink_setsockopt (router, ZLINK_ROUTING_ID, "PROV", 4);
+    char ep[256] = {0};
+    std::size_t len = sizeof (ep);
+    zlink_getsockopt (router, ZLINK_LAST_ENDPOINT, ep, &len);
+    zlink_receiver_connect_registry (provider, "inproc://rpc-reg-router");
+    zlink_receiver_register (provider, service_name, ep, 1);
+
+    void *discovery = zlink_discovery_new_typed (ctx, ZLINK_SERVICE_TYPE_GATEWAY);
+    zlink_discovery_connect_registry (discovery, "inproc://rpc-reg-pub");
+    zlink_discovery_subscribe (discovery, service_name);
+    void *gateway = zlink_gateway_new (ctx, discovery, NULL);
+    while (zlink_gateway_connection_count (gateway, service_name) < 1)
+        std::this_thread::sleep_for (std::chrono::milliseconds (5));
+    int timeout_ms = 5000;
+    zlink_gateway_setsockopt (gateway, ZLINK_RCVTIMEO, &timeout_ms,
+                              sizeof (timeout_ms));
+
+    std::thread echo (echo_run, router, requests);
+
+    const auto start = std::chrono::steady_clock::now ();
+    const std::size_t replies =
+      async_ ? run_async (gateway, part_count_, window_)
+             : run_sync (gateway, part_count_, window_);
+    const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now () - start;
+    echo.join ();
+
+    zlink_gateway_destroy (&gateway);
+    zlink_receiver_destroy (&provider);
+    zlink_discovery_destroy (&discovery);
+    zlink_registry_destroy (&registry);
+    zlink_ctx_term (ctx);
+
+    if (replies < requests)
+        std::fprintf (stderr, "lost %llu replies\n",
+                      static_cast<unsigned long long> (requests - replies));
+    return elapsed.count ();
+}
+
+int main ()
+{
+    const char *endpoints[] = {"tcp://127.0.0.1:*", "inproc://rpc-provider"};
+    const char *names[] = {"tcp", "inproc"};
+    const std::size_t part_counts[] = {1, 4};
+    const std::size_t windows[] = {1, 64};
+    for (std::size_t e = 0; e < sizeof endpoints / sizeof *endpoints; ++e)
+        for (std::size_t p = 0; p < sizeof part_counts / sizeof *part_counts;
+             ++p)
+            for (std::size_t w = 0; w < sizeof windows / sizeof *windows;
+                 ++w)
+                for (int async = 0; async < 2; ++async) {
+                    const double seconds =
+                      run (endpoints[e], async != 0, part_counts[p],
+                           windows[w]);
+                    std::printf ("%-6s %-5s parts=%zu window=%-3zu  "
+                                 "%10.0lf req/s  total %.3lf s\n",
+                                 names[e], async ? "async" : "sync",
+                                 part_counts[p], windows[w],
+                                 requests / seconds, seconds);
+                }
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
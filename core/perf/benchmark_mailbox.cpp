@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include "core/command.hpp"
+#include "core/ypipe.hpp"
+#include "core/ypipe_mpsc.hpp"
+#include "utils/config.hpp"
+#include "utils/mutex.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+//  Compares the mailbox command pipe (ypipe_mpsc_t) against the mutex
+//  guarded ypipe_t it replaced, with 1 to 16 threads sending commands to a
+//  single reader. The reader spins instead of sleeping on a signaler, so
+//  only the queue itself is measured.
+
+const std::size_t ncommands = 2000000;
+const std::size_t samples = 3;
+
+class locked_pipe_t
+{
+  public:
+    bool write (const zlink::command_t &cmd_)
+    {
+        zlink::scoped_lock_t lock (_sync);
+        _pipe.write (cmd_, false);
+        return _pipe.flush ();
+    }
+
+    bool read (zlink::command_t *cmd_) { return _pipe.read (cmd_); }
+
+  private:
+    zlink::mutex_t _sync;
+    zlink::ypipe_t<zlink::command_t, zlink::command_pipe_granularity> _pipe;
+};
+
+typedef zlink::ypipe_mpsc_t<zlink::command_t,
+                            zlink::command_pipe_size,
+                            zlink::command_pipe_granularity>
+  mpsc_pipe_t;
+
+template <class T> static double run (std::size_t writers_)
+{
+    using namespace std::chrono;
+
+    T pipe;
+    std::atomic<bool> go (false);
+    const std::size_t per_writer = ncommands / writers_;
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < writers_; ++i)
+        threads.push_back (std::thread ([&] {
+            zlink::command_t cmd;
+            cmd.destination = NULL;
+            cmd.type = zlink::command_t::activate_read;
+            while (!go.load ())
+                std::this_thread::yield ();
+            for (std::size_t j = 0; j < per_writer; ++j)
+                pipe.write (cmd);
+        }));
+
+    const steady_clock::time_point start = steady_clock::now ();
+    go.store (true);
+    zlink::command_t cmd;
+    for (std::size_t received = 0; received < per_writer * writers_;)
+        if (pipe.read (&cmd))
+            ++received;
+        else
+            std::this_thread::yield ();
+    const double seconds =
+      duration<double> (steady_clock::now () - start).count ();
+
+    for (std::size_t i = 0; i < threads.size (); ++i)
+        threads[i].join ();
+    return per_writer * writers_ / seconds;
+}
+
+template <class T> static void benchmark (const char *name_, std::size_t writers_)
+{
+    double best = 0;
+    for (std::size_t i = 0; i < samples; ++i) {
+        const double rate = run<T> (writers_);
+        if (rate > best)
+            best = rate;
+    }
+    std::printf ("%-10s writers=%-3llu %7.2lf M commands/s  %6.1lf ns/command\n",
+                 name_, static_cast<unsigned long long> (writers_), best / 1e6,
+                 1e9 / best);
+}
+
+int main ()
+{
+    const std::size_t writer_counts[] = {1, 2, 4, 8, 16};
+    for (std::size_t writers : writer_counts) {
+        benchmark<locked_pipe_t> ("mutex", writers);
+        benchmark<mpsc_pipe_t> ("mpsc", writers);
+    }
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
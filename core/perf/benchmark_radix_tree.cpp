@@ -4,95 +4,125 @@
 
 #include "radix_tree.hpp"
 #include "trie.hpp"
+#include "generic_mtrie_impl.hpp"
 
 #include <chrono>
 #include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <random>
 #include <ratio>
 #include <vector>
 
-const std::size_t nkeys = 10000;
+//  Measures subscription matching as the number of subscriptions grows:
+//  trie_t and radix_tree_t as used by SUB/XSUB filtering, generic_mtrie_t
+//  as used by XPUB. Messages are a subscribed topic followed by a payload,
+//  mixed with messages that match nothing.
+const std::size_t key_counts[] = {100, 1000, 10000, 100000};
 const std::size_t nqueries = 1000000;
-const std::size_t warmup_runs = 10;
-const std::size_t samples = 10;
+const std::size_t warmup_runs = 2;
+const std::size_t samples = 5;
 const std::size_t key_length = 20;
+const std::size_t payload_length = 12;
 const char *chars = "abcdefghijklmnopqrstuvwxyz0123456789";
 const int chars_len = 36;
 
+typedef zlink::generic_mtrie_t<int> mtrie_t;
+
+struct mtrie_adapter_t
+{
+    mtrie_t mtrie;
+    int value;
+
+    bool check (const unsigned char *data_, std::size_t size_)
+    {
+        bool found = false;
+        mtrie.match (data_, size_, on_match, &found);
+        return found;
+    }
+
+    static void on_match (int *, bool *found_) { *found_ = true; }
+};
+
 template <class T>
-void benchmark_lookup (T &subscriptions_,
-                       std::vector<unsigned char *> &queries_)
+void benchmark_match (const char *name_,
+                      T &subscriptions_,
+                      const std::vector<unsigned char> &queries_)
 {
     using namespace std::chrono;
-    std::vector<duration<long, std::nano> > samples_vec;
-    samples_vec.reserve (samples);
+    const std::size_t query_size = key_length + payload_length;
+    std::size_t matched = 0;
 
-    for (std::size_t run = 0; run < warmup_runs; ++run) {
-        for (auto &query : queries_)
-            subscriptions_.check (query, key_length);
-    }
+    for (std::size_t run = 0; run < warmup_runs; ++run)
+        for (std::size_t i = 0; i < nqueries; ++i)
+            matched += subscriptions_.check (&queries_[i * query_size],
+                                             query_size);
 
+    double best = 0;
     for (std::size_t run = 0; run < samples; ++run) {
-        duration<long, std::nano> interval (0);
-        for (auto &query : queries_) {
-            auto start = steady_clock::now ();
-            subscriptions_.check (query, key_length);
-            auto end = steady_clock::now ();
-            interval += end - start;
-        }
-        samples_vec.push_back (interval / queries_.size ());
+        const steady_clock::time_point start = steady_clock::now ();
+        for (std::size_t i = 0; i < nqueries; ++i)
+            matched += subscriptions_.check (&queries_[i * query_size],
+                                             query_size);
+        const double seconds =
+          duration<double> (steady_clock::now () - start).count ();
+        const double rate = nqueries / seconds;
+        if (rate > best)
+            best = rate;
     }
 
-    std::size_t sum = 0;
-    for (const auto &sample : samples_vec)
-        sum += sample.count ();
-    std::printf ("Average lookup time = %.1lf ns\n",
-                 static_cast<double> (sum) / samples);
+    std::printf ("  %-12s %8.2f M matches/s  %6.1f ns/match  (hits %llu)\n",
+                 name_, best / 1e6, 1e9 / best,
+                 static_cast<unsigned long long> (
+                   matched / (warmup_runs + samples)));
 }
 
-int main ()
+void run (std::size_t nkeys_, std::minstd_rand &rng_)
 {
-    // Generate input set.
-    std::minstd_rand rng (123456789);
-    std::vector<unsigned char *> input_set;
-    std::vector<unsigned char *> queries;
-    input_set.reserve (nkeys);
-    queries.reserve (nqueries);
-
-    for (std::size_t i = 0; i < nkeys; ++i) {
-        unsigned char *key = new unsigned char[key_length];
-        for (std::size_t j = 0; j < key_length; j++)
-            key[j] = static_cast<unsigned char> (chars[rng () % chars_len]);
-        input_set.emplace_back (key);
+    std::vector<unsigned char> keys (nkeys_ * key_length);
+    for (std::size_t i = 0; i < keys.size (); ++i)
+        keys[i] = static_cast<unsigned char> (chars[rng_ () % chars_len]);
+
+    //  Half of the messages start with a subscribed topic.
+    const std::size_t query_size = key_length + payload_length;
+    std::vector<unsigned char> queries (nqueries * query_size);
+    for (std::size_t i = 0; i < nqueries; ++i) {
+        unsigned char *query = &queries[i * query_size];
+        for (std::size_t j = 0; j < query_size; ++j)
+            query[j] = static_cast<unsigned char> (chars[rng_ () % chars_len]);
+        if (i % 2 == 0)
+            memcpy (query, &keys[(rng_ () % nkeys_) * key_length],
+                    key_length);
     }
-    for (std::size_t i = 0; i < nqueries; ++i)
-        queries.push_back (input_set[rng () % nkeys]);
 
-    // Initialize both data structures.
-    //
     // Keeping initialization out of the benchmarking function helps
     // heaptrack detect peak memory consumption of the radix tree.
     zlink::trie_t trie;
     zlink::radix_tree_t radix_tree;
-    for (auto &key : input_set) {
+    mtrie_adapter_t mtrie;
+    for (std::size_t i = 0; i < nkeys_; ++i) {
+        unsigned char *key = &keys[i * key_length];
         trie.add (key, key_length);
         radix_tree.add (key, key_length);
+        mtrie.mtrie.add (key, key_length, &mtrie.value);
     }
 
-    // Create a benchmark.
-    std::printf ("keys = %llu, queries = %llu, key size = %llu\n",
-                 static_cast<unsigned long long> (nkeys),
+    std::printf ("subscriptions = %llu, messages = %llu, topic size = %llu, "
+                 "message size = %llu\n",
+                 static_cast<unsigned long long> (nkeys_),
                  static_cast<unsigned long long> (nqueries),
-                 static_cast<unsigned long long> (key_length));
-    std::puts ("[trie]");
-    benchmark_lookup (trie, queries);
-
-    std::puts ("[radix_tree]");
-    benchmark_lookup (radix_tree, queries);
+                 static_cast<unsigned long long> (key_length),
+                 static_cast<unsigned long long> (query_size));
+    benchmark_match ("trie", trie, queries);
+    benchmark_match ("radix_tree", radix_tree, queries);
+    benchmark_match ("mtrie", mtrie, queries);
+}
 
-    for (auto &op : input_set)
-        delete[] op;
+int main ()
+{
+    std::minstd_rand rng (123456789);
+    for (std::size_t i = 0; i < sizeof key_counts / sizeof key_counts[0]; ++i)
+        run (key_counts[i], rng);
 }
 
 #else
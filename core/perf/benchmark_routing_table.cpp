@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include "utils/blob_map.hpp"
+#include "protocol/wire.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+
+//  Compares the ROUTER/STREAM outbound pipe table (blob_map_t) against the
+//  std::map it replaced, for 10 to 100k peers with auto-assigned 5 byte
+//  routing ids.
+
+const std::size_t nqueries = 1000000;
+const std::size_t samples = 5;
+
+struct out_pipe_t
+{
+    void *pipe;
+    bool active;
+};
+
+typedef std::map<zlink::blob_t, out_pipe_t> std_table_t;
+typedef zlink::blob_map_t<out_pipe_t> hash_table_t;
+
+static zlink::blob_t routing_id (uint32_t id_)
+{
+    unsigned char buf[5];
+    buf[0] = 0;
+    zlink::put_uint32 (buf + 1, id_);
+    return zlink::blob_t (buf, sizeof buf);
+}
+
+static out_pipe_t *lookup (std_table_t &table_, const unsigned char *data_)
+{
+    const std_table_t::iterator it =
+      table_.find (zlink::blob_t (const_cast<unsigned char *> (data_), 5,
+                                  zlink::reference_tag_t ()));
+    return it == table_.end () ? NULL : &it->second;
+}
+
+static out_pipe_t *lookup (hash_table_t &table_, const unsigned char *data_)
+{
+    return table_.find (data_, 5);
+}
+
+static void insert (std_table_t &table_, uint32_t id_)
+{
+    const out_pipe_t pipe = {NULL, true};
+    table_.insert (std::make_pair (routing_id (id_), pipe));
+}
+
+static void insert (hash_table_t &table_, uint32_t id_)
+{
+    const out_pipe_t pipe = {NULL, true};
+    table_.insert (routing_id (id_), pipe);
+}
+
+template <class T>
+static void benchmark (const char *name_,
+                       std::size_t peers_,
+                       const std::vector<zlink::blob_t> &queries_)
+{
+    using namespace std::chrono;
+
+    T table;
+    for (std::size_t i = 0; i < peers_; ++i)
+        insert (table, static_cast<uint32_t> (i));
+
+    double best_lookup = 0;
+    for (std::size_t run = 0; run < samples; ++run) {
+        std::size_t hits = 0;
+        const steady_clock::time_point start = steady_clock::now ();
+        for (const auto &query : queries_)
+            hits += lookup (table, query.data ()) != NULL;
+        const double ns =
+          duration<double, std::nano> (steady_clock::now () - start).count ()
+          / queries_.size ();
+        if (hits != queries_.size ())
+            std::printf ("unexpected miss\n");
+        if (run == 0 || ns < best_lookup)
+            best_lookup = ns;
+    }
+
+    //  Peer churn: disconnect one peer and connect a new one.
+    const std::size_t churn = 100000;
+    const steady_clock::time_point start = steady_clock::now ();
+    for (std::size_t i = 0; i < churn; ++i) {
+        table.erase (routing_id (static_cast<uint32_t> (i)));
+        insert (table, static_cast<uint32_t> (peers_ + i));
+    }
+    const double churn_ns =
+      duration<double, std::nano> (steady_clock::now () - start).count ()
+      / churn;
+
+    std::printf ("%-10s peers=%-7llu lookup=%6.1lf ns  churn=%7.1lf ns\n",
+                 name_, static_cast<unsigned long long> (peers_), best_lookup,
+                 churn_ns);
+}
+
+int main ()
+{
+    const std::size_t peer_counts[] = {10, 100, 1000, 10000, 100000};
+    std::minstd_rand rng (123456789);
+
+    for (std::size_t peers : peer_counts) {
+        std::vector<zlink::blob_t> queries;
+        queries.reserve (nqueries);
+        for (std::size_t i = 0; i < nqueries; ++i)
+            queries.push_back (routing_id (rng () % peers));
+
+        benchmark<std_table_t> ("std::map", peers, queries);
+        benchmark<hash_table_t> ("blob_map", peers, queries);
+    }
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
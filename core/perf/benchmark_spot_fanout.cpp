@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include <zlink.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//  Local publish cost of a SPOT node as its pattern subscriptions grow.
+//  Every sub holds one pattern "zone:<n>:*"; the published topic matches
+//  exactly one of them, whose sub is drained as the run goes. The node is
+//  not bound, so nothing goes on the wire.
+//
+//  - node:   zlink_spot_pub_publish, patterns indexed by prefix.
+//  - linear: the same prefixes compared one by one, as a scan over all
+//            pattern subscribers would, without any delivery.
+
+const std::size_t messages = 200000;
+const char *topic = "zone:7:entity:move";
+
+static std::string pattern_prefix (std::size_t n_)
+{
+    char buf[32];
+    std::snprintf (buf, sizeof buf, "zone:%zu:", n_);
+    return buf;
+}
+
+static double run_node (std::size_t subscribers_)
+{
+    void *ctx = zlink_ctx_new ();
+    void *node = zlink_spot_node_new (ctx);
+    void *pub = zlink_spot_pub_new (node);
+    std::vector<void *> subs;
+    void *target = NULL;
+    for (std::size_t n = 0; n < subscribers_; ++n) {
+        void *sub = zlink_spot_sub_new (node);
+        const std::string pattern = pattern_prefix (n) + "*";
+        zlink_spot_sub_subscribe_pattern (sub, pattern.c_str ());
+        if (n == 7)
+            target = sub;
+        subs.push_back (sub);
+    }
+
+    const auto start = std::chrono::steady_clock::now ();
+    for (std::size_t i = 0; i < messages; ++i) {
+        zlink_msg_t part;
+        zlink_msg_init_size (&part, 32);
+        memset (zlink_msg_data (&part), 'x', 32);
+        zlink_spot_pub_publish (pub, topic, &part, 1, 0);
+
+        zlink_msg_t *parts = NULL;
+        std::size_t count = 0;
+        if (target
+            && zlink_spot_sub_recv (target, &parts, &count, ZLINK_DONTWAIT,
+                                    NULL, NULL)
+                 == 0)
+            zlink_msgv_close (parts, count);
+    }
+    const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now () - start;
+
+    zlink_spot_pub_destroy (&pub);
+    for (std::size_t n = 0; n < subs.size (); ++n)
+        zlink_spot_sub_destroy (&subs[n]);
+    zlink_spot_node_destroy (&node);
+    zlink_ctx_term (ctx);
+    return elapsed.count ();
+}
+
+static double run_linear (std::size_t subscribers_)
+{
+    std::vector<std::string> prefixes;
+    for (std::size_t n = 0; n < subscribers_; ++n)
+        prefixes.push_back (pattern_prefix (n));
+
+    const std::size_t topic_size = strlen (topic);
+    std::size_t matched = 0;
+    const auto start = std::chrono::steady_clock::now ();
+    for (std::size_t i = 0; i < messages; ++i) {
+        for (std::size_t n = 0; n < prefixes.size (); ++n) {
+            const std::string &prefix = prefixes[n];
+            if (prefix.size () <= topic_size
+                && memcmp (topic, prefix.data (), prefix.size ()) == 0)
+                ++matched;
+        }
+    }
+    const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now () - start;
+    if (matched != (subscribers_ > 7 ? messages : 0))
+        std::fprintf (stderr, "unexpected match count %zu\n", matched);
+    return elapsed.count ();
+}
+
+int main ()
+{
+    const std::size_t counts[] = {10, 100, 1000, 10000};
+    for (std::size_t i = 0; i < sizeof counts / sizeof *counts; ++i) {
+        const double node = run_node (counts[i]);
+        const double linear = run_linear (counts[i]);
+        std::printf ("patterns=%-6zu node %8.0lf ns/msg  linear scan only "
+                     "%8.0lf ns/msg\n",
+                     counts[i], node * 1e9 / messages,
+                     linear * 1e9 / messages);
+    }
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include <zlink.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+//  Publish throughput of one SPOT node shared by many publisher threads.
+//  The node is bound over tcp with no peer, so every message goes through
+//  the PUB socket and is dropped there; a local sub holds exact and pattern
+//  subscriptions on other topics, so no message is delivered locally.
+//  Each thread publishes on its own topic through its own spot_pub.
+
+const std::size_t messages_per_thread = 200000;
+const std::size_t payload_size = 32;
+
+static void publish_run (void *node_, int index_)
+{
+    void *pub = zlink_spot_pub_new (node_);
+    char topic[32];
+    std::snprintf (topic, sizeof topic, "bench:zone:%d:move", index_);
+    for (std::size_t i = 0; i < messages_per_thread; ++i) {
+        zlink_msg_t part;
+        zlink_msg_init_size (&part, payload_size);
+        memset (zlink_msg_data (&part), 'x', payload_size);
+        zlink_spot_pub_publish (pub, topic, &part, 1, 0);
+    }
+    zlink_spot_pub_destroy (&pub);
+}
+
+static double run (int threads_)
+{
+    void *ctx = zlink_ctx_new ();
+    void *node = zlink_spot_node_new (ctx);
+    zlink_spot_node_bind (node, "tcp://127.0.0.1:*");
+    void *sub = zlink_spot_sub_new (node);
+    zlink_spot_sub_subscribe (sub, "other:zone:1:move");
+    zlink_spot_sub_subscribe_pattern (sub, "other:*");
+    std::this_thread::sleep_for (std::chrono::milliseconds (50));
+
+    const auto start = std::chrono::steady_clock::now ();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_; ++t)
+        threads.push_back (std::thread (publish_run, node, t));
+    for (std::size_t t = 0; t < threads.size (); ++t)
+        threads[t].join ();
+    const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now () - start;
+
+    zlink_spot_sub_destroy (&sub);
+    zlink_spot_node_destroy (&node);
+    zlink_ctx_term (ctx);
+    return elapsed.count ();
+}
+
+int main ()
+{
+    const int thread_counts[] = {1, 2, 4, 8};
+    for (std::size_t i = 0; i < sizeof thread_counts / sizeof *thread_counts;
+         ++i) {
+        const int threads = thread_counts[i];
+        const double seconds = run (threads);
+        std::printf ("threads=%-2d  %10.0lf msg/s  total %.3lf s\n", threads,
+                     messages_per_thread * threads / seconds, seconds);
+    }
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
@@ -0,0 +1,189 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#if __cplusplus >= 201103L
+
+#include "core/timer_wheel.hpp"
+
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+
+//  Heartbeat timers of 100k connections. Every simulated millisecond a
+//  thousand connections see traffic and push their heartbeat timer back,
+//  and the timers that expire are scheduled again, as engines do.
+//
+//  - asio:  a steady_timer per connection, as engines had before; pushing
+//           a timer back cancels its wait and starts a new one.
+//  - map:   timers ordered in a std::multimap, as poller_base_t had,
+//           cancelled through a stored iterator.
+//  - wheel: timer_wheel_t with timers embedded in the connections.
+//
+//  asio runs on the real clock rather than the simulated one, so its
+//  timers expire at other times than those of map and wheel.
+
+const std::size_t connections = 100000;
+const int heartbeat_ivl = 1000;
+const int duration_ms = 5000;
+const std::size_t rearms_per_ms = 1000;
+
+typedef zlink::timer_wheel_t::timer_t wheel_timer_t;
+
+struct result_t
+{
+    double seconds;
+    std::size_t rearms;
+    std::size_t expiries;
+};
+
+static std::vector<std::size_t> traffic_pattern ()
+{
+    std::mt19937 rng (42);
+    std::uniform_int_distribution<std::size_t> pick (0, connections - 1);
+    std::vector<std::size_t> pattern (duration_ms * rearms_per_ms);
+    for (std::size_t i = 0; i < pattern.size (); ++i)
+        pattern[i] = pick (rng);
+    return pattern;
+}
+
+static result_t run_wheel (const std::vector<std::size_t> &pattern_)
+{
+    static std::size_t expiries;
+    static zlink::timer_wheel_t *wheel;
+    static uint64_t now;
+
+    struct on_expiry
+    {
+        static void fire (wheel_timer_t *timer_)
+        {
+            ++expiries;
+            wheel->add (timer_, now + heartbeat_ivl);
+        }
+    };
+
+    now = 0;
+    expiries = 0;
+    zlink::timer_wheel_t w (now);
+    wheel = &w;
+    std::vector<wheel_timer_t> timers (connections);
+    for (std::size_t i = 0; i < connections; ++i) {
+        timers[i].callback = on_expiry::fire;
+        w.add (&timers[i], i % heartbeat_ivl);
+    }
+
+    const auto start = std::chrono::steady_clock::now ();
+    std::size_t next = 0;
+    for (int ms = 0; ms < duration_ms; ++ms) {
+        for (std::size_t i = 0; i < rearms_per_ms; ++i) {
+            wheel_timer_t *timer = &timers[pattern_[next++]];
+            w.cancel (timer);
+            w.add (timer, now + heartbeat_ivl);
+        }
+        w.advance (++now);
+    }
+    const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now () - start;
+    const result_t result = {elapsed.count (), pattern_.size (), expiries};
+    return result;
+}
+
+static result_t run_map (const std::vector<std::size_t> &pattern_)
+{
+    typedef std::multimap<uint64_t, std::size_t> timers_t;
+    timers_t timers;
+    std::vector<timers_t::iterator> handles (connections);
+    for (std::size_t i = 0; i < connections; ++i)
+        handles[i] = timers.insert (
+          timers_t::value_type (i % heartbeat_ivl, i));
+
+    uint64_t now = 0;
+    std::size_t expiries = 0;
+    const auto start = std::chrono::steady_clock::now ();
+    std::size_t next = 0;
+    for (int ms = 0; ms < duration_ms; ++ms) {
+        for (std::size_t i = 0; i < rearms_per_ms; ++i) {
+            const std::size_t conn = pattern_[next++];
+            timers.erase (handles[conn]);
+            handles[conn] = timers.insert (
+              timers_t::value_type (now + heartbeat_ivl, conn));
+        }
+        ++now;
+        while (!timers.empty () && timers.begin ()->first <= now) {
+            const std::size_t conn = timers.begin ()->second;
+            timers.erase (timers.begin ());
+            ++expiries;
+            handles[conn] = timers.insert (
+              timers_t::value_type (now + heartbeat_ivl, conn));
+        }
+    }
+    const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now () - start;
+    const result_t result = {elapsed.count (), pattern_.size (), expiries};
+    return result;
+}
+
+static result_t run_asio (const std::vector<std::size_t> &pattern_)
+{
+    boost::asio::io_context io_context;
+    std::vector<boost::asio::steady_timer *> timers (connections);
+    std::size_t expiries = 0;
+    const auto on_timer = [&expiries] (const boost::system::error_code &ec_) {
+        if (!ec_)
+            ++expiries;
+    };
+    for (std::size_t i = 0; i < connections; ++i) {
+        timers[i] = new boost::asio::steady_timer (io_context);
+        timers[i]->expires_after (std::chrono::milliseconds (heartbeat_ivl));
+        timers[i]->async_wait (on_timer);
+    }
+
+    const auto start = std::chrono::steady_clock::now ();
+    std::size_t next = 0;
+    for (int ms = 0; ms < duration_ms; ++ms) {
+        for (std::size_t i = 0; i < rearms_per_ms; ++i) {
+            boost::asio::steady_timer *timer = timers[pattern_[next++]];
+            timer->expires_after (std::chrono::milliseconds (heartbeat_ivl));
+            timer->async_wait (on_timer);
+        }
+        io_context.poll ();
+    }
+    const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now () - start;
+
+    for (std::size_t i = 0; i < connections; ++i)
+        delete timers[i];
+    io_context.poll ();
+
+    const result_t result = {elapsed.count (), pattern_.size (), expiries};
+    return result;
+}
+
+static void report (const char *name_, const result_t &result_)
+{
+    std::printf ("%-6s connections=%llu  %7.1lf ns/rearm  expiries=%llu  "
+                 "total %.3lf s\n",
+                 name_, static_cast<unsigned long long> (connections),
+                 result_.seconds * 1e9 / result_.rearms,
+                 static_cast<unsigned long long> (result_.expiries),
+                 result_.seconds);
+}
+
+int main ()
+{
+    const std::vector<std::size_t> pattern = traffic_pattern ();
+    report ("asio", run_asio (pattern));
+    report ("map", run_map (pattern));
+    report ("wheel", run_wheel (pattern));
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
@@ -165,6 +165,18 @@ int zlink_ctx_get (void *ctx_, int option_)
     return (static_cast<zlink::ctx_t *> (ctx_))->get (option_);
 }
 
+int zlink_ctx_io_thread_stats (void *ctx_,
+                               zlink_io_thread_stats_t *stats_,
+                               size_t *count_)
+{
+    if (!ctx_ || !(static_cast<zlink::ctx_t *> (ctx_))->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return (static_cast<zlink::ctx_t *> (ctx_))
+      ->io_thread_stats (stats_, count_);
+}
+
 // Sockets
 
 struct socket_handle_t
@@ -688,12 +700,20 @@ int zlink_discovery_destroy (void **discovery_p_)
 }
 
 void *zlink_gateway_new (void *ctx_, void *discovery_, const char *routing_id_)
+{
+    return zlink_gateway_new_sharded (ctx_, discovery_, routing_id_, 1);
+}
+
+void *zlink_gateway_new_sharded (void *ctx_,
+                                 void *discovery_,
+                                 const char *routing_id_,
+                                 int shards_)
 {
     if (!ctx_ || !(static_cast<zlink::ctx_t *> (ctx_))->check_tag ()) {
         errno = EFAULT;
         return NULL;
     }
-    if (!discovery_) {
+    if (!discovery_ || shards_ < 1) {
         errno = EINVAL;
         return NULL;
     }
@@ -704,7 +724,7 @@ void *zlink_gateway_new (void *ctx_, void *discovery_, const char *routing_id_)
     }
     zlink::gateway_t *gateway =
       new (std::nothrow) zlink::gateway_t (static_cast<zlink::ctx_t *> (ctx_),
-                                           disc, routing_id_);
+                                           disc, routing_id_, shards_);
     if (!gateway) {
         errno = ENOMEM;
         return NULL;
@@ -744,6 +764,35 @@ int zlink_gateway_recv (void *gateway_,
     return gateway->recv (parts_, part_count_, flags_, service_name_out_);
 }
 
+zlink_gateway_service_t *zlink_gateway_service (void *gateway_,
+                                                const char *service_name_)
+{
+    if (!gateway_)
+        return NULL;
+    zlink::gateway_t *gateway = static_cast<zlink::gateway_t *> (gateway_);
+    if (!gateway->check_tag ()) {
+        errno = EFAULT;
+        return NULL;
+    }
+    return gateway->service (service_name_);
+}
+
+int zlink_gateway_send_service (void *gateway_,
+                                zlink_gateway_service_t *service_,
+                                zlink_msg_t *parts_,
+                                size_t part_count_,
+                                int flags_)
+{
+    if (!gateway_)
+        return -1;
+    zlink::gateway_t *gateway = static_cast<zlink::gateway_t *> (gateway_);
+    if (!gateway->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return gateway->send_service (service_, parts_, part_count_, flags_);
+}
+
 int zlink_gateway_send_rid (void *gateway_,
                             const char *service_name_,
                             const zlink_routing_id_t *routing_id_,
@@ -762,6 +811,44 @@ int zlink_gateway_send_rid (void *gateway_,
                               flags_);
 }
 
+int zlink_gateway_send_keyed (void *gateway_,
+                              const char *service_name_,
+                              const void *key_,
+                              size_t key_len_,
+                              zlink_msg_t *parts_,
+                              size_t part_count_,
+                              int flags_)
+{
+    if (!gateway_)
+        return -1;
+    zlink::gateway_t *gateway = static_cast<zlink::gateway_t *> (gateway_);
+    if (!gateway->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return gateway->send_keyed (service_name_, key_, key_len_, parts_,
+                                part_count_, flags_);
+}
+
+int zlink_gateway_request_async (void *gateway_,
+                                 const char *service_name_,
+                                 zlink_msg_t *parts_,
+                                 size_t part_count_,
+                                 int timeout_ms_,
+                                 zlink_gateway_completion_fn *callback_,
+                                 void *userdata_)
+{
+    if (!gateway_)
+        return -1;
+    zlink::gateway_t *gateway = static_cast<zlink::gateway_t *> (gateway_);
+    if (!gateway->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return gateway->request_async (service_name_, parts_, part_count_,
+                                   timeout_ms_, callback_, userdata_);
+}
+
 int zlink_gateway_set_lb_strategy (void *gateway_,
                                    const char *service_name_,
                                    int strategy_)
@@ -776,6 +863,22 @@ int zlink_gateway_set_lb_strategy (void *gateway_,
     return gateway->set_lb_strategy (service_name_, strategy_);
 }
 
+int zlink_gateway_set_request_policy (void *gateway_,
+                                      const char *service_name_,
+                                      int hedge_budget_,
+                                      int max_retries_)
+{
+    if (!gateway_)
+        return -1;
+    zlink::gateway_t *gateway = static_cast<zlink::gateway_t *> (gateway_);
+    if (!gateway->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return gateway->set_request_policy (service_name_, hedge_budget_,
+                                        max_retries_);
+}
+
 int zlink_gateway_setsockopt (void *gateway_,
                               int option_,
                               const void *optval_,
@@ -1522,6 +1625,26 @@ int zlink_recv (void *s_, void *buf_, size_t len_, int flags_)
     return nbytes;
 }
 
+// Batched functions.
+
+int zlink_sendmmsg (void *s_, zlink_msg_t *msgs_, size_t count_, int flags_)
+{
+    socket_handle_t handle = as_socket_handle (s_);
+    if (!handle.socket)
+        return -1;
+    return handle.socket->send_batch (
+      reinterpret_cast<zlink::msg_t *> (msgs_), count_, flags_);
+}
+
+int zlink_recvmmsg (void *s_, zlink_msg_t *msgs_, size_t count_, int flags_)
+{
+    socket_handle_t handle = as_socket_handle (s_);
+    if (!handle.socket)
+        return -1;
+    return handle.socket->recv_batch (
+      reinterpret_cast<zlink::msg_t *> (msgs_), count_, flags_);
+}
+
 // Message manipulators.
 
 int zlink_msg_init (zlink_msg_t *msg_)
@@ -1848,6 +1971,10 @@ int zlink_has (const char *capability_)
     if (strcmp (capability_, zlink::protocol_name::ipc) == 0)
         return true;
 #endif
+#if defined(ZLINK_HAVE_SHM)
+    if (strcmp (capability_, zlink::protocol_name::shm) == 0)
+        return true;
+#endif
 #if defined(ZLINK_HAVE_TLS)
     if (strcmp (capability_, "tls") == 0)
         return true;
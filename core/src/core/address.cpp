@@ -33,7 +33,11 @@ zlink::address_t::~address_t ()
         LIBZLINK_DELETE (resolved.tcp_addr);
     }
 #if defined ZLINK_HAVE_IPC
-    else if (protocol == protocol_name::ipc) {
+    else if (protocol == protocol_name::ipc
+#if defined ZLINK_HAVE_SHM
+             || protocol == protocol_name::shm
+#endif
+    ) {
         LIBZLINK_DELETE (resolved.ipc_addr);
     }
 #endif
@@ -69,6 +73,15 @@ int zlink::address_t::to_string (std::string &addr_) const
     if (protocol == protocol_name::ipc && resolved.ipc_addr)
         return resolved.ipc_addr->to_string (addr_);
 #endif
+#if defined ZLINK_HAVE_SHM
+    //  shm:// endpoints are addressed like ipc:// ones.
+    if (protocol == protocol_name::shm && resolved.ipc_addr) {
+        const int rc = resolved.ipc_addr->to_string (addr_);
+        if (rc == 0 && addr_.compare (0, 6, "ipc://") == 0)
+            addr_.replace (0, 6, "shm://");
+        return rc;
+    }
+#endif
 
     if (!protocol.empty () && !address.empty ()) {
         std::stringstream s;
@@ -45,6 +45,9 @@ static const char epgm[] = "epgm";
 #if defined ZLINK_HAVE_IPC
 static const char ipc[] = "ipc";
 #endif
+#if defined ZLINK_HAVE_SHM
+static const char shm[] = "shm";
+#endif
 }
 
 struct address_t
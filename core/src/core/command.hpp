@@ -44,6 +44,7 @@ struct command_t
         reaped,
         inproc_connected,
         conn_failed,
+        migrated,
         done
     } type;
 
@@ -157,6 +158,12 @@ struct command_t
         {
         } reaped;
 
+        //  Sent by the I/O thread a session is moved away from to the one
+        //  it is moved to, ahead of any command it forwards to the session.
+        struct
+        {
+        } migrated;
+
         //  Sent by reaper thread to the term thread when all the sockets
         //  are successfully deallocated.
         struct
@@ -20,6 +20,7 @@
 #include "utils/err.hpp"
 #include "core/msg.hpp"
 #include "utils/random.hpp"
+#include "utils/allocator.hpp"
 
 #ifdef ZLINK_USE_NSS
 #include <nss.h>
@@ -51,7 +52,9 @@ zlink::ctx_t::ctx_t () :
     _max_msgsz (INT_MAX),
     _io_thread_count (ZLINK_IO_THREADS_DFLT),
     _blocky (true),
-    _ipv6 (false)
+    _ipv6 (false),
+    _io_uring (false),
+    _io_thread_balance (true)
 {
 #ifdef HAVE_FORK
     _pid = getpid ();
@@ -242,6 +245,27 @@ int zlink::ctx_t::set (int option_, const void *optval_, size_t optvallen_)
             }
             break;
 
+        case ZLINK_MSG_ALLOCATOR:
+            if (is_int && set_allocator (value) == 0)
+                return 0;
+            break;
+
+        case ZLINK_IO_URING:
+            if (is_int && value >= 0) {
+                scoped_lock_t locker (_opt_sync);
+                _io_uring = (value != 0);
+                return 0;
+            }
+            break;
+
+        case ZLINK_IO_THREAD_BALANCE:
+            if (is_int && value >= 0) {
+                scoped_lock_t locker (_opt_sync);
+                _io_thread_balance = (value != 0);
+                return 0;
+            }
+            break;
+
         default: {
             return thread_ctx_t::set (option_, optval_, optvallen_);
         }
@@ -312,6 +336,29 @@ int zlink::ctx_t::get (int option_, void *optval_, const size_t *optvallen_)
             }
             break;
 
+        case ZLINK_MSG_ALLOCATOR:
+            if (is_int) {
+                *value = get_allocator ();
+                return 0;
+            }
+            break;
+
+        case ZLINK_IO_URING:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _io_uring;
+                return 0;
+            }
+            break;
+
+        case ZLINK_IO_THREAD_BALANCE:
+            if (is_int) {
+                scoped_lock_t locker (_opt_sync);
+                *value = _io_thread_balance;
+                return 0;
+            }
+            break;
+
         default: {
             return thread_ctx_t::get (option_, optval_, optvallen_);
         }
@@ -599,22 +646,71 @@ zlink::io_thread_t *zlink::ctx_t::choose_io_thread (uint64_t affinity_)
     if (_io_threads.empty ())
         return NULL;
 
-    //  Find the I/O thread with minimum load.
-    int min_load = -1;
+    //  Find the I/O thread with minimum load: the least traffic, with
+    //  threads below io_thread_idle_load all counting as idle, then the
+    //  fewest sessions and the fewest registered file descriptors.
+    uint64_t min_traffic = 0;
+    int min_sessions = 0;
+    int min_load = 0;
     io_thread_t *selected_io_thread = NULL;
     for (io_threads_t::size_type i = 0, size = _io_threads.size (); i != size;
          i++) {
         if (!affinity_ || (affinity_ & (uint64_t (1) << i))) {
-            const int load = _io_threads[i]->get_load ();
-            if (selected_io_thread == NULL || load < min_load) {
+            io_thread_t *io_thread = _io_threads[i];
+            uint64_t traffic = io_thread->get_traffic_load ();
+            if (traffic < io_thread_idle_load)
+                traffic = 0;
+            const int sessions = io_thread->get_sessions ();
+            const int load = io_thread->get_load ();
+            if (selected_io_thread == NULL || traffic < min_traffic
+                || (traffic == min_traffic
+                    && (sessions < min_sessions
+                        || (sessions == min_sessions && load < min_load)))) {
+                min_traffic = traffic;
+                min_sessions = sessions;
                 min_load = load;
-                selected_io_thread = _io_threads[i];
+                selected_io_thread = io_thread;
             }
         }
     }
     return selected_io_thread;
 }
 
+int zlink::ctx_t::io_thread_stats (zlink_io_thread_stats_t *stats_,
+                                   size_t *count_)
+{
+    if (!count_) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    scoped_lock_t locker (_slot_sync);
+    const size_t available = _starting ? 0 : _io_threads.size ();
+    if (!stats_) {
+        *count_ = available;
+        return 0;
+    }
+
+    const size_t to_copy = *count_ < available ? *count_ : available;
+    for (size_t i = 0; i < to_copy; ++i) {
+        const io_thread_t *io_thread = _io_threads[i];
+        const poller_t *poller = io_thread->get_poller ();
+        zlink_io_thread_stats_t *stats = &stats_[i];
+        memset (stats, 0, sizeof (*stats));
+        stats->bytes_in = poller->get_traffic (poller_t::traffic_bytes_in);
+        stats->bytes_out = poller->get_traffic (poller_t::traffic_bytes_out);
+        stats->msgs_in = poller->get_traffic (poller_t::traffic_msgs_in);
+        stats->msgs_out = poller->get_traffic (poller_t::traffic_msgs_out);
+        stats->load = poller->get_traffic_load ();
+        stats->sessions = static_cast<uint32_t> (io_thread->get_sessions ());
+        stats->migrations =
+          static_cast<uint32_t> (io_thread->get_migrations ());
+    }
+
+    *count_ = to_copy;
+    return 0;
+}
+
 int zlink::ctx_t::register_endpoint (const char *addr_,
                                    const endpoint_t &endpoint_)
 {
@@ -16,6 +16,7 @@
 #include "core/options.hpp"
 #include "utils/atomic_counter.hpp"
 #include "core/thread.hpp"
+#include "zlink.h"
 
 namespace zlink
 {
@@ -104,6 +105,9 @@ class ctx_t ZLINK_FINAL : public thread_ctx_t
     //  Returns NULL if no I/O thread is available.
     zlink::io_thread_t *choose_io_thread (uint64_t affinity_);
 
+    //  Fills in the traffic figures of the I/O threads.
+    int io_thread_stats (zlink_io_thread_stats_t *stats_, size_t *count_);
+
     //  Returns reaper thread object.
     zlink::object_t *get_reaper () const;
 
@@ -208,6 +212,12 @@ class ctx_t ZLINK_FINAL : public thread_ctx_t
     //  Is IPv6 enabled on this context?
     bool _ipv6;
 
+    //  Do the I/O threads use io_uring where available?
+    bool _io_uring;
+
+    //  May I/O threads move connections between them?
+    bool _io_thread_balance;
+
     ZLINK_NON_COPYABLE_NOR_MOVABLE (ctx_t)
 
 #ifdef HAVE_FORK
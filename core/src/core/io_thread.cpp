@@ -8,15 +8,30 @@
 #include "core/io_thread.hpp"
 #include "utils/err.hpp"
 #include "core/ctx.hpp"
+#include "core/session_base.hpp"
+#include "engine/asio/io_uring_service.hpp"
+#include "utils/config.hpp"
+#include "utils/likely.hpp"
+
+#include <algorithm>
 
 zlink::io_thread_t::io_thread_t (ctx_t *ctx_, uint32_t tid_) :
-    object_t (ctx_, tid_)
+    object_t (ctx_, tid_),
+    _balance (ctx_->get (ZLINK_IO_THREAD_BALANCE) != 0),
+    _overloaded_samples (0),
+    _last_sample (_clock.now_ms ())
 {
     _poller = new (std::nothrow) poller_t (*ctx_);
     alloc_assert (_poller);
+#if defined ZLINK_IOTHREAD_POLLER_USE_ASIO && defined ZLINK_HAVE_IO_URING
+    //  Falls back to the reactor silently if the kernel is too old.
+    if (ctx_->get (ZLINK_IO_URING))
+        io_uring_service_t::install (_poller->get_io_context ());
+#endif
     _mailbox.set_io_context (&_poller->get_io_context (),
                              &io_thread_t::mailbox_handler, this, NULL);
     _mailbox.schedule_if_needed ();
+    _poller->add_timer (io_thread_sample_ivl, this, sample_timer_id);
 }
 
 zlink::io_thread_t::~io_thread_t ()
@@ -48,6 +63,49 @@ int zlink::io_thread_t::get_load () const
     return _poller->get_load ();
 }
 
+int zlink::io_thread_t::get_index () const
+{
+    return static_cast<int> (get_tid ()) - ctx_t::reaper_tid - 1;
+}
+
+uint64_t zlink::io_thread_t::get_traffic_load () const
+{
+    return _poller->get_traffic_load ();
+}
+
+void zlink::io_thread_t::adjust_sessions (int amount_)
+{
+    if (amount_ > 0)
+        _sessions.add (amount_);
+    else if (amount_ < 0)
+        _sessions.sub (-amount_);
+}
+
+int zlink::io_thread_t::get_sessions () const
+{
+    return _sessions.get ();
+}
+
+int zlink::io_thread_t::get_migrations () const
+{
+    return _migrations.get ();
+}
+
+void zlink::io_thread_t::add_session (session_base_t *session_)
+{
+    _session_list.push_back (session_);
+}
+
+void zlink::io_thread_t::remove_session (session_base_t *session_)
+{
+    const std::vector<session_base_t *>::iterator it =
+      std::find (_session_list.begin (), _session_list.end (), session_);
+    if (it == _session_list.end ())
+        return;
+    *it = _session_list.back ();
+    _session_list.pop_back ();
+}
+
 void zlink::io_thread_t::in_event ()
 {
     process_mailbox ();
@@ -63,8 +121,13 @@ void zlink::io_thread_t::process_mailbox ()
         int rc = _mailbox.recv (&cmd, 0);
 
         while (rc == 0 || errno == EINTR) {
-            if (rc == 0)
-                cmd.destination->process_command (cmd);
+            if (rc == 0) {
+                const uint32_t tid = cmd.destination->get_forward_tid ();
+                if (unlikely (tid != get_tid ()))
+                    get_ctx ()->send_command (tid, cmd);
+                else
+                    cmd.destination->process_command (cmd);
+            }
             rc = _mailbox.recv (&cmd, 0);
         }
 
@@ -78,10 +141,61 @@ void zlink::io_thread_t::out_event ()
     zlink_assert (false);
 }
 
-void zlink::io_thread_t::timer_event (int)
+void zlink::io_thread_t::timer_event (int id_)
 {
-    //  No timers here. This function is never called.
-    zlink_assert (false);
+    zlink_assert (id_ == sample_timer_id);
+
+    const uint64_t now = _clock.now_ms ();
+    const uint64_t interval = now - _last_sample;
+    _last_sample = now;
+
+    for (size_t i = 0, size = _session_list.size (); i != size; ++i)
+        _session_list[i]->sample_traffic (interval);
+    _poller->sample_traffic (interval);
+
+    if (_balance)
+        balance ();
+
+    _poller->add_timer (io_thread_sample_ivl, this, sample_timer_id);
+}
+
+void zlink::io_thread_t::balance ()
+{
+    io_thread_t *target = get_ctx ()->choose_io_thread (0);
+    const uint64_t load = get_traffic_load ();
+    const uint64_t target_load = target->get_traffic_load ();
+    if (target == this || load < io_thread_balance_min_load
+        || load < 2 * target_load) {
+        _overloaded_samples = 0;
+        return;
+    }
+    if (++_overloaded_samples < io_thread_balance_samples)
+        return;
+    _overloaded_samples = 0;
+
+    //  Moving a session with load x leaves the threads load - x and
+    //  target_load + x apart, so the best session to move carries
+    //  closest to half the difference. One carrying the whole difference
+    //  or more would only swap the roles of the threads.
+    const uint64_t gap = load - target_load;
+    session_base_t *best = NULL;
+    uint64_t best_distance = gap / 2;
+    for (size_t i = 0, size = _session_list.size (); i != size; ++i) {
+        session_base_t *session = _session_list[i];
+        const uint64_t session_load = session->get_traffic_load ();
+        if (session_load == 0 || session_load >= gap)
+            continue;
+        const uint64_t distance = session_load > gap / 2
+                                    ? session_load - gap / 2
+                                    : gap / 2 - session_load;
+        if (distance < best_distance && session->can_migrate (target)) {
+            best = session;
+            best_distance = distance;
+        }
+    }
+
+    if (best && best->migrate (target))
+        _migrations.add (1);
 }
 
 zlink::poller_t *zlink::io_thread_t::get_poller () const
@@ -3,6 +3,10 @@
 #ifndef __ZLINK_IO_THREAD_HPP_INCLUDED__
 #define __ZLINK_IO_THREAD_HPP_INCLUDED__
 
+#include <vector>
+
+#include "utils/atomic_counter.hpp"
+#include "utils/clock.hpp"
 #include "utils/stdint.hpp"
 #include "core/object.hpp"
 #include "core/poller.hpp"
@@ -14,6 +18,7 @@
 namespace zlink
 {
 class ctx_t;
+class session_base_t;
 
 //  Generic part of the I/O thread. Polling-mechanism-specific features
 //  are implemented in separate "polling objects".
@@ -53,6 +58,27 @@ class io_thread_t ZLINK_FINAL : public object_t, public i_poll_events
     //  Returns load experienced by the I/O thread.
     int get_load () const;
 
+    //  Position of the thread among the I/O threads of the context, as
+    //  used by ZLINK_AFFINITY.
+    int get_index () const;
+
+    //  Returns the traffic load measured by the poller.
+    uint64_t get_traffic_load () const;
+
+    //  Number of sessions living in the thread. Adjusted by the sessions
+    //  as they are created, destroyed or moved; may be called from any
+    //  thread.
+    void adjust_sessions (int amount_);
+    int get_sessions () const;
+
+    //  Number of sessions moved away to other I/O threads.
+    int get_migrations () const;
+
+    //  Sessions the thread measures traffic for and may move to other
+    //  threads. Called from the I/O thread only.
+    void add_session (session_base_t *session_);
+    void remove_session (session_base_t *session_);
+
   private:
     //  I/O thread accesses incoming commands via this mailbox.
     mailbox_t _mailbox;
@@ -63,6 +89,31 @@ class io_thread_t ZLINK_FINAL : public object_t, public i_poll_events
     static void mailbox_handler (void *arg_);
     void process_mailbox ();
 
+    //  Moves a session to the least loaded I/O thread if this one has
+    //  been much busier for a while.
+    void balance ();
+
+    enum
+    {
+        sample_timer_id = 0x40
+    };
+
+    //  Sessions running in the thread, and their number including the
+    //  ones not plugged yet.
+    std::vector<session_base_t *> _session_list;
+    atomic_counter_t _sessions;
+
+    atomic_counter_t _migrations;
+
+    //  True if sessions may be moved to other threads.
+    const bool _balance;
+
+    //  Intervals in a row this thread has been overloaded.
+    int _overloaded_samples;
+
+    clock_t _clock;
+    uint64_t _last_sample;
+
     ZLINK_NON_COPYABLE_NOR_MOVABLE (io_thread_t)
 };
 }
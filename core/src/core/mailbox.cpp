@@ -24,8 +24,8 @@ zlink::mailbox_t::~mailbox_t ()
 {
     //  TODO: Retrieve and deallocate commands inside the _cpipe.
 
-    // Work around problem that other threads might still be in our
-    // send() method, by waiting on the mutex before disappearing.
+    // Work around problem that other threads might still be waking us up
+    // in our send() method, by waiting on the mutex before disappearing.
     _sync.lock ();
     _sync.unlock ();
 }
@@ -37,23 +37,20 @@ zlink::fd_t zlink::mailbox_t::get_fd () const
 
 void zlink::mailbox_t::send (const command_t &cmd_)
 {
+    if (_cpipe.write (cmd_))
+        return;
+
     _sync.lock ();
-    _cpipe.write (cmd_, false);
-    const bool ok = _cpipe.flush ();
-    if (!ok) {
-        // Signal all registered signalers for ZLINK_FD support
-        for (std::vector<signaler_t *>::iterator it = _signalers.begin (),
-                                                 end = _signalers.end ();
-             it != end; ++it) {
-            (*it)->send ();
-        }
+    // Signal all registered signalers for ZLINK_FD support
+    for (std::vector<signaler_t *>::iterator it = _signalers.begin (),
+                                             end = _signalers.end ();
+         it != end; ++it) {
+        (*it)->send ();
     }
     _sync.unlock ();
 
-    if (!ok) {
-        _signaler.send ();
-        schedule_if_needed ();
-    }
+    _signaler.send ();
+    schedule_if_needed ();
 }
 
 int zlink::mailbox_t::recv (command_t *cmd_, int timeout_)
@@ -7,7 +7,7 @@
 
 #include "utils/config.hpp"
 #include "core/command.hpp"
-#include "core/ypipe.hpp"
+#include "core/ypipe_mpsc.hpp"
 #include "utils/mutex.hpp"
 #include "core/i_mailbox.hpp"
 #include "core/signaler.hpp"
@@ -64,18 +64,19 @@ class mailbox_t ZLINK_FINAL : public i_mailbox
 #endif
 
   private:
-    //  The pipe to store actual commands.
-    typedef ypipe_t<command_t, command_pipe_granularity> cpipe_t;
+    //  The pipe to store actual commands. There's only one thread
+    //  receiving from the mailbox, but there is arbitrary number of
+    //  threads sending, which the pipe allows without locking.
+    typedef ypipe_mpsc_t<command_t, command_pipe_size, command_pipe_granularity>
+      cpipe_t;
     cpipe_t _cpipe;
 
     //  Signaler to wake up a sleeping receiver.
     signaler_t _signaler;
     bool _active;
 
-    //  There's only one thread receiving from the mailbox, but there
-    //  is arbitrary number of threads sending. Given that ypipe requires
-    //  synchronised access on both of its endpoints, we have to synchronise
-    //  the sending side.
+    //  Guards the ZLINK_FD signalers, which senders notify when they wake
+    //  the receiver up.
     mutex_t _sync;
 
     boost::asio::io_context *_io_context;
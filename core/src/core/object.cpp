@@ -12,12 +12,15 @@
 #include "core/session_base.hpp"
 #include "sockets/socket_base.hpp"
 
-zlink::object_t::object_t (ctx_t *ctx_, uint32_t tid_) : _ctx (ctx_), _tid (tid_)
+zlink::object_t::object_t (ctx_t *ctx_, uint32_t tid_) :
+    _ctx (ctx_), _tid (tid_), _forward_tid (tid_)
 {
 }
 
 zlink::object_t::object_t (object_t *parent_) :
-    _ctx (parent_->_ctx), _tid (parent_->_tid)
+    _ctx (parent_->_ctx),
+    _tid (parent_->_tid),
+    _forward_tid (parent_->_forward_tid)
 {
 }
 
@@ -33,6 +36,17 @@ uint32_t zlink::object_t::get_tid () const
 void zlink::object_t::set_tid (uint32_t id_)
 {
     _tid = id_;
+    _forward_tid = id_;
+}
+
+uint32_t zlink::object_t::get_forward_tid () const
+{
+    return _forward_tid;
+}
+
+void zlink::object_t::set_forward_tid (uint32_t id_)
+{
+    _forward_tid = id_;
 }
 
 zlink::ctx_t *zlink::object_t::get_ctx () const
@@ -124,6 +138,10 @@ void zlink::object_t::process_command (const command_t &cmd_)
             process_conn_failed ();
             break;
 
+        case command_t::migrated:
+            process_migrated ();
+            break;
+
         case command_t::done:
         default:
             zlink_assert (false);
@@ -228,6 +246,16 @@ void zlink::object_t::send_conn_failed (session_base_t *destination_)
     send_command (cmd);
 }
 
+void zlink::object_t::send_migrated (session_base_t *destination_)
+{
+    //  Sent straight to the thread the session runs in now, so that it
+    //  gets there before any command forwarded to the session.
+    command_t cmd;
+    cmd.destination = destination_;
+    cmd.type = command_t::migrated;
+    _ctx->send_command (destination_->get_forward_tid (), cmd);
+}
+
 void zlink::object_t::send_bind (own_t *destination_,
                                pipe_t *pipe_,
                                bool inc_seqnum_)
@@ -461,6 +489,11 @@ void zlink::object_t::process_conn_failed ()
     zlink_assert (false);
 }
 
+void zlink::object_t::process_migrated ()
+{
+    zlink_assert (false);
+}
+
 void zlink::object_t::send_command (const command_t &cmd_)
 {
     _ctx->send_command (cmd_.destination->get_tid (), cmd_);
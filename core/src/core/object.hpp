@@ -34,6 +34,12 @@ class object_t
 
     uint32_t get_tid () const;
     void set_tid (uint32_t id_);
+
+    //  Objects moved to another I/O thread keep their thread ID, so that
+    //  the commands sent to them arrive in order; the thread they were
+    //  moved away from passes the commands on to the forward thread.
+    uint32_t get_forward_tid () const;
+    void set_forward_tid (uint32_t id_);
     ctx_t *get_ctx () const;
     void process_command (const zlink::command_t &cmd_);
     void send_inproc_connected (zlink::socket_base_t *socket_);
@@ -83,7 +89,7 @@ class object_t
     void send_reaped ();
     void send_done ();
     void send_conn_failed (zlink::session_base_t *destination_);
-
+    void send_migrated (zlink::session_base_t *destination_);
 
     //  These handlers can be overridden by the derived objects. They are
     //  called when command arrives from another thread.
@@ -105,7 +111,7 @@ class object_t
     virtual void process_reap (zlink::socket_base_t *socket_);
     virtual void process_reaped ();
     virtual void process_conn_failed ();
-
+    virtual void process_migrated ();
 
     //  Special handler called after a command that requires a seqnum
     //  was processed. The implementation should catch up with its counter
@@ -119,6 +125,9 @@ class object_t
     //  Thread ID of the thread the object belongs to.
     uint32_t _tid;
 
+    //  Thread ID of the thread the object runs in.
+    uint32_t _forward_tid;
+
     void send_command (const command_t &cmd_);
 
     ZLINK_NON_COPYABLE_NOR_MOVABLE (object_t)
@@ -179,6 +179,7 @@ zlink::options_t::options_t () :
     heartbeat_timeout (-1),
     use_fd (-1),
     in_batch_size (8192),
+    in_batch_max (262144),
     out_batch_size (8192),
     zero_copy (true),
     monitor_event_version (1),
@@ -407,6 +408,13 @@ int zlink::options_t::setsockopt (int option_,
             return do_setsockopt_int_as_bool_strict (optval_, optvallen_,
                                                      &zmp_metadata);
 
+        case ZLINK_IN_BATCH_MAX:
+            if (is_int && value >= 0) {
+                in_batch_max = value;
+                return 0;
+            }
+            break;
+
         case ZLINK_HEARTBEAT_IVL:
             if (is_int && value >= 0) {
                 heartbeat_interval = value;
@@ -728,6 +736,13 @@ int zlink::options_t::getsockopt (int option_,
             }
             break;
 
+        case ZLINK_IN_BATCH_MAX:
+            if (is_int) {
+                *value = in_batch_max;
+                return 0;
+            }
+            break;
+
         case ZLINK_HEARTBEAT_IVL:
             if (is_int) {
                 *value = heartbeat_interval;
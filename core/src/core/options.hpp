@@ -187,6 +187,10 @@ struct options_t
     //  them may be read by a single 'recv' system call, thus avoiding
     //  unnecessary network stack traversals.
     int in_batch_size;
+    //  Upper bound for the receive buffer of stream engines. The buffer
+    //  starts at in_batch_size and grows towards this size while reads
+    //  keep filling it; a value not above in_batch_size keeps it fixed.
+    int in_batch_max;
     //  Maximal batching size for engines with sending functionality.
     //  So, if there are 10 messages that fit into the batch size, all of
     //  them may be written by a single 'send' system call, thus avoiding
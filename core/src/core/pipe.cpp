@@ -94,6 +94,8 @@ zlink::pipe_t::pipe_t (object_t *parent_,
     _peers_msgs_read (0),
     _peer (NULL),
     _sink (NULL),
+    _flush_batch (NULL),
+    _flush_deferred (false),
     _state (active),
     _delay (true),
     _server_socket_routing_id (0),
@@ -279,10 +281,43 @@ void zlink::pipe_t::flush ()
     if (_state == term_ack_sent)
         return;
 
+    if (_flush_batch && _flush_batch->_active && _state == active) {
+        if (!_flush_deferred) {
+            _flush_deferred = true;
+            _flush_batch->_pipes.push_back (this);
+        }
+        return;
+    }
+
     if (_out_pipe && !_out_pipe->flush ())
         send_activate_read (_peer);
 }
 
+void zlink::pipe_t::set_flush_batch (pipe_flush_batch_t *batch_)
+{
+    _flush_batch = batch_;
+}
+
+zlink::pipe_flush_batch_t::pipe_flush_batch_t () : _active (false)
+{
+}
+
+void zlink::pipe_flush_batch_t::begin ()
+{
+    _active = true;
+}
+
+void zlink::pipe_flush_batch_t::end ()
+{
+    _active = false;
+    for (std::vector<pipe_t *>::size_type i = 0, size = _pipes.size ();
+         i != size; ++i) {
+        _pipes[i]->_flush_deferred = false;
+        _pipes[i]->flush ();
+    }
+    _pipes.clear ();
+}
+
 void zlink::pipe_t::process_activate_read ()
 {
     if (!_in_active && (_state == active || _state == waiting_for_delimiter)) {
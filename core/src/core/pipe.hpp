@@ -13,6 +13,8 @@
 #include "core/endpoint.hpp"
 #include "core/msg.hpp"
 
+#include <vector>
+
 namespace zlink
 {
 class pipe_t;
@@ -40,6 +42,30 @@ struct i_pipe_events
     virtual void pipe_terminated (zlink::pipe_t *pipe_) = 0;
 };
 
+//  Collects the pipes whose flush was postponed while a socket writes a
+//  batch of messages, so that each pipe is flushed (and its reader woken
+//  up) once per batch rather than once per message. Only flushes of active
+//  pipes are deferred; termination traffic is always flushed immediately.
+class pipe_flush_batch_t
+{
+  public:
+    pipe_flush_batch_t ();
+
+    void begin ();
+
+    //  Flushes every deferred pipe and leaves batch mode. Must be called
+    //  before the owning socket processes commands again.
+    void end ();
+
+  private:
+    friend class pipe_t;
+
+    bool _active;
+    std::vector<pipe_t *> _pipes;
+
+    ZLINK_NON_COPYABLE_NOR_MOVABLE (pipe_flush_batch_t)
+};
+
 //  Note that pipe can be stored in three different arrays.
 //  The array of inbound pipes (1), the array of outbound pipes (2) and
 //  the generic array of pipes to be deallocated (3).
@@ -55,6 +81,9 @@ class pipe_t ZLINK_FINAL : public object_t,
                          const int hwms_[2],
                          const bool conflate_[2]);
 
+    //  The flush batch resets deferred flushes when it completes.
+    friend class pipe_flush_batch_t;
+
   public:
     //  Specifies the object to send events to.
     void set_event_sink (i_pipe_events *sink_);
@@ -93,6 +122,10 @@ class pipe_t ZLINK_FINAL : public object_t,
     //  Flush the messages downstream.
     void flush ();
 
+    //  Batch that collects flushes issued while it is active. NULL means
+    //  every flush goes downstream immediately.
+    void set_flush_batch (pipe_flush_batch_t *batch_);
+
     //  Temporarily disconnects the inbound message stream and drops
     //  all the messages on the fly. Causes 'hiccuped' event to be generated
     //  in the peer.
@@ -191,6 +224,11 @@ class pipe_t ZLINK_FINAL : public object_t,
     //  Sink to send events to.
     i_pipe_events *_sink;
 
+    //  Flush batch of the owning socket and whether this pipe is already
+    //  queued on it.
+    pipe_flush_batch_t *_flush_batch;
+    bool _flush_deferred;
+
     //  States of the pipe endpoint:
     //  active: common state before any termination begins,
     //  delimiter_received: delimiter was read from pipe before
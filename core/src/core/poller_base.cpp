@@ -3,12 +3,32 @@
 #include "utils/precompiled.hpp"
 #include "core/poller_base.hpp"
 #include "core/i_poll_events.hpp"
+#include "utils/config.hpp"
 #include "utils/err.hpp"
 
+#include <new>
+
+zlink::poller_base_t::poller_base_t () :
+    _wheel (_clock.now_ms ()),
+    _wakeup (0),
+    _executing_timers (false),
+    _traffic_load (0)
+{
+    for (int i = 0; i != traffic_counters; ++i) {
+        _interval_traffic[i] = 0;
+        _traffic[i].store (0, std::memory_order_relaxed);
+    }
+}
+
 zlink::poller_base_t::~poller_base_t ()
 {
     //  Make sure there is no more load on the shutdown.
     zlink_assert (get_load () == 0);
+
+    for (sink_timers_t::iterator it = _sink_timers.begin (),
+                                 end = _sink_timers.end ();
+         it != end; ++it)
+        delete it->second;
 }
 
 int zlink::poller_base_t::get_load () const
@@ -16,6 +36,48 @@ int zlink::poller_base_t::get_load () const
     return _load.get ();
 }
 
+uint64_t zlink::poller_base_t::get_traffic_load () const
+{
+    return _traffic_load.load (std::memory_order_relaxed);
+}
+
+void zlink::poller_base_t::add_traffic (const traffic_t &traffic_)
+{
+    for (int i = 0; i != traffic_counters; ++i)
+        _interval_traffic[i] += traffic_[i];
+}
+
+void zlink::poller_base_t::sample_traffic (uint64_t interval_ms_)
+{
+    for (int i = 0; i != traffic_counters; ++i)
+        _traffic[i].store (_traffic[i].load (std::memory_order_relaxed)
+                             + _interval_traffic[i],
+                           std::memory_order_relaxed);
+    _traffic_load.store (traffic_load (_interval_traffic, interval_ms_,
+                                       get_traffic_load ()),
+                         std::memory_order_relaxed);
+    for (int i = 0; i != traffic_counters; ++i)
+        _interval_traffic[i] = 0;
+}
+
+uint64_t zlink::poller_base_t::get_traffic (int counter_) const
+{
+    zlink_assert (counter_ >= 0 && counter_ < traffic_counters);
+    return _traffic[counter_].load (std::memory_order_relaxed);
+}
+
+uint64_t zlink::poller_base_t::traffic_load (const traffic_t &traffic_,
+                                             uint64_t interval_ms_,
+                                             uint64_t load_)
+{
+    const uint64_t units =
+      traffic_[traffic_bytes_in] + traffic_[traffic_bytes_out]
+      + (traffic_[traffic_msgs_in] + traffic_[traffic_msgs_out])
+          * io_thread_msg_cost;
+    const uint64_t rate = interval_ms_ ? units * 1000 / interval_ms_ : 0;
+    return (load_ + rate) / 2;
+}
+
 void zlink::poller_base_t::adjust_load (int amount_)
 {
     if (amount_ > 0)
@@ -26,18 +88,25 @@ void zlink::poller_base_t::adjust_load (int amount_)
 
 void zlink::poller_base_t::add_timer (int timeout_, i_poll_events *sink_, int id_)
 {
-    uint64_t expiration = _clock.now_ms () + timeout_;
-    timer_info_t info = {sink_, id_};
-    _timers.insert (timers_t::value_type (expiration, info));
+    sink_timer_t *timer = new (std::nothrow) sink_timer_t;
+    alloc_assert (timer);
+    timer->callback = sink_timer_expired;
+    timer->id = id_;
+    timer->poller = this;
+    timer->sink = sink_;
+    _sink_timers.insert (sink_timers_t::value_type (sink_, timer));
+    schedule (timer, timeout_);
 }
 
 void zlink::poller_base_t::cancel_timer (i_poll_events *sink_, int id_)
 {
-    //  Complexity of this operation is O(n). We assume it is rarely used.
-    for (timers_t::iterator it = _timers.begin (), end = _timers.end ();
-         it != end; ++it)
-        if (it->second.sink == sink_ && it->second.id == id_) {
-            _timers.erase (it);
+    std::pair<sink_timers_t::iterator, sink_timers_t::iterator> range =
+      _sink_timers.equal_range (sink_);
+    for (sink_timers_t::iterator it = range.first; it != range.second; ++it)
+        if (it->second->id == id_) {
+            _wheel.cancel (it->second);
+            delete it->second;
+            _sink_timers.erase (it);
             return;
         }
 
@@ -51,43 +120,78 @@ void zlink::poller_base_t::cancel_timer (i_poll_events *sink_, int id_)
     //  As soon as that is resolved an 'assert (false)' should be put here.
 }
 
-uint64_t zlink::poller_base_t::execute_timers ()
+void zlink::poller_base_t::add_timer (timer_wheel_t::timer_t *timer_,
+                                      int timeout_)
 {
-    //  Fast track.
-    if (_timers.empty ())
-        return 0;
+    schedule (timer_, timeout_);
+}
 
-    //  Get the current time.
-    const uint64_t current = _clock.now_ms ();
+void zlink::poller_base_t::cancel_timer (timer_wheel_t::timer_t *timer_)
+{
+    _wheel.cancel (timer_);
+}
 
-    //  Execute the timers that are already due.
-    uint64_t res = 0;
-    timer_info_t timer_temp;
-    timers_t::iterator it;
+uint64_t
+zlink::poller_base_t::timer_remaining (const timer_wheel_t::timer_t *timer_)
+{
+    if (!timer_->active ())
+        return 0;
+    const uint64_t current = _clock.now_ms ();
+    return timer_->expiry () > current ? timer_->expiry () - current : 0;
+}
 
-    do {
-        it = _timers.begin ();
+void zlink::poller_base_t::schedule (timer_wheel_t::timer_t *timer_,
+                                     int timeout_)
+{
+    const uint64_t current = _clock.now_ms ();
+    const uint64_t expiration = current + timeout_;
+    _wheel.add (timer_, expiration);
+
+    //  Pull the wake up forward if the new timer is the earliest one.
+    if (!_executing_timers && (_wakeup == 0 || expiration < _wakeup)) {
+        _wakeup = expiration;
+        timers_rescheduled (timeout_ > 0 ? timeout_ : 0);
+    }
+}
 
-        //  If we have to wait to execute the item, same will be true for
-        //  all the following items because multimap is sorted. Thus we can
-        //  stop checking the subsequent timers.
-        if (it->first > current) {
-            res = it->first - current;
+void zlink::poller_base_t::sink_timer_expired (timer_wheel_t::timer_t *timer_)
+{
+    sink_timer_t *timer = static_cast<sink_timer_t *> (timer_);
+    poller_base_t *poller = timer->poller;
+    i_poll_events *sink = timer->sink;
+    const int id = timer->id;
+
+    std::pair<sink_timers_t::iterator, sink_timers_t::iterator> range =
+      poller->_sink_timers.equal_range (sink);
+    for (sink_timers_t::iterator it = range.first; it != range.second; ++it)
+        if (it->second == timer) {
+            poller->_sink_timers.erase (it);
             break;
         }
+    delete timer;
 
-        //  Save and remove the timer because timer_event() call might delete
-        //  exactly this timer and then the iterator will be invalid.
-        timer_temp = it->second;
-        _timers.erase (it);
+    //  Trigger the timer.
+    sink->timer_event (id);
+}
 
-        //  Trigger the timer.
-        timer_temp.sink->timer_event (timer_temp.id);
+uint64_t zlink::poller_base_t::execute_timers ()
+{
+    //  Fast track.
+    if (!_wheel.size ()) {
+        _wakeup = 0;
+        return 0;
+    }
 
-    } while (!_timers.empty ());
+    //  Execute the timers that are already due. Timers added meanwhile are
+    //  accounted for by the wheel itself.
+    const uint64_t current = _clock.now_ms ();
+    _executing_timers = true;
+    const uint64_t res = _wheel.advance (current);
+    _executing_timers = false;
 
     //  Return the time to wait for the next timer (at least 1ms), or 0, if
     //  there are no more timers.
+    _wakeup = res ? current + res : 0;
     return res;
 }
 
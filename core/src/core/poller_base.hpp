@@ -3,11 +3,13 @@
 #ifndef __ZLINK_POLLER_BASE_HPP_INCLUDED__
 #define __ZLINK_POLLER_BASE_HPP_INCLUDED__
 
-#include <map>
+#include <atomic>
+#include <unordered_map>
 
 #include "utils/clock.hpp"
 #include "utils/atomic_counter.hpp"
 #include "core/ctx.hpp"
+#include "core/timer_wheel.hpp"
 
 namespace zlink
 {
@@ -25,6 +27,10 @@ struct i_poll_events;
 //   Returns load of the poller.
 // int get_load() const;
 //
+//   Returns the traffic the poller's thread has handled per second,
+//   measured as described at poller_base_t::sample_traffic.
+// uint64_t get_traffic_load() const;
+//
 //   Add a timeout to expire in timeout_ milliseconds. After the
 //   expiration, timer_event on sink_ object will be called with
 //   argument set to id_.
@@ -67,7 +73,7 @@ struct i_poll_events;
 // Most of the methods may only be called from a zlink::i_poll_events callback
 // function when invoked by the poller (and, therefore, typically from the
 // poller's worker thread), with the following exceptions:
-// - get_load may be called from outside
+// - get_load, get_traffic_load and get_traffic may be called from outside
 // - add_fd and add_timer may be called from outside before start
 // - start may be called from outside once
 //
@@ -95,14 +101,56 @@ struct i_poll_events;
 class poller_base_t
 {
   public:
-    poller_base_t () ZLINK_DEFAULT;
+    poller_base_t ();
     virtual ~poller_base_t ();
 
     // Methods from the poller concept.
     int get_load () const;
+    uint64_t get_traffic_load () const;
     void add_timer (int timeout_, zlink::i_poll_events *sink_, int id_);
     void cancel_timer (zlink::i_poll_events *sink_, int id_);
 
+    //  Schedules a timer owned by the caller, e.g. embedded in an engine,
+    //  to expire in timeout_ milliseconds. Unlike the sink based timers
+    //  this does not allocate. Called from the worker thread only.
+    void add_timer (timer_wheel_t::timer_t *timer_, int timeout_);
+    void cancel_timer (timer_wheel_t::timer_t *timer_);
+
+    //  Returns the number of milliseconds until timer_ expires, 0 if it
+    //  is due or not scheduled.
+    uint64_t timer_remaining (const timer_wheel_t::timer_t *timer_);
+
+    //  Traffic handled by the worker thread: bytes read and written by
+    //  its engines and messages passed to and from its sessions.
+    enum
+    {
+        traffic_bytes_in,
+        traffic_bytes_out,
+        traffic_msgs_in,
+        traffic_msgs_out,
+        traffic_counters
+    };
+    typedef uint64_t traffic_t[traffic_counters];
+
+    //  Adds traffic handled during the current interval. Called from the
+    //  worker thread only.
+    void add_traffic (const traffic_t &traffic_);
+
+    //  Ends the current interval, interval_ms_ milliseconds long, and
+    //  updates the traffic load: bytes per second with every message
+    //  counted as io_thread_msg_cost bytes, averaged over the last few
+    //  intervals. Called from the worker thread only.
+    void sample_traffic (uint64_t interval_ms_);
+
+    //  Returns one of the traffic counters, as of the last interval.
+    uint64_t get_traffic (int counter_) const;
+
+    //  Returns the load traffic_ amounts to over interval_ms_,
+    //  averaged with the previous load_.
+    static uint64_t traffic_load (const traffic_t &traffic_,
+                                  uint64_t interval_ms_,
+                                  uint64_t load_);
+
   protected:
     //  Called by individual poller implementations to manage the load.
     void adjust_load (int amount_);
@@ -111,23 +159,55 @@ class poller_base_t
     //  to wait to match the next timer or 0 meaning "no timers".
     uint64_t execute_timers ();
 
+    //  Called when a timer is added that expires before the poller would
+    //  otherwise call execute_timers again, timeout_ milliseconds from
+    //  now. Pollers that sleep until the next timer must wake up by then.
+    virtual void timers_rescheduled (uint64_t timeout_)
+    {
+        LIBZLINK_UNUSED (timeout_);
+    }
+
   private:
+    //  Schedules timer_ on the wheel and wakes up the poller if needed.
+    void schedule (timer_wheel_t::timer_t *timer_, int timeout_);
+
+    //  Callback of the sink based timers.
+    static void sink_timer_expired (timer_wheel_t::timer_t *timer_);
+
     //  Clock instance private to this I/O thread.
     clock_t _clock;
 
-    //  List of active timers.
-    struct timer_info_t
+    //  All timers of the thread, scheduled in O(1).
+    timer_wheel_t _wheel;
+
+    //  Time, on _clock, at which execute_timers is to be called next, or
+    //  0 if no timer is scheduled.
+    uint64_t _wakeup;
+
+    //  Set while execute_timers runs; it works out the wake up time
+    //  itself once the due timers were executed.
+    bool _executing_timers;
+
+    //  Timers added with a sink, looked up by the sink on cancellation.
+    struct sink_timer_t : timer_wheel_t::timer_t
     {
+        poller_base_t *poller;
         zlink::i_poll_events *sink;
-        int id;
     };
-    typedef std::multimap<uint64_t, timer_info_t> timers_t;
-    timers_t _timers;
+    typedef std::unordered_multimap<zlink::i_poll_events *, sink_timer_t *>
+      sink_timers_t;
+    sink_timers_t _sink_timers;
 
     //  Load of the poller. Currently the number of file descriptors
     //  registered.
     atomic_counter_t _load;
 
+    //  Traffic of the current interval, and the totals and load as of
+    //  the last one.
+    traffic_t _interval_traffic;
+    std::atomic<uint64_t> _traffic[traffic_counters];
+    std::atomic<uint64_t> _traffic_load;
+
     ZLINK_NON_COPYABLE_NOR_MOVABLE (poller_base_t)
 };
 
@@ -8,6 +8,7 @@
 #include "core/pipe.hpp"
 #include "utils/likely.hpp"
 #include "core/address.hpp"
+#include "core/io_thread.hpp"
 
 // ASIO-only build: Transport connecters are always included
 #include "transports/tcp/asio_tcp_connecter.hpp"
@@ -72,8 +73,11 @@ zlink::session_base_t::session_base_t (class io_thread_t *io_thread_,
     _pending_peer_routing_id_valid (false),
     _io_thread (io_thread_),
     _has_linger_timer (false),
-    _addr (addr_)
+    _addr (addr_),
+    _traffic_load (0)
 {
+    memset (_traffic, 0, sizeof _traffic);
+    _io_thread->adjust_sessions (1);
 }
 
 const zlink::endpoint_uri_pair_t &zlink::session_base_t::get_endpoint () const
@@ -120,6 +124,10 @@ zlink::session_base_t::~session_base_t ()
     if (_engine)
         _engine->terminate ();
 
+    flush_traffic ();
+    _io_thread->remove_session (this);
+    _io_thread->adjust_sessions (-1);
+
     LIBZLINK_DELETE (_addr);
 }
 
@@ -140,6 +148,7 @@ int zlink::session_base_t::pull_msg (msg_t *msg_)
     }
 
     _incomplete_in = (msg_->flags () & msg_t::more) != 0;
+    ++_traffic[poller_t::traffic_msgs_out];
 
     return 0;
 }
@@ -153,6 +162,7 @@ int zlink::session_base_t::push_msg (msg_t *msg_)
     if (_pipe && _pipe->write (msg_)) {
         const int rc = msg_->init ();
         errno_assert (rc == 0);
+        ++_traffic[poller_t::traffic_msgs_in];
         return 0;
     }
 
@@ -267,6 +277,7 @@ zlink::socket_base_t *zlink::session_base_t::get_socket () const
 
 void zlink::session_base_t::process_plug ()
 {
+    _io_thread->add_session (this);
     if (_active)
         start_connecting (false);
 }
@@ -377,6 +388,66 @@ void zlink::session_base_t::engine_error (bool handshaked_,
         _pipe->check_read ();
 }
 
+void zlink::session_base_t::sample_traffic (uint64_t interval_ms_)
+{
+    _traffic_load =
+      poller_t::traffic_load (_traffic, interval_ms_, _traffic_load);
+    flush_traffic ();
+}
+
+void zlink::session_base_t::flush_traffic ()
+{
+    _io_thread->get_poller ()->add_traffic (_traffic);
+    memset (_traffic, 0, sizeof _traffic);
+}
+
+bool zlink::session_base_t::can_migrate (io_thread_t *io_thread_) const
+{
+    //  Only sessions with an established connection move, and only once:
+    //  commands keep being addressed to the thread the session was created
+    //  in, which forwards them.
+    if (!_engine || !_pipe || is_terminating () || _pending
+        || !_terminating_pipes.empty () || _has_linger_timer
+        || get_forward_tid () != get_tid ())
+        return false;
+
+    //  The new thread must be one the socket may use.
+    const int index = io_thread_->get_index ();
+    return !options.affinity || (options.affinity & (uint64_t (1) << index));
+}
+
+bool zlink::session_base_t::migrate (io_thread_t *io_thread_)
+{
+    return can_migrate (io_thread_) && _engine->migrate (io_thread_);
+}
+
+void zlink::session_base_t::engine_migrated (io_thread_t *io_thread_)
+{
+    flush_traffic ();
+    _io_thread->remove_session (this);
+    _io_thread->adjust_sessions (-1);
+    io_thread_->adjust_sessions (1);
+
+    //  Timers the session sets from now on run in the new thread.
+    io_object_t::unplug ();
+    io_object_t::plug (io_thread_);
+    _io_thread = io_thread_;
+
+    //  Commands to the session and its pipe are still sent to the old
+    //  thread, which passes them on. The new thread learns about the
+    //  session before any of them.
+    set_forward_tid (io_thread_->get_tid ());
+    _pipe->set_forward_tid (io_thread_->get_tid ());
+    send_migrated (this);
+}
+
+void zlink::session_base_t::process_migrated ()
+{
+    _io_thread->add_session (this);
+    if (_engine)
+        _engine->resume ();
+}
+
 void zlink::session_base_t::process_term (int linger_)
 {
     zlink_assert (!_pending);
@@ -490,7 +561,11 @@ void zlink::session_base_t::start_connecting (bool wait_)
     }
 #endif
 #if defined ZLINK_HAVE_IPC
-    else if (_addr->protocol == protocol_name::ipc) {
+    else if (_addr->protocol == protocol_name::ipc
+#if defined ZLINK_HAVE_SHM
+             || _addr->protocol == protocol_name::shm
+#endif
+    ) {
         connecter = new (std::nothrow)
           asio_ipc_connecter_t (io_thread, this, options, _addr, wait_);
     }
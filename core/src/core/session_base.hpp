@@ -38,6 +38,27 @@ class session_base_t : public own_t, public io_object_t, public i_pipe_events
     void engine_error (bool handshaked_, zlink::i_engine::error_reason_t reason_);
     void engine_ready ();
 
+    //  Called by the engine in the old I/O thread once it has moved to
+    //  io_thread_. Moves the session along with it.
+    void engine_migrated (zlink::io_thread_t *io_thread_);
+
+    //  Traffic accounting. The engine reports the bytes it moves, the
+    //  session counts the messages; the I/O thread samples the totals.
+    void add_traffic (int counter_, uint64_t amount_)
+    {
+        _traffic[counter_] += amount_;
+    }
+    void sample_traffic (uint64_t interval_ms_);
+    uint64_t get_traffic_load () const { return _traffic_load; }
+
+    //  Returns true if the session and its engine may be moved to
+    //  io_thread_ right now.
+    bool can_migrate (zlink::io_thread_t *io_thread_) const;
+
+    //  Starts moving the session and its engine to io_thread_. Returns
+    //  false if they cannot be moved.
+    bool migrate (zlink::io_thread_t *io_thread_);
+
     //  i_pipe_events interface implementation.
     void read_activated (zlink::pipe_t *pipe_) ZLINK_FINAL;
     void write_activated (zlink::pipe_t *pipe_) ZLINK_FINAL;
@@ -76,6 +97,7 @@ class session_base_t : public own_t, public io_object_t, public i_pipe_events
     void process_attach (zlink::i_engine *engine_) ZLINK_FINAL;
     void process_term (int linger_) ZLINK_FINAL;
     void process_conn_failed () ZLINK_OVERRIDE;
+    void process_migrated () ZLINK_FINAL;
 
     //  i_poll_events handlers.
     void timer_event (int id_) ZLINK_FINAL;
@@ -84,6 +106,9 @@ class session_base_t : public own_t, public io_object_t, public i_pipe_events
     //  Call this function when engine disconnect to get rid of leftovers.
     void clean_pipes ();
 
+    //  Hands the traffic counted since the last sample over to the poller.
+    void flush_traffic ();
+
     //  If true, this session (re)connects to the peer. Otherwise, it's
     //  a transient session created by the listener.
     const bool _active;
@@ -128,6 +153,10 @@ class session_base_t : public own_t, public io_object_t, public i_pipe_events
     //  Protocol and address to use when connecting.
     address_t *_addr;
 
+    //  Traffic since the last sample and the resulting load.
+    poller_t::traffic_t _traffic;
+    uint64_t _traffic_load;
+
     ZLINK_NON_COPYABLE_NOR_MOVABLE (session_base_t)
 };
 }
@@ -0,0 +1,176 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "utils/precompiled.hpp"
+#include "core/timer_wheel.hpp"
+#include "utils/err.hpp"
+#include "utils/simd.hpp"
+
+#include <string.h>
+
+zlink::timer_wheel_t::timer_t::timer_t () :
+    callback (NULL),
+    arg (NULL),
+    id (0),
+    _next (NULL),
+    _pprev (NULL),
+    _expiry (0),
+    _slot (0)
+{
+}
+
+zlink::timer_wheel_t::timer_wheel_t (uint64_t now_) : _next (now_), _size (0)
+{
+    memset (_slots, 0, sizeof _slots);
+    memset (_occupied, 0, sizeof _occupied);
+}
+
+void zlink::timer_wheel_t::add (timer_t *timer_, uint64_t expiry_)
+{
+    zlink_assert (!timer_->active ());
+    timer_->_expiry = expiry_;
+    link (timer_);
+    ++_size;
+}
+
+void zlink::timer_wheel_t::cancel (timer_t *timer_)
+{
+    if (!timer_->active ())
+        return;
+    unlink (timer_);
+    --_size;
+}
+
+void zlink::timer_wheel_t::link (timer_t *timer_)
+{
+    //  Timers that are due already go to the next tick.
+    uint64_t expiry = timer_->_expiry;
+    if (expiry < _next)
+        expiry = _next;
+
+    //  The level is chosen by the distance from the next tick and the slot
+    //  by the expiry itself, so a slot of level n holds the timers that
+    //  expire within the same 256^n milliseconds.
+    const uint64_t delta = expiry - _next;
+    uint32_t level = 0;
+    while (level + 1 < levels && delta >> ((level + 1) * slot_bits))
+        ++level;
+    if (level == levels - 1 && delta >> (levels * slot_bits))
+        expiry = _next + (static_cast<uint64_t> (1) << (levels * slot_bits))
+                 - 1;
+    const uint32_t index =
+      static_cast<uint32_t> (expiry >> (level * slot_bits)) & slot_mask;
+
+    timer_t **head = &_slots[level][index];
+    timer_->_next = *head;
+    if (*head)
+        (*head)->_pprev = &timer_->_next;
+    *head = timer_;
+    timer_->_pprev = head;
+    timer_->_slot = level * slots + index;
+    if (level == 0)
+        _occupied[index / 32] |= 1u << (index % 32);
+}
+
+void zlink::timer_wheel_t::unlink (timer_t *timer_)
+{
+    *timer_->_pprev = timer_->_next;
+    if (timer_->_next)
+        timer_->_next->_pprev = timer_->_pprev;
+    if (timer_->_slot < slots && !_slots[0][timer_->_slot])
+        _occupied[timer_->_slot / 32] &= ~(1u << (timer_->_slot % 32));
+    timer_->_next = NULL;
+    timer_->_pprev = NULL;
+}
+
+uint32_t zlink::timer_wheel_t::cascade (uint32_t level_)
+{
+    const uint32_t index =
+      static_cast<uint32_t> (_next >> (level_ * slot_bits)) & slot_mask;
+    timer_t *timer = _slots[level_][index];
+    _slots[level_][index] = NULL;
+    while (timer) {
+        timer_t *next = timer->_next;
+        link (timer);
+        timer = next;
+    }
+    return index;
+}
+
+uint32_t zlink::timer_wheel_t::first_occupied (uint32_t from_) const
+{
+    for (uint32_t word = from_ / 32; word < slots / 32; ++word) {
+        uint32_t bits = _occupied[word];
+        if (word == from_ / 32)
+            bits &= ~0u << (from_ % 32);
+        if (bits)
+            return word * 32 + simd::lowest_bit (bits);
+    }
+    return slots;
+}
+
+uint64_t zlink::timer_wheel_t::advance (uint64_t now_)
+{
+    while (_next <= now_) {
+        //  Nothing can expire on an empty wheel; catch up at once.
+        if (!_size) {
+            _next = now_ + 1;
+            break;
+        }
+
+        const uint32_t index = static_cast<uint32_t> (_next) & slot_mask;
+
+        //  Within a range of level 0, skip the empty slots.
+        if (index != 0) {
+            const uint32_t first = first_occupied (index);
+            uint64_t target = (_next & ~static_cast<uint64_t> (slot_mask))
+                              + first;
+            if (target > now_ + 1)
+                target = now_ + 1;
+            if (target > _next) {
+                _next = target;
+                continue;
+            }
+        }
+
+        //  Entering a new range of level 0, move down the timers that fall
+        //  into it, and so on for the levels above.
+        if (index == 0 && cascade (1) == 0 && cascade (2) == 0)
+            cascade (3);
+
+        //  Take the due timers off their slot first, so that those the
+        //  callbacks schedule do not end up among them.
+        timer_t *due = _slots[0][index];
+        if (due) {
+            _slots[0][index] = NULL;
+            _occupied[index / 32] &= ~(1u << (index % 32));
+            for (timer_t *timer = due; timer; timer = timer->_next)
+                timer->_slot = detached_slot;
+            due->_pprev = &due;
+        }
+        ++_next;
+
+        while (due) {
+            timer_t *timer = due;
+            unlink (timer);
+            --_size;
+            timer->callback (timer);
+        }
+    }
+
+    return timeout (now_);
+}
+
+uint64_t zlink::timer_wheel_t::timeout (uint64_t now_) const
+{
+    if (!_size)
+        return 0;
+
+    //  Wake up for the next occupied slot of level 0, or at the start of
+    //  the next range of level 0, where timers move down from level 1.
+    const uint32_t index = static_cast<uint32_t> (_next) & slot_mask;
+    uint64_t target = _next;
+    if (index != 0)
+        target = (_next & ~static_cast<uint64_t> (slot_mask))
+                 + first_occupied (index);
+    return target > now_ ? target - now_ : 1;
+}
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZLINK_TIMER_WHEEL_HPP_INCLUDED__
+#define __ZLINK_TIMER_WHEEL_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "utils/macros.hpp"
+#include "utils/stdint.hpp"
+
+namespace zlink
+{
+//  Hierarchical hashed timing wheel with a resolution of one millisecond.
+//
+//  Level 0 has a slot for each of the next 256 milliseconds; each further
+//  level covers 256 slots of the level below it. Timers further away sit
+//  in a coarse slot and move down a level whenever the wheel reaches the
+//  range of that slot, so scheduling and cancelling a timer is O(1) no
+//  matter how many timers are pending.
+//
+//  Timers are intrusive: the owner embeds a timer_t and the wheel only
+//  links it, so scheduling does not allocate. The wheel is not thread
+//  safe; it belongs to the thread that advances it.
+
+class timer_wheel_t
+{
+  public:
+    struct timer_t
+    {
+        timer_t ();
+
+        //  Called when the timer expires, after it has been taken off the
+        //  wheel. The callback may schedule the timer again.
+        void (*callback) (timer_t *timer_);
+
+        //  Free for the owner of the timer, untouched by the wheel.
+        void *arg;
+        int id;
+
+        bool active () const { return _pprev != NULL; }
+        uint64_t expiry () const { return _expiry; }
+
+      private:
+        friend class timer_wheel_t;
+
+        timer_t *_next;
+        timer_t **_pprev;
+        uint64_t _expiry;
+        uint32_t _slot;
+    };
+
+    //  now_ is the current time in milliseconds, on the clock later passed
+    //  to advance.
+    explicit timer_wheel_t (uint64_t now_);
+
+    //  Schedules timer_ to expire at expiry_. Timers due already expire on
+    //  the next advance. timer_ must not be scheduled.
+    void add (timer_t *timer_, uint64_t expiry_);
+
+    //  Takes timer_ off the wheel. Does nothing if timer_ is not scheduled.
+    void cancel (timer_t *timer_);
+
+    //  Expires all timers due at now_. Returns the number of milliseconds
+    //  until the wheel needs to be advanced again, or 0 if no timer is
+    //  scheduled.
+    uint64_t advance (uint64_t now_);
+
+    //  Returns the number of milliseconds from now_ until the wheel needs
+    //  to be advanced, or 0 if no timer is scheduled.
+    uint64_t timeout (uint64_t now_) const;
+
+    size_t size () const { return _size; }
+
+  private:
+    enum
+    {
+        slot_bits = 8,
+        slots = 1 << slot_bits,
+        slot_mask = slots - 1,
+        levels = 4,
+        detached_slot = levels * slots
+    };
+
+    void link (timer_t *timer_);
+    void unlink (timer_t *timer_);
+
+    //  Re-schedules the timers of a slot of level_ into lower levels.
+    //  Returns the index of the slot.
+    uint32_t cascade (uint32_t level_);
+
+    //  Returns the first occupied slot of level 0 in [from_, slots), or
+    //  slots if there is none.
+    uint32_t first_occupied (uint32_t from_) const;
+
+    timer_t *_slots[levels][slots];
+
+    //  Bitmap of the non-empty slots of level 0.
+    uint32_t _occupied[slots / 32];
+
+    //  The next tick to be processed.
+    uint64_t _next;
+
+    size_t _size;
+
+    ZLINK_NON_COPYABLE_NOR_MOVABLE (timer_wheel_t)
+};
+}
+
+#endif
@@ -0,0 +1,216 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZLINK_YPIPE_MPSC_HPP_INCLUDED__
+#define __ZLINK_YPIPE_MPSC_HPP_INCLUDED__
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "platform.hpp"
+#include "core/yqueue.hpp"
+#include "utils/err.hpp"
+#include "utils/macros.hpp"
+#include "utils/mutex.hpp"
+#include "utils/stdint.hpp"
+
+namespace zlink
+{
+//  Lock-free queue with any number of writers and a single reader.
+//  T must be trivially copyable. N is the capacity of the ring used on the
+//  fast path and must be a power of two; G is the granularity of the
+//  overflow queue.
+//
+//  Writers claim a ring position with a CAS on the tail counter, store the
+//  item and publish it by swapping in the slot's sequence number, so no
+//  writer ever waits for another. Once the ring is full, writers append to
+//  a locked overflow queue instead, and keep doing so until the reader has
+//  taken it over. The reader takes it only after every claimed ring slot
+//  has been consumed, and reads it before the ring, so items of any single
+//  writer stay in order.
+//
+//  The reader goes to sleep by tagging the sequence number of the slot it
+//  waits on. The write that removes the tag - the one publishing into that
+//  slot, or an overflow write - reports the reader was sleeping, exactly as
+//  ypipe_t::flush does, and the caller has to wake it up.
+
+template <typename T, int N, int G> class ypipe_mpsc_t
+{
+  public:
+    ypipe_mpsc_t () :
+        _head (0), _overflow_in (&_overflow[0]), _overflow_in_size (0),
+        _overflowing (false), _overflow_out (&_overflow[1]),
+        _overflow_out_size (0), _sleep_pos (0), _tail (0)
+    {
+        static_assert ((N & (N - 1)) == 0, "N must be a power of two");
+#if defined HAVE_POSIX_MEMALIGN
+        void *pv;
+        if (posix_memalign (&pv, ZLINK_CACHELINE_SIZE, sizeof (T) * N) != 0)
+            pv = NULL;
+        _values = static_cast<T *> (pv);
+#else
+        _values = static_cast<T *> (malloc (sizeof (T) * N));
+#endif
+        alloc_assert (_values);
+        for (int i = 0; i < N; ++i)
+            _seqs[i].store (i, std::memory_order_relaxed);
+    }
+
+    ~ypipe_mpsc_t ()
+    {
+        //  Writers in the overflow path may still be inside write ().
+        _sync.lock ();
+        _sync.unlock ();
+        free (_values);
+    }
+
+    //  Writes an item to the pipe. Returns false if the reader is sleeping;
+    //  in that case the caller is obliged to wake it up.
+    bool write (const T &value_)
+    {
+        if (!_overflowing.load (std::memory_order_acquire)) {
+            uint64_t pos = _tail.load (std::memory_order_relaxed);
+            while (true) {
+                std::atomic<uint64_t> &seq = _seqs[pos & (N - 1)];
+                const int64_t dif =
+                  static_cast<int64_t> ((seq.load () & ~sleep_tag) - pos);
+                if (dif == 0) {
+                    if (_tail.compare_exchange_weak (pos, pos + 1)) {
+                        _values[pos & (N - 1)] = value_;
+                        return !(seq.exchange (pos + 1) & sleep_tag);
+                    }
+                } else if (dif < 0)
+                    break;
+                else
+                    pos = _tail.load (std::memory_order_relaxed);
+            }
+        }
+
+        //  The ring is full, or items are already waiting in the overflow
+        //  queue and this one has to go after them.
+        scoped_lock_t lock (_sync);
+        _overflow_in->push ();
+        _overflow_in->back () = value_;
+        ++_overflow_in_size;
+        _overflowing.store (true);
+
+        //  A reader sleeping on an empty ring is not woken by any ring
+        //  write, so take its tag here.
+        const uint64_t pos = _sleep_pos.load ();
+        uint64_t tagged = pos | sleep_tag;
+        return !_seqs[pos & (N - 1)].compare_exchange_strong (tagged, pos);
+    }
+
+    //  Checks whether there is an item to read. If not, the reader goes to
+    //  sleep.
+    bool check_read () { return prefetch () != none; }
+
+    //  Reads an item from the pipe. Returns false if there is nothing to
+    //  read, in which case the reader goes to sleep.
+    bool read (T *value_)
+    {
+        const source_t source = prefetch ();
+        if (source == ring) {
+            const uint64_t idx = _head & (N - 1);
+            *value_ = _values[idx];
+            _seqs[idx].store (_head + N, std::memory_order_release);
+            ++_head;
+            return true;
+        }
+        if (source == overflow) {
+            *value_ = _overflow_out->front ();
+            _overflow_out->pop ();
+            --_overflow_out_size;
+            return true;
+        }
+        return false;
+    }
+
+  private:
+    enum source_t
+    {
+        none,
+        ring,
+        overflow
+    };
+
+    static const uint64_t sleep_tag = uint64_t (1) << 63;
+
+    //  Finds where the next item comes from, putting the reader to sleep if
+    //  there is none.
+    source_t prefetch ()
+    {
+        if (_overflow_out_size > 0)
+            return overflow;
+
+        std::atomic<uint64_t> &seq = _seqs[_head & (N - 1)];
+        while (true) {
+            uint64_t current = seq.load (std::memory_order_acquire);
+            if (current == _head + 1)
+                return ring;
+            if (current == (_head | sleep_tag))
+                return none;
+
+            //  The overflow queue is only taken once every ring slot
+            //  claimed before its items were written has been consumed.
+            //  Writers return to the ring right away, as the items taken
+            //  are read before any of theirs.
+            if (_overflowing.load (std::memory_order_acquire)) {
+                scoped_lock_t lock (_sync);
+                if (_overflow_in_size > 0 && _tail.load () == _head) {
+                    std::swap (_overflow_in, _overflow_out);
+                    _overflow_out_size = _overflow_in_size;
+                    _overflow_in_size = 0;
+                    _overflowing.store (false);
+                    return overflow;
+                }
+            }
+
+            _sleep_pos.store (_head);
+            if (!seq.compare_exchange_strong (current, _head | sleep_tag))
+                continue;
+
+            //  An overflow write racing with the tag may have missed it. If
+            //  no ring write is pending to wake us, wake up on our own,
+            //  unless a writer already took the tag and is waking us.
+            if (_tail.load () != _head || !_overflowing.load ())
+                return none;
+            current = _head | sleep_tag;
+            if (!seq.compare_exchange_strong (current, _head))
+                return none;
+        }
+    }
+
+    //  Ring of N items. _seqs[i] holds the position the slot is free for,
+    //  that position + 1 once the item is published, and the position with
+    //  sleep_tag while the reader sleeps on an empty slot.
+    T *_values;
+    std::atomic<uint64_t> _seqs[N];
+
+    //  Next position to read. Accessed by the reader only.
+    uint64_t _head;
+
+    //  Items written while the ring was full, and the ones the reader has
+    //  taken over but not read yet.
+    mutex_t _sync;
+    yqueue_t<T, G> _overflow[2];
+    yqueue_t<T, G> *_overflow_in;
+    size_t _overflow_in_size;
+    std::atomic<bool> _overflowing;
+    yqueue_t<T, G> *_overflow_out;
+    size_t _overflow_out_size;
+
+    //  Position the reader went to sleep on.
+    std::atomic<uint64_t> _sleep_pos;
+
+    //  Next position to claim, on its own cache line as all writers
+    //  contend on it.
+    char _pad[ZLINK_CACHELINE_SIZE];
+    std::atomic<uint64_t> _tail;
+
+    ZLINK_NON_COPYABLE_NOR_MOVABLE (ypipe_mpsc_t)
+};
+}
+
+#endif
@@ -91,6 +91,14 @@ bool env_flag_enabled (const char *name_)
     return env && *env && *env != '0';
 }
 
+bool env_flag_enabled (const char *name_, bool default_)
+{
+    const char *env = std::getenv (name_);
+    if (!env || !*env)
+        return default_;
+    return *env != '0';
+}
+
 size_t parse_size_env (const char *name_, size_t fallback_)
 {
     const char *env = std::getenv (name_);
@@ -105,13 +113,15 @@ size_t parse_size_env (const char *name_, size_t fallback_)
 }
 
 const bool asio_gather_write_on =
-  env_flag_enabled ("ZLINK_ASIO_GATHER_WRITE");
+  env_flag_enabled ("ZLINK_ASIO_GATHER_WRITE", true);
 
 const bool asio_single_write_on =
   env_flag_enabled ("ZLINK_ASIO_SINGLE_WRITE");
 
+//  Bodies from this size on are written in place rather than copied
+//  through the encoder buffer.
 const size_t asio_gather_threshold =
-  parse_size_env ("ZLINK_ASIO_GATHER_THRESHOLD", 65536);
+  parse_size_env ("ZLINK_ASIO_GATHER_THRESHOLD", 1024);
 
 }
 
@@ -142,8 +152,15 @@ zlink::asio_engine_t::asio_engine_t (
     _has_handshake_stage (true),
     _io_context (NULL),
     _transport (std::move (transport_)),
+    _poller (NULL),
     _current_timer_id (-1),
+    _migrated_timer (-1),
     _read_buffer (read_buffer_size),
+    _decoder_buffer_size (static_cast<size_t> (options_.in_batch_size)),
+    _decoder_buffer_target (_decoder_buffer_size),
+    _read_request_size (0),
+    _full_reads (0),
+    _short_reads (0),
     _total_pending_bytes (0),
     _fd (fd_),
     _plugged (false),
@@ -154,14 +171,12 @@ zlink::asio_engine_t::asio_engine_t (
     _handshake_pending (false),
     _async_zero_copy (false),
     _async_gather (false),
-    _gather_header_size (0),
-    _gather_body (NULL),
-    _gather_body_size (0),
     _terminating (false),
     _read_buffer_ptr (NULL),
     _read_from_pending_pool (false),
     _session (NULL),
-    _socket (NULL)
+    _socket (NULL),
+    _migrate_to (NULL)
 {
     ENGINE_DBG ("Constructor called, fd=%d", fd_);
 
@@ -203,6 +218,8 @@ zlink::asio_engine_t::~asio_engine_t ()
         _fd = retired_fd;
     }
 
+    finish_gather_output ();
+
     const int rc = _tx_msg.close ();
     errno_assert (rc == 0);
 
@@ -222,7 +239,7 @@ zlink::asio_engine_t::~asio_engine_t ()
     _total_pending_bytes = 0;
 
     //  Smart pointers will automatically clean up ASIO objects
-    //  (_timer, _socket_handle/_stream_descriptor)
+    //  (_socket_handle/_stream_descriptor)
 }
 
 void zlink::asio_engine_t::plug (io_thread_t *io_thread_,
@@ -240,13 +257,11 @@ void zlink::asio_engine_t::plug (io_thread_t *io_thread_,
     _socket = _session->get_socket ();
 
     //  Get reference to io_context from the io_thread's poller
-    asio_poller_t *poller =
-      static_cast<asio_poller_t *> (io_thread_->get_poller ());
-    _io_context = &poller->get_io_context ();
+    _poller = io_thread_->get_poller ();
+    _io_context = &_poller->get_io_context ();
 
-    //  Allocate timer with correct io_context
-    _timer = std::unique_ptr<boost::asio::steady_timer> (
-      new boost::asio::steady_timer (*_io_context));
+    _timer.callback = timer_expired;
+    _timer.arg = this;
 
     _io_error = false;
 
@@ -356,8 +371,9 @@ void zlink::asio_engine_t::unplug ()
     //  Cancel pending async operations by closing the transport
     if (_transport)
         _transport->close ();
-    if (_timer)
-        _timer->cancel ();
+    if (_poller)
+        _poller->cancel_timer (&_timer);
+    _migrated_timer = -1;
 
     //  Clear pending buffers (True Proactor Pattern)
     _pending_buffers.clear ();
@@ -405,19 +421,20 @@ void zlink::asio_engine_t::start_async_read ()
     //  True Proactor Pattern: We no longer check _input_stopped here.
     //  Async reads continue even during backpressure, with data being buffered
     //  in _pending_buffers. This eliminates unnecessary recvfrom() EAGAIN calls.
-    if (_read_pending || _io_error)
+    if (_read_pending || _io_error || unlikely (_migrate_to != NULL))
         return;
 
     ENGINE_DBG ("start_async_read: insize=%zu", _insize);
 
     _read_pending = true;
     _read_from_pending_pool = false;
+    _read_request_size = 0;
 
     //  Get buffer from decoder if available
     size_t read_size;
 
     if (_decoder && _input_stopped) {
-        read_size = _options.in_batch_size;
+        read_size = _decoder_buffer_size;
         if (read_size == 0)
             read_size = read_buffer_size;
 
@@ -429,6 +446,7 @@ void zlink::asio_engine_t::start_async_read ()
         _read_buffer_ptr = _pending_read_buffer.data ();
         _read_from_pending_pool = true;
     } else if (_decoder) {
+        apply_read_buffer_size ();
         _decoder->get_buffer (&_read_buffer_ptr, &read_size);
 
         //  If we have partial data from previous read, move it to buffer start.
@@ -445,6 +463,7 @@ void zlink::asio_engine_t::start_async_read ()
             _read_buffer_ptr += _insize;
             read_size -= _insize;
         }
+        _read_request_size = read_size;
     } else {
         //  During handshake, use internal buffer
         _read_buffer_ptr = _read_buffer.data ();
@@ -458,19 +477,68 @@ void zlink::asio_engine_t::start_async_read ()
           _read_buffer_ptr, read_size,
           [this] (const boost::system::error_code &ec, std::size_t bytes) {
               on_read_complete (ec, bytes);
+              if (unlikely (_migrate_to != NULL))
+                  migrate_if_idle ();
           });
     }
 }
 
+void zlink::asio_engine_t::adapt_read_buffer (size_t requested_,
+                                              size_t transferred_)
+{
+    const size_t min_size = static_cast<size_t> (_options.in_batch_size);
+    const size_t max_size =
+      std::max (min_size, static_cast<size_t> (_options.in_batch_max));
+    if (min_size == 0 || max_size <= min_size)
+        return;
+
+    //  A read that filled its buffer suggests the peer has more queued up.
+    //  This also covers reads straight into a large message body.
+    if (transferred_ >= requested_) {
+        _short_reads = 0;
+        if (++_full_reads >= read_grow_after
+            && _decoder_buffer_target < max_size) {
+            _decoder_buffer_target =
+              std::min (max_size, _decoder_buffer_target * 2);
+            _full_reads = 0;
+        }
+        return;
+    }
+
+    _full_reads = 0;
+    if (transferred_ < _decoder_buffer_target / 4) {
+        if (++_short_reads >= read_shrink_after
+            && _decoder_buffer_target > min_size) {
+            _decoder_buffer_target =
+              std::max (min_size, _decoder_buffer_target / 2);
+            _short_reads = 0;
+        }
+    } else
+        _short_reads = 0;
+}
+
+void zlink::asio_engine_t::apply_read_buffer_size ()
+{
+    //  Partial input still lives in the current buffer; switch only
+    //  between reads that left nothing behind.
+    if (_insize > 0 || _decoder_buffer_size == _decoder_buffer_target)
+        return;
+    _decoder->set_buffer_size (_decoder_buffer_target);
+    _decoder_buffer_size = _decoder_buffer_target;
+}
+
 bool zlink::asio_engine_t::speculative_read ()
 {
-    if (_read_pending || _io_error || !_transport)
+    if (_read_pending || _io_error || !_transport
+        || unlikely (_migrate_to != NULL))
         return false;
 
     //  Prepare read buffer the same way as start_async_read().
     size_t read_size;
+    _read_request_size = 0;
 
     if (_decoder) {
+        apply_read_buffer_size ();
         _decoder->get_buffer (&_read_buffer_ptr, &read_size);
 
         //  If we have partial data from previous read, move it to buffer start.
@@ -485,6 +553,7 @@ bool zlink::asio_engine_t::speculative_read ()
             _read_buffer_ptr += _insize;
             read_size -= _insize;
         }
+        _read_request_size = read_size;
     } else {
         _read_buffer_ptr = _read_buffer.data ();
         read_size = _read_buffer.size ();
@@ -513,7 +582,8 @@ bool zlink::asio_engine_t::speculative_read ()
 
 void zlink::asio_engine_t::start_async_write ()
 {
-    if (_terminating || _write_pending || _io_error)
+    if (_terminating || _write_pending || _io_error
+        || unlikely (_migrate_to != NULL))
         return;
 
     ENGINE_DBG ("start_async_write: outsize=%zu", _outsize);
@@ -541,6 +611,7 @@ void zlink::asio_engine_t::start_async_write ()
                 return;
             }
         } else {
+            _session->add_traffic (poller_t::traffic_bytes_out, bytes);
             _outpos += bytes;
             _outsize -= bytes;
             if (_outsize == 0) {
@@ -557,6 +628,8 @@ void zlink::asio_engine_t::start_async_write ()
           _outpos, _outsize,
           [this] (const boost::system::error_code &ec, std::size_t bytes) {
               on_write_complete (ec, bytes);
+              if (unlikely (_migrate_to != NULL))
+                  migrate_if_idle ();
           });
     }
 }
@@ -588,32 +661,118 @@ bool zlink::asio_engine_t::prepare_gather_output ()
         return false;
     }
 
-    const size_t body_size = _tx_msg.size ();
-    if (body_size < asio_gather_threshold) {
+    if (_tx_msg.size () < asio_gather_threshold) {
         _encoder->load_msg (&_tx_msg);
         return false;
     }
 
-    size_t header_size = 0;
-    if (!build_gather_header (_tx_msg, _gather_header,
-                              sizeof (_gather_header), header_size)) {
+    if (_gather_arena.empty ()) {
+        _gather_arena.resize (gather_arena_size);
+        _gather_buffers.reserve (gather_max_buffers);
+        _gather_msgs.reserve (gather_max_buffers);
+    }
+
+    size_t arena_used = 0;
+    size_t batch_bytes = 0;
+    if (!append_gather_msg (arena_used, batch_bytes)) {
         _encoder->load_msg (&_tx_msg);
         return false;
     }
 
-    _gather_header_size = header_size;
-    _gather_body = static_cast<const unsigned char *> (_tx_msg.data ());
-    _gather_body_size = body_size;
+    //  Transports taking a buffer sequence get every queued message that
+    //  fits; the others keep to one header + body pair per write.
+    const bool vectored = _transport->supports_vectored_write ();
+    while (vectored && batch_bytes < gather_max_bytes
+           && _gather_buffers.size () + 2 <= gather_max_buffers) {
+        if ((this->*_next_msg) (&_tx_msg) == -1)
+            break;
+        //  A message that does not fit goes through the encoder; its
+        //  output is written once this batch has completed.
+        if (!append_gather_msg (arena_used, batch_bytes)) {
+            _encoder->load_msg (&_tx_msg);
+            break;
+        }
+    }
+
     _async_gather = true;
     _write_pending = true;
     _async_zero_copy = false;
     _output_stopped = false;
 
-    _transport->async_writev (
-      _gather_header, _gather_header_size, _gather_body, _gather_body_size,
+    const i_asio_transport::completion_handler_t handler =
       [this] (const boost::system::error_code &ec, std::size_t bytes) {
           on_write_complete (ec, bytes);
-      });
+          if (unlikely (_migrate_to != NULL))
+              migrate_if_idle ();
+      };
+    if (vectored) {
+        _transport->async_write_buffers (&_gather_buffers[0],
+                                         _gather_buffers.size (), handler);
+    } else {
+        const boost::asio::const_buffer &header = _gather_buffers[0];
+        const boost::asio::const_buffer body =
+          _gather_buffers.size () > 1 ? _gather_buffers[1]
+                                      : boost::asio::const_buffer ();
+        _transport->async_writev (
+          static_cast<const unsigned char *> (header.data ()), header.size (),
+          static_cast<const unsigned char *> (body.data ()), body.size (),
+          handler);
+    }
+    return true;
+}
+
+bool zlink::asio_engine_t::append_gather_msg (size_t &arena_used_,
+                                            size_t &batch_bytes_)
+{
+    const size_t body_size = _tx_msg.size ();
+    const bool inline_body = body_size < gather_inline_size;
+    const size_t room = gather_arena_size - arena_used_;
+    if (inline_body && room < body_size)
+        return false;
+
+    unsigned char *const chunk = &_gather_arena[arena_used_];
+    size_t header_size = 0;
+    if (!build_gather_header (_tx_msg, chunk,
+                              room - (inline_body ? body_size : 0),
+                              header_size))
+        return false;
+
+    size_t chunk_size = header_size;
+    if (inline_body && body_size > 0) {
+        memcpy (chunk + header_size, _tx_msg.data (), body_size);
+        chunk_size += body_size;
+    }
+
+    //  Consecutive arena chunks share one buffer.
+    if (!_gather_buffers.empty ()
+        && static_cast<const unsigned char *> (_gather_buffers.back ().data ())
+               + _gather_buffers.back ().size ()
+             == chunk) {
+        _gather_buffers.back () = boost::asio::const_buffer (
+          _gather_buffers.back ().data (),
+          _gather_buffers.back ().size () + chunk_size);
+    } else
+        _gather_buffers.push_back (boost::asio::const_buffer (chunk, chunk_size));
+    arena_used_ += chunk_size;
+    batch_bytes_ += header_size + body_size;
+
+    if (inline_body) {
+        int rc = _tx_msg.close ();
+        errno_assert (rc == 0);
+        rc = _tx_msg.init ();
+        errno_assert (rc == 0);
+    } else {
+        //  Bodies this large are never VSM, so the data pointer stays
+        //  valid while the message is held.
+        _gather_msgs.resize (_gather_msgs.size () + 1);
+        msg_t &held = _gather_msgs.back ();
+        int rc = held.init ();
+        errno_assert (rc == 0);
+        rc = held.move (_tx_msg);
+        errno_assert (rc == 0);
+        _gather_buffers.push_back (
+          boost::asio::const_buffer (held.data (), body_size));
+    }
     return true;
 }
 
@@ -623,14 +782,12 @@ void zlink::asio_engine_t::finish_gather_output ()
         return;
 
     _async_gather = false;
-    _gather_header_size = 0;
-    _gather_body = NULL;
-    _gather_body_size = 0;
-
-    const int rc = _tx_msg.close ();
-    errno_assert (rc == 0);
-    const int rc_init = _tx_msg.init ();
-    errno_assert (rc_init == 0);
+    _gather_buffers.clear ();
+    for (size_t i = 0, n = _gather_msgs.size (); i != n; ++i) {
+        const int rc = _gather_msgs[i].close ();
+        errno_assert (rc == 0);
+    }
+    _gather_msgs.clear ();
 }
 
 void zlink::asio_engine_t::on_read_complete (const boost::system::error_code &ec,
@@ -661,6 +818,8 @@ void zlink::asio_engine_t::on_read_complete (const boost::system::error_code &ec
         return;
     }
 
+    _session->add_traffic (poller_t::traffic_bytes_in, bytes_transferred);
+
     //  True Proactor Pattern: If backpressure is active, buffer the data
     //  instead of processing it. This keeps async_read always pending,
     //  eliminating unnecessary recvfrom() EAGAIN calls when backpressure clears.
@@ -718,6 +877,9 @@ void zlink::asio_engine_t::on_read_complete (const boost::system::error_code &ec
         return;
     }
 
+    if (_read_request_size > 0)
+        adapt_read_buffer (_read_request_size, bytes_transferred);
+
     //  Handle buffer pointers based on whether we have partial data
     if (_decoder && _insize > 0) {
         //  We have partial data from previous read.
@@ -779,6 +941,8 @@ void zlink::asio_engine_t::on_write_complete (const boost::system::error_code &e
         return;
     }
 
+    _session->add_traffic (poller_t::traffic_bytes_out, bytes_transferred);
+
     if (_async_gather)
         finish_gather_output ();
 
@@ -792,6 +956,9 @@ void zlink::asio_engine_t::on_write_complete (const boost::system::error_code &e
         _outsize -= bytes_transferred;
 
         if (_outsize > 0) {
+            //  A moving engine writes the rest in its new I/O thread.
+            if (unlikely (_migrate_to != NULL))
+                return;
             _write_pending = true;
             if (_transport) {
                 _transport->async_write_some (
@@ -799,6 +966,8 @@ void zlink::asio_engine_t::on_write_complete (const boost::system::error_code &e
                   [this] (const boost::system::error_code &wec,
                           std::size_t bytes) {
                       on_write_complete (wec, bytes);
+                      if (unlikely (_migrate_to != NULL))
+                          migrate_if_idle ();
                   });
             }
             return;
@@ -963,6 +1132,10 @@ void zlink::asio_engine_t::speculative_write ()
     if (_io_error)
         return;
 
+    //  Guard: A moving engine writes once it is in its new I/O thread.
+    if (unlikely (_migrate_to != NULL))
+        return;
+
     //  Try gather path first for large messages.
     if (prepare_gather_output ())
         return;
@@ -1005,6 +1178,7 @@ void zlink::asio_engine_t::speculative_write ()
     }
 
     //  Partial or complete write succeeded
+    _session->add_traffic (poller_t::traffic_bytes_out, bytes);
     _outpos += bytes;
     _outsize -= bytes;
 
@@ -1051,6 +1225,7 @@ void zlink::asio_engine_t::speculative_write ()
                 return;
             }
 
+            _session->add_traffic (poller_t::traffic_bytes_out, more_bytes);
             _outpos += more_bytes;
             _outsize -= more_bytes;
 
@@ -1322,6 +1497,88 @@ const zlink::endpoint_uri_pair_t &zlink::asio_engine_t::get_endpoint () const
     return _endpoint_uri_pair;
 }
 
+bool zlink::asio_engine_t::migrate (io_thread_t *io_thread_)
+{
+    //  Only engines past the handshake move, and only between writes, so
+    //  the move never waits for a peer that does not read.
+    if (!_plugged || _terminating || _handshaking || _handshake_pending
+        || _io_error || _write_pending || _migrate_to
+        || !_transport->supports_migration ())
+        return false;
+
+    _migrate_to = io_thread_;
+    migrate_if_idle ();
+    return true;
+}
+
+void zlink::asio_engine_t::migrate_if_idle ()
+{
+    if (_terminating || !_plugged) {
+        _migrate_to = NULL;
+        return;
+    }
+
+    //  Cancelled operations complete with operation_aborted and are
+    //  restarted by resume ().
+    if (_read_pending)
+        _transport->cancel ();
+    if (_read_pending || _write_pending)
+        return;
+
+    finish_migration ();
+}
+
+void zlink::asio_engine_t::finish_migration ()
+{
+    io_thread_t *io_thread = _migrate_to;
+    _migrate_to = NULL;
+
+    //  The session may have started to terminate meanwhile.
+    if (_io_error || !_session->can_migrate (io_thread)) {
+        resume ();
+        return;
+    }
+
+    poller_t *poller = io_thread->get_poller ();
+    boost::asio::io_context &io_context = poller->get_io_context ();
+    if (!_transport->migrate (io_context)) {
+        if (_transport->is_open ())
+            resume ();
+        else
+            error (connection_error);
+        return;
+    }
+
+    //  The pending timer, if any, keeps its expiry. The wheels belong to
+    //  their threads, so it is taken off this one here and scheduled on
+    //  the new one by resume ().
+    if (_timer.active ()) {
+        _migrated_timer = static_cast<int> (_poller->timer_remaining (&_timer));
+        _poller->cancel_timer (&_timer);
+    }
+    _poller = poller;
+    _io_context = &io_context;
+
+    _session->engine_migrated (io_thread);
+}
+
+void zlink::asio_engine_t::resume ()
+{
+    if (_terminating || !_plugged)
+        return;
+
+    if (_migrated_timer != -1) {
+        _poller->add_timer (&_timer, _migrated_timer);
+        _migrated_timer = -1;
+    }
+
+    if (_outsize > 0)
+        start_async_write ();
+    else if (!_output_stopped)
+        speculative_write ();
+    start_async_read ();
+}
+
 int zlink::asio_engine_t::decode_and_push (msg_t *msg_)
 {
     const bool trace =
@@ -1453,32 +1710,33 @@ void zlink::asio_engine_t::add_timer (int timeout_, int id_)
 {
     ENGINE_DBG ("add_timer: timeout=%d, id=%d", timeout_, id_);
 
-    zlink_assert (_timer);
+    zlink_assert (_poller);
+
+    //  The engine has a single timer; a new one replaces the current one.
+    _poller->cancel_timer (&_timer);
     _current_timer_id = id_;
-    _timer->expires_after (std::chrono::milliseconds (timeout_));
-    _timer->async_wait (
-      [this, id_] (const boost::system::error_code &ec) {
-          on_timer (id_, ec);
-      });
+    _timer.id = id_;
+    _poller->add_timer (&_timer, timeout_);
 }
 
 void zlink::asio_engine_t::cancel_timer (int id_)
 {
     ENGINE_DBG ("cancel_timer: id=%d", id_);
 
-    if (_current_timer_id == id_ && _timer) {
-        _timer->cancel ();
+    if (_current_timer_id == id_ && _poller) {
+        _poller->cancel_timer (&_timer);
         _current_timer_id = -1;
     }
 }
 
-void zlink::asio_engine_t::on_timer (int id_, const boost::system::error_code &ec)
+void zlink::asio_engine_t::timer_expired (timer_wheel_t::timer_t *timer_)
 {
-    ENGINE_DBG ("on_timer: id=%d, ec=%s, terminating=%d", id_,
-                ec.message ().c_str (), _terminating);
+    static_cast<asio_engine_t *> (timer_->arg)->on_timer (timer_->id);
+}
 
-    if (ec == boost::asio::error::operation_aborted)
-        return;
+void zlink::asio_engine_t::on_timer (int id_)
+{
+    ENGINE_DBG ("on_timer: id=%d, terminating=%d", id_, _terminating);
 
     //  If terminating, just return - terminate() is draining handlers
     if (_terminating)
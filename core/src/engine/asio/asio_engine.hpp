@@ -55,6 +55,8 @@ class asio_engine_t : public i_engine
     bool restart_input () ZLINK_OVERRIDE;
     void restart_output () ZLINK_OVERRIDE;
     const endpoint_uri_pair_t &get_endpoint () const ZLINK_OVERRIDE;
+    bool migrate (zlink::io_thread_t *io_thread_) ZLINK_OVERRIDE;
+    void resume () ZLINK_OVERRIDE;
 
   protected:
     typedef metadata_t::dict_t properties_t;
@@ -126,7 +128,8 @@ class asio_engine_t : public i_engine
     void cancel_handshake_timer ();
 
     //  Timer callback
-    void on_timer (int id_, const boost::system::error_code &ec);
+    void on_timer (int id_);
+    static void timer_expired (timer_wheel_t::timer_t *timer_);
 
     //  Access to session and socket
     session_base_t *session () { return _session; }
@@ -187,7 +190,7 @@ class asio_engine_t : public i_engine
     //  Indicate if engine has a handshake stage
     bool _has_handshake_stage;
 
-    //  Add a timer using ASIO
+    //  Add a timer on the timer wheel of the I/O thread
     void add_timer (int timeout_, int id_);
 
     //  Cancel a timer
@@ -216,36 +219,76 @@ class asio_engine_t : public i_engine
     //  Returns true if a read was attempted or an error occurred.
     bool speculative_read ();
 
+    //  Adaptive decoder buffer sizing. Called after each read of
+    //  'transferred_' bytes into a buffer of 'requested_' bytes.
+    void adapt_read_buffer (size_t requested_, size_t transferred_);
+
+    //  Hand the decoder its new buffer size once no partial input is
+    //  left in the current buffer.
+    void apply_read_buffer_size ();
+
     //  Prepare output buffer from encoder (called by speculative_write).
     //  Returns true if data is available in _outpos/_outsize.
     bool prepare_output_buffer ();
 
-    //  Prepare gather write (header + body) for large messages.
+    //  Prepare gather write for medium and large messages: one vectored
+    //  write carrying as many queued messages as fit the batch limits.
     //  Returns true if gather write was scheduled or output was stopped.
     bool prepare_gather_output ();
 
+    //  Append _tx_msg to the gather batch. Returns false, leaving _tx_msg
+    //  untouched, if it does not fit.
+    bool append_gather_msg (size_t &arena_used_, size_t &batch_bytes_);
+
     //  Finalize message state after gather write completion.
     void finish_gather_output ();
 
     //  Unplug the engine from the session.
     void unplug ();
 
+    //  Moves the engine to _migrate_to once no async operation is in
+    //  flight any more, cancelling the ones that can be restarted.
+    void migrate_if_idle ();
+    void finish_migration ();
+
     //  Pointer to io_context (set during plug())
     boost::asio::io_context *_io_context;
 
     //  Transport abstraction (TCP/SSL/etc)
     std::unique_ptr<i_asio_transport> _transport;
 
-    //  Timers for handshake and heartbeat (allocated during plug())
-    std::unique_ptr<boost::asio::steady_timer> _timer;
+    //  Poller of the I/O thread the engine runs in (set during plug())
+    poller_t *_poller;
+
+    //  Timer for handshake and heartbeat, scheduled on _poller's wheel
+    timer_wheel_t::timer_t _timer;
 
     //  Current timer ID
     int _current_timer_id;
 
+    //  Milliseconds left on the timer when the engine moved to another
+    //  I/O thread, scheduled again by resume (); -1 if none.
+    int _migrated_timer;
+
     //  Internal read buffer for async operations
     static const size_t read_buffer_size = 8192;
     std::vector<unsigned char> _read_buffer;
 
+    //  Decoder buffer size. Doubles after read_grow_after consecutive
+    //  reads that filled the buffer, up to options.in_batch_max, and
+    //  halves back towards options.in_batch_size after read_shrink_after
+    //  consecutive reads that used less than a quarter of it.
+    enum
+    {
+        read_grow_after = 4,
+        read_shrink_after = 16
+    };
+    size_t _decoder_buffer_size;
+    size_t _decoder_buffer_target;
+    size_t _read_request_size;
+    int _full_reads;
+    int _short_reads;
+
     //  Internal write buffer for async operations
     std::vector<unsigned char> _write_buffer;
 
@@ -291,10 +334,19 @@ class asio_engine_t : public i_engine
     bool _async_zero_copy;
     bool _async_gather;
 
-    unsigned char _gather_header[64];
-    size_t _gather_header_size;
-    const unsigned char *_gather_body;
-    size_t _gather_body_size;
+    //  Gather batch. Headers and small bodies are laid out back to back
+    //  in _gather_arena; larger bodies are referenced in place and their
+    //  messages held in _gather_msgs until the write completes.
+    enum
+    {
+        gather_arena_size = 16384,
+        gather_inline_size = 256,
+        gather_max_buffers = 64,
+        gather_max_bytes = 262144
+    };
+    std::vector<unsigned char> _gather_arena;
+    std::vector<boost::asio::const_buffer> _gather_buffers;
+    std::vector<msg_t> _gather_msgs;
 
     //  True if engine is being terminated (prevents callback processing)
     bool _terminating;
@@ -308,6 +360,10 @@ class asio_engine_t : public i_engine
     //  Socket
     zlink::socket_base_t *_socket;
 
+    //  I/O thread the engine is moving to. No new I/O is started while
+    //  it is set.
+    zlink::io_thread_t *_migrate_to;
+
     ZLINK_NON_COPYABLE_NOR_MOVABLE (asio_engine_t)
 };
 }  // namespace zlink
@@ -46,6 +46,7 @@ zlink::asio_poller_t::asio_poller_t (const zlink::thread_ctx_t &ctx_) :
     worker_poller_base_t (ctx_),
     _io_context (),
     _work_guard (boost::asio::make_work_guard (_io_context)),
+    _timer (_io_context),
     _stopping (false)
 {
     ASIO_DBG ("Constructor called, this=%p", (void *) this);
@@ -244,6 +245,23 @@ void zlink::asio_poller_t::stop ()
     _io_context.stop ();
 }
 
+void zlink::asio_poller_t::timers_rescheduled (uint64_t timeout_)
+{
+    _timer.expires_after (std::chrono::milliseconds (timeout_));
+    _timer.async_wait (
+      [this] (const boost::system::error_code &ec) { on_timer (ec); });
+}
+
+void zlink::asio_poller_t::on_timer (const boost::system::error_code &ec_)
+{
+    if (ec_ == boost::asio::error::operation_aborted || _stopping)
+        return;
+
+    const uint64_t timeout = execute_timers ();
+    if (timeout > 0)
+        timers_rescheduled (timeout);
+}
+
 int zlink::asio_poller_t::max_fds ()
 {
     return -1;
@@ -447,9 +465,6 @@ void zlink::asio_poller_t::loop ()
     ASIO_DBG ("loop: started, this=%p", (void *) this);
 
     while (!_stopping) {
-        //  Execute any due timers.
-        uint64_t timeout = execute_timers ();
-
         //  Reset the io_context if it's stopped (e.g., after previous run completion)
         if (_io_context.stopped ()) {
             ASIO_DBG ("loop: restarting io_context");
@@ -469,16 +484,10 @@ void zlink::asio_poller_t::loop ()
         std::size_t events_processed = _io_context.poll ();
         ASIO_DBG ("loop: poll() processed %zu events", events_processed);
 
-        //  Step 2: Only wait if no events were ready
+        //  Step 2: Only wait if no events were ready. Timers are run by
+        //  _timer, which wakes run_for up in time.
         if (events_processed == 0) {
-            static const int max_poll_timeout_ms = 100;
-            int poll_timeout_ms;
-            if (timeout > 0) {
-                poll_timeout_ms = static_cast<int> (
-                  std::min (timeout, static_cast<uint64_t> (max_poll_timeout_ms)));
-            } else {
-                poll_timeout_ms = max_poll_timeout_ms;
-            }
+            static const int poll_timeout_ms = 100;
 
             ASIO_DBG ("loop: run_for %d ms (no ready events)", poll_timeout_ms);
             _io_context.run_for (
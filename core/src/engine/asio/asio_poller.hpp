@@ -62,6 +62,10 @@ class asio_poller_t ZLINK_FINAL : public worker_poller_base_t
     //  Main event loop.
     void loop () ZLINK_OVERRIDE;
 
+    //  Arms _timer to run the due timers in timeout_ milliseconds.
+    void timers_rescheduled (uint64_t timeout_) ZLINK_OVERRIDE;
+    void on_timer (const boost::system::error_code &ec_);
+
     //  Poll entry structure for tracking FD state
     struct poll_entry_t
     {
@@ -100,6 +104,10 @@ class asio_poller_t ZLINK_FINAL : public worker_poller_base_t
     boost::asio::executor_work_guard<boost::asio::io_context::executor_type>
       _work_guard;
 
+    //  The single Asio timer driving the timer wheel of the thread; it
+    //  always waits for the earliest timer.
+    boost::asio::steady_timer _timer;
+
     //  List of retired event sources (to be deleted after loop iteration)
     typedef std::vector<poll_entry_t *> retired_t;
     retired_t _retired;
@@ -16,6 +16,29 @@
 namespace zlink
 {
 
+//  Buffer sequence over a caller-owned array of const_buffer. Lets a
+//  vectored write hand the engine's iovec array to async_write without
+//  copying it into a container; the array must outlive the operation.
+class const_buffer_span_t
+{
+  public:
+    typedef boost::asio::const_buffer value_type;
+    typedef const boost::asio::const_buffer *const_iterator;
+
+    const_buffer_span_t (const boost::asio::const_buffer *buffers_,
+                         std::size_t count_) :
+        _first (buffers_), _last (buffers_ + count_)
+    {
+    }
+
+    const_iterator begin () const { return _first; }
+    const_iterator end () const { return _last; }
+
+  private:
+    const boost::asio::const_buffer *_first;
+    const boost::asio::const_buffer *_last;
+};
+
 //  Transport abstraction interface for ASIO-based engines.
 //
 //  This interface abstracts the underlying stream transport (TCP, SSL, WebSocket)
@@ -129,6 +152,24 @@ class i_asio_transport
         }
     }
 
+    //  Indicates whether the transport supports async_write_buffers, i.e.
+    //  writing many messages with a single writev/sendmsg.
+    //  Default: false (unsupported).
+    virtual bool supports_vectored_write () const { return false; }
+
+    //  Async gather write of count buffers. The handler runs once all of
+    //  them were written or on error; the buffers must stay valid until
+    //  then. Default: not supported; handler receives
+    //  operation_not_supported.
+    virtual void async_write_buffers (const boost::asio::const_buffer *buffers,
+                                      std::size_t count,
+                                      completion_handler_t handler)
+    {
+        if (handler) {
+            handler (boost::asio::error::operation_not_supported, 0);
+        }
+    }
+
     //  Check if this transport requires a handshake phase.
     //  TCP: false, SSL: true, WebSocket: true
     virtual bool requires_handshake () const { return false; }
@@ -144,6 +185,23 @@ class i_asio_transport
         }
     }
 
+    //  Indicates whether the transport can be moved to another io_context
+    //  with migrate (). Default: false (unsupported).
+    virtual bool supports_migration () const { return false; }
+
+    //  Cancel the outstanding async operations; their handlers receive
+    //  operation_aborted.
+    virtual void cancel () {}
+
+    //  Re-open the transport on io_context, keeping the connection. Must
+    //  be called with no async operation outstanding. Returns false if
+    //  the transport could not be moved; it is then either still open on
+    //  its old io_context or closed.
+    virtual bool migrate (boost::asio::io_context &io_context)
+    {
+        return false;
+    }
+
     //  Check if transport is encrypted.
     //  TCP: false, SSL: true, WSS: true, WS: false
     virtual bool is_encrypted () const { return false; }
@@ -0,0 +1,845 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "utils/precompiled.hpp"
+#include "engine/asio/io_uring_service.hpp"
+
+#if defined ZLINK_IOTHREAD_POLLER_USE_ASIO && defined ZLINK_HAVE_IO_URING
+
+#include "utils/err.hpp"
+
+#include <algorithm>
+#include <new>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace zlink
+{
+namespace
+{
+//  Submission queue depth. The completion queue is larger since one
+//  multishot receive posts a completion per arriving chunk.
+const unsigned sq_depth = 256;
+const unsigned cq_ratio = 4;
+
+//  ZLINK_IO_URING_SQ_DEPTH overrides the submission queue depth; the tests
+//  shrink it to run the queues full.
+unsigned ring_depth ()
+{
+    const char *env = getenv ("ZLINK_IO_URING_SQ_DEPTH");
+    if (!env || !*env)
+        return sq_depth;
+    const unsigned long value = strtoul (env, NULL, 10);
+    return value > 0 && value <= sq_depth ? static_cast<unsigned> (value)
+                                          : sq_depth;
+}
+
+//  Receive buffers shared by all streams of the thread. The count must be
+//  a power of two.
+const unsigned buf_count = 256;
+const unsigned buf_size = 16 * 1024;
+const uint16_t buf_group = 0;
+
+//  A stream holding this many received bytes the engine has not taken
+//  yet stops receiving until it drains, so that one slow reader cannot
+//  take every buffer of the ring.
+const std::size_t rx_limit = 4 * buf_size;
+
+//  Marks data received into the stream's bounce buffer.
+const uint16_t bounce_bid = 0xffff;
+
+int sys_io_uring_setup (unsigned entries_, struct io_uring_params *params_)
+{
+    return static_cast<int> (syscall (__NR_io_uring_setup, entries_, params_));
+}
+
+int sys_io_uring_enter (int fd_, unsigned to_submit_, unsigned flags_)
+{
+    return static_cast<int> (
+      syscall (__NR_io_uring_enter, fd_, to_submit_, 0, flags_, NULL, 0));
+}
+
+int sys_io_uring_register (int fd_,
+                           unsigned opcode_,
+                           const void *arg_,
+                           unsigned nr_args_)
+{
+    return static_cast<int> (
+      syscall (__NR_io_uring_register, fd_, opcode_, arg_, nr_args_));
+}
+
+template <typename T> T *at_offset (void *base_, uint32_t offset_)
+{
+    return reinterpret_cast<T *> (static_cast<unsigned char *> (base_)
+                                  + offset_);
+}
+
+boost::system::error_code errno_code (int errno_)
+{
+    return boost::system::error_code (errno_, boost::system::system_category ());
+}
+}
+
+boost::asio::execution_context::id io_uring_service_t::id;
+
+bool io_uring_service_t::install (boost::asio::io_context &io_context_)
+{
+    if (boost::asio::has_service<io_uring_service_t> (io_context_))
+        return true;
+
+    io_uring_service_t *service =
+      new (std::nothrow) io_uring_service_t (io_context_);
+    alloc_assert (service);
+    if (!service->init ()) {
+        LIBZLINK_DELETE (service);
+        return false;
+    }
+    boost::asio::add_service (io_context_, service);
+    return true;
+}
+
+io_uring_service_t *
+io_uring_service_t::find (boost::asio::io_context &io_context_)
+{
+    if (!boost::asio::has_service<io_uring_service_t> (io_context_))
+        return NULL;
+    return &boost::asio::use_service<io_uring_service_t> (io_context_);
+}
+
+io_uring_service_t::io_uring_service_t (boost::asio::io_context &io_context_) :
+    boost::asio::execution_context::service (io_context_),
+    _io_context (io_context_),
+    _ring_fd (-1),
+    _ring (NULL),
+    _ring_size (0),
+    _sq_head (NULL),
+    _sq_tail (NULL),
+    _sq_mask (0),
+    _sq_entries (0),
+    _sq_flags (NULL),
+    _sqes (NULL),
+    _sqes_size (0),
+    _sq_local_tail (0),
+    _sq_submitted (0),
+    _cq_head (NULL),
+    _cq_tail (NULL),
+    _cq_mask (0),
+    _cqes (NULL),
+    _flush_posted (false),
+    _reaping (false),
+    _submitting (false),
+    _event_fd (-1),
+    _buf_ring (NULL),
+    _buf_ring_size (0),
+    _buffers (NULL),
+    _buf_tail (0),
+    _multishot (true)
+{
+}
+
+io_uring_service_t::~io_uring_service_t ()
+{
+    //  Closing the ring cancels whatever the kernel still holds.
+    if (_ring_fd != -1)
+        ::close (_ring_fd);
+    if (_event) {
+        boost::system::error_code ec;
+        _event->close (ec);
+    } else if (_event_fd != -1)
+        ::close (_event_fd);
+
+    if (_sqes)
+        munmap (_sqes, _sqes_size);
+    if (_ring)
+        munmap (_ring, _ring_size);
+    if (_buf_ring)
+        munmap (_buf_ring, _buf_ring_size);
+    free (_buffers);
+
+    for (std::size_t i = 0, n = _streams.size (); i != n; ++i)
+        LIBZLINK_DELETE (_streams[i]);
+}
+
+void io_uring_service_t::shutdown ()
+{
+    if (_event) {
+        boost::system::error_code ec;
+        _event->cancel (ec);
+    }
+}
+
+bool io_uring_service_t::init ()
+{
+    struct io_uring_params params;
+    memset (&params, 0, sizeof params);
+    const unsigned depth = ring_depth ();
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = cq_ratio * depth;
+
+    //  ENOSYS on old kernels, EPERM where io_uring is disabled.
+    _ring_fd = sys_io_uring_setup (depth, &params);
+    if (_ring_fd == -1)
+        return false;
+
+    //  Sockets that are not ready must wait in the kernel's poll machinery
+    //  rather than in a worker thread, and no completion may be dropped.
+    const unsigned required =
+      IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_FAST_POLL;
+    if ((params.features & required) != required)
+        return false;
+
+    _ring_size =
+      std::max (params.sq_off.array + params.sq_entries * sizeof (unsigned),
+                params.cq_off.cqes
+                  + params.cq_entries * sizeof (struct io_uring_cqe));
+    void *ring = mmap (NULL, _ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQ_RING);
+    if (ring == MAP_FAILED)
+        return false;
+    _ring = ring;
+
+    _sq_head = at_offset<unsigned> (_ring, params.sq_off.head);
+    _sq_tail = at_offset<unsigned> (_ring, params.sq_off.tail);
+    _sq_mask = *at_offset<unsigned> (_ring, params.sq_off.ring_mask);
+    _sq_flags = at_offset<unsigned> (_ring, params.sq_off.flags);
+    _sq_entries = params.sq_entries;
+    _sq_local_tail = _sq_submitted = *_sq_tail;
+
+    //  Entries are used in ring order, so the index array is the identity.
+    unsigned *array = at_offset<unsigned> (_ring, params.sq_off.array);
+    for (unsigned i = 0; i != _sq_entries; ++i)
+        array[i] = i;
+
+    _sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+    void *sqes = mmap (NULL, _sqes_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+    _sqes = static_cast<io_uring_sqe *> (sqes);
+
+    _cq_head = at_offset<unsigned> (_ring, params.cq_off.head);
+    _cq_tail = at_offset<unsigned> (_ring, params.cq_off.tail);
+    _cq_mask = *at_offset<unsigned> (_ring, params.cq_off.ring_mask);
+    _cqes = at_offset<io_uring_cqe> (_ring, params.cq_off.cqes);
+
+    //  Buffer ring (Linux 5.19).
+    _buf_ring_size = buf_count * sizeof (struct io_uring_buf);
+    void *buf_ring = mmap (NULL, _buf_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf_ring == MAP_FAILED)
+        return false;
+    _buf_ring = static_cast<io_uring_buf_ring *> (buf_ring);
+    _buffers = static_cast<unsigned char *> (malloc (buf_count * buf_size));
+    alloc_assert (_buffers);
+
+    struct io_uring_buf_reg reg;
+    memset (&reg, 0, sizeof reg);
+    reg.ring_addr = reinterpret_cast<uintptr_t> (_buf_ring);
+    reg.ring_entries = buf_count;
+    reg.bgid = buf_group;
+    if (sys_io_uring_register (_ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1)
+        != 0)
+        return false;
+    for (unsigned i = 0; i != buf_count; ++i)
+        recycle (static_cast<uint16_t> (i));
+
+    _event_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd == -1)
+        return false;
+    if (sys_io_uring_register (_ring_fd, IORING_REGISTER_EVENTFD, &_event_fd, 1)
+        != 0)
+        return false;
+
+    _event.reset (new (std::nothrow)
+                    boost::asio::posix::stream_descriptor (_io_context));
+    alloc_assert (_event);
+    boost::system::error_code ec;
+    _event->assign (_event_fd, ec);
+    if (ec) {
+        _event.reset ();
+        return false;
+    }
+
+    wait_completions ();
+    return true;
+}
+
+io_uring_stream_t *io_uring_service_t::open_stream (fd_t fd_)
+{
+    io_uring_stream_t *stream = new (std::nothrow) io_uring_stream_t (*this, fd_);
+    alloc_assert (stream);
+    stream->_index = _streams.size ();
+    _streams.push_back (stream);
+    return stream;
+}
+
+void io_uring_service_t::release (io_uring_stream_t *stream_)
+{
+    io_uring_stream_t *last = _streams.back ();
+    last->_index = stream_->_index;
+    _streams[stream_->_index] = last;
+    _streams.pop_back ();
+    LIBZLINK_DELETE (stream_);
+}
+
+io_uring_sqe *io_uring_service_t::get_sqe ()
+{
+    //  Without SQPOLL the kernel consumes entries within io_uring_enter,
+    //  so submitting always makes room.
+    _submitting = true;
+    while (_sq_local_tail - __atomic_load_n (_sq_head, __ATOMIC_ACQUIRE)
+           >= _sq_entries)
+        submit ();
+    _submitting = false;
+
+    io_uring_sqe *sqe = &_sqes[_sq_local_tail & _sq_mask];
+    ++_sq_local_tail;
+    memset (sqe, 0, sizeof *sqe);
+
+    //  Everything queued until the io_context gets round to the flush goes
+    //  to the kernel in one system call.
+    if (!_flush_posted) {
+        _flush_posted = true;
+        boost::asio::post (_io_context, [this] () { flush (); });
+    }
+    return sqe;
+}
+
+void io_uring_service_t::submit ()
+{
+    while (_sq_submitted != _sq_local_tail) {
+        __atomic_store_n (_sq_tail, _sq_local_tail, __ATOMIC_RELEASE);
+        const int rc =
+          sys_io_uring_enter (_ring_fd, _sq_local_tail - _sq_submitted, 0);
+        if (rc > 0) {
+            _sq_submitted += static_cast<unsigned> (rc);
+            continue;
+        }
+        if (rc == -1 && errno == EINTR)
+            continue;
+
+        //  Completions backed up in the kernel. The caller may be in the
+        //  middle of starting an operation, so they are only moved aside.
+        errno_assert (rc == -1 && (errno == EBUSY || errno == EAGAIN));
+        stash ();
+    }
+}
+
+void io_uring_service_t::stash ()
+{
+    unsigned head = *_cq_head;
+    if (head == __atomic_load_n (_cq_tail, __ATOMIC_ACQUIRE)) {
+        //  The kernel kept completions that did not fit; fetch them.
+        const int rc = sys_io_uring_enter (_ring_fd, 0, IORING_ENTER_GETEVENTS);
+        errno_assert (rc != -1 || errno == EINTR || errno == EBUSY);
+    }
+    const unsigned tail = __atomic_load_n (_cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+        const io_uring_cqe &cqe = _cqes[head & _cq_mask];
+        const cqe_t stashed = {cqe.user_data, cqe.res, cqe.flags};
+        _backlog.push_back (stashed);
+    }
+    __atomic_store_n (_cq_head, head, __ATOMIC_RELEASE);
+
+    //  A reap already under way picks the backlog up; otherwise the flush
+    //  does.
+    if (!_reaping && !_flush_posted) {
+        _flush_posted = true;
+        boost::asio::post (_io_context, [this] () { flush (); });
+    }
+}
+
+void io_uring_service_t::flush ()
+{
+    _flush_posted = false;
+    submit ();
+
+    //  Operations the kernel completed right away are handled now rather
+    //  than after a round through the eventfd.
+    reap ();
+}
+
+void io_uring_service_t::wait_completions ()
+{
+    _event->async_wait (boost::asio::posix::descriptor_base::wait_read,
+                        [this] (const boost::system::error_code &ec_) {
+                            if (ec_)
+                                return;
+                            uint64_t count;
+                            const ssize_t rc =
+                              ::read (_event_fd, &count, sizeof count);
+                            LIBZLINK_UNUSED (rc);
+                            reap ();
+                            wait_completions ();
+                        });
+}
+
+void io_uring_service_t::reap ()
+{
+    if (_reaping)
+        return;
+    zlink_assert (!_submitting);
+    _reaping = true;
+
+    unsigned head = *_cq_head;
+    while (true) {
+        //  Stashed completions are older than those still in the queue.
+        if (!_backlog.empty ()) {
+            const cqe_t cqe = _backlog.front ();
+            _backlog.pop_front ();
+            complete (cqe);
+            head = *_cq_head;
+            continue;
+        }
+        if (head == __atomic_load_n (_cq_tail, __ATOMIC_ACQUIRE)) {
+            if (!(__atomic_load_n (_sq_flags, __ATOMIC_RELAXED)
+                  & IORING_SQ_CQ_OVERFLOW))
+                break;
+            //  The kernel kept completions that did not fit; fetch them.
+            sys_io_uring_enter (_ring_fd, 0, IORING_ENTER_GETEVENTS);
+            if (head == __atomic_load_n (_cq_tail, __ATOMIC_ACQUIRE))
+                break;
+        }
+
+        //  Release the slot before dispatching: the handler may queue
+        //  further operations, and stash what is left behind it.
+        const io_uring_cqe &entry = _cqes[head & _cq_mask];
+        const cqe_t cqe = {entry.user_data, entry.res, entry.flags};
+        __atomic_store_n (_cq_head, ++head, __ATOMIC_RELEASE);
+        complete (cqe);
+        head = *_cq_head;
+    }
+
+    _reaping = false;
+}
+
+void io_uring_service_t::complete (const cqe_t &cqe_)
+{
+    //  Cancellations carry no user data; their targets complete on their
+    //  own.
+    if (!cqe_.user_data)
+        return;
+
+    io_uring_stream_t::op_t *op = reinterpret_cast<io_uring_stream_t::op_t *> (
+      static_cast<uintptr_t> (cqe_.user_data));
+    if (op->recv)
+        op->stream->on_recv (cqe_.res, cqe_.flags);
+    else
+        op->stream->on_send (cqe_.res);
+}
+
+unsigned char *io_uring_service_t::buffer (uint16_t bid_) const
+{
+    return _buffers + static_cast<std::size_t> (bid_) * buf_size;
+}
+
+void io_uring_service_t::recycle (uint16_t bid_)
+{
+    //  The entries start at the ring itself, their first one sharing its
+    //  reserved field with the tail; the header's flexible array member is
+    //  shifted when compiled as C++.
+    struct io_uring_buf *bufs =
+      reinterpret_cast<struct io_uring_buf *> (_buf_ring);
+    struct io_uring_buf *buf = &bufs[_buf_tail & (buf_count - 1)];
+    buf->addr = reinterpret_cast<uintptr_t> (buffer (bid_));
+    buf->len = buf_size;
+    buf->bid = bid_;
+    ++_buf_tail;
+    __atomic_store_n (&_buf_ring->tail, _buf_tail, __ATOMIC_RELEASE);
+}
+
+io_uring_stream_t::io_uring_stream_t (io_uring_service_t &service_, fd_t fd_) :
+    _service (service_),
+    _fd (fd_),
+    _closed (false),
+    _index (0),
+    _recv_armed (false),
+    _recv_multishot (false),
+    _recv_cancelling (false),
+    _starved (false),
+    _bounce_busy (false),
+    _rx_bytes (0),
+    _read_buffer (NULL),
+    _read_size (0),
+    _send_inflight (false),
+    _send_cancelling (false),
+    _iov_pos (0),
+    _sent (0)
+{
+    _recv_op.stream = this;
+    _recv_op.recv = true;
+    _send_op.stream = this;
+    _send_op.recv = false;
+    memset (&_msg, 0, sizeof _msg);
+}
+
+io_uring_stream_t::~io_uring_stream_t ()
+{
+}
+
+void io_uring_stream_t::close ()
+{
+    zlink_assert (!_closed);
+    _closed = true;
+
+    //  An in-flight send reads from engine memory that is about to be
+    //  released; shutting the socket down makes it fail rather than send
+    //  whatever ends up there. Data already queued still goes out.
+    ::shutdown (_fd, SHUT_RDWR);
+    if (_recv_armed)
+        cancel (&_recv_op);
+    if (_send_inflight)
+        cancel (&_send_op);
+
+    //  Pending requests keep their own reference to the socket.
+    ::close (_fd);
+    _fd = -1;
+
+    for (std::deque<chunk_t>::const_iterator it = _rx.begin (); it != _rx.end ();
+         ++it)
+        if (it->bid != bounce_bid)
+            _service.recycle (it->bid);
+    _rx.clear ();
+    _rx_bytes = 0;
+
+    if (_read_handler)
+        post (_read_handler, boost::asio::error::operation_aborted, 0);
+    if (_write_handler)
+        post (_write_handler, boost::asio::error::operation_aborted, 0);
+
+    if (idle ())
+        _service.release (this);
+    else
+        _service.submit ();
+}
+
+void io_uring_stream_t::cancel ()
+{
+    zlink_assert (!_closed);
+
+    //  The receive goes into the service's buffers, not the engine's, so
+    //  it keeps running; only the handler is taken back.
+    if (_read_handler) {
+        _read_buffer = NULL;
+        _read_size = 0;
+        post (_read_handler, boost::asio::error::operation_aborted, 0);
+    }
+
+    //  The send reads from engine memory and must be stopped before the
+    //  handler reports back.
+    if (_send_inflight && !_send_cancelling) {
+        _send_cancelling = true;
+        cancel (&_send_op);
+    }
+}
+
+void io_uring_stream_t::async_read_some (unsigned char *buffer_,
+                                         std::size_t size_,
+                                         completion_handler_t handler_)
+{
+    zlink_assert (!_read_handler);
+    _read_handler = handler_;
+
+    const std::size_t n = take (buffer_, size_);
+    if (n > 0 || size_ == 0) {
+        post (_read_handler, boost::system::error_code (), n);
+        return;
+    }
+    if (_rx_error) {
+        post (_read_handler, _rx_error, 0);
+        return;
+    }
+
+    _read_buffer = buffer_;
+    _read_size = size_;
+    arm_recv ();
+}
+
+std::size_t io_uring_stream_t::read_some (unsigned char *buffer_,
+                                          std::size_t len_)
+{
+    const std::size_t n = take (buffer_, len_);
+    if (n > 0 || len_ == 0) {
+        errno = 0;
+        return n;
+    }
+
+    if (!_rx_error)
+        errno = EAGAIN;
+    else if (_rx_error == boost::asio::error::eof
+             || _rx_error == boost::asio::error::connection_reset
+             || _rx_error == boost::asio::error::broken_pipe)
+        errno = EPIPE;
+    else
+        errno = EIO;
+    return 0;
+}
+
+void io_uring_stream_t::async_write (const boost::asio::const_buffer *buffers_,
+                                     std::size_t count_,
+                                     completion_handler_t handler_)
+{
+    zlink_assert (!_write_handler);
+    _write_handler = handler_;
+
+    _iov.clear ();
+    for (std::size_t i = 0; i != count_; ++i) {
+        if (buffers_[i].size () == 0)
+            continue;
+        struct iovec iov;
+        iov.iov_base = const_cast<void *> (buffers_[i].data ());
+        iov.iov_len = buffers_[i].size ();
+        _iov.push_back (iov);
+    }
+    _iov_pos = 0;
+    _sent = 0;
+
+    if (_iov.empty ()) {
+        post (_write_handler, boost::system::error_code (), 0);
+        return;
+    }
+    submit_send ();
+}
+
+std::size_t io_uring_stream_t::write_some (const unsigned char *data_,
+                                           std::size_t len_)
+{
+    if (len_ == 0)
+        return 0;
+
+    //  Bytes must not overtake a send the kernel still holds.
+    if (_write_handler) {
+        errno = EAGAIN;
+        return 0;
+    }
+
+    const ssize_t rc = ::send (_fd, data_, len_, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (rc >= 0) {
+        errno = 0;
+        return static_cast<std::size_t> (rc);
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        errno = EAGAIN;
+    else if (errno == ECONNRESET || errno == EPIPE)
+        errno = EPIPE;
+    else if (errno != ENOTCONN && errno != EBADF)
+        errno = EIO;
+    return 0;
+}
+
+void io_uring_stream_t::arm_recv ()
+{
+    if (_recv_armed || _closed || _rx_error || _rx_bytes >= rx_limit)
+        return;
+
+    const bool multishot = _service._multishot && !_starved;
+    if (!multishot && _bounce_busy)
+        return;
+
+    io_uring_sqe *sqe = _service.get_sqe ();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = _fd;
+    sqe->user_data = reinterpret_cast<uintptr_t> (&_recv_op);
+    if (multishot) {
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = buf_group;
+    } else {
+        if (_bounce.empty ())
+            _bounce.resize (buf_size);
+        sqe->addr = reinterpret_cast<uintptr_t> (&_bounce[0]);
+        sqe->len = buf_size;
+    }
+    _recv_multishot = multishot;
+    _recv_armed = true;
+}
+
+void io_uring_stream_t::cancel (op_t *op_)
+{
+    io_uring_sqe *sqe = _service.get_sqe ();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uintptr_t> (op_);
+}
+
+void io_uring_stream_t::on_recv (int res_, unsigned flags_)
+{
+    if (!_recv_multishot || !(flags_ & IORING_CQE_F_MORE)) {
+        _recv_armed = false;
+        _recv_cancelling = false;
+    }
+
+    if (res_ > 0) {
+        chunk_t chunk;
+        chunk.bid = (flags_ & IORING_CQE_F_BUFFER)
+                      ? static_cast<uint16_t> (flags_ >> IORING_CQE_BUFFER_SHIFT)
+                      : bounce_bid;
+        chunk.offset = 0;
+        chunk.size = static_cast<uint32_t> (res_);
+        if (_closed) {
+            if (chunk.bid != bounce_bid)
+                _service.recycle (chunk.bid);
+        } else {
+            _rx.push_back (chunk);
+            _rx_bytes += chunk.size;
+            if (chunk.bid == bounce_bid) {
+                _bounce_busy = true;
+                _starved = false;
+            }
+        }
+    } else if (res_ == 0)
+        _rx_error = boost::asio::error::eof;
+    else if (res_ == -ENOBUFS)
+        _starved = true;
+    else if (res_ == -EINVAL && _recv_multishot)
+        //  The kernel predates multishot receive (Linux 6.0).
+        _service._multishot = false;
+    else if (res_ != -ECANCELED && res_ != -EAGAIN && res_ != -EINTR)
+        _rx_error = errno_code (-res_);
+
+    if (_closed) {
+        if (idle ())
+            _service.release (this);
+        return;
+    }
+
+    if (!_recv_armed)
+        arm_recv ();
+    else if (_recv_multishot && _rx_bytes >= rx_limit && !_recv_cancelling) {
+        //  The engine is not keeping up; stop taking buffers from the ring
+        //  until it does.
+        _recv_cancelling = true;
+        cancel (&_recv_op);
+    }
+
+    if (_read_handler && (_rx_bytes > 0 || _rx_error)) {
+        const std::size_t n = take (_read_buffer, _read_size);
+        completion_handler_t handler;
+        handler.swap (_read_handler);
+        //  May close the stream; nothing below may touch it.
+        handler (n ? boost::system::error_code () : _rx_error, n);
+    }
+}
+
+void io_uring_stream_t::on_send (int res_)
+{
+    _send_inflight = false;
+    const bool cancelled = _send_cancelling;
+    _send_cancelling = false;
+
+    if (_closed) {
+        if (idle ())
+            _service.release (this);
+        return;
+    }
+
+    if (!cancelled && (res_ == -EAGAIN || res_ == -EINTR)) {
+        submit_send ();
+        return;
+    }
+
+    boost::system::error_code ec;
+    if (cancelled && res_ <= 0)
+        ec = boost::asio::error::operation_aborted;
+    else if (res_ < 0)
+        ec = errno_code (-res_);
+    else if (res_ == 0)
+        ec = boost::asio::error::broken_pipe;
+    else {
+        std::size_t n = static_cast<std::size_t> (res_);
+        _sent += n;
+        while (n > 0) {
+            struct iovec &iov = _iov[_iov_pos];
+            if (n < iov.iov_len) {
+                iov.iov_base = static_cast<unsigned char *> (iov.iov_base) + n;
+                iov.iov_len -= n;
+                break;
+            }
+            n -= iov.iov_len;
+            ++_iov_pos;
+        }
+        if (_iov_pos < _iov.size ()) {
+            if (cancelled)
+                ec = boost::asio::error::operation_aborted;
+            else {
+                submit_send ();
+                return;
+            }
+        }
+    }
+
+    completion_handler_t handler;
+    handler.swap (_write_handler);
+    handler (ec, _sent);
+}
+
+void io_uring_stream_t::submit_send ()
+{
+    io_uring_sqe *sqe = _service.get_sqe ();
+    sqe->fd = _fd;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = reinterpret_cast<uintptr_t> (&_send_op);
+
+    const std::size_t left = _iov.size () - _iov_pos;
+    if (left == 1) {
+        sqe->opcode = IORING_OP_SEND;
+        sqe->addr = reinterpret_cast<uintptr_t> (_iov[_iov_pos].iov_base);
+        sqe->len = static_cast<uint32_t> (
+          std::min<std::size_t> (_iov[_iov_pos].iov_len, INT_MAX));
+    } else {
+        _msg.msg_iov = &_iov[_iov_pos];
+        _msg.msg_iovlen = std::min<std::size_t> (left, IOV_MAX);
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->addr = reinterpret_cast<uintptr_t> (&_msg);
+        sqe->len = 1;
+    }
+    _send_inflight = true;
+}
+
+std::size_t io_uring_stream_t::take (unsigned char *buffer_, std::size_t size_)
+{
+    std::size_t n = 0;
+    while (n < size_ && !_rx.empty ()) {
+        chunk_t &chunk = _rx.front ();
+        const unsigned char *data = chunk.bid == bounce_bid
+                                      ? &_bounce[0]
+                                      : _service.buffer (chunk.bid);
+        const std::size_t part = std::min<std::size_t> (chunk.size, size_ - n);
+        memcpy (buffer_ + n, data + chunk.offset, part);
+        n += part;
+        chunk.offset += static_cast<uint32_t> (part);
+        chunk.size -= static_cast<uint32_t> (part);
+        if (chunk.size == 0) {
+            if (chunk.bid == bounce_bid)
+                _bounce_busy = false;
+            else
+                _service.recycle (chunk.bid);
+            _rx.pop_front ();
+        }
+    }
+    _rx_bytes -= n;
+
+    //  There is room again; keep the socket drained.
+    if (n > 0)
+        arm_recv ();
+    return n;
+}
+
+void io_uring_stream_t::post (completion_handler_t &handler_,
+                              const boost::system::error_code &ec_,
+                              std::size_t bytes_)
+{
+    completion_handler_t handler;
+    handler.swap (handler_);
+    boost::asio::post (_service._io_context,
+                       [handler, ec_, bytes_] () { handler (ec_, bytes_); });
+}
+}
+
+#endif  // ZLINK_IOTHREAD_POLLER_USE_ASIO && ZLINK_HAVE_IO_URING
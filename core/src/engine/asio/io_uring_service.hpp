@@ -0,0 +1,262 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZLINK_IO_URING_SERVICE_HPP_INCLUDED__
+#define __ZLINK_IO_URING_SERVICE_HPP_INCLUDED__
+
+#include "core/poller.hpp"
+#if defined ZLINK_IOTHREAD_POLLER_USE_ASIO && defined ZLINK_HAVE_IO_URING
+
+#include <boost/asio.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "engine/asio/i_asio_transport.hpp"
+#include "utils/fd.hpp"
+#include "utils/macros.hpp"
+#include "utils/stdint.hpp"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+namespace zlink
+{
+class io_uring_stream_t;
+
+//  io_uring backend for the stream transports of one I/O thread.
+//
+//  Installed as an asio service on the I/O thread's io_context when the
+//  context enables ZLINK_IO_URING and the kernel supports it; the TCP and
+//  IPC transports then drive their socket through an io_uring_stream_t
+//  instead of an asio socket.
+//
+//  Submissions queued while handlers run are flushed with one
+//  io_uring_enter when the io_context gets to the posted flush, and
+//  completions are announced through an eventfd the io_context waits on,
+//  so a single wakeup serves every connection of the thread.
+//
+//  Receives are multishot and land in buffers the kernel picks from a
+//  buffer ring registered once for the whole thread, so an idle connection
+//  pins no receive buffer at all.
+class io_uring_service_t ZLINK_FINAL
+    : public boost::asio::execution_context::service
+{
+  public:
+    static boost::asio::execution_context::id id;
+
+    //  Installs the service on io_context_. Returns false, leaving the
+    //  io_context alone, if the kernel lacks what the service needs; the
+    //  transports then keep using asio sockets.
+    static bool install (boost::asio::io_context &io_context_);
+
+    //  Returns the service installed on io_context_, or NULL.
+    static io_uring_service_t *find (boost::asio::io_context &io_context_);
+
+    //  Only install creates working services; asio needs the constructor
+    //  to be accessible all the same.
+    explicit io_uring_service_t (boost::asio::io_context &io_context_);
+    ~io_uring_service_t () ZLINK_OVERRIDE;
+
+    //  Takes ownership of the connected socket fd_. The stream stays valid
+    //  until io_uring_stream_t::close.
+    io_uring_stream_t *open_stream (fd_t fd_);
+
+  private:
+    friend class io_uring_stream_t;
+
+    void shutdown () ZLINK_OVERRIDE;
+
+    //  Sets up the rings, the eventfd and the buffer ring.
+    bool init ();
+
+    //  Returns a zeroed submission entry; the flush is scheduled.
+    io_uring_sqe *get_sqe ();
+
+    //  Completion moved out of the kernel's queue but not yet dispatched.
+    struct cqe_t
+    {
+        uint64_t user_data;
+        int32_t res;
+        uint32_t flags;
+    };
+
+    //  Hands the queued entries to the kernel. Never runs a handler.
+    void submit ();
+    void flush ();
+
+    void wait_completions ();
+    void reap ();
+    //  Moves the completions out of the kernel's queue into _backlog so
+    //  that it can take more, leaving their dispatch to reap.
+    void stash ();
+    void complete (const cqe_t &cqe_);
+
+    //  Returns a receive buffer to the kernel.
+    void recycle (uint16_t bid_);
+    unsigned char *buffer (uint16_t bid_) const;
+
+    void release (io_uring_stream_t *stream_);
+
+    boost::asio::io_context &_io_context;
+
+    int _ring_fd;
+
+    //  Submission and completion rings share one mapping.
+    void *_ring;
+    std::size_t _ring_size;
+
+    unsigned *_sq_head;
+    unsigned *_sq_tail;
+    unsigned _sq_mask;
+    unsigned _sq_entries;
+    unsigned *_sq_flags;
+    io_uring_sqe *_sqes;
+    std::size_t _sqes_size;
+    unsigned _sq_local_tail;
+    unsigned _sq_submitted;
+
+    unsigned *_cq_head;
+    unsigned *_cq_tail;
+    unsigned _cq_mask;
+    io_uring_cqe *_cqes;
+
+    bool _flush_posted;
+    bool _reaping;
+
+    //  Set while get_sqe makes room; handlers must not run then.
+    bool _submitting;
+
+    //  Completions stashed while the kernel's queue was full, oldest first.
+    std::deque<cqe_t> _backlog;
+
+    int _event_fd;
+    std::unique_ptr<boost::asio::posix::stream_descriptor> _event;
+
+    io_uring_buf_ring *_buf_ring;
+    std::size_t _buf_ring_size;
+    unsigned char *_buffers;
+    uint16_t _buf_tail;
+
+    //  Cleared when the kernel refuses multishot receive.
+    bool _multishot;
+
+    //  Streams not yet released, including closed ones whose operations
+    //  the kernel has still to complete.
+    std::vector<io_uring_stream_t *> _streams;
+
+    ZLINK_NON_COPYABLE_NOR_MOVABLE (io_uring_service_t)
+};
+
+//  Connected socket driven by an io_uring_service_t. Mirrors the subset of
+//  i_asio_transport the stream transports need; handlers run from the
+//  io_context, never from within the initiating call.
+class io_uring_stream_t
+{
+  public:
+    typedef i_asio_transport::completion_handler_t completion_handler_t;
+
+    //  Fails the pending operations with operation_aborted, closes the
+    //  socket and gives the stream back to the service. The stream must
+    //  not be used afterwards.
+    void close ();
+
+    //  Fails the pending read with operation_aborted at once and asks the
+    //  kernel to drop the in-flight send, whose handler then runs with
+    //  operation_aborted as well. The stream stays open.
+    void cancel ();
+
+    void async_read_some (unsigned char *buffer_,
+                          std::size_t size_,
+                          completion_handler_t handler_);
+
+    //  Returns data already received; 0 with errno EAGAIN if there is none.
+    std::size_t read_some (unsigned char *buffer_, std::size_t len_);
+
+    //  Writes all of the buffers, which must stay valid until the handler
+    //  runs.
+    void async_write (const boost::asio::const_buffer *buffers_,
+                      std::size_t count_,
+                      completion_handler_t handler_);
+
+    std::size_t write_some (const unsigned char *data_, std::size_t len_);
+
+  private:
+    friend class io_uring_service_t;
+
+    //  Completion target; its address is the user data of the entry.
+    struct op_t
+    {
+        io_uring_stream_t *stream;
+        bool recv;
+    };
+
+    //  Received bytes not yet handed to the engine.
+    struct chunk_t
+    {
+        uint16_t bid;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    io_uring_stream_t (io_uring_service_t &service_, fd_t fd_);
+    ~io_uring_stream_t ();
+
+    void arm_recv ();
+    void cancel (op_t *op_);
+    void on_recv (int res_, unsigned flags_);
+    void on_send (int res_);
+    void submit_send ();
+    std::size_t take (unsigned char *buffer_, std::size_t size_);
+    void post (completion_handler_t &handler_,
+               const boost::system::error_code &ec_,
+               std::size_t bytes_);
+    bool idle () const { return !_recv_armed && !_send_inflight; }
+
+    io_uring_service_t &_service;
+    fd_t _fd;
+    bool _closed;
+
+    //  Position in the service's stream list.
+    std::size_t _index;
+
+    op_t _recv_op;
+    bool _recv_armed;
+    bool _recv_multishot;
+    bool _recv_cancelling;
+
+    //  Set when the buffer ring ran dry; the next receive goes into the
+    //  stream's own bounce buffer instead.
+    bool _starved;
+    std::vector<unsigned char> _bounce;
+    bool _bounce_busy;
+
+    std::deque<chunk_t> _rx;
+    std::size_t _rx_bytes;
+    boost::system::error_code _rx_error;
+
+    unsigned char *_read_buffer;
+    std::size_t _read_size;
+    completion_handler_t _read_handler;
+
+    op_t _send_op;
+    bool _send_inflight;
+    bool _send_cancelling;
+    std::vector<struct iovec> _iov;
+    std::size_t _iov_pos;
+    std::size_t _sent;
+    struct msghdr _msg;
+    completion_handler_t _write_handler;
+
+    ZLINK_NON_COPYABLE_NOR_MOVABLE (io_uring_stream_t)
+};
+}
+
+#endif  // ZLINK_IOTHREAD_POLLER_USE_ASIO && ZLINK_HAVE_IO_URING
+
+#endif  // __ZLINK_IO_URING_SERVICE_HPP_INCLUDED__
@@ -47,6 +47,19 @@ struct i_engine
     virtual void restart_output () = 0;
 
     virtual const endpoint_uri_pair_t &get_endpoint () const = 0;
+
+    //  Asks the engine to move to another I/O thread. The engine stops
+    //  its I/O, moves once nothing is in flight any more and hands over
+    //  to the session with engine_migrated. Returns false if the engine
+    //  cannot move; engines are not movable unless they override this.
+    virtual bool migrate (zlink::io_thread_t *io_thread_)
+    {
+        LIBZLINK_UNUSED (io_thread_);
+        return false;
+    }
+
+    //  Restarts the I/O of a moved engine in its new I/O thread.
+    virtual void resume () {}
 };
 }
 
@@ -122,6 +122,11 @@ class decoder_base_t : public i_decoder
         _allocator.resize (new_size_);
     }
 
+    void set_buffer_size (std::size_t new_size_) ZLINK_FINAL
+    {
+        _allocator.set_max_size (new_size_);
+    }
+
   protected:
     //  Prototype of state machine action. Action should return false if
     //  it is unable to push the data to the system.
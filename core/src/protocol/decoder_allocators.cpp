@@ -4,14 +4,17 @@
 #include "protocol/decoder_allocators.hpp"
 
 #include "core/msg.hpp"
+#include "utils/allocator.hpp"
 
 zlink::shared_message_memory_allocator::shared_message_memory_allocator (
   std::size_t bufsize_) :
     _buf (NULL),
     _buf_size (0),
     _max_size (bufsize_),
+    _buf_max_size (0),
     _msg_content (NULL),
-    _max_counters ((_max_size + msg_t::max_vsm_size - 1) / msg_t::max_vsm_size)
+    _max_counters ((_max_size + msg_t::max_vsm_size - 1) / msg_t::max_vsm_size),
+    _counters_follow_size (true)
 {
 }
 
@@ -20,8 +23,10 @@ zlink::shared_message_memory_allocator::shared_message_memory_allocator (
     _buf (NULL),
     _buf_size (0),
     _max_size (bufsize_),
+    _buf_max_size (0),
     _msg_content (NULL),
-    _max_counters (max_messages_)
+    _max_counters (max_messages_),
+    _counters_follow_size (false)
 {
 }
 
@@ -47,6 +52,13 @@ unsigned char *zlink::shared_message_memory_allocator::allocate ()
         }
     }
 
+    // an unused buffer of the wrong size is dropped rather than re-used
+    if (_buf && _buf_max_size != _max_size) {
+        reinterpret_cast<zlink::atomic_counter_t *> (_buf)->~atomic_counter_t ();
+        dealloc_tl (_buf);
+        clear ();
+    }
+
     // if buf != NULL it is not used by any message so we can re-use it for the next run
     if (!_buf) {
         // allocate memory for reference counters together with reception buffer
@@ -54,10 +66,11 @@ unsigned char *zlink::shared_message_memory_allocator::allocate ()
           _max_size + sizeof (zlink::atomic_counter_t)
           + _max_counters * sizeof (zlink::msg_t::content_t);
 
-        _buf = static_cast<unsigned char *> (std::malloc (allocationsize));
+        _buf = static_cast<unsigned char *> (alloc_tl (allocationsize));
         alloc_assert (_buf);
 
         new (_buf) atomic_counter_t (1);
+        _buf_max_size = _max_size;
     } else {
         // release reference count to couple lifetime to messages
         zlink::atomic_counter_t *c =
@@ -71,12 +84,22 @@ unsigned char *zlink::shared_message_memory_allocator::allocate ()
     return _buf + sizeof (zlink::atomic_counter_t);
 }
 
+void zlink::shared_message_memory_allocator::set_max_size (
+  std::size_t max_size_)
+{
+    zlink_assert (max_size_ > 0);
+    _max_size = max_size_;
+    if (_counters_follow_size)
+        _max_counters =
+          (_max_size + msg_t::max_vsm_size - 1) / msg_t::max_vsm_size;
+}
+
 void zlink::shared_message_memory_allocator::deallocate ()
 {
     zlink::atomic_counter_t *c = reinterpret_cast<zlink::atomic_counter_t *> (_buf);
     if (_buf && !c->sub (1)) {
         c->~atomic_counter_t ();
-        std::free (_buf);
+        dealloc_tl (_buf);
     }
     clear ();
 }
@@ -108,7 +131,7 @@ void zlink::shared_message_memory_allocator::call_dec_ref (void *, void *hint_)
 
     if (!c->sub (1)) {
         c->~atomic_counter_t ();
-        std::free (buf);
+        dealloc_tl (buf);
         buf = NULL;
     }
 }
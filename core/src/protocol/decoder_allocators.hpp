@@ -9,6 +9,7 @@
 #include "utils/atomic_counter.hpp"
 #include "core/msg.hpp"
 #include "utils/err.hpp"
+#include "utils/allocator.hpp"
 
 namespace zlink
 {
@@ -18,12 +19,12 @@ class c_single_allocator
   public:
     explicit c_single_allocator (std::size_t bufsize_) :
         _buf_size (bufsize_),
-        _buf (static_cast<unsigned char *> (std::malloc (_buf_size)))
+        _buf (static_cast<unsigned char *> (alloc (_buf_size)))
     {
         alloc_assert (_buf);
     }
 
-    ~c_single_allocator () { std::free (_buf); }
+    ~c_single_allocator () { dealloc (_buf); }
 
     unsigned char *allocate () { return _buf; }
 
@@ -34,6 +35,8 @@ class c_single_allocator
     //  This buffer is fixed, size must not be changed
     void resize (std::size_t new_size_) { LIBZLINK_UNUSED (new_size_); }
 
+    void set_max_size (std::size_t max_size_) { LIBZLINK_UNUSED (max_size_); }
+
   private:
     std::size_t _buf_size;
     unsigned char *_buf;
@@ -88,6 +91,11 @@ class shared_message_memory_allocator
 
     void resize (std::size_t new_size_) { _buf_size = new_size_; }
 
+    // Change the size of buffers allocated from now on. A buffer that is
+    // still referenced by messages keeps its size; an idle buffer of the
+    // old size is replaced on the next allocate ().
+    void set_max_size (std::size_t max_size_);
+
     zlink::msg_t::content_t *provide_content () { return _msg_content; }
 
     void advance_content () { _msg_content++; }
@@ -97,9 +105,13 @@ class shared_message_memory_allocator
 
     unsigned char *_buf;
     std::size_t _buf_size;
-    const std::size_t _max_size;
+    std::size_t _max_size;
+    // Size _buf was allocated with (may lag behind _max_size).
+    std::size_t _buf_max_size;
     zlink::msg_t::content_t *_msg_content;
     std::size_t _max_counters;
+    // True if _max_counters is derived from _max_size.
+    const bool _counters_follow_size;
 };
 }
 
@@ -20,6 +20,11 @@ class i_decoder
     virtual void get_buffer (unsigned char **data_, size_t *size_) = 0;
 
     virtual void resize_buffer (size_t) = 0;
+
+    //  Changes the size of the buffers handed out by get_buffer, starting
+    //  with the next one. Decoders with a fixed buffer ignore it.
+    virtual void set_buffer_size (size_t) = 0;
+
     //  Decodes data pointed to by data_.
     //  When a message is decoded, 1 is returned.
     //  When the decoder needs more data, 0 is returned.
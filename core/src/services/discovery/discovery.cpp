@@ -5,6 +5,7 @@
 #include "services/discovery/discovery.hpp"
 #include "services/discovery/discovery_protocol.hpp"
 
+#include "utils/clock.hpp"
 #include "utils/err.hpp"
 
 #include <algorithm>
@@ -19,6 +20,13 @@ static bool is_valid_service_type (uint16_t service_type_)
            || service_type_ == discovery_protocol::service_type_spot_node;
 }
 
+static const provider_snapshot_ptr &empty_snapshot ()
+{
+    static const provider_snapshot_ptr snapshot =
+      std::make_shared<provider_snapshot_t> ();
+    return snapshot;
+}
+
 static void close_frames (std::vector<zlink_msg_t> *frames_)
 {
     if (!frames_)
@@ -33,6 +41,7 @@ discovery_t::discovery_t (ctx_t *ctx_, uint16_t service_type_) :
     _tag (discovery_tag_value),
     _stop (0),
     _update_seq (0),
+    _table (std::make_shared<service_table_t> ()),
     _service_type (service_type_)
 {
     zlink_assert (_ctx);
@@ -74,7 +83,8 @@ int discovery_t::subscribe (const char *service_name_)
         return -1;
     }
     scoped_lock_t lock (_sync);
-    _subscriptions.insert (service_name_);
+    if (_subscriptions.insert (service_name_).second)
+        publish ();
     return 0;
 }
 
@@ -85,7 +95,8 @@ int discovery_t::unsubscribe (const char *service_name_)
         return -1;
     }
     scoped_lock_t lock (_sync);
-    _subscriptions.erase (service_name_);
+    if (_subscriptions.erase (service_name_) > 0)
+        publish ();
     return 0;
 }
 
@@ -122,37 +133,20 @@ int discovery_t::set_socket_option (int socket_role_,
     return 0;
 }
 
-void discovery_t::snapshot_providers (const std::string &service_name_,
-                                      std::vector<provider_info_t> *out_)
-{
-    if (!out_)
-        return;
-    out_->clear ();
-    scoped_lock_t lock (_sync);
-    if (!_subscriptions.empty ()
-        && _subscriptions.find (service_name_) == _subscriptions.end ())
-        return;
-    std::map<std::string, service_state_t>::iterator it =
-      _services.find (service_name_);
-    if (it == _services.end ())
-        return;
-    *out_ = it->second.providers;
-}
-
-uint64_t discovery_t::update_seq ()
+provider_snapshot_ptr
+discovery_t::providers (const std::string &service_name_) const
 {
-    scoped_lock_t lock (_sync);
-    return _update_seq;
+    const service_table_ptr table = std::atomic_load (&_table);
+    std::map<std::string, provider_snapshot_ptr>::const_iterator it =
+      table->services.find (service_name_);
+    if (it == table->services.end ())
+        return empty_snapshot ();
+    return it->second;
 }
 
-uint64_t discovery_t::service_update_seq (const std::string &service_name_)
+uint64_t discovery_t::update_seq () const
 {
-    scoped_lock_t lock (_sync);
-    std::map<std::string, uint64_t>::iterator it =
-      _service_seq.find (service_name_);
-    if (it == _service_seq.end ())
-        return 0;
-    return it->second;
+    return std::atomic_load (&_table)->seq;
 }
 
 void discovery_t::add_observer (discovery_observer_t *observer_)
@@ -180,17 +174,16 @@ int discovery_t::get_receivers (const char *service_name_,
         return -1;
     }
 
-    std::vector<provider_info_t> snapshot;
-    snapshot_providers (service_name_, &snapshot);
+    const provider_snapshot_ptr snapshot = providers (service_name_);
 
     const size_t capacity = *count_;
-    *count_ = snapshot.size ();
+    *count_ = snapshot->providers.size ();
     if (!providers_)
         return 0;
 
-    const size_t copy_count = std::min (capacity, snapshot.size ());
+    const size_t copy_count = std::min (capacity, snapshot->providers.size ());
     for (size_t i = 0; i < copy_count; ++i) {
-        const provider_info_t &entry = snapshot[i];
+        const provider_info_t &entry = snapshot->providers[i];
         memset (&providers_[i], 0, sizeof (providers_[i]));
         strncpy (providers_[i].service_name, entry.service_name.c_str (),
                  sizeof (providers_[i].service_name) - 1);
@@ -211,15 +204,7 @@ int discovery_t::receiver_count (const char *service_name_)
         return -1;
     }
 
-    scoped_lock_t lock (_sync);
-    if (!_subscriptions.empty ()
-        && _subscriptions.find (service_name_) == _subscriptions.end ())
-        return 0;
-    std::map<std::string, service_state_t>::iterator it =
-      _services.find (service_name_);
-    if (it == _services.end ())
-        return 0;
-    return static_cast<int> (it->second.providers.size ());
+    return static_cast<int> (providers (service_name_)->providers.size ());
 }
 
 int discovery_t::service_available (const char *service_name_)
@@ -229,15 +214,7 @@ int discovery_t::service_available (const char *service_name_)
         return -1;
     }
 
-    scoped_lock_t lock (_sync);
-    if (!_subscriptions.empty ()
-        && _subscriptions.find (service_name_) == _subscriptions.end ())
-        return 0;
-    std::map<std::string, service_state_t>::iterator it =
-      _services.find (service_name_);
-    if (it == _services.end ())
-        return 0;
-    return it->second.providers.empty () ? 0 : 1;
+    return providers (service_name_)->providers.empty () ? 0 : 1;
 }
 
 int discovery_t::destroy ()
@@ -273,6 +250,8 @@ void discovery_t::loop ()
     zlink_setsockopt (sub, ZLINK_SUBSCRIBE, "", 0);
 
     std::set<std::string> connected;
+    zlink::clock_t clock;
+    uint64_t next_list_request = 0;
 
     while (_stop.get () == 0) {
         std::set<std::string> endpoints;
@@ -309,9 +288,18 @@ void discovery_t::loop ()
                 if (!zlink_msg_more (&frame))
                     break;
             }
-            if (!frames.empty ())
-                handle_service_list (frames);
+            //  Lists and deltas are single frames.
+            const bool gap =
+              frames.size () == 1 && handle_service_list (frames[0]);
             close_frames (&frames);
+            if (gap) {
+                const uint64_t now = clock.now_ms ();
+                if (now >= next_list_request) {
+                    discovery_protocol::request_service_list (sub);
+                    next_list_request =
+                      now + discovery_protocol::list_request_interval_ms;
+                }
+            }
         }
     }
 
@@ -338,127 +326,193 @@ void discovery_t::notify_observers (const std::set<std::string> &services_)
     }
 }
 
-void discovery_t::  handle_service_list (const std::vector<zlink_msg_t> &frames_)
+//  Builds the snapshots that are missing and swaps in a new table. Readers
+//  still holding the old table keep it, and the snapshots in it, alive.
+void discovery_t::publish ()
 {
-    if (frames_.size () < 4)
-        return;
-
-    uint16_t msg_id = 0;
-    if (!discovery_protocol::read_u16 (frames_[0], &msg_id))
-        return;
-    if (msg_id != discovery_protocol::msg_service_list)
-        return;
-
-    uint32_t registry_id = 0;
-    uint64_t list_seq = 0;
-    uint32_t service_count = 0;
-
-    if (!discovery_protocol::read_u32 (frames_[1], &registry_id)
-        || !discovery_protocol::read_u64 (frames_[2], &list_seq)
-        || !discovery_protocol::read_u32 (frames_[3], &service_count)) {
-        return;
+    std::shared_ptr<service_table_t> table =
+      std::make_shared<service_table_t> ();
+    table->seq = _update_seq;
+    for (std::map<std::string, service_state_t>::iterator it =
+           _services.begin ();
+         it != _services.end (); ++it) {
+        if (!_subscriptions.empty ()
+            && _subscriptions.find (it->first) == _subscriptions.end ())
+            continue;
+        service_state_t &state = it->second;
+        if (!state.snapshot) {
+            std::shared_ptr<provider_snapshot_t> snapshot =
+              std::make_shared<provider_snapshot_t> ();
+            snapshot->seq = _update_seq;
+            snapshot->providers = state.providers;
+            state.snapshot = snapshot;
+        }
+        table->services.insert (table->services.end (),
+                                std::make_pair (it->first, state.snapshot));
     }
+    std::atomic_store (&_table, service_table_ptr (table));
+}
 
-    std::map<std::string, service_state_t> updated;
-
-    size_t index = 4;
-    for (uint32_t i = 0; i < service_count && index < frames_.size (); ++i) {
-        if (index + 2 >= frames_.size ())
-            break;
-        uint16_t service_type = 0;
-        if (!discovery_protocol::read_u16 (frames_[index++], &service_type))
-            break;
-        const std::string service_name =
-          discovery_protocol::read_string (frames_[index++]);
-        uint32_t receiver_count = 0;
-        if (!discovery_protocol::read_u32 (frames_[index++], &receiver_count))
-            break;
-
-        service_state_t state;
-        for (uint32_t p = 0; p < receiver_count && index + 2 < frames_.size ();
-             ++p) {
-            provider_info_t info;
-            info.service_name = service_name;
-            info.endpoint = discovery_protocol::read_string (frames_[index++]);
-            discovery_protocol::read_routing_id (frames_[index++],
-                                                 &info.routing_id);
-            discovery_protocol::read_u32 (frames_[index++], &info.weight);
-            info.registered_at = 0;
-            if (service_type == _service_type)
-                state.providers.push_back (info);
-        }
+static bool same_provider (const provider_info_t &a_,
+                           const provider_info_t &b_)
+{
+    if (a_.endpoint != b_.endpoint)
+        return false;
+    if (a_.routing_id.size != b_.routing_id.size)
+        return false;
+    if (a_.routing_id.size > 0
+        && memcmp (a_.routing_id.data, b_.routing_id.data, a_.routing_id.size)
+             != 0)
+        return false;
+    return a_.weight == b_.weight;
+}
 
-        if (service_type != _service_type)
-            continue;
+static bool endpoint_less (const provider_info_t &a_, const provider_info_t &b_)
+{
+    return a_.endpoint < b_.endpoint;
+}
 
-        std::map<std::string, service_state_t>::iterator it =
-          updated.find (service_name);
-        if (it == updated.end ()) {
-            updated[service_name] = state;
-        } else {
-            it->second.providers.insert (it->second.providers.end (),
-                                         state.providers.begin (),
-                                         state.providers.end ());
-        }
-    }
+//  Returns true if updates of the registry were missed, so that its whole
+//  list is needed.
+bool discovery_t::handle_service_list (const zlink_msg_t &msg_)
+{
+    discovery_protocol::service_update_t update;
+    if (!discovery_protocol::decode_service_update (
+          zlink_msg_data (const_cast<zlink_msg_t *> (&msg_)),
+          zlink_msg_size (&msg_), &update))
+        return false;
 
     std::set<std::string> changed;
     {
         scoped_lock_t lock (_sync);
         std::map<uint32_t, uint64_t>::iterator sit =
-          _registry_seq.find (registry_id);
-        if (sit != _registry_seq.end () && list_seq <= sit->second)
-            return;
-        _registry_seq[registry_id] = list_seq;
-
-        const auto provider_equal =
-          [] (const provider_info_t &a_, const provider_info_t &b_) {
-              if (a_.endpoint != b_.endpoint)
-                  return false;
-              if (a_.routing_id.size != b_.routing_id.size)
-                  return false;
-              if (a_.routing_id.size > 0
-                  && memcmp (a_.routing_id.data, b_.routing_id.data,
-                             a_.routing_id.size)
-                       != 0)
-                  return false;
-              return a_.weight == b_.weight;
-          };
-        const auto providers_equal =
-          [&] (const service_state_t &a_, const service_state_t &b_) {
-              if (a_.providers.size () != b_.providers.size ())
-                  return false;
-              for (size_t i = 0; i < a_.providers.size (); ++i) {
-                  if (!provider_equal (a_.providers[i], b_.providers[i]))
-                      return false;
-              }
-              return true;
-          };
-
-        for (std::map<std::string, service_state_t>::iterator uit =
-               updated.begin ();
-             uit != updated.end (); ++uit) {
-            std::map<std::string, service_state_t>::iterator oit =
-              _services.find (uit->first);
-            if (oit == _services.end ()
-                || !providers_equal (oit->second, uit->second)) {
-                _service_seq[uit->first] = _update_seq + 1;
-                changed.insert (uit->first);
+          _registry_seq.find (update.registry_id);
+        const bool known = sit != _registry_seq.end ();
+        if (known && update.seq <= sit->second)
+            return false;
+
+        if (update.msg_id == discovery_protocol::msg_service_delta) {
+            if (!known || update.base_seq != sit->second)
+                return true;
+            apply_delta (update.changes, &changed);
+        } else
+            apply_list (update.changes, &changed);
+        _registry_seq[update.registry_id] = update.seq;
+
+        if (!changed.empty ()) {
+            _update_seq++;
+            for (std::set<std::string>::const_iterator it = changed.begin ();
+                 it != changed.end (); ++it) {
+                std::map<std::string, service_state_t>::iterator sit =
+                  _services.find (*it);
+                if (sit != _services.end ())
+                    sit->second.snapshot.reset ();
             }
+            publish ();
         }
-        for (std::map<std::string, service_state_t>::iterator oit =
-               _services.begin ();
-             oit != _services.end (); ++oit) {
-            if (updated.find (oit->first) == updated.end ()) {
-                _service_seq[oit->first] = _update_seq + 1;
-                changed.insert (oit->first);
-            }
-        }
-        _services.swap (updated);
-        _update_seq++;
     }
 
-    if (!changed.empty ())
-        notify_observers (changed);
+    notify_observers (changed);
+    return false;
+}
+
+void discovery_t::apply_list (
+  const std::vector<discovery_protocol::provider_change_t> &changes_,
+  std::set<std::string> *changed_)
+{
+    std::map<std::string, service_state_t> updated;
+    for (size_t i = 0; i < changes_.size (); ++i) {
+        const discovery_protocol::provider_change_t &change = changes_[i];
+        if (change.service_type != _service_type)
+            continue;
+        provider_info_t info;
+        info.service_name = change.service_name;
+        info.endpoint = change.endpoint;
+        info.routing_id = change.routing_id;
+        info.weight = change.weight;
+        info.registered_at = 0;
+        updated[change.service_name].providers.push_back (info);
+    }
+
+    for (std::map<std::string, service_state_t>::iterator uit =
+           updated.begin ();
+         uit != updated.end (); ++uit) {
+        std::vector<provider_info_t> &providers = uit->second.providers;
+        std::sort (providers.begin (), providers.end (), endpoint_less);
+
+        std::map<std::string, service_state_t>::iterator oit =
+          _services.find (uit->first);
+        if (oit == _services.end ()
+            || oit->second.providers.size () != providers.size ()
+            || !std::equal (providers.begin (), providers.end (),
+                            oit->second.providers.begin (), same_provider))
+            changed_->insert (uit->first);
+        else
+            uit->second.snapshot = oit->second.snapshot;
+    }
+    for (std::map<std::string, service_state_t>::iterator oit =
+           _services.begin ();
+         oit != _services.end (); ++oit) {
+        if (updated.find (oit->first) == updated.end ())
+            changed_->insert (oit->first);
+    }
+    _services.swap (updated);
+}
+
+void discovery_t::apply_delta (
+  const std::vector<discovery_protocol::provider_change_t> &changes_,
+  std::set<std::string> *changed_)
+{
+    for (size_t i = 0; i < changes_.size (); ++i) {
+        const discovery_protocol::provider_change_t &change = changes_[i];
+        if (change.service_type != _service_type)
+            continue;
+
+        provider_info_t info;
+        info.service_name = change.service_name;
+        info.endpoint = change.endpoint;
+        info.routing_id = change.routing_id;
+        info.weight = change.weight;
+        info.registered_at = 0;
+
+        //  Providers are kept in the order of their endpoints, as lists
+        //  bring them.
+        std::map<std::string, service_state_t>::iterator sit =
+          _services.find (change.service_name);
+        if (sit == _services.end ()) {
+            if (change.op != discovery_protocol::delta_add)
+                continue;
+            sit = _services
+                    .insert (std::make_pair (change.service_name,
+                                             service_state_t ()))
+                    .first;
+        }
+        std::vector<provider_info_t> &providers = sit->second.providers;
+        std::vector<provider_info_t>::iterator pit = std::lower_bound (
+          providers.begin (), providers.end (), info, endpoint_less);
+        const bool found =
+          pit != providers.end () && pit->endpoint == change.endpoint;
+
+        if (change.op == discovery_protocol::delta_add) {
+            if (found && same_provider (*pit, info))
+                continue;
+            if (found)
+                *pit = info;
+            else
+                providers.insert (pit, info);
+        } else if (!found)
+            continue;
+        else if (change.op == discovery_protocol::delta_remove) {
+            providers.erase (pit);
+            if (providers.empty ())
+                _services.erase (sit);
+        } else if (change.op == discovery_protocol::delta_weight) {
+            if (pit->weight == change.weight)
+                continue;
+            pit->weight = change.weight;
+        } else
+            continue;
+        changed_->insert (change.service_name);
+    }
 }
 }
@@ -5,10 +5,12 @@
 
 #include "core/ctx.hpp"
 #include "core/thread.hpp"
+#include "services/discovery/discovery_protocol.hpp"
 #include "utils/atomic_counter.hpp"
 #include "utils/mutex.hpp"
 
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -24,6 +26,15 @@ struct provider_info_t
     uint64_t registered_at;
 };
 
+//  The providers of a service as of one update. A snapshot is immutable
+//  once published, so readers share it instead of copying it.
+struct provider_snapshot_t
+{
+    uint64_t seq;
+    std::vector<provider_info_t> providers;
+};
+typedef std::shared_ptr<const provider_snapshot_t> provider_snapshot_ptr;
+
 class discovery_observer_t
 {
   public:
@@ -56,10 +67,10 @@ class discovery_t
 
     uint16_t service_type () const { return _service_type; }
 
-    void snapshot_providers (const std::string &service_name_,
-                             std::vector<provider_info_t> *out_);
-    uint64_t update_seq ();
-    uint64_t service_update_seq (const std::string &service_name_);
+    //  Never returns NULL; a service without providers, or one that is
+    //  not subscribed, has an empty snapshot.
+    provider_snapshot_ptr providers (const std::string &service_name_) const;
+    uint64_t update_seq () const;
     void add_observer (discovery_observer_t *observer_);
     void remove_observer (discovery_observer_t *observer_);
 
@@ -67,12 +78,31 @@ class discovery_t
     struct service_state_t
     {
         std::vector<provider_info_t> providers;
+        //  Published copy of providers; reset when they change.
+        provider_snapshot_ptr snapshot;
+    };
+
+    //  What readers see: the snapshots of the subscribed services. The
+    //  table is replaced as a whole after each change and never modified,
+    //  so readers only load the pointer.
+    struct service_table_t
+    {
+        uint64_t seq;
+        std::map<std::string, provider_snapshot_ptr> services;
     };
+    typedef std::shared_ptr<const service_table_t> service_table_ptr;
 
     static void run (void *arg_);
     void loop ();
-    void handle_service_list (const std::vector<zlink_msg_t> &frames_);
+    bool handle_service_list (const zlink_msg_t &msg_);
+    void apply_list (const std::vector<discovery_protocol::provider_change_t>
+                       &changes_,
+                     std::set<std::string> *changed_);
+    void apply_delta (const std::vector<discovery_protocol::provider_change_t>
+                        &changes_,
+                      std::set<std::string> *changed_);
     void notify_observers (const std::set<std::string> &services_);
+    void publish ();
 
     ctx_t *_ctx;
     uint32_t _tag;
@@ -87,7 +117,8 @@ class discovery_t
     std::set<std::string> _subscriptions;
     std::set<discovery_observer_t *> _observers;
     uint64_t _update_seq;
-    std::map<std::string, uint64_t> _service_seq;
+    //  Written under _sync, read without it through atomic_load.
+    service_table_ptr _table;
     struct socket_opt_t
     {
         int option;
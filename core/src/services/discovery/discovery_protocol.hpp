@@ -4,10 +4,12 @@
 #define __ZLINK_DISCOVERY_PROTOCOL_HPP_INCLUDED__
 
 #include "core/msg.hpp"
+#include "protocol/wire.hpp"
 #include "utils/err.hpp"
 #include "utils/stdint.hpp"
 
 #include <string>
+#include <vector>
 
 namespace zlink
 {
@@ -20,6 +22,16 @@ static const uint16_t msg_heartbeat = 0x0004;
 static const uint16_t msg_service_list = 0x0005;
 static const uint16_t msg_registry_sync = 0x0006;
 static const uint16_t msg_update_weight = 0x0007;
+static const uint16_t msg_service_delta = 0x0008;
+
+//  Operations carried by msg_service_delta.
+static const uint8_t delta_add = 1;
+static const uint8_t delta_remove = 2;
+static const uint8_t delta_weight = 3;
+
+//  Minimum time between two requests for a whole service list, see
+//  request_service_list.
+static const uint64_t list_request_interval_ms = 500;
 
 static const uint16_t service_type_gateway_receiver = 1;
 static const uint16_t service_type_spot_node = 2;
@@ -120,6 +132,252 @@ inline bool read_routing_id (const zlink_msg_t &msg_, zlink_routing_id_t *out_)
                 zlink_msg_data (const_cast<zlink_msg_t *> (&msg_)), size);
     return true;
 }
+
+//  The registry publishes msg_service_list and msg_service_delta as a
+//  single frame, in network byte order. Strings are prefixed with a u16
+//  length, routing ids with a u8 length.
+//
+//  msg_service_list:  u16 msg_id, u32 registry_id, u64 seq,
+//                     u32 service_count, then per service
+//                       u16 service_type, string service_name,
+//                       u32 provider_count, then per provider
+//                         string endpoint, routing_id, u32 weight
+//
+//  msg_service_delta: u16 msg_id, u32 registry_id, u64 base_seq, u64 seq,
+//                     u32 change_count, then per change
+//                       u8 op, u16 service_type, string service_name,
+//                       string endpoint, routing_id, u32 weight
+//
+//  A delta turns the list at base_seq into the list at seq. A delta with
+//  no changes and base_seq == seq is a keepalive announcing the current
+//  sequence number.
+
+class frame_writer_t
+{
+  public:
+    void put_u8 (uint8_t value_) { _buf.push_back (value_); }
+
+    void put_u16 (uint16_t value_)
+    {
+        unsigned char *p = grow (2);
+        put_uint16 (p, value_);
+    }
+
+    void put_u32 (uint32_t value_)
+    {
+        unsigned char *p = grow (4);
+        put_uint32 (p, value_);
+    }
+
+    void put_u64 (uint64_t value_)
+    {
+        unsigned char *p = grow (8);
+        put_uint64 (p, value_);
+    }
+
+    void put_string (const std::string &value_)
+    {
+        const size_t size = value_.size () > 0xffff ? 0xffff : value_.size ();
+        put_u16 (static_cast<uint16_t> (size));
+        if (size > 0)
+            memcpy (grow (size), value_.data (), size);
+    }
+
+    void put_routing_id (const zlink_routing_id_t &rid_)
+    {
+        put_u8 (rid_.size);
+        if (rid_.size > 0)
+            memcpy (grow (rid_.size), rid_.data, rid_.size);
+    }
+
+    //  Overwrites a u32 written earlier at offset_.
+    void patch_u32 (size_t offset_, uint32_t value_)
+    {
+        zlink_assert (offset_ + 4 <= _buf.size ());
+        put_uint32 (&_buf[offset_], value_);
+    }
+
+    size_t size () const { return _buf.size (); }
+
+    int send (void *socket_, int flags_) const
+    {
+        return send_frame (socket_, _buf.empty () ? NULL : &_buf[0],
+                           _buf.size (), flags_);
+    }
+
+  private:
+    unsigned char *grow (size_t size_)
+    {
+        const size_t offset = _buf.size ();
+        _buf.resize (offset + size_);
+        return &_buf[offset];
+    }
+
+    std::vector<unsigned char> _buf;
+};
+
+//  Reads fields off a frame; every getter fails once the frame runs short.
+class frame_reader_t
+{
+  public:
+    frame_reader_t (const void *data_, size_t size_) :
+        _data (static_cast<const unsigned char *> (data_)),
+        _size (size_),
+        _pos (0)
+    {
+    }
+
+    bool get_u8 (uint8_t *out_)
+    {
+        if (!has (1))
+            return false;
+        *out_ = get_uint8 (_data + _pos);
+        _pos += 1;
+        return true;
+    }
+
+    bool get_u16 (uint16_t *out_)
+    {
+        if (!has (2))
+            return false;
+        *out_ = get_uint16 (_data + _pos);
+        _pos += 2;
+        return true;
+    }
+
+    bool get_u32 (uint32_t *out_)
+    {
+        if (!has (4))
+            return false;
+        *out_ = get_uint32 (_data + _pos);
+        _pos += 4;
+        return true;
+    }
+
+    bool get_u64 (uint64_t *out_)
+    {
+        if (!has (8))
+            return false;
+        *out_ = get_uint64 (_data + _pos);
+        _pos += 8;
+        return true;
+    }
+
+    bool get_string (std::string *out_)
+    {
+        uint16_t size = 0;
+        if (!get_u16 (&size) || !has (size))
+            return false;
+        out_->assign (reinterpret_cast<const char *> (_data + _pos), size);
+        _pos += size;
+        return true;
+    }
+
+    bool get_routing_id (zlink_routing_id_t *out_)
+    {
+        uint8_t size = 0;
+        if (!get_u8 (&size) || !has (size))
+            return false;
+        out_->size = size;
+        if (size > 0)
+            memcpy (out_->data, _data + _pos, size);
+        _pos += size;
+        return true;
+    }
+
+  private:
+    bool has (size_t size_) const { return _size - _pos >= size_; }
+
+    const unsigned char *_data;
+    size_t _size;
+    size_t _pos;
+};
+
+struct provider_change_t
+{
+    uint8_t op;
+    uint16_t service_type;
+    std::string service_name;
+    std::string endpoint;
+    zlink_routing_id_t routing_id;
+    uint32_t weight;
+};
+
+//  A decoded msg_service_list or msg_service_delta. A list is presented
+//  as a delta adding every provider, with base_seq equal to seq.
+struct service_update_t
+{
+    uint16_t msg_id;
+    uint32_t registry_id;
+    uint64_t base_seq;
+    uint64_t seq;
+    std::vector<provider_change_t> changes;
+};
+
+inline bool decode_service_update (const void *data_,
+                                   size_t size_,
+                                   service_update_t *out_)
+{
+    frame_reader_t reader (data_, size_);
+    out_->changes.clear ();
+    if (!reader.get_u16 (&out_->msg_id) || !reader.get_u32 (&out_->registry_id))
+        return false;
+
+    if (out_->msg_id == msg_service_list) {
+        uint32_t service_count = 0;
+        if (!reader.get_u64 (&out_->seq) || !reader.get_u32 (&service_count))
+            return false;
+        out_->base_seq = out_->seq;
+        for (uint32_t i = 0; i < service_count; ++i) {
+            provider_change_t change;
+            change.op = delta_add;
+            uint32_t provider_count = 0;
+            if (!reader.get_u16 (&change.service_type)
+                || !reader.get_string (&change.service_name)
+                || !reader.get_u32 (&provider_count))
+                return false;
+            for (uint32_t p = 0; p < provider_count; ++p) {
+                if (!reader.get_string (&change.endpoint)
+                    || !reader.get_routing_id (&change.routing_id)
+                    || !reader.get_u32 (&change.weight))
+                    return false;
+                out_->changes.push_back (change);
+            }
+        }
+        return true;
+    }
+
+    if (out_->msg_id == msg_service_delta) {
+        uint32_t change_count = 0;
+        if (!reader.get_u64 (&out_->base_seq) || !reader.get_u64 (&out_->seq)
+            || !reader.get_u32 (&change_count) || out_->seq < out_->base_seq)
+            return false;
+        for (uint32_t i = 0; i < change_count; ++i) {
+            provider_change_t change;
+            if (!reader.get_u8 (&change.op)
+                || !reader.get_u16 (&change.service_type)
+                || !reader.get_string (&change.service_name)
+                || !reader.get_string (&change.endpoint)
+                || !reader.get_routing_id (&change.routing_id)
+                || !reader.get_u32 (&change.weight))
+                return false;
+            out_->changes.push_back (change);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+//  Asks the registries behind sub_ for a fresh msg_service_list. The XPUB
+//  of a registry runs verbose, so a repeated subscription reaches it even
+//  though the subscription exists already; dropping the extra reference
+//  right away is not forwarded.
+inline void request_service_list (void *sub_)
+{
+    zlink_setsockopt (sub_, ZLINK_SUBSCRIBE, "", 0);
+    zlink_setsockopt (sub_, ZLINK_UNSUBSCRIBE, "", 0);
+}
 }
 }
 
@@ -289,6 +289,7 @@ void registry_t::loop ()
     zlink::clock_t clock;
     uint64_t next_broadcast = clock.now_ms () + _broadcast_interval_ms;
     uint64_t last_sent_seq = _list_seq;
+    uint64_t next_list_request = 0;
 
     while (_stop.get () == 0) {
         {
@@ -354,18 +355,30 @@ void registry_t::loop ()
                 }
             }
             idx++;
-            if (peer_sub && (items[idx].revents & ZLINK_POLLIN))
-                handle_peer (peer_sub);
+            if (peer_sub && (items[idx].revents & ZLINK_POLLIN)
+                && handle_peer (peer_sub)) {
+                //  Missed an update of a peer; ask for its whole list.
+                const uint64_t now = clock.now_ms ();
+                if (now >= next_list_request) {
+                    discovery_protocol::request_service_list (peer_sub);
+                    next_list_request =
+                      now + discovery_protocol::list_request_interval_ms;
+                }
+            }
         }
 
+        //  Changes go out as a delta against the last published sequence
+        //  number. Without changes a keepalive delta tells subscribers the
+        //  current sequence number, so that they notice lost updates, and
+        //  tells peers that this registry is alive.
         const uint64_t now = clock.now_ms ();
         remove_expired (now);
         if (_list_seq != last_sent_seq) {
-            send_service_list (pub);
+            send_service_delta (pub, last_sent_seq);
             last_sent_seq = _list_seq;
             next_broadcast = now + _broadcast_interval_ms;
         } else if (now >= next_broadcast) {
-            send_service_list (pub);
+            send_service_delta (pub, _list_seq);
             next_broadcast = now + _broadcast_interval_ms;
         }
     }
@@ -449,238 +462,215 @@ void registry_t::handle_router (void *router_)
         zlink_msg_close (&frames[i]);
 }
 
-void registry_t::handle_peer (void *sub_)
+bool registry_t::handle_peer (void *sub_)
 {
-    std::vector<zlink_msg_t> frames;
-    while (true) {
-        zlink_msg_t frame;
-        zlink_msg_init (&frame);
-        if (zlink_msg_recv (&frame, sub_, 0) == -1) {
-            zlink_msg_close (&frame);
-            break;
-        }
-        frames.push_back (frame);
-        if (!zlink_msg_more (&frame))
-            break;
-    }
-
-    if (frames.empty ())
-        return;
-
-    uint16_t msg_id = 0;
-    if (!discovery_protocol::read_u16 (frames[0], &msg_id)) {
-        for (size_t i = 0; i < frames.size (); ++i)
-            zlink_msg_close (&frames[i]);
-        return;
-    }
-
-    if (msg_id != discovery_protocol::msg_service_list
-        && msg_id != discovery_protocol::msg_registry_sync) {
-        for (size_t i = 0; i < frames.size (); ++i)
-            zlink_msg_close (&frames[i]);
-        return;
-    }
-
-    if (frames.size () < 4) {
-        for (size_t i = 0; i < frames.size (); ++i)
-            zlink_msg_close (&frames[i]);
-        return;
+    zlink_msg_t msg;
+    zlink_msg_init (&msg);
+    if (zlink_msg_recv (&msg, sub_, 0) == -1) {
+        zlink_msg_close (&msg);
+        return false;
     }
 
-    uint32_t peer_registry_id = 0;
-    uint64_t list_seq = 0;
-    uint32_t service_count = 0;
-    if (!discovery_protocol::read_u32 (frames[1], &peer_registry_id)
-        || !discovery_protocol::read_u64 (frames[2], &list_seq)
-        || !discovery_protocol::read_u32 (frames[3], &service_count)) {
-        for (size_t i = 0; i < frames.size (); ++i)
-            zlink_msg_close (&frames[i]);
-        return;
+    //  Lists and deltas are single frames; skip anything else.
+    discovery_protocol::service_update_t update;
+    const bool valid =
+      !zlink_msg_more (&msg)
+      && discovery_protocol::decode_service_update (
+        zlink_msg_data (&msg), zlink_msg_size (&msg), &update);
+    while (zlink_msg_more (&msg)) {
+        zlink_msg_close (&msg);
+        zlink_msg_init (&msg);
+        if (zlink_msg_recv (&msg, sub_, 0) == -1)
+            break;
     }
+    zlink_msg_close (&msg);
+    if (!valid)
+        return false;
 
-    service_map_t incoming;
     zlink::clock_t clock;
     const uint64_t now = clock.now_ms ();
 
-    uint32_t local_registry_id = 0;
-    {
-        scoped_lock_t lock (_sync);
-        local_registry_id = _registry_id;
-        if (local_registry_id == 0)
-            local_registry_id = 1;
+    scoped_lock_t lock (_sync);
+    uint32_t local_registry_id = _registry_id;
+    if (local_registry_id == 0)
+        local_registry_id = 1;
+    if (update.registry_id == local_registry_id)
+        return false;
+
+    _peer_last_seen[update.registry_id] = now;
+    std::map<uint32_t, uint64_t>::iterator it =
+      _peer_seq.find (update.registry_id);
+    const bool known = it != _peer_seq.end ();
+    if (known && update.seq <= it->second)
+        return false;
 
-        if (peer_registry_id == local_registry_id) {
-            for (size_t i = 0; i < frames.size (); ++i)
-                zlink_msg_close (&frames[i]);
-            return;
-        }
+    bool changed = false;
+    if (update.msg_id == discovery_protocol::msg_service_delta) {
+        if (!known || update.base_seq != it->second)
+            return true;
+        changed = apply_peer_delta (update.registry_id, update, now);
+    } else
+        changed = apply_peer_list (update.registry_id, update, now);
+
+    _peer_seq[update.registry_id] = update.seq;
+    if (changed)
+        _list_seq++;
+    return false;
+}
 
-        _peer_last_seen[peer_registry_id] = now;
-        std::map<uint32_t, uint64_t>::iterator it =
-          _peer_seq.find (peer_registry_id);
-        if (it != _peer_seq.end () && list_seq <= it->second) {
-            for (size_t i = 0; i < frames.size (); ++i)
-                zlink_msg_close (&frames[i]);
-            return;
+static bool same_provider (const zlink_routing_id_t &rid_,
+                           uint32_t weight_,
+                           const zlink_routing_id_t &other_rid_,
+                           uint32_t other_weight_)
+{
+    return weight_ == other_weight_ && rid_.size == other_rid_.size
+           && (rid_.size == 0
+               || memcmp (rid_.data, other_rid_.data, rid_.size) == 0);
+}
+
+bool registry_t::apply_peer_list (
+  uint32_t peer_registry_id_,
+  const discovery_protocol::service_update_t &update_,
+  uint64_t now_ms_)
+{
+    //  Take out what the peer contributed so far; whatever its list does
+    //  not bring back is gone.
+    service_map_t previous;
+    for (service_map_t::iterator sit = _services.begin ();
+         sit != _services.end ();) {
+        provider_map_t &providers = sit->second.providers;
+        for (provider_map_t::iterator pit = providers.begin ();
+             pit != providers.end ();) {
+            if (pit->second.source_registry == peer_registry_id_) {
+                previous[sit->first].providers.insert (*pit);
+                providers.erase (pit++);
+                continue;
+            }
+            ++pit;
         }
+        if (providers.empty ())
+            _services.erase (sit++);
+        else
+            ++sit;
     }
 
-    size_t index = 4;
-    for (uint32_t i = 0; i < service_count && index < frames.size (); ++i) {
-        if (index + 2 >= frames.size ())
-            break;
-        uint16_t service_type = 0;
-        if (!discovery_protocol::read_u16 (frames[index++], &service_type))
-            break;
-        const std::string service_name =
-          discovery_protocol::read_string (frames[index++]);
-        uint32_t provider_count = 0;
-        if (!discovery_protocol::read_u32 (frames[index++], &provider_count))
-            break;
+    bool changed = false;
+    for (size_t i = 0; i < update_.changes.size (); ++i) {
+        const discovery_protocol::provider_change_t &change =
+          update_.changes[i];
+        if (change.endpoint.empty ())
+            continue;
 
         service_key_t service_key;
-        service_key.service_type = service_type;
-        service_key.service_name = service_name;
-        service_entry_t &service = incoming[service_key];
-        for (uint32_t p = 0; p < provider_count && index + 2 < frames.size ();
-             ++p) {
-            provider_entry_t entry;
-            entry.endpoint = discovery_protocol::read_string (frames[index++]);
-            discovery_protocol::read_routing_id (frames[index++],
-                                                 &entry.routing_id);
-            uint32_t weight = 1;
-            discovery_protocol::read_u32 (frames[index++], &weight);
-            entry.weight = weight == 0 ? 1 : weight;
-            entry.registered_at = now;
-            entry.last_heartbeat = now;
-            entry.source_registry = peer_registry_id;
-            if (!entry.endpoint.empty ())
-                service.providers[entry.endpoint] = entry;
-        }
-    }
+        service_key.service_type = change.service_type;
+        service_key.service_name = change.service_name;
 
-    bool changed = false;
-    {
-        scoped_lock_t lock (_sync);
-        std::map<uint32_t, uint64_t>::iterator it =
-          _peer_seq.find (peer_registry_id);
-        if (peer_registry_id == local_registry_id
-            || (it != _peer_seq.end () && list_seq <= it->second)) {
-            for (size_t i = 0; i < frames.size (); ++i)
-                zlink_msg_close (&frames[i]);
-            return;
-        }
+        //  Providers registered here or learnt from another registry win.
+        provider_map_t &providers = _services[service_key].providers;
+        if (providers.find (change.endpoint) != providers.end ())
+            continue;
 
-        for (service_map_t::const_iterator sit = incoming.begin ();
-             sit != incoming.end (); ++sit) {
-            const service_key_t &service_key = sit->first;
-            const provider_map_t &providers = sit->second.providers;
-            service_map_t::const_iterator existing_service =
-              _services.find (service_key);
-            for (provider_map_t::const_iterator pit = providers.begin ();
-                 pit != providers.end (); ++pit) {
-                bool match = false;
-                if (existing_service != _services.end ()) {
-                    provider_map_t::const_iterator ep =
-                      existing_service->second.providers.find (pit->first);
-                    if (ep != existing_service->second.providers.end ()
-                        && ep->second.source_registry == peer_registry_id) {
-                        const provider_entry_t &cur = ep->second;
-                        const provider_entry_t &incoming_entry = pit->second;
-                        match =
-                          cur.weight == incoming_entry.weight
-                          && cur.routing_id.size
-                               == incoming_entry.routing_id.size
-                          && (cur.routing_id.size == 0
-                              || memcmp (cur.routing_id.data,
-                                         incoming_entry.routing_id.data,
-                                         cur.routing_id.size)
-                                   == 0);
-                    } else if (ep != existing_service->second.providers.end ()
-                               && ep->second.source_registry
-                                    != peer_registry_id) {
-                        match = true;
-                    }
-                }
-                if (!match) {
-                    changed = true;
-                    break;
-                }
+        provider_entry_t &entry = providers[change.endpoint];
+        entry.endpoint = change.endpoint;
+        entry.routing_id = change.routing_id;
+        entry.weight = change.weight == 0 ? 1 : change.weight;
+        entry.registered_at = now_ms_;
+        entry.last_heartbeat = now_ms_;
+        entry.source_registry = peer_registry_id_;
+
+        service_map_t::iterator prev = previous.find (service_key);
+        if (prev != previous.end ()) {
+            provider_map_t::iterator old =
+              prev->second.providers.find (change.endpoint);
+            if (old != prev->second.providers.end ()) {
+                const bool same =
+                  same_provider (old->second.routing_id, old->second.weight,
+                                 entry.routing_id, entry.weight);
+                prev->second.providers.erase (old);
+                if (same)
+                    continue;
             }
-            if (changed)
-                break;
         }
+        record_change (discovery_protocol::delta_add, service_key, entry);
+        changed = true;
+    }
 
-        if (!changed) {
-            for (service_map_t::const_iterator sit = _services.begin ();
-                 sit != _services.end (); ++sit) {
-                const provider_map_t &providers = sit->second.providers;
-                for (provider_map_t::const_iterator pit = providers.begin ();
-                     pit != providers.end (); ++pit) {
-                    if (pit->second.source_registry != peer_registry_id)
-                        continue;
-                    service_map_t::const_iterator incoming_service =
-                      incoming.find (sit->first);
-                    if (incoming_service == incoming.end ()
-                        || incoming_service->second.providers.find (pit->first)
-                             == incoming_service->second.providers.end ()) {
-                        changed = true;
-                        break;
-                    }
-                }
-                if (changed)
-                    break;
-            }
+    for (service_map_t::const_iterator sit = previous.begin ();
+         sit != previous.end (); ++sit) {
+        const provider_map_t &providers = sit->second.providers;
+        for (provider_map_t::const_iterator pit = providers.begin ();
+             pit != providers.end (); ++pit) {
+            record_change (discovery_protocol::delta_remove, sit->first,
+                           pit->second);
+            changed = true;
         }
+    }
+    return changed;
+}
 
-        if (!changed) {
-            _peer_seq[peer_registry_id] = list_seq;
-            for (size_t i = 0; i < frames.size (); ++i)
-                zlink_msg_close (&frames[i]);
-            return;
-        }
+bool registry_t::apply_peer_delta (
+  uint32_t peer_registry_id_,
+  const discovery_protocol::service_update_t &update_,
+  uint64_t now_ms_)
+{
+    bool changed = false;
+    for (size_t i = 0; i < update_.changes.size (); ++i) {
+        const discovery_protocol::provider_change_t &change =
+          update_.changes[i];
+        if (change.endpoint.empty ())
+            continue;
 
-        for (service_map_t::iterator sit = _services.begin ();
-             sit != _services.end ();) {
-            provider_map_t &providers = sit->second.providers;
-            for (provider_map_t::iterator pit = providers.begin ();
-                 pit != providers.end ();) {
-                if (pit->second.source_registry == peer_registry_id) {
-                    pit = providers.erase (pit);
-                    continue;
-                }
-                ++pit;
-            }
-            if (providers.empty ()) {
-                sit = _services.erase (sit);
+        service_key_t service_key;
+        service_key.service_type = change.service_type;
+        service_key.service_name = change.service_name;
+        const uint32_t weight = change.weight == 0 ? 1 : change.weight;
+
+        if (change.op == discovery_protocol::delta_add) {
+            provider_map_t &providers = _services[service_key].providers;
+            provider_map_t::iterator pit = providers.find (change.endpoint);
+            if (pit != providers.end ()
+                && (pit->second.source_registry != peer_registry_id_
+                    || same_provider (pit->second.routing_id,
+                                      pit->second.weight, change.routing_id,
+                                      weight)))
                 continue;
-            }
-            ++sit;
+            provider_entry_t &entry = providers[change.endpoint];
+            entry.endpoint = change.endpoint;
+            entry.routing_id = change.routing_id;
+            entry.weight = weight;
+            entry.registered_at = now_ms_;
+            entry.last_heartbeat = now_ms_;
+            entry.source_registry = peer_registry_id_;
+            record_change (discovery_protocol::delta_add, service_key, entry);
+            changed = true;
+            continue;
         }
 
-        for (service_map_t::const_iterator sit = incoming.begin ();
-             sit != incoming.end (); ++sit) {
-            const service_key_t &service_key = sit->first;
-            const provider_map_t &providers = sit->second.providers;
-            service_entry_t &service = _services[service_key];
-            for (provider_map_t::const_iterator pit = providers.begin ();
-                 pit != providers.end (); ++pit) {
-                provider_map_t::iterator existing =
-                  service.providers.find (pit->first);
-                if (existing != service.providers.end ()
-                    && existing->second.source_registry != peer_registry_id) {
-                    continue;
-                }
-                service.providers[pit->first] = pit->second;
-            }
-        }
+        service_map_t::iterator sit = _services.find (service_key);
+        if (sit == _services.end ())
+            continue;
+        provider_map_t::iterator pit =
+          sit->second.providers.find (change.endpoint);
+        if (pit == sit->second.providers.end ()
+            || pit->second.source_registry != peer_registry_id_)
+            continue;
 
-        _peer_seq[peer_registry_id] = list_seq;
-        _list_seq++;
+        if (change.op == discovery_protocol::delta_remove) {
+            record_change (discovery_protocol::delta_remove, service_key,
+                           pit->second);
+            sit->second.providers.erase (pit);
+            if (sit->second.providers.empty ())
+                _services.erase (sit);
+            changed = true;
+        } else if (change.op == discovery_protocol::delta_weight
+                   && pit->second.weight != weight) {
+            pit->second.weight = weight;
+            record_change (discovery_protocol::delta_weight, service_key,
+                           pit->second);
+            changed = true;
+        }
     }
-
-    for (size_t i = 0; i < frames.size (); ++i)
-        zlink_msg_close (&frames[i]);
+    return changed;
 }
 
 void registry_t::handle_register (void *router_, const zlink_msg_t *frames_,
@@ -733,6 +723,7 @@ void registry_t::handle_register (void *router_, const zlink_msg_t *frames_,
     entry.last_heartbeat = now;
     entry.source_registry = _registry_id;
 
+    record_change (discovery_protocol::delta_add, service_key, entry);
     _list_seq++;
     send_register_ack (router_, sender_id_, 0x00, endpoint, std::string ());
 }
@@ -765,6 +756,7 @@ void registry_t::handle_unregister (const zlink_msg_t *frames_,
     if (pit->second.source_registry != _registry_id)
         return;
 
+    record_change (discovery_protocol::delta_remove, service_key, pit->second);
     sit->second.providers.erase (pit);
     if (sit->second.providers.empty ())
         _services.erase (sit);
@@ -852,6 +844,7 @@ void registry_t::handle_update_weight (void *router_, const zlink_msg_t *frames_
     }
 
     pit->second.weight = weight;
+    record_change (discovery_protocol::delta_weight, service_key, pit->second);
     _list_seq++;
     send_register_ack (router_, sender_id_, 0x00, endpoint, std::string ());
 }
@@ -897,6 +890,24 @@ void registry_t::send_register_ack (void *router_,
             discovery_protocol::send_string (router_, error_, 0));
 }
 
+void registry_t::record_change (uint8_t op_,
+                                const service_key_t &service_key_,
+                                const provider_entry_t &entry_)
+{
+    std::pair<change_map_t::iterator, bool> inserted = _changes.insert (
+      change_map_t::value_type (std::make_pair (service_key_, entry_.endpoint),
+                                change_t ()));
+    change_t &change = inserted.first->second;
+
+    //  Changes to the same provider collapse into the last one, except
+    //  that a pending add already carries the new weight.
+    if (inserted.second || op_ != discovery_protocol::delta_weight
+        || change.op != discovery_protocol::delta_add)
+        change.op = op_;
+    change.routing_id = entry_.routing_id;
+    change.weight = entry_.weight;
+}
+
 void registry_t::send_service_list (void *pub_)
 {
     uint32_t registry_id = 0;
@@ -907,60 +918,62 @@ void registry_t::send_service_list (void *pub_)
             registry_id = 1;
     }
 
-    discovery_protocol::send_u16 (pub_, discovery_protocol::msg_service_list,
-                                  ZLINK_SNDMORE);
-    discovery_protocol::send_u32 (pub_, registry_id, ZLINK_SNDMORE);
-    discovery_protocol::send_u64 (pub_, _list_seq, ZLINK_SNDMORE);
+    discovery_protocol::frame_writer_t writer;
+    writer.put_u16 (discovery_protocol::msg_service_list);
+    writer.put_u32 (registry_id);
+    writer.put_u64 (_list_seq);
+    const size_t count_offset = writer.size ();
+    writer.put_u32 (0);
 
     uint32_t service_count = 0;
     for (service_map_t::const_iterator it = _services.begin ();
          it != _services.end (); ++it) {
-        if (!it->second.providers.empty ())
-            service_count++;
-    }
-
-    discovery_protocol::send_u32 (pub_, service_count,
-                                  service_count == 0 ? 0 : ZLINK_SNDMORE);
-
-    if (service_count == 0)
-        return;
-
-    uint32_t emitted = 0;
-    for (service_map_t::const_iterator it = _services.begin ();
-         it != _services.end (); ++it) {
-        if (it->second.providers.empty ())
-            continue;
-
-        const service_key_t &service_key = it->first;
         const provider_map_t &providers = it->second.providers;
-        const uint32_t provider_count =
-          static_cast<uint32_t> (providers.size ());
-
-        discovery_protocol::send_u16 (pub_, service_key.service_type,
-                                      ZLINK_SNDMORE);
-        discovery_protocol::send_string (pub_, service_key.service_name,
-                                         ZLINK_SNDMORE);
-        discovery_protocol::send_u32 (pub_, provider_count,
-                                      ZLINK_SNDMORE);
+        if (providers.empty ())
+            continue;
 
-        uint32_t provider_index = 0;
+        writer.put_u16 (it->first.service_type);
+        writer.put_string (it->first.service_name);
+        writer.put_u32 (static_cast<uint32_t> (providers.size ()));
         for (provider_map_t::const_iterator pit = providers.begin ();
-             pit != providers.end (); ++pit, ++provider_index) {
-            const provider_entry_t &entry = pit->second;
-            const bool last_provider =
-              (provider_index + 1) == provider_count
-              && (emitted + 1) == service_count;
-
-            discovery_protocol::send_string (pub_, entry.endpoint,
-                                             ZLINK_SNDMORE);
-            discovery_protocol::send_routing_id (pub_, entry.routing_id,
-                                                 ZLINK_SNDMORE);
-            discovery_protocol::send_u32 (pub_, entry.weight,
-                                          last_provider ? 0 : ZLINK_SNDMORE);
+             pit != providers.end (); ++pit) {
+            writer.put_string (pit->second.endpoint);
+            writer.put_routing_id (pit->second.routing_id);
+            writer.put_u32 (pit->second.weight);
         }
+        service_count++;
+    }
+    writer.patch_u32 (count_offset, service_count);
+    writer.send (pub_, 0);
+}
+
+void registry_t::send_service_delta (void *pub_, uint64_t base_seq_)
+{
+    uint32_t registry_id = 0;
+    {
+        scoped_lock_t lock (_sync);
+        registry_id = _registry_id;
+        if (registry_id == 0)
+            registry_id = 1;
+    }
 
-        emitted++;
+    discovery_protocol::frame_writer_t writer;
+    writer.put_u16 (discovery_protocol::msg_service_delta);
+    writer.put_u32 (registry_id);
+    writer.put_u64 (base_seq_);
+    writer.put_u64 (_list_seq);
+    writer.put_u32 (static_cast<uint32_t> (_changes.size ()));
+    for (change_map_t::const_iterator it = _changes.begin ();
+         it != _changes.end (); ++it) {
+        writer.put_u8 (it->second.op);
+        writer.put_u16 (it->first.first.service_type);
+        writer.put_string (it->first.first.service_name);
+        writer.put_string (it->first.second);
+        writer.put_routing_id (it->second.routing_id);
+        writer.put_u32 (it->second.weight);
     }
+    _changes.clear ();
+    writer.send (pub_, 0);
 }
 
 void registry_t::remove_expired (uint64_t now_ms_)
@@ -979,6 +992,8 @@ void registry_t::remove_expired (uint64_t now_ms_)
             if (now_ms_ > pit->second.last_heartbeat
                 && now_ms_ - pit->second.last_heartbeat
                      > _heartbeat_timeout_ms) {
+                record_change (discovery_protocol::delta_remove, sit->first,
+                               pit->second);
                 pit = providers.erase (pit);
                 changed = true;
                 continue;
@@ -1006,6 +1021,8 @@ void registry_t::remove_expired (uint64_t now_ms_)
                 for (provider_map_t::iterator eit = providers.begin ();
                      eit != providers.end ();) {
                     if (eit->second.source_registry == peer_id) {
+                        record_change (discovery_protocol::delta_remove,
+                                       sit->first, eit->second);
                         eit = providers.erase (eit);
                         changed = true;
                         continue;
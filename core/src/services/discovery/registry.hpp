@@ -5,6 +5,7 @@
 
 #include "core/ctx.hpp"
 #include "core/thread.hpp"
+#include "services/discovery/discovery_protocol.hpp"
 #include "utils/atomic_counter.hpp"
 #include "utils/clock.hpp"
 #include "utils/mutex.hpp"
@@ -68,10 +69,27 @@ class registry_t
 
     typedef std::map<service_key_t, service_entry_t> service_map_t;
 
+    //  A change to a provider not yet published, see send_service_delta.
+    struct change_t
+    {
+        uint8_t op;
+        zlink_routing_id_t routing_id;
+        uint32_t weight;
+    };
+
+    typedef std::map<std::pair<service_key_t, std::string>, change_t>
+      change_map_t;
+
     static void run (void *arg_);
     void loop ();
     void handle_router (void *router_);
-    void handle_peer (void *sub_);
+    bool handle_peer (void *sub_);
+    bool apply_peer_list (uint32_t peer_registry_id_,
+                          const discovery_protocol::service_update_t &update_,
+                          uint64_t now_ms_);
+    bool apply_peer_delta (uint32_t peer_registry_id_,
+                           const discovery_protocol::service_update_t &update_,
+                           uint64_t now_ms_);
     void handle_register (void *router_, const zlink_msg_t *frames_,
                           size_t frame_count_,
                           const zlink_routing_id_t &sender_id_);
@@ -85,7 +103,11 @@ class registry_t
                             uint8_t status_,
                             const std::string &endpoint_,
                             const std::string &error_);
+    void record_change (uint8_t op_,
+                        const service_key_t &service_key_,
+                        const provider_entry_t &entry_);
     void send_service_list (void *pub_);
+    void send_service_delta (void *pub_, uint64_t base_seq_);
     void remove_expired (uint64_t now_ms_);
 
     void stop_worker ();
@@ -120,6 +142,7 @@ class registry_t
     mutex_t _sync;
 
     service_map_t _services;
+    change_map_t _changes;
     std::map<uint32_t, uint64_t> _peer_seq;
     std::map<uint32_t, uint64_t> _peer_last_seen;
 
@@ -3,7 +3,9 @@
 #include "services/gateway/gateway.hpp"
 
 #include "core/msg.hpp"
+#include "protocol/wire.hpp"
 #include "services/gateway/routing_id_utils.hpp"
+#include "utils/random.hpp"
 
 #include <algorithm>
 #include <chrono>
@@ -19,6 +21,14 @@ namespace
 {
 static const uint32_t gateway_tag_value = 0x1e6700d7;
 
+// Plain requests to a provider that never answers stop being tracked past
+// this many, or once they are this old.
+static const size_t max_pending_requests = 1024;
+static const uint64_t pending_expiry_us = 60 * 1000000;
+
+// Weight of a new latency sample in the moving average, as a shift.
+static const int ewma_shift = 3;
+
 // Ensure the ROUTER socket has a routing id so peers can reply.
 static void ensure_gateway_routing_id (socket_base_t *socket_,
                                        const std::string *override_id_)
@@ -75,39 +85,124 @@ static int monitor_event_mask ()
            | ZLINK_EVENT_HANDSHAKE_FAILED_AUTH;
 }
 
-static std::string routing_id_key (const zlink_routing_id_t &rid_)
+// How long a blocking recv over several shards waits on their mailboxes
+// before it tries every shard again.
+static const long shard_poll_interval_ms = 100;
+
+// Size of the correlation frame of an asynchronous request.
+static const size_t call_id_size = 8;
+
+// A provider that turned out to be unreachable is left out this long.
+static const uint64_t down_backoff_ms = 500;
+
+// The hedge delay is taken from this many recent call latencies, once
+// there are enough of them, and taken again every latency_refresh calls.
+static const size_t latency_window = 128;
+static const size_t latency_min_samples = 20;
+static const size_t latency_refresh = 16;
+
+// How much hedge budget a service saves up, in hundredths of a hedge.
+static const int hedge_budget_cap = 1000;
+
+//  FNV-1a
+static uint64_t hash_bytes (const void *data_, size_t size_)
 {
-    if (rid_.size == 0)
-        return std::string ();
-    return std::string (reinterpret_cast<const char *> (rid_.data), rid_.size);
+    const unsigned char *bytes = static_cast<const unsigned char *> (data_);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size_; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
 }
+
+//  Rendezvous score of a key on a provider: the splitmix64 finalizer over
+//  both hashes, so that every provider ranks the keys independently.
+static uint64_t rendezvous_score (uint64_t key_hash_, uint64_t rid_hash_)
+{
+    uint64_t x = key_hash_ ^ rid_hash_;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static bool same_routing_id (const zlink_routing_id_t &a_,
+                             const zlink_routing_id_t &b_)
+{
+    return a_.size > 0 && a_.size == b_.size
+           && memcmp (a_.data, b_.data, a_.size) == 0;
+}
+
+// Threads are numbered as they first send through a gateway; thread n
+// uses shard n modulo the shard count, so a pool of workers spreads evenly.
+static atomic_counter_t next_caller;
+
+static size_t caller_slot ()
+{
+    static thread_local size_t slot = next_caller.add (1);
+    return slot;
+}
+}
+
+gateway_t::shard_t::shard_t () :
+    index (0),
+    router (NULL),
+    monitor (NULL),
+    fd (retired_fd),
+    last_pool (NULL),
+    force_refresh_all (false),
+    timers (clock.now_ms ()),
+    first_call_id (0),
+    next_call_id (0),
+    async_woken (false)
+{
+    //  Id 0 marks a plain request in send_request_frames, so it is never
+    //  handed out.
+    do
+        first_call_id = (static_cast<uint64_t> (generate_random ()) << 32)
+                        | generate_random ();
+    while (first_call_id == 0);
+    next_call_id = first_call_id;
 }
 
 gateway_t::gateway_t (ctx_t *ctx_, discovery_t *discovery_,
-                      const char *routing_id_) :
+                      const char *routing_id_,
+                      int shards_) :
     _ctx (ctx_),
     _discovery (discovery_),
     _tag (gateway_tag_value),
-    _last_pool (NULL),
-    _force_refresh_all (false),
-    _monitor_socket (NULL),
-    _router_socket (NULL),
-    _use_lock (true),
+    _recv_shard (0),
+    _rcvtimeo (-1),
     _stop (0),
+    _async_started (false),
+    _request_timeout (5000),
     _tls_trust_system (0),
     _routing_id_override (routing_id_ ? routing_id_ : "")
 {
     zlink_assert (_ctx);
+    zlink_assert (shards_ > 0);
     if (_discovery)
         _discovery->add_observer (this);
-    if (init_router_socket () != 0)
-        _tag = 0xdeadbeef;
+    for (int i = 0; i < shards_; ++i) {
+        shard_t *shard = new (std::nothrow) shard_t;
+        alloc_assert (shard);
+        shard->index = static_cast<size_t> (i);
+        _shards.push_back (shard);
+        if (init_router_socket (shard) != 0)
+            _tag = 0xdeadbeef;
+    }
     _refresh_worker.start (refresh_run, this, "gateway-refresh");
 }
 
 gateway_t::~gateway_t ()
 {
     _tag = 0xdeadbeef;
+    for (size_t i = 0; i < _shards.size (); ++i) {
+        shard_t *shard = _shards[i];
+        for (size_t j = 0; j < shard->free_calls.size (); ++j)
+            delete shard->free_calls[j];
+        delete shard;
+    }
 }
 
 bool gateway_t::check_tag () const
@@ -124,112 +219,123 @@ void gateway_t::refresh_run (void *arg_)
 void gateway_t::refresh_loop ()
 {
     while (_stop.get () == 0) {
-        std::vector<std::string> services_to_refresh;
-        {
-            scoped_lock_t lock (_sync);
-            process_monitor_events ();
-            const uint64_t now_ms = _clock.now_ms ();
+        std::set<service_pool_t *> pools_to_refresh;
+        for (size_t i = 0; i < _shards.size (); ++i) {
+            shard_t *shard = _shards[i];
+            scoped_lock_t lock (shard->sync);
+            process_monitor_events (shard);
+            const uint64_t now_ms = shard->clock.now_ms ();
             for (std::map<std::string, uint64_t>::iterator it =
-                   _down_until_ms.begin ();
-                 it != _down_until_ms.end ();) {
+                   shard->down_until_ms.begin ();
+                 it != shard->down_until_ms.end ();) {
                 if (now_ms >= it->second) {
-                    _down_endpoints.erase (it->first);
-                    it = _down_until_ms.erase (it);
-                    _force_refresh_all = true;
+                    shard->down_endpoints.erase (it->first);
+                    shard->down_until_ms.erase (it++);
+                    shard->force_refresh_all = true;
                 } else {
                     ++it;
                 }
             }
-            if (_discovery) {
-                if (_force_refresh_all) {
-                    for (std::map<std::string, service_pool_t>::iterator it =
-                           _pools.begin ();
-                         it != _pools.end (); ++it) {
-                        it->second.dirty = true;
-                        services_to_refresh.push_back (it->first);
-                    }
-                } else {
-                    for (std::set<std::string>::iterator sit =
-                           _pending_updates.begin ();
-                         sit != _pending_updates.end (); ++sit) {
-                        std::map<std::string, service_pool_t>::iterator pit =
-                          _pools.find (*sit);
-                        if (pit != _pools.end ()) {
-                            pit->second.dirty = true;
-                            services_to_refresh.push_back (*sit);
-                        }
-                    }
-                }
+            pools_to_refresh.insert (shard->pending.begin (),
+                                     shard->pending.end ());
+            shard->pending.clear ();
+            if (shard->force_refresh_all) {
+                shard->force_refresh_all = false;
+                scoped_lock_t pools_lock (_sync);
+                for (std::map<std::string, service_pool_t>::iterator it =
+                       _pools.begin ();
+                     it != _pools.end (); ++it)
+                    pools_to_refresh.insert (&it->second);
+            }
+        }
+        {
+            scoped_lock_t lock (_sync);
+            for (std::set<std::string>::iterator sit =
+                   _pending_updates.begin ();
+                 sit != _pending_updates.end (); ++sit) {
+                std::map<std::string, service_pool_t>::iterator pit =
+                  _pools.find (*sit);
+                if (pit != _pools.end ())
+                    pools_to_refresh.insert (&pit->second);
             }
             _pending_updates.clear ();
-            _force_refresh_all = false;
-        }
-        if (_discovery && !services_to_refresh.empty ()) {
-            for (size_t i = 0; i < services_to_refresh.size (); ++i) {
-                const std::string &service = services_to_refresh[i];
-                std::vector<provider_info_t> providers;
-                _discovery->snapshot_providers (service, &providers);
-                const uint64_t seq =
-                  _discovery->service_update_seq (service);
-                scoped_lock_t lock (_sync);
-                std::map<std::string, service_pool_t>::iterator it =
-                  _pools.find (service);
-                if (it == _pools.end ())
-                    continue;
-                if (!it->second.dirty)
-                    continue;
-                refresh_pool (&it->second, providers, seq);
+        }
+        if (_discovery) {
+            for (std::set<service_pool_t *>::iterator it =
+                   pools_to_refresh.begin ();
+                 it != pools_to_refresh.end (); ++it) {
+                service_pool_t *pool = *it;
+                const provider_snapshot_ptr snapshot =
+                  _discovery->providers (pool->service_name);
+                for (size_t i = 0; i < _shards.size (); ++i) {
+                    scoped_lock_t lock (_shards[i]->sync);
+                    refresh_pool (_shards[i], pool, snapshot->providers,
+                                  snapshot->seq);
+                }
             }
         }
         std::this_thread::sleep_for (std::chrono::milliseconds (1));
     }
 }
 
-int gateway_t::init_router_socket ()
+int gateway_t::init_router_socket (shard_t *shard_)
 {
-    if (_router_socket)
+    if (shard_->router)
         return 0;
-    if (allocate_router (_ctx, &_router_socket) != 0)
+    if (allocate_router (_ctx, &shard_->router) != 0)
         return -1;
-    ensure_gateway_routing_id (_router_socket, &_routing_id_override);
+    // Shards are separate peers to the providers, so they need distinct
+    // routing ids.
+    std::string routing_id = _routing_id_override;
+    if (!routing_id.empty () && shard_->index > 0) {
+        char suffix[16];
+        snprintf (suffix, sizeof suffix, "#%u",
+                  static_cast<unsigned> (shard_->index));
+        routing_id += suffix;
+    }
+    ensure_gateway_routing_id (shard_->router, &routing_id);
     int hwm = 1000000;
-    _router_socket->setsockopt (ZLINK_SNDHWM, &hwm, sizeof (hwm));
-    _router_socket->setsockopt (ZLINK_RCVHWM, &hwm, sizeof (hwm));
+    shard_->router->setsockopt (ZLINK_SNDHWM, &hwm, sizeof (hwm));
+    shard_->router->setsockopt (ZLINK_RCVHWM, &hwm, sizeof (hwm));
     // Enable socket monitor to receive connection-ready events.
-    if (!_monitor_socket) {
+    if (!shard_->monitor) {
         void *monitor =
-          zlink_socket_monitor_open (static_cast<void *> (_router_socket),
+          zlink_socket_monitor_open (static_cast<void *> (shard_->router),
                                      monitor_event_mask ());
-        _monitor_socket = monitor;
+        shard_->monitor = monitor;
     }
     // Apply TLS settings before connecting to any providers.
-    if (apply_tls_client (_router_socket, _tls_ca, _tls_hostname,
+    if (apply_tls_client (shard_->router, _tls_ca, _tls_hostname,
                           _tls_trust_system)
         != 0) {
-        _router_socket->close ();
-        _router_socket = NULL;
+        shard_->router->close ();
+        shard_->router = NULL;
         return -1;
     }
     // Fail sends when routing id is unknown (no silent drops).
     int mandatory = 1;
-    _router_socket->setsockopt (ZLINK_ROUTER_MANDATORY, &mandatory,
+    shard_->router->setsockopt (ZLINK_ROUTER_MANDATORY, &mandatory,
                                 sizeof (mandatory));
     // Keep send from blocking too long when caller uses blocking send.
     int sndtimeo = 50;
-    _router_socket->setsockopt (ZLINK_SNDTIMEO, &sndtimeo, sizeof (sndtimeo));
+    shard_->router->setsockopt (ZLINK_SNDTIMEO, &sndtimeo,
+                                sizeof (sndtimeo));
     // Avoid long linger during teardown.
     int linger = 0;
-    _router_socket->setsockopt (ZLINK_LINGER, &linger, sizeof (linger));
+    shard_->router->setsockopt (ZLINK_LINGER, &linger, sizeof (linger));
     // Allow a new connection with the same routing id to take over.
     int handover = 1;
-    _router_socket->setsockopt (ZLINK_ROUTER_HANDOVER, &handover,
+    shard_->router->setsockopt (ZLINK_ROUTER_HANDOVER, &handover,
                                 sizeof (handover));
+    // Lets a blocking recv wait on all shards at once.
+    size_t fd_size = sizeof (shard_->fd);
+    shard_->router->getsockopt (ZLINK_FD, &shard_->fd, &fd_size);
     return 0;
 }
 
-int gateway_t::ensure_router_socket ()
+gateway_t::shard_t *gateway_t::caller_shard ()
 {
-    return _router_socket ? 0 : -1;
+    return _shards[caller_slot () % _shards.size ()];
 }
 
 gateway_t::service_pool_t *
@@ -240,15 +346,26 @@ gateway_t::service_pool_t *
     if (it != _pools.end ())
         return &it->second;
 
+    if (!_shards[0]->router)
+        return NULL;
+
     service_pool_t pool;
+    pool.owner = this;
     pool.service_name = service_name_;
-    pool.rr_index = 0;
-    pool.lb_strategy = ZLINK_GATEWAY_LB_ROUND_ROBIN;
-    pool.last_seen_seq = 0;
-    pool.dirty = true;
+    pool.shards.resize (_shards.size ());
+    for (size_t i = 0; i < pool.shards.size (); ++i) {
+        shard_pool_t &shard_pool = pool.shards[i];
+        shard_pool.rr_index = 0;
+        shard_pool.lb_strategy = ZLINK_GATEWAY_LB_ROUND_ROBIN;
+        shard_pool.rng = generate_random () | 1;
+        shard_pool.last_seen_seq = 0;
+        shard_pool.hedge_budget = 0;
+        shard_pool.max_retries = 0;
+        shard_pool.hedge_tokens = 0;
+        shard_pool.latency_count = 0;
+        shard_pool.hedge_after_ms = 0;
+    }
 
-    if (ensure_router_socket () != 0)
-        return NULL;
     _pools.insert (std::make_pair (service_name_, pool));
     if (_discovery)
         _pending_updates.insert (service_name_);
@@ -256,40 +373,56 @@ gateway_t::service_pool_t *
 }
 
 gateway_t::service_pool_t *
-  gateway_t::get_or_create_pool_cached (const char *service_name_)
+  gateway_t::get_or_create_pool_cached (shard_t *shard_,
+                                        const char *service_name_)
 {
     if (!service_name_ || service_name_[0] == '\0')
         return NULL;
-    if (_last_pool && !_last_service_name.empty ()
-        && _last_service_name == service_name_) {
-        return _last_pool;
+    if (shard_->last_pool && !shard_->last_service_name.empty ()
+        && shard_->last_service_name == service_name_) {
+        return shard_->last_pool;
     }
     std::string service (service_name_);
-    service_pool_t *pool = get_or_create_pool (service);
-    if (pool) {
-        _last_service_name = service;
-        _last_pool = pool;
+    service_pool_t *pool = NULL;
+    std::map<std::string, service_pool_t *>::iterator it =
+      shard_->pools.find (service);
+    if (it != shard_->pools.end ()) {
+        pool = it->second;
+    } else {
+        {
+            scoped_lock_t lock (_sync);
+            pool = get_or_create_pool (service);
+        }
+        if (!pool)
+            return NULL;
+        shard_->pools[service] = pool;
     }
+    shard_->last_service_name = service;
+    shard_->last_pool = pool;
     return pool;
 }
 
-void gateway_t::refresh_pool (service_pool_t *pool_,
+void gateway_t::refresh_pool (shard_t *shard_,
+                              service_pool_t *pool_,
                               const std::vector<provider_info_t> &providers,
                               uint64_t seq_)
 {
-    if (!pool_ || !_router_socket)
+    if (!pool_ || !shard_->router)
         return;
 
-    process_monitor_events ();
+    process_monitor_events (shard_);
+    shard_pool_t &shard_pool = pool_->shards[shard_->index];
 
     // 2) Build routing_id map by endpoint for this service.
     std::vector<std::string> next_endpoints;
     std::vector<zlink_routing_id_t> next_routing_ids;
     std::map<std::string, zlink_routing_id_t> routing_map;
+    std::map<std::string, uint32_t> weight_map;
 
     for (size_t i = 0; i < providers.size (); ++i) {
         const provider_info_t &entry = providers[i];
         routing_map[entry.endpoint] = entry.routing_id;
+        weight_map[entry.endpoint] = entry.weight > 0 ? entry.weight : 1;
     }
 
     // 3) Connect and keep only peers that are actually ready (POLLOUT).
@@ -301,26 +434,27 @@ void gateway_t::refresh_pool (service_pool_t *pool_,
         if (rid.size == 0)
             continue;
         // Only attempt a new connect if not already connected.
-        if (std::find (pool_->endpoints.begin (), pool_->endpoints.end (),
-                       endpoint)
-            == pool_->endpoints.end ()) {
-            _router_socket->setsockopt (ZLINK_CONNECT_ROUTING_ID, rid.data,
+        if (std::find (shard_pool.endpoints.begin (),
+                       shard_pool.endpoints.end (), endpoint)
+            == shard_pool.endpoints.end ()) {
+            shard_->router->setsockopt (ZLINK_CONNECT_ROUTING_ID, rid.data,
                                         rid.size);
-            _router_socket->connect (endpoint.c_str ());
+            shard_->router->connect (endpoint.c_str ());
         }
         std::map<std::string, uint64_t>::iterator dit =
-          _down_until_ms.find (endpoint);
-        if (dit != _down_until_ms.end ()) {
-            if (_clock.now_ms () < dit->second)
+          shard_->down_until_ms.find (endpoint);
+        if (dit != shard_->down_until_ms.end ()) {
+            if (shard_->clock.now_ms () < dit->second)
                 continue;
-            _down_until_ms.erase (dit);
-            _down_endpoints.erase (endpoint);
+            shard_->down_until_ms.erase (dit);
+            shard_->down_endpoints.erase (endpoint);
         }
-        if (_ready_endpoints.find (endpoint) == _ready_endpoints.end ()) {
-            const int state = _router_socket->get_peer_state (rid.data,
-                                                             rid.size);
+        if (shard_->ready_endpoints.find (endpoint)
+            == shard_->ready_endpoints.end ()) {
+            const int state = shard_->router->get_peer_state (rid.data,
+                                                              rid.size);
             if (state >= 0 && (state & ZLINK_POLLOUT)) {
-                _ready_endpoints.insert (endpoint);
+                shard_->ready_endpoints.insert (endpoint);
                 next_endpoints.push_back (endpoint);
                 next_routing_ids.push_back (rid);
             }
@@ -333,54 +467,251 @@ void gateway_t::refresh_pool (service_pool_t *pool_,
 
     // 4) Disconnect endpoints that disappeared from discovery only.
     //    Readiness is transient; do not term on temporary not-ready.
-    for (size_t i = 0; i < pool_->endpoints.size (); ++i) {
-        const std::string &endpoint = pool_->endpoints[i];
+    std::vector<zlink_routing_id_t> removed;
+    for (size_t i = 0; i < shard_pool.endpoints.size (); ++i) {
+        const std::string &endpoint = shard_pool.endpoints[i];
         if (routing_map.find (endpoint) == routing_map.end ()) {
-            _router_socket->term_endpoint (endpoint.c_str ());
+            shard_->router->term_endpoint (endpoint.c_str ());
+            removed.push_back (shard_pool.routing_ids[i]);
         }
     }
 
-    // 5) Commit refreshed pool.
-    for (size_t i = 0; i < pool_->endpoints.size (); ++i) {
-        _endpoint_to_service.erase (pool_->endpoints[i]);
+    // 5) Carry the balancing state of the providers that stay over.
+    std::vector<provider_stats_t> next_stats (next_endpoints.size ());
+    for (size_t i = 0; i < next_endpoints.size (); ++i) {
+        const size_t old = static_cast<size_t> (
+          std::find (shard_pool.endpoints.begin (),
+                     shard_pool.endpoints.end (), next_endpoints[i])
+          - shard_pool.endpoints.begin ());
+        if (old < shard_pool.stats.size ())
+            std::swap (next_stats[i], shard_pool.stats[old]);
+        next_stats[i].weight = weight_map[next_endpoints[i]];
     }
-    for (size_t i = 0; i < pool_->routing_ids.size (); ++i) {
-        const std::string key = routing_id_key (pool_->routing_ids[i]);
-        if (!key.empty ())
-            _routing_id_to_service.erase (key);
+
+    // 6) Commit refreshed pool.
+    for (size_t i = 0; i < shard_pool.endpoints.size (); ++i) {
+        shard_->endpoint_to_pool.erase (shard_pool.endpoints[i]);
     }
-    pool_->endpoints.swap (next_endpoints);
-    pool_->routing_ids.swap (next_routing_ids);
-    for (size_t i = 0; i < pool_->routing_ids.size (); ++i) {
-        const std::string key = routing_id_key (pool_->routing_ids[i]);
-        if (!key.empty ())
-            _routing_id_to_service[key] = pool_->service_name;
+    for (size_t i = 0; i < shard_pool.routing_ids.size (); ++i) {
+        const zlink_routing_id_t &rid = shard_pool.routing_ids[i];
+        if (rid.size > 0)
+            shard_->routing_id_to_pool.erase (rid.data, rid.size);
+    }
+    close_envelopes (&shard_pool);
+    shard_pool.endpoints.swap (next_endpoints);
+    shard_pool.routing_ids.swap (next_routing_ids);
+    shard_pool.stats.swap (next_stats);
+    shard_pool.envelopes.resize (shard_pool.routing_ids.size ());
+    shard_pool.rid_hashes.resize (shard_pool.routing_ids.size ());
+    for (size_t i = 0; i < shard_pool.routing_ids.size (); ++i) {
+        const zlink_routing_id_t &rid = shard_pool.routing_ids[i];
+        const int rc = shard_pool.envelopes[i].init_size (rid.size);
+        errno_assert (rc == 0);
+        shard_pool.rid_hashes[i] = hash_bytes (rid.data, rid.size);
+        if (rid.size == 0)
+            continue;
+        memcpy (shard_pool.envelopes[i].data (), rid.data, rid.size);
+        //  A provider serving several services maps to the last one.
+        shard_->routing_id_to_pool.erase (rid.data, rid.size);
+        shard_->routing_id_to_pool.insert (blob_t (rid.data, rid.size),
+                                           pool_);
     }
     // Track endpoint->service for monitor event routing.
     for (std::map<std::string, zlink_routing_id_t>::const_iterator it =
            routing_map.begin ();
          it != routing_map.end (); ++it) {
-        _endpoint_to_service[it->first] = pool_->service_name;
+        shard_->endpoint_to_pool[it->first] = pool_;
     }
-    for (size_t i = 0; i < pool_->endpoints.size (); ++i) {
-        _endpoint_to_service[pool_->endpoints[i]] = pool_->service_name;
+    for (size_t i = 0; i < shard_pool.endpoints.size (); ++i) {
+        shard_->endpoint_to_pool[shard_pool.endpoints[i]] = pool_;
     }
-    pool_->dirty = false;
-    pool_->last_seen_seq = seq_;
+    shard_pool.last_seen_seq = seq_;
+
+    // 7) Send the calls still waiting on removed providers elsewhere.
+    for (size_t i = 0; i < removed.size (); ++i)
+        retry_calls (shard_, pool_, removed[i]);
 }
 
-bool gateway_t::select_provider (service_pool_t *pool_, size_t *index_out_)
+bool gateway_t::select_provider (shard_pool_t *pool_, size_t *index_out_)
 {
     if (!pool_ || pool_->routing_ids.empty () || !index_out_)
         return false;
-    // Round-robin only (minimal policy).
+    zlink_assert (pool_->stats.size () == pool_->routing_ids.size ());
+    switch (pool_->lb_strategy) {
+        case ZLINK_GATEWAY_LB_WEIGHTED:
+            *index_out_ = select_weighted (pool_);
+            return true;
+        case ZLINK_GATEWAY_LB_LEAST_OUTSTANDING:
+            *index_out_ = select_least_outstanding (pool_);
+            return true;
+        case ZLINK_GATEWAY_LB_P2C_EWMA:
+            *index_out_ = select_p2c_ewma (pool_);
+            return true;
+        default:
+            break;
+    }
     const size_t index = pool_->rr_index % pool_->routing_ids.size ();
     pool_->rr_index++;
     *index_out_ = index;
     return true;
 }
+// Smooth weighted round-robin: every provider gains its weight, the one
+// ahead is picked and falls back by the total. A 3:1 pool goes a a b a
+// rather than a a a b, so no provider sees bursts.
+size_t gateway_t::select_weighted (shard_pool_t *pool_)
+{
+    std::vector<provider_stats_t> &stats = pool_->stats;
+    int64_t total = 0;
+    size_t best = 0;
+    for (size_t i = 0; i < stats.size (); ++i) {
+        stats[i].current_weight += stats[i].weight;
+        total += stats[i].weight;
+        if (stats[i].current_weight > stats[best].current_weight)
+            best = i;
+    }
+    stats[best].current_weight -= total;
+    return best;
+}
+
+// Fewest requests awaiting a reply. Ties rotate so that an idle pool is
+// still spread evenly.
+size_t gateway_t::select_least_outstanding (shard_pool_t *pool_)
+{
+    const std::vector<provider_stats_t> &stats = pool_->stats;
+    const size_t count = stats.size ();
+    const size_t start = pool_->rr_index++ % count;
+    size_t best = start;
+    for (size_t n = 1; n < count; ++n) {
+        const size_t i = (start + n) % count;
+        if (stats[i].pending () < stats[best].pending ())
+            best = i;
+    }
+    return best;
+}
+
+// Power of two choices: of two random providers, take the one whose
+// latency times pending requests is lower. Providers without a latency
+// sample yet are assumed to be average.
+size_t gateway_t::select_p2c_ewma (shard_pool_t *pool_)
+{
+    const std::vector<provider_stats_t> &stats = pool_->stats;
+    const size_t count = stats.size ();
+    if (count == 1)
+        return 0;
+
+    uint64_t known_sum = 0;
+    size_t known = 0;
+    for (size_t i = 0; i < count; ++i)
+        if (stats[i].ewma_us) {
+            known_sum += stats[i].ewma_us;
+            ++known;
+        }
+    const uint64_t default_ewma = known ? known_sum / known : 0;
+
+    uint32_t &rng = pool_->rng;
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    const size_t first = rng % count;
+    size_t second = (rng / count) % (count - 1);
+    if (second >= first)
+        ++second;
+
+    uint64_t cost[2];
+    const size_t picks[2] = {first, second};
+    for (int k = 0; k < 2; ++k) {
+        const provider_stats_t &s = stats[picks[k]];
+        const uint64_t ewma = s.ewma_us ? s.ewma_us : default_ewma;
+        cost[k] = (ewma + 1) * (s.pending () + 1);
+    }
+    return cost[1] < cost[0] ? second : first;
+}
+
+void gateway_t::on_request_sent (shard_pool_t *pool_,
+                                 size_t provider_index_,
+                                 uint64_t call_id_)
+{
+    if (provider_index_ >= pool_->stats.size ())
+        return;
+    provider_stats_t &stats = pool_->stats[provider_index_];
+    if (call_id_) {
+        ++stats.calls;
+        return;
+    }
+    //  Replies that never came would otherwise count against the provider
+    //  for good.
+    const uint64_t now = clock_t::now_us ();
+    std::deque<uint64_t> &sent = stats.sent_us;
+    while (!sent.empty ()
+           && (sent.size () >= max_pending_requests
+               || now - sent.front () > pending_expiry_us))
+        sent.pop_front ();
+    sent.push_back (now);
+}
+
+void gateway_t::on_reply (shard_t *shard_,
+                          service_pool_t *pool_,
+                          const zlink_routing_id_t &rid_)
+{
+    shard_pool_t *shard_pool = &pool_->shards[shard_->index];
+    size_t index = 0;
+    if (!find_provider_index (shard_pool, &rid_, &index)
+        || index >= shard_pool->stats.size ())
+        return;
+    provider_stats_t &stats = shard_pool->stats[index];
+    if (stats.sent_us.empty ())
+        return;
+
+    const uint64_t sent = stats.sent_us.front ();
+    stats.sent_us.pop_front ();
+    record_ewma (&stats, sent);
+}
 
-bool gateway_t::find_provider_index (service_pool_t *pool_,
+void gateway_t::record_ewma (provider_stats_t *stats_, uint64_t sent_us_)
+{
+    const uint64_t now = clock_t::now_us ();
+    const int64_t sample =
+      now > sent_us_ ? static_cast<int64_t> (now - sent_us_) : 1;
+    if (!stats_->ewma_us)
+        stats_->ewma_us = static_cast<uint64_t> (sample);
+    else
+        stats_->ewma_us = static_cast<uint64_t> (
+          static_cast<int64_t> (stats_->ewma_us)
+          + (sample - static_cast<int64_t> (stats_->ewma_us))
+              / (1 << ewma_shift));
+    if (!stats_->ewma_us)
+        stats_->ewma_us = 1;
+}
+
+void gateway_t::drop_call (shard_pool_t *pool_, const zlink_routing_id_t &rid_)
+{
+    size_t index = 0;
+    //  A provider that left and came back starts from zero.
+    if (rid_.size > 0 && find_provider_index (pool_, &rid_, &index)
+        && index < pool_->stats.size () && pool_->stats[index].calls > 0)
+        --pool_->stats[index].calls;
+}
+
+void gateway_t::settle_call (call_t *call_, const zlink_routing_id_t *replied_)
+{
+    //  The call no longer waits on either provider; the one that replied
+    //  gets a latency sample from the time the call went to it.
+    shard_pool_t *shard_pool = &call_->pool->shards[call_->shard->index];
+    size_t index = 0;
+    if (replied_ && find_provider_index (shard_pool, replied_, &index)
+        && index < shard_pool->stats.size ()) {
+        if (same_routing_id (*replied_, call_->rid))
+            record_ewma (&shard_pool->stats[index], call_->rid_sent_us);
+        else if (same_routing_id (*replied_, call_->hedge_rid))
+            record_ewma (&shard_pool->stats[index], call_->hedge_sent_us);
+    }
+    drop_call (shard_pool, call_->rid);
+    drop_call (shard_pool, call_->hedge_rid);
+    call_->rid.size = 0;
+    call_->hedge_rid.size = 0;
+}
+
+bool gateway_t::find_provider_index (shard_pool_t *pool_,
                                      const zlink_routing_id_t *rid_,
                                      size_t *index_out_)
 {
@@ -400,13 +731,15 @@ bool gateway_t::find_provider_index (service_pool_t *pool_,
     return false;
 }
 
-int gateway_t::send_request_frames (service_pool_t *pool_,
+int gateway_t::send_request_frames (shard_t *shard_,
+                                    shard_pool_t *pool_,
                                     size_t provider_index_,
                                     zlink_msg_t *parts_,
                                     size_t part_count_,
-                                    int flags_)
+                                    int flags_,
+                                    uint64_t call_id_)
 {
-    if (!pool_ || !_router_socket) {
+    if (!pool_ || !shard_->router) {
         errno = ENOTSUP;
         return -1;
     }
@@ -419,29 +752,58 @@ int gateway_t::send_request_frames (service_pool_t *pool_,
         return -1;
     }
 
-    const zlink_routing_id_t &rid = pool_->routing_ids[provider_index_];
-    zlink_msg_t rid_msg;
-    zlink_msg_init_size (&rid_msg, rid.size);
-    if (rid.size > 0)
-        memcpy (zlink_msg_data (&rid_msg), rid.data, rid.size);
-    int send_flags =
-      (part_count_ > 0 ? ZLINK_SNDMORE : 0) | (flags_ & ZLINK_DONTWAIT);
-    if (zlink_msg_send (&rid_msg, _router_socket, send_flags) < 0) {
-        zlink_msg_close (&rid_msg);
-        return -1;
+    msg_t *parts = reinterpret_cast<msg_t *> (parts_);
+    for (size_t i = 0; i < part_count_; ++i) {
+        if (!parts[i].check ()) {
+            errno = EFAULT;
+            return -1;
+        }
     }
-    zlink_msg_close (&rid_msg);
 
+    //  The request goes out as one batch: a copy of the cached routing id
+    //  frame, the correlation frame of an asynchronous request, and the
+    //  caller's parts, written to the pipe with a single flush.
+    const size_t first_part = call_id_ ? 2 : 1;
+    const size_t count = part_count_ + first_part;
+    if (shard_->frames.size () < count)
+        shard_->frames.resize (count);
+    msg_t *frames = &shard_->frames[0];
+    int rc = frames[0].init ();
+    errno_assert (rc == 0);
+    rc = frames[0].copy (pool_->envelopes[provider_index_]);
+    errno_assert (rc == 0);
+    if (call_id_) {
+        rc = frames[1].init_size (call_id_size);
+        errno_assert (rc == 0);
+        put_uint64 (static_cast<unsigned char *> (frames[1].data ()),
+                    call_id_);
+    }
     for (size_t i = 0; i < part_count_; ++i) {
-        send_flags =
-          (i + 1 < part_count_) ? ZLINK_SNDMORE : 0;
-        send_flags |= (flags_ & ZLINK_DONTWAIT);
-        if (zlink_msg_send (&parts_[i], _router_socket, send_flags) < 0) {
-            return -1;
+        rc = frames[first_part + i].init ();
+        errno_assert (rc == 0);
+        rc = frames[first_part + i].move (parts[i]);
+        errno_assert (rc == 0);
+    }
+
+    const int sent = shard_->router->send_batch (
+      frames, count, ZLINK_SNDMORE | (flags_ & ZLINK_DONTWAIT));
+    if (sent < static_cast<int> (count)) {
+        //  Parts that did not go out stay with the caller.
+        const int err = errno;
+        const size_t unsent = sent > 0 ? static_cast<size_t> (sent) : 0;
+        for (size_t i = unsent; i < first_part; ++i) {
+            rc = frames[i].close ();
+            errno_assert (rc == 0);
         }
-        zlink_msg_close (&parts_[i]);
+        for (size_t i = std::max (unsent, first_part); i < count; ++i) {
+            rc = parts[i - first_part].move (frames[i]);
+            errno_assert (rc == 0);
+        }
+        errno = err;
+        return -1;
     }
 
+    on_request_sent (pool_, provider_index_, call_id_);
     return 0;
 }
 
@@ -460,21 +822,151 @@ int gateway_t::send (const char *service_name_,
         return -1;
     }
 
-    scoped_optional_lock_t lock (_use_lock ? &_sync : NULL);
-    service_pool_t *pool = get_or_create_pool_cached (service_name_);
+    shard_t *shard = caller_shard ();
+    scoped_lock_t lock (shard->sync);
+    service_pool_t *pool = get_or_create_pool_cached (shard, service_name_);
     if (!pool) {
         errno = ENOMEM;
         return -1;
     }
+    return send_to_pool (shard, pool, parts_, part_count_, flags_);
+}
+
+zlink_gateway_service_t *gateway_t::service (const char *service_name_)
+{
+    if (!service_name_ || service_name_[0] == '\0') {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    scoped_lock_t lock (_sync);
+    service_pool_t *pool = get_or_create_pool (service_name_);
+    if (!pool) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return reinterpret_cast<zlink_gateway_service_t *> (pool);
+}
+
+int gateway_t::send_service (zlink_gateway_service_t *service_,
+                             zlink_msg_t *parts_,
+                             size_t part_count_,
+                             int flags_)
+{
+    service_pool_t *pool = reinterpret_cast<service_pool_t *> (service_);
+    if (!pool || pool->owner != this || !parts_ || part_count_ == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flags_ != 0 && flags_ != ZLINK_DONTWAIT) {
+        errno = ENOTSUP;
+        return -1;
+    }
 
+    shard_t *shard = caller_shard ();
+    scoped_lock_t lock (shard->sync);
+    return send_to_pool (shard, pool, parts_, part_count_, flags_);
+}
+
+int gateway_t::send_to_pool (shard_t *shard_,
+                             service_pool_t *pool_,
+                             zlink_msg_t *parts_,
+                             size_t part_count_,
+                             int flags_,
+                             uint64_t call_id_,
+                             size_t *provider_index_,
+                             const uint64_t *key_hash_)
+{
+    shard_pool_t *shard_pool = &pool_->shards[shard_->index];
     size_t provider_index = 0;
-    if (!select_provider (pool, &provider_index)) {
+    if (!(key_hash_ ? select_keyed (shard_, shard_pool, *key_hash_,
+                                    &provider_index)
+                    : select_provider (shard_pool, &provider_index))) {
         errno = EHOSTUNREACH;
         return -1;
     }
+    //  A provider the ROUTER socket has no connection to is marked down
+    //  and, as far as the service allows, another one is tried.
+    for (int retries = 0;; ++retries) {
+        if (send_request_frames (shard_, shard_pool, provider_index, parts_,
+                                 part_count_, flags_, call_id_)
+            == 0)
+            break;
+        if (errno != EHOSTUNREACH || retries >= shard_pool->max_retries)
+            return -1;
+        const zlink_routing_id_t failed =
+          shard_pool->routing_ids[provider_index];
+        mark_down (shard_, pool_, shard_pool->endpoints[provider_index]);
+        if (!(key_hash_ ? select_keyed (shard_, shard_pool, *key_hash_,
+                                        &provider_index)
+                        : select_other_provider (shard_, shard_pool, failed,
+                                                 &provider_index))) {
+            errno = EHOSTUNREACH;
+            return -1;
+        }
+    }
+    if (provider_index_)
+        *provider_index_ = provider_index;
+    return 0;
+}
+
+bool gateway_t::select_keyed (shard_t *shard_,
+                              shard_pool_t *pool_,
+                              uint64_t key_hash_,
+                              size_t *index_out_)
+{
+    //  Rendezvous hashing: the key goes to the provider that scores it
+    //  highest. A provider joining or leaving moves only the keys it
+    //  wins or held, and a down provider hands its keys to their
+    //  runners-up for as long as it is down.
+    bool found = false;
+    uint64_t best = 0;
+    for (size_t i = 0; i < pool_->rid_hashes.size (); ++i) {
+        if (!shard_->down_endpoints.empty ()
+            && shard_->down_endpoints.count (pool_->endpoints[i]))
+            continue;
+        const uint64_t score =
+          rendezvous_score (key_hash_, pool_->rid_hashes[i]);
+        if (!found || score > best) {
+            best = score;
+            *index_out_ = i;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool gateway_t::select_other_provider (shard_t *shard_,
+                                       shard_pool_t *pool_,
+                                       const zlink_routing_id_t &exclude_,
+                                       size_t *index_out_)
+{
+    size_t index = 0;
+    if (!select_provider (pool_, &index))
+        return false;
+    //  Keep the balancer's choice if it will do, else take the next one
+    //  that is neither excluded nor down.
+    const size_t count = pool_->routing_ids.size ();
+    for (size_t n = 0; n < count; ++n, index = (index + 1) % count) {
+        if (same_routing_id (pool_->routing_ids[index], exclude_))
+            continue;
+        if (shard_->down_endpoints.count (pool_->endpoints[index]))
+            continue;
+        *index_out_ = index;
+        return true;
+    }
+    return false;
+}
 
-    return send_request_frames (pool, provider_index, parts_, part_count_,
-                                flags_);
+void gateway_t::mark_down (shard_t *shard_,
+                           service_pool_t *pool_,
+                           const std::string &endpoint_)
+{
+    shard_->ready_endpoints.erase (endpoint_);
+    shard_->down_endpoints.insert (endpoint_);
+    shard_->down_until_ms[endpoint_] =
+      shard_->clock.now_ms () + down_backoff_ms;
+    shard_->pending.insert (pool_);
 }
 
 int gateway_t::recv (zlink_msg_t **parts_,
@@ -487,110 +979,642 @@ int gateway_t::recv (zlink_msg_t **parts_,
         return -1;
     }
 
-    scoped_optional_lock_t lock (_use_lock ? &_sync : NULL);
-    if (ensure_router_socket () != 0 || !_router_socket) {
+    // Replies come back on the shard that sent the request. Look at every
+    // shard, starting at another one each call so that none is starved,
+    // and wait on all their mailboxes when none has a reply. Waiting never
+    // holds a shard lock, so senders are not held up by a blocked recv.
+    int timeout_ms = -1;
+    if (flags_ == 0) {
+        scoped_lock_t lock (_sync);
+        timeout_ms = _rcvtimeo;
+    }
+    const uint64_t deadline =
+      timeout_ms > 0 ? clock_t::now_us () / 1000 + timeout_ms : 0;
+    std::vector<zlink_pollitem_t> items;
+    while (true) {
+        const size_t start = _recv_shard.add (1);
+        for (size_t n = 0; n < _shards.size (); ++n) {
+            shard_t *shard = _shards[(start + n) % _shards.size ()];
+            scoped_lock_t lock (shard->sync);
+            if (recv_from (shard, parts_, part_count_, ZLINK_DONTWAIT,
+                           service_name_out_)
+                == 0)
+                return 0;
+            if (errno != EAGAIN)
+                return -1;
+        }
+
+        long wait_ms = shard_poll_interval_ms;
+        if (timeout_ms == 0 || flags_ == ZLINK_DONTWAIT) {
+            errno = EAGAIN;
+            return -1;
+        }
+        if (timeout_ms > 0) {
+            const uint64_t now_ms = clock_t::now_us () / 1000;
+            if (now_ms >= deadline) {
+                errno = EAGAIN;
+                return -1;
+            }
+            if (deadline - now_ms < static_cast<uint64_t> (wait_ms))
+                wait_ms = static_cast<long> (deadline - now_ms);
+        }
+        if (items.empty ()) {
+            //  The last item wakes up when the completion thread keeps a
+            //  reply that it read for recv.
+            items.resize (_shards.size () + 1);
+            for (size_t i = 0; i < items.size (); ++i) {
+                items[i].socket = NULL;
+                items[i].fd = i < _shards.size () ? _shards[i]->fd
+                                                  : _recv_signaler.get_fd ();
+                items[i].events = ZLINK_POLLIN;
+                items[i].revents = 0;
+            }
+        }
+        const int rc =
+          zlink_poll (&items[0], static_cast<int> (items.size ()), wait_ms);
+        if (rc < 0)
+            return -1;
+        if (rc > 0 && (items.back ().revents & ZLINK_POLLIN))
+            _recv_signaler.recv_failable ();
+    }
+}
+
+void gateway_t::close_envelopes (shard_pool_t *pool_)
+{
+    for (size_t i = 0; i < pool_->envelopes.size (); ++i) {
+        const int rc = pool_->envelopes[i].close ();
+        errno_assert (rc == 0);
+    }
+    pool_->envelopes.clear ();
+}
+
+int gateway_t::recv_from (shard_t *shard_,
+                          zlink_msg_t **parts_,
+                          size_t *part_count_,
+                          int flags_,
+                          char *service_name_out_)
+{
+    if (!shard_->router) {
         errno = ENOTSUP;
         return -1;
     }
 
-    zlink_msg_t msg;
-    if (zlink_msg_init (&msg) != 0) {
-        errno = EFAULT;
-        return -1;
+    service_pool_t *pool = NULL;
+    zlink_msg_t *out = NULL;
+    size_t out_count = 0;
+    if (!shard_->replies.empty ()) {
+        //  Read earlier by the completion thread.
+        const reply_t &reply = shard_->replies.front ();
+        pool = reply.pool;
+        out = reply.parts;
+        out_count = reply.part_count;
+        shard_->replies.pop_front ();
+    } else {
+        size_t frame_count = 0;
+        zlink_routing_id_t rid;
+        while (true) {
+            if (read_reply (shard_, flags_, &pool, &rid, &frame_count) != 0)
+                return -1;
+            if (!complete_call (shard_, pool, rid, frame_count))
+                break;
+            wake_async (shard_);
+        }
+        if (take_frames (shard_, 0, frame_count, &out) != 0)
+            return -1;
+        out_count = frame_count;
     }
 
-    const int rc = zlink_msg_recv (&msg, _router_socket, flags_);
-    if (rc != 0) {
-        zlink_msg_close (&msg);
+    if (service_name_out_) {
+        memset (service_name_out_, 0, 256);
+        if (pool)
+            strncpy (service_name_out_, pool->service_name.c_str (), 255);
+    }
+    if (parts_)
+        *parts_ = out;
+    else
+        zlink_msgv_close (out, out_count);
+    if (part_count_)
+        *part_count_ = out_count;
+    return 0;
+}
+
+int gateway_t::read_reply (shard_t *shard_,
+                           int flags_,
+                           service_pool_t **pool_out_,
+                           zlink_routing_id_t *rid_out_,
+                           size_t *frame_count_)
+{
+    msg_t envelope;
+    int rc = envelope.init ();
+    errno_assert (rc == 0);
+    if (shard_->router->recv (&envelope, flags_) != 0) {
+        rc = envelope.close ();
+        errno_assert (rc == 0);
         return -1;
     }
 
     zlink_routing_id_t rid;
     rid.size = 0;
-    const size_t rid_size = zlink_msg_size (&msg);
+    const size_t rid_size = envelope.size ();
     if (rid_size > 0) {
         size_t copy_size = rid_size;
         if (copy_size > sizeof (rid.data))
             copy_size = sizeof (rid.data);
         rid.size = static_cast<uint8_t> (copy_size);
-        memcpy (rid.data, zlink_msg_data (&msg), copy_size);
+        memcpy (rid.data, envelope.data (), copy_size);
     }
 
-    std::string service_name;
+    service_pool_t *pool = NULL;
     if (rid.size > 0) {
-        const std::string key = routing_id_key (rid);
-        std::map<std::string, std::string>::const_iterator it =
-          _routing_id_to_service.find (key);
-        if (it != _routing_id_to_service.end ())
-            service_name = it->second;
+        service_pool_t **found =
+          shard_->routing_id_to_pool.find (rid.data, rid.size);
+        if (found)
+            pool = *found;
     }
+    *pool_out_ = pool;
+    *rid_out_ = rid;
+
+    const bool more = (envelope.flags () & msg_t::more) != 0;
+    rc = envelope.close ();
+    errno_assert (rc == 0);
+    *frame_count_ = 0;
+    if (!more)
+        return 0;
 
-    if (service_name_out_) {
-        memset (service_name_out_, 0, 256);
-        if (!service_name.empty ())
-            strncpy (service_name_out_, service_name.c_str (), 255);
+    //  The rest of the reply is already queued once its first frame is,
+    //  so it is collected in the shard's frame buffer without allocating.
+    size_t count = 0;
+    while (true) {
+        if (shard_->frames.size () <= count)
+            shard_->frames.resize (count + 1);
+        msg_t *part = &shard_->frames[count];
+        rc = part->init ();
+        errno_assert (rc == 0);
+        if (shard_->router->recv (part, flags_) != 0) {
+            const int err = errno;
+            for (size_t i = 0; i <= count; ++i) {
+                rc = shard_->frames[i].close ();
+                errno_assert (rc == 0);
+            }
+            errno = err;
+            return -1;
+        }
+        ++count;
+        if (!(part->flags () & msg_t::more))
+            break;
     }
 
-    const int more = zlink_msg_more (&msg);
-    zlink_msg_close (&msg);
+    *frame_count_ = count;
+    return 0;
+}
 
-    if (!more) {
-        if (parts_)
-            *parts_ = NULL;
-        if (part_count_)
-            *part_count_ = 0;
+int gateway_t::take_frames (shard_t *shard_,
+                            size_t first_,
+                            size_t count_,
+                            zlink_msg_t **parts_out_)
+{
+    int rc = 0;
+    *parts_out_ = NULL;
+    if (first_ >= count_)
         return 0;
+    msg_t *out =
+      static_cast<msg_t *> (malloc (sizeof (msg_t) * (count_ - first_)));
+    if (!out) {
+        for (size_t i = first_; i < count_; ++i) {
+            rc = shard_->frames[i].close ();
+            errno_assert (rc == 0);
+        }
+        errno = ENOMEM;
+        return -1;
+    }
+    for (size_t i = first_; i < count_; ++i) {
+        rc = out[i - first_].init ();
+        errno_assert (rc == 0);
+        rc = out[i - first_].move (shard_->frames[i]);
+        errno_assert (rc == 0);
     }
+    *parts_out_ = reinterpret_cast<zlink_msg_t *> (out);
+    return 0;
+}
 
-    std::vector<zlink_msg_t> tmp_parts;
-    while (true) {
-        zlink_msg_t part;
-        if (zlink_msg_init (&part) != 0) {
-            errno = EFAULT;
-            return -1;
+bool gateway_t::complete_call (shard_t *shard_,
+                              service_pool_t *pool_,
+                              const zlink_routing_id_t &rid_,
+                              size_t frame_count_)
+{
+    if (frame_count_ == 0)
+        return false;
+    uint64_t id = 0;
+    if (shard_->frames[0].size () == call_id_size)
+        id = get_uint64 (
+          static_cast<const unsigned char *> (shard_->frames[0].data ()));
+    if (shard_->frames[0].size () != call_id_size
+        || id == 0
+        || id - shard_->first_call_id
+             >= shard_->next_call_id - shard_->first_call_id) {
+        //  A probe from a provider that just connected is a single empty
+        //  frame; anything else is a plain reply and settles the oldest
+        //  plain request.
+        if (pool_ && (frame_count_ > 1 || shard_->frames[0].size () > 0))
+            on_reply (shard_, pool_, rid_);
+        return false;
+    }
+
+    //  A reply to a call of this shard. One that comes after its call
+    //  timed out is dropped.
+    int rc = shard_->frames[0].close ();
+    errno_assert (rc == 0);
+    std::unordered_map<uint64_t, call_t *>::iterator it =
+      shard_->calls.find (id);
+    if (it == shard_->calls.end ()) {
+        for (size_t i = 1; i < frame_count_; ++i) {
+            rc = shard_->frames[i].close ();
+            errno_assert (rc == 0);
+        }
+        return true;
+    }
+    call_t *call = it->second;
+    zlink_msg_t *parts = NULL;
+    if (take_frames (shard_, 1, frame_count_, &parts) != 0) {
+        finish_call (call, ENOMEM, NULL, 0);
+        return true;
+    }
+    settle_call (call, &rid_);
+    shard_pool_t *shard_pool = &call->pool->shards[shard_->index];
+    if (shard_pool->hedge_budget > 0)
+        record_latency (shard_, shard_pool,
+                        clock_t::now_us () - call->sent_us);
+    finish_call (call, 0, parts, frame_count_ - 1);
+    return true;
+}
+
+void gateway_t::finish_call (call_t *call_,
+                             int status_,
+                             zlink_msg_t *parts_,
+                             size_t part_count_)
+{
+    shard_t *shard = call_->shard;
+    const completion_t completion = {call_->callback, call_->userdata,
+                                     status_, parts_, part_count_};
+    shard->completed.push_back (completion);
+    shard->timers.cancel (&call_->timer);
+    shard->timers.cancel (&call_->hedge_timer);
+    settle_call (call_, NULL);
+    for (size_t i = 0; i < call_->parts.size (); ++i) {
+        const int rc = call_->parts[i].close ();
+        errno_assert (rc == 0);
+    }
+    call_->parts.clear ();
+    shard->calls.erase (call_->id);
+    shard->free_calls.push_back (call_);
+}
+
+void gateway_t::call_expired (timer_wheel_t::timer_t *timer_)
+{
+    finish_call (static_cast<call_t *> (timer_->arg), ETIMEDOUT, NULL, 0);
+}
+
+void gateway_t::hedge_due (timer_wheel_t::timer_t *timer_)
+{
+    call_t *call = static_cast<call_t *> (timer_->arg);
+    shard_pool_t *shard_pool = &call->pool->shards[call->shard->index];
+    if (shard_pool->hedge_tokens < 100)
+        return;
+    if (call->pool->owner->resend_call (call, call->rid, &call->hedge_rid)) {
+        call->hedge_sent_us = clock_t::now_us ();
+        shard_pool->hedge_tokens -= 100;
+    }
+}
+
+bool gateway_t::resend_call (call_t *call_,
+                             const zlink_routing_id_t &exclude_,
+                             zlink_routing_id_t *sent_to_)
+{
+    shard_t *shard = call_->shard;
+    shard_pool_t *shard_pool = &call_->pool->shards[shard->index];
+    size_t index = 0;
+    if (call_->parts.empty ()
+        || !select_other_provider (shard, shard_pool, exclude_, &index))
+        return false;
+
+    std::vector<msg_t> &parts = shard->resend_parts;
+    parts.resize (call_->parts.size ());
+    for (size_t i = 0; i < parts.size (); ++i) {
+        int rc = parts[i].init ();
+        errno_assert (rc == 0);
+        rc = parts[i].copy (call_->parts[i]);
+        errno_assert (rc == 0);
+    }
+    //  Never block the thread that resends on a full pipe.
+    if (send_request_frames (shard, shard_pool, index,
+                             reinterpret_cast<zlink_msg_t *> (&parts[0]),
+                             parts.size (), ZLINK_DONTWAIT, call_->id)
+        != 0) {
+        for (size_t i = 0; i < parts.size (); ++i)
+            parts[i].close ();
+        return false;
+    }
+    *sent_to_ = shard_pool->routing_ids[index];
+    return true;
+}
+
+void gateway_t::retry_calls (shard_t *shard_,
+                             service_pool_t *pool_,
+                             const zlink_routing_id_t &rid_)
+{
+    if (shard_->calls.empty ())
+        return;
+    shard_pool_t *shard_pool = &pool_->shards[shard_->index];
+    const zlink_routing_id_t rid = rid_;
+
+    //  A call whose hedge is still out just waits for the hedge; one
+    //  that waited on the lost provider alone is sent elsewhere.
+    std::vector<call_t *> stranded;
+    for (std::unordered_map<uint64_t, call_t *>::iterator it =
+           shard_->calls.begin ();
+         it != shard_->calls.end (); ++it) {
+        call_t *call = it->second;
+        if (call->pool != pool_)
+            continue;
+        if (same_routing_id (call->hedge_rid, rid)) {
+            drop_call (shard_pool, rid);
+            call->hedge_rid.size = 0;
+        } else if (same_routing_id (call->rid, rid)) {
+            if (call->hedge_rid.size > 0) {
+                drop_call (shard_pool, rid);
+                call->rid = call->hedge_rid;
+                call->rid_sent_us = call->hedge_sent_us;
+                call->hedge_rid.size = 0;
+            } else if (shard_pool->max_retries > 0)
+                stranded.push_back (call);
         }
-        const int prc = zlink_msg_recv (&part, _router_socket, flags_);
-        if (prc != 0) {
-            zlink_msg_close (&part);
-            for (size_t i = 0; i < tmp_parts.size (); ++i)
-                zlink_msg_close (&tmp_parts[i]);
+    }
+    for (size_t i = 0; i < stranded.size (); ++i) {
+        call_t *call = stranded[i];
+        drop_call (shard_pool, rid);
+        call->rid.size = 0;
+        if (call->retries < shard_pool->max_retries
+            && resend_call (call, rid, &call->rid)) {
+            call->rid_sent_us = clock_t::now_us ();
+            ++call->retries;
+        } else
+            finish_call (call, EHOSTUNREACH, NULL, 0);
+    }
+    if (!shard_->completed.empty ())
+        wake_async (shard_);
+}
+
+void gateway_t::record_latency (shard_t *shard_,
+                                shard_pool_t *pool_,
+                                uint64_t sample_us_)
+{
+    const uint32_t sample = static_cast<uint32_t> (
+      std::min<uint64_t> (sample_us_, UINT32_MAX));
+    if (pool_->latencies_us.size () < latency_window)
+        pool_->latencies_us.push_back (sample);
+    else
+        pool_->latencies_us[pool_->latency_count % latency_window] = sample;
+    ++pool_->latency_count;
+    if (pool_->latency_count < latency_min_samples
+        || pool_->latency_count % latency_refresh != 0)
+        return;
+
+    std::vector<uint32_t> &scratch = shard_->latency_scratch;
+    scratch.assign (pool_->latencies_us.begin (), pool_->latencies_us.end ());
+    std::vector<uint32_t>::iterator p95 =
+      scratch.begin () + scratch.size () * 95 / 100;
+    std::nth_element (scratch.begin (), p95, scratch.end ());
+    pool_->hedge_after_ms = std::max<uint64_t> (1, (*p95 + 999) / 1000);
+}
+
+void gateway_t::wake_async (shard_t *shard_)
+{
+    if (shard_->async_woken)
+        return;
+    shard_->async_woken = true;
+    _async_signaler.send ();
+}
+
+int gateway_t::start_async ()
+{
+    if (_async_started.load (std::memory_order_acquire))
+        return 0;
+    scoped_lock_t lock (_sync);
+    if (!_async_worker.get_started ()) {
+        if (!_async_signaler.valid () || !_recv_signaler.valid ()) {
+            errno = EMFILE;
             return -1;
         }
-        tmp_parts.push_back (part);
-        if (!zlink_msg_more (&part))
-            break;
+        _async_worker.start (async_run, this, "gateway-async");
     }
+    _async_started.store (true, std::memory_order_release);
+    return 0;
+}
 
-    const size_t out_count = tmp_parts.size ();
-    zlink_msg_t *out =
-      static_cast<zlink_msg_t *> (malloc (sizeof (zlink_msg_t) * out_count));
-    if (!out) {
-        for (size_t i = 0; i < tmp_parts.size (); ++i)
-            zlink_msg_close (&tmp_parts[i]);
-        errno = ENOMEM;
+int gateway_t::request_async (const char *service_name_,
+                              zlink_msg_t *parts_,
+                              size_t part_count_,
+                              int timeout_ms_,
+                              zlink_gateway_completion_fn *callback_,
+                              void *userdata_)
+{
+    if (!service_name_ || service_name_[0] == '\0' || !parts_
+        || part_count_ == 0 || !callback_ || timeout_ms_ < -1) {
+        errno = EINVAL;
         return -1;
     }
+    if (_stop.get () != 0) {
+        errno = ETERM;
+        return -1;
+    }
+    if (start_async () != 0)
+        return -1;
+    const int timeout_ms =
+      timeout_ms_ == 0 ? _request_timeout.load () : timeout_ms_;
 
-    for (size_t i = 0; i < out_count; ++i) {
-        if (zlink_msg_init (&out[i]) != 0
-            || zlink_msg_move (&out[i], &tmp_parts[i]) != 0) {
-            for (size_t j = 0; j <= i && j < out_count; ++j)
-                zlink_msg_close (&out[j]);
-            free (out);
-            for (size_t j = i; j < tmp_parts.size (); ++j)
-                zlink_msg_close (&tmp_parts[j]);
-            errno = EFAULT;
-            return -1;
+    shard_t *shard = caller_shard ();
+    scoped_lock_t lock (shard->sync);
+    service_pool_t *pool = get_or_create_pool_cached (shard, service_name_);
+    if (!pool) {
+        errno = ENOMEM;
+        return -1;
+    }
+    shard_pool_t *shard_pool = &pool->shards[shard->index];
+
+    call_t *call = NULL;
+    if (shard->free_calls.empty ()) {
+        call = new (std::nothrow) call_t;
+        alloc_assert (call);
+        call->shard = shard;
+        call->timer.callback = call_expired;
+        call->timer.arg = call;
+        call->hedge_timer.callback = hedge_due;
+        call->hedge_timer.arg = call;
+    } else {
+        call = shard->free_calls.back ();
+        shard->free_calls.pop_back ();
+    }
+    //  Hedges and retries send the request again, so it is kept.
+    const bool keep = shard_pool->hedge_budget > 0 || shard_pool->max_retries > 0;
+    if (keep) {
+        call->parts.resize (part_count_);
+        for (size_t i = 0; i < part_count_; ++i) {
+            int rc = call->parts[i].init ();
+            errno_assert (rc == 0);
+            rc = call->parts[i].copy (*reinterpret_cast<msg_t *> (&parts_[i]));
+            if (rc != 0) {
+                for (size_t j = 0; j < i; ++j)
+                    call->parts[j].close ();
+                call->parts.clear ();
+                shard->free_calls.push_back (call);
+                return -1;
+            }
         }
     }
 
-    if (parts_)
-        *parts_ = out;
-    if (part_count_)
-        *part_count_ = out_count;
+    const uint64_t id = shard->next_call_id;
+    size_t provider_index = 0;
+    if (send_to_pool (shard, pool, parts_, part_count_, 0, id,
+                      &provider_index)
+        != 0) {
+        const int err = errno;
+        for (size_t i = 0; i < call->parts.size (); ++i)
+            call->parts[i].close ();
+        call->parts.clear ();
+        shard->free_calls.push_back (call);
+        errno = err;
+        return -1;
+    }
+    if (++shard->next_call_id == 0)
+        ++shard->next_call_id;
+
+    call->pool = pool;
+    call->id = id;
+    call->sent_us = clock_t::now_us ();
+    call->rid_sent_us = call->sent_us;
+    call->callback = callback_;
+    call->userdata = userdata_;
+    call->rid = shard_pool->routing_ids[provider_index];
+    call->hedge_rid.size = 0;
+    call->retries = 0;
+    shard->calls[id] = call;
+    const uint64_t now_ms = shard->clock.now_ms ();
+    if (timeout_ms > 0)
+        shard->timers.add (&call->timer, now_ms + timeout_ms);
+    if (shard_pool->hedge_budget > 0) {
+        shard_pool->hedge_tokens = std::min (
+          shard_pool->hedge_tokens + shard_pool->hedge_budget,
+          hedge_budget_cap);
+        if (shard_pool->hedge_after_ms > 0
+            && shard_pool->routing_ids.size () > 1)
+            shard->timers.add (&call->hedge_timer,
+                               now_ms + shard_pool->hedge_after_ms);
+    }
+
+    //  Sending may have taken in the command that announces a reply, in
+    //  which case the completion thread would not see the socket wake.
+    if (shard->calls.size () == 1 || shard->router->has_in ())
+        wake_async (shard);
     return 0;
 }
 
+bool gateway_t::drain_replies (shard_t *shard_)
+{
+    bool kept = false;
+    while (!shard_->calls.empty ()) {
+        service_pool_t *pool = NULL;
+        size_t frame_count = 0;
+        zlink_routing_id_t rid;
+        if (read_reply (shard_, ZLINK_DONTWAIT, &pool, &rid, &frame_count)
+            != 0)
+            break;
+        if (complete_call (shard_, pool, rid, frame_count))
+            continue;
+        reply_t reply = {pool, NULL, frame_count};
+        if (take_frames (shard_, 0, frame_count, &reply.parts) != 0)
+            continue;
+        shard_->replies.push_back (reply);
+        kept = true;
+    }
+    return kept;
+}
+
+void gateway_t::async_run (void *arg_)
+{
+    gateway_t *self = static_cast<gateway_t *> (arg_);
+    self->async_loop ();
+}
+
+void gateway_t::async_loop ()
+{
+    std::vector<zlink_pollitem_t> items (_shards.size () + 1);
+    for (size_t i = 0; i < items.size (); ++i) {
+        items[i].socket = NULL;
+        items[i].fd =
+          i < _shards.size () ? _shards[i]->fd : _async_signaler.get_fd ();
+        items[i].events = ZLINK_POLLIN;
+        items[i].revents = 0;
+    }
+    std::vector<completion_t> completions;
+    while (_stop.get () == 0) {
+        long wait_ms = shard_poll_interval_ms;
+        bool kept = false;
+        for (size_t i = 0; i < _shards.size (); ++i) {
+            shard_t *shard = _shards[i];
+            scoped_lock_t lock (shard->sync);
+            shard->async_woken = false;
+            kept |= drain_replies (shard);
+            const uint64_t next =
+              shard->timers.advance (shard->clock.now_ms ());
+            if (next > 0 && next < static_cast<uint64_t> (wait_ms))
+                wait_ms = static_cast<long> (next);
+            completions.insert (completions.end (), shard->completed.begin (),
+                                shard->completed.end ());
+            shard->completed.clear ();
+        }
+        if (kept)
+            _recv_signaler.send ();
+
+        //  Callbacks run without any lock held, so they may send.
+        for (size_t i = 0; i < completions.size (); ++i) {
+            const completion_t &completion = completions[i];
+            completion.callback (completion.status, completion.parts,
+                                 completion.part_count, completion.userdata);
+            zlink_msgv_close (completion.parts, completion.part_count);
+        }
+        completions.clear ();
+
+        if (zlink_poll (&items[0], static_cast<int> (items.size ()), wait_ms)
+              > 0
+            && (items.back ().revents & ZLINK_POLLIN))
+            _async_signaler.recv_failable ();
+    }
+}
+
+void gateway_t::cancel_calls ()
+{
+    std::vector<completion_t> completions;
+    for (size_t i = 0; i < _shards.size (); ++i) {
+        shard_t *shard = _shards[i];
+        scoped_lock_t lock (shard->sync);
+        while (!shard->calls.empty ())
+            finish_call (shard->calls.begin ()->second, ECANCELED, NULL, 0);
+        completions.insert (completions.end (), shard->completed.begin (),
+                            shard->completed.end ());
+        shard->completed.clear ();
+        for (size_t j = 0; j < shard->replies.size (); ++j)
+            zlink_msgv_close (shard->replies[j].parts,
+                              shard->replies[j].part_count);
+        shard->replies.clear ();
+    }
+    for (size_t i = 0; i < completions.size (); ++i) {
+        const completion_t &completion = completions[i];
+        completion.callback (completion.status, completion.parts,
+                             completion.part_count, completion.userdata);
+        zlink_msgv_close (completion.parts, completion.part_count);
+    }
+}
+
 int gateway_t::send_rid (const char *service_name_,
                          const zlink_routing_id_t *routing_id_,
                          zlink_msg_t *parts_,
@@ -607,21 +1631,52 @@ int gateway_t::send_rid (const char *service_name_,
         return -1;
     }
 
-    scoped_optional_lock_t lock (_use_lock ? &_sync : NULL);
-    service_pool_t *pool = get_or_create_pool_cached (service_name_);
+    shard_t *shard = caller_shard ();
+    scoped_lock_t lock (shard->sync);
+    service_pool_t *pool = get_or_create_pool_cached (shard, service_name_);
     if (!pool) {
         errno = ENOMEM;
         return -1;
     }
 
+    shard_pool_t *shard_pool = &pool->shards[shard->index];
     size_t provider_index = 0;
-    if (!find_provider_index (pool, routing_id_, &provider_index)) {
+    if (!find_provider_index (shard_pool, routing_id_, &provider_index)) {
         errno = EHOSTUNREACH;
         return -1;
     }
 
-    return send_request_frames (pool, provider_index, parts_, part_count_,
-                                flags_);
+    return send_request_frames (shard, shard_pool, provider_index, parts_,
+                                part_count_, flags_);
+}
+
+int gateway_t::send_keyed (const char *service_name_,
+                           const void *key_,
+                           size_t key_len_,
+                           zlink_msg_t *parts_,
+                           size_t part_count_,
+                           int flags_)
+{
+    if (!service_name_ || service_name_[0] == '\0' || !key_ || key_len_ == 0
+        || !parts_ || part_count_ == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flags_ != 0 && flags_ != ZLINK_DONTWAIT) {
+        errno = ENOTSUP;
+        return -1;
+    }
+
+    const uint64_t key_hash = hash_bytes (key_, key_len_);
+    shard_t *shard = caller_shard ();
+    scoped_lock_t lock (shard->sync);
+    service_pool_t *pool = get_or_create_pool_cached (shard, service_name_);
+    if (!pool) {
+        errno = ENOMEM;
+        return -1;
+    }
+    return send_to_pool (shard, pool, parts_, part_count_, flags_, 0, NULL,
+                         &key_hash);
 }
 
 int gateway_t::set_lb_strategy (const char *service_name_, int strategy_)
@@ -631,16 +1686,49 @@ int gateway_t::set_lb_strategy (const char *service_name_, int strategy_)
         return -1;
     }
     if (strategy_ != ZLINK_GATEWAY_LB_ROUND_ROBIN
-        && strategy_ != ZLINK_GATEWAY_LB_WEIGHTED) {
+        && strategy_ != ZLINK_GATEWAY_LB_WEIGHTED
+        && strategy_ != ZLINK_GATEWAY_LB_LEAST_OUTSTANDING
+        && strategy_ != ZLINK_GATEWAY_LB_P2C_EWMA) {
         errno = EINVAL;
         return -1;
     }
 
-    scoped_optional_lock_t lock (_use_lock ? &_sync : NULL);
-    service_pool_t *pool = get_or_create_pool (service_name_);
+    service_pool_t *pool = NULL;
+    {
+        scoped_lock_t lock (_sync);
+        pool = get_or_create_pool (service_name_);
+    }
     if (!pool)
         return -1;
-    pool->lb_strategy = strategy_;
+    for (size_t i = 0; i < _shards.size (); ++i) {
+        scoped_lock_t lock (_shards[i]->sync);
+        pool->shards[i].lb_strategy = strategy_;
+    }
+    return 0;
+}
+
+int gateway_t::set_request_policy (const char *service_name_,
+                                   int hedge_budget_,
+                                   int max_retries_)
+{
+    if (!service_name_ || service_name_[0] == '\0' || hedge_budget_ < 0
+        || hedge_budget_ > 100 || max_retries_ < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    service_pool_t *pool = NULL;
+    {
+        scoped_lock_t lock (_sync);
+        pool = get_or_create_pool (service_name_);
+    }
+    if (!pool)
+        return -1;
+    for (size_t i = 0; i < _shards.size (); ++i) {
+        scoped_lock_t lock (_shards[i]->sync);
+        pool->shards[i].hedge_budget = hedge_budget_;
+        pool->shards[i].max_retries = max_retries_;
+    }
     return 0;
 }
 
@@ -653,19 +1741,31 @@ int gateway_t::set_socket_option (int option_,
         return -1;
     }
 
-    scoped_optional_lock_t lock (_use_lock ? &_sync : NULL);
-    if (!_router_socket) {
-        errno = ENOTSUP;
-        return -1;
+    for (size_t i = 0; i < _shards.size (); ++i) {
+        scoped_lock_t lock (_shards[i]->sync);
+        if (!_shards[i]->router) {
+            errno = ENOTSUP;
+            return -1;
+        }
+        if (_shards[i]->router->setsockopt (option_, optval_, optvallen_)
+            != 0)
+            return -1;
     }
-    return _router_socket->setsockopt (option_, optval_, optvallen_);
+    if (option_ == ZLINK_RCVTIMEO && optvallen_ == sizeof (int)) {
+        scoped_lock_t lock (_sync);
+        memcpy (&_rcvtimeo, optval_, sizeof (int));
+    }
+    if (option_ == ZLINK_REQUEST_TIMEOUT && optvallen_ == sizeof (int)) {
+        int value = 0;
+        memcpy (&value, optval_, sizeof (int));
+        _request_timeout.store (value);
+    }
+    return 0;
 }
 
 void *gateway_t::router ()
 {
-    if (ensure_router_socket () != 0)
-        return NULL;
-    return static_cast<void *> (_router_socket);
+    return static_cast<void *> (_shards[0]->router);
 }
 
 void gateway_t::on_service_update (const std::string &service_name_)
@@ -673,13 +1773,8 @@ void gateway_t::on_service_update (const std::string &service_name_)
     if (_stop.get () != 0)
         return;
     scoped_lock_t lock (_sync);
-    if (!service_name_.empty ()) {
+    if (!service_name_.empty ())
         _pending_updates.insert (service_name_);
-        std::map<std::string, service_pool_t>::iterator pit =
-          _pools.find (service_name_);
-        if (pit != _pools.end ())
-            pit->second.dirty = true;
-    }
 }
 
 int gateway_t::connection_count (const char *service_name_)
@@ -689,12 +1784,24 @@ int gateway_t::connection_count (const char *service_name_)
         return -1;
     }
 
-    scoped_optional_lock_t lock (_use_lock ? &_sync : NULL);
-    process_monitor_events ();
-    service_pool_t *pool = get_or_create_pool (service_name_);
+    service_pool_t *pool = NULL;
+    {
+        scoped_lock_t lock (_sync);
+        pool = get_or_create_pool (service_name_);
+    }
     if (!pool)
         return 0;
-    return static_cast<int> (pool->endpoints.size ());
+
+    // A service counts as connected as far as every shard is.
+    size_t count = 0;
+    for (size_t i = 0; i < _shards.size (); ++i) {
+        scoped_lock_t lock (_shards[i]->sync);
+        process_monitor_events (_shards[i]);
+        const size_t shard_count = pool->shards[i].endpoints.size ();
+        if (i == 0 || shard_count < count)
+            count = shard_count;
+    }
+    return static_cast<int> (count);
 }
 
 int gateway_t::set_tls_client (const char *ca_cert_,
@@ -706,18 +1813,22 @@ int gateway_t::set_tls_client (const char *ca_cert_,
         return -1;
     }
 
-    scoped_optional_lock_t lock (_use_lock ? &_sync : NULL);
-    _tls_ca.assign (ca_cert_);
-    _tls_hostname.assign (hostname_);
-    _tls_trust_system = trust_system_;
+    {
+        scoped_lock_t lock (_sync);
+        _tls_ca.assign (ca_cert_);
+        _tls_hostname.assign (hostname_);
+        _tls_trust_system = trust_system_;
+    }
 
-    if (ensure_router_socket () != 0)
-        return -1;
-    if (_router_socket
-        && apply_tls_client (_router_socket, _tls_ca, _tls_hostname,
-                             _tls_trust_system)
-             != 0)
-        return -1;
+    for (size_t i = 0; i < _shards.size (); ++i) {
+        scoped_lock_t lock (_shards[i]->sync);
+        if (!_shards[i]->router)
+            return -1;
+        if (apply_tls_client (_shards[i]->router, ca_cert_, hostname_,
+                              trust_system_)
+            != 0)
+            return -1;
+    }
     return 0;
 }
 
@@ -728,34 +1839,53 @@ int gateway_t::destroy ()
         _discovery->remove_observer (this);
     if (_refresh_worker.get_started ())
         _refresh_worker.stop ();
-    _pools.clear ();
-    _last_service_name.clear ();
-    _last_pool = NULL;
-    _endpoint_to_service.clear ();
-    _routing_id_to_service.clear ();
-    _ready_endpoints.clear ();
-    _down_endpoints.clear ();
-    _down_until_ms.clear ();
-    _force_refresh_all = false;
-    _pending_updates.clear ();
-    if (_monitor_socket) {
-        zlink_close (_monitor_socket);
-        _monitor_socket = NULL;
-    }
-    if (_router_socket) {
-        _router_socket->close ();
-        _router_socket = NULL;
+    if (_async_worker.get_started ()) {
+        _async_signaler.send ();
+        _async_worker.stop ();
+    }
+    cancel_calls ();
+    for (size_t i = 0; i < _shards.size (); ++i) {
+        shard_t *shard = _shards[i];
+        scoped_lock_t lock (shard->sync);
+        shard->pools.clear ();
+        shard->last_service_name.clear ();
+        shard->last_pool = NULL;
+        shard->endpoint_to_pool.clear ();
+        shard->routing_id_to_pool.clear ();
+        shard->ready_endpoints.clear ();
+        shard->down_endpoints.clear ();
+        shard->down_until_ms.clear ();
+        shard->pending.clear ();
+        shard->force_refresh_all = false;
+        if (shard->monitor) {
+            zlink_close (shard->monitor);
+            shard->monitor = NULL;
+        }
+        if (shard->router) {
+            shard->router->close ();
+            shard->router = NULL;
+        }
+    }
+    {
+        scoped_lock_t lock (_sync);
+        for (std::map<std::string, service_pool_t>::iterator it =
+               _pools.begin ();
+             it != _pools.end (); ++it)
+            for (size_t i = 0; i < it->second.shards.size (); ++i)
+                close_envelopes (&it->second.shards[i]);
+        _pools.clear ();
+        _pending_updates.clear ();
     }
     return 0;
 }
 
-void gateway_t::process_monitor_events ()
+void gateway_t::process_monitor_events (shard_t *shard_)
 {
-    if (!_monitor_socket)
+    if (!shard_->monitor)
         return;
     while (true) {
         zlink_monitor_event_t event;
-        const int rc = zlink_monitor_recv (_monitor_socket, &event,
+        const int rc = zlink_monitor_recv (shard_->monitor, &event,
                                            ZLINK_DONTWAIT);
         if (rc != 0) {
             if (errno == EAGAIN)
@@ -765,30 +1895,41 @@ void gateway_t::process_monitor_events ()
         const std::string endpoint = event.remote_addr;
         if (endpoint.empty ())
             continue;
+        bool lost = false;
         if (event.event == ZLINK_EVENT_CONNECTION_READY) {
-            _down_endpoints.erase (endpoint);
-            _down_until_ms.erase (endpoint);
-            _ready_endpoints.insert (endpoint);
+            shard_->down_endpoints.erase (endpoint);
+            shard_->down_until_ms.erase (endpoint);
+            shard_->ready_endpoints.insert (endpoint);
         } else if (event.event == ZLINK_EVENT_DISCONNECTED
                    || event.event == ZLINK_EVENT_HANDSHAKE_FAILED_NO_DETAIL
                    || event.event == ZLINK_EVENT_HANDSHAKE_FAILED_PROTOCOL
                    || event.event == ZLINK_EVENT_HANDSHAKE_FAILED_AUTH) {
-            _ready_endpoints.erase (endpoint);
-            _down_endpoints.insert (endpoint);
-            _down_until_ms[endpoint] = _clock.now_ms () + 500;
-        }
-        std::map<std::string, std::string>::iterator it =
-          _endpoint_to_service.find (endpoint);
-        if (it != _endpoint_to_service.end ()) {
-            std::map<std::string, service_pool_t>::iterator pit =
-              _pools.find (it->second);
-            if (pit != _pools.end ()) {
-                pit->second.dirty = true;
-                _pending_updates.insert (it->second);
-            }
-        } else {
-            _force_refresh_all = true;
+            shard_->ready_endpoints.erase (endpoint);
+            shard_->down_endpoints.insert (endpoint);
+            shard_->down_until_ms[endpoint] =
+              shard_->clock.now_ms () + down_backoff_ms;
+            lost = true;
         }
+        std::map<std::string, service_pool_t *>::iterator it =
+          shard_->endpoint_to_pool.find (endpoint);
+        if (it == shard_->endpoint_to_pool.end ()) {
+            shard_->force_refresh_all = true;
+            continue;
+        }
+        shard_->pending.insert (it->second);
+        if (!lost)
+            continue;
+        //  The plain requests to the lost provider will not be answered;
+        //  calls waiting on it are sent elsewhere.
+        shard_pool_t &shard_pool = it->second->shards[shard_->index];
+        const size_t index = static_cast<size_t> (
+          std::find (shard_pool.endpoints.begin (), shard_pool.endpoints.end (),
+                     endpoint)
+          - shard_pool.endpoints.begin ());
+        if (index < shard_pool.stats.size ())
+            shard_pool.stats[index].sent_us.clear ();
+        if (index < shard_pool.routing_ids.size ())
+            retry_calls (shard_, it->second, shard_pool.routing_ids[index]);
     }
 }
 }
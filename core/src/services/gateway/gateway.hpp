@@ -7,16 +7,23 @@
 
 #include "core/ctx.hpp"
 #include "core/msg.hpp"
+#include "core/signaler.hpp"
 #include "core/thread.hpp"
+#include "core/timer_wheel.hpp"
 #include "services/discovery/discovery.hpp"
 #include "utils/clock.hpp"
 #include "utils/atomic_counter.hpp"
+#include "utils/blob_map.hpp"
+#include "utils/fd.hpp"
 #include "utils/mutex.hpp"
 
+#include <atomic>
+#include <deque>
 #include <map>
 #include <set>
 #include <stdint.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace zlink
@@ -26,8 +33,11 @@ class socket_base_t;
 class gateway_t : public discovery_observer_t
 {
   public:
+    // A gateway with more than one shard gives each shard its own ROUTER
+    // socket and lock; a calling thread always uses the same shard.
     gateway_t (ctx_t *ctx_, discovery_t *discovery_,
-               const char *routing_id_ = NULL);
+               const char *routing_id_ = NULL,
+               int shards_ = 1);
     ~gateway_t ();
 
     bool check_tag () const;
@@ -36,6 +46,11 @@ class gateway_t : public discovery_observer_t
               zlink_msg_t *parts_,
               size_t part_count_,
               int flags_);
+    zlink_gateway_service_t *service (const char *service_name_);
+    int send_service (zlink_gateway_service_t *service_,
+                      zlink_msg_t *parts_,
+                      size_t part_count_,
+                      int flags_);
     int recv (zlink_msg_t **parts_,
               size_t *part_count_,
               int flags_,
@@ -45,8 +60,23 @@ class gateway_t : public discovery_observer_t
                   zlink_msg_t *parts_,
                   size_t part_count_,
                   int flags_);
+    int send_keyed (const char *service_name_,
+                    const void *key_,
+                    size_t key_len_,
+                    zlink_msg_t *parts_,
+                    size_t part_count_,
+                    int flags_);
+    int request_async (const char *service_name_,
+                       zlink_msg_t *parts_,
+                       size_t part_count_,
+                       int timeout_ms_,
+                       zlink_gateway_completion_fn *callback_,
+                       void *userdata_);
 
     int set_lb_strategy (const char *service_name_, int strategy_);
+    int set_request_policy (const char *service_name_,
+                            int hedge_budget_,
+                            int max_retries_);
     int set_socket_option (int option_,
                            const void *optval_,
                            size_t optvallen_);
@@ -60,35 +90,248 @@ class gateway_t : public discovery_observer_t
     int destroy ();
 
   private:
-    struct service_pool_t
+    // What the load balancer knows about a provider. Calls find their
+    // reply by correlation id through the call table, so only their number
+    // is kept here. Plain requests carry no id and are assumed to be
+    // answered in order, so a plain reply settles the oldest one.
+    struct provider_stats_t
+    {
+        provider_stats_t () :
+            weight (1), current_weight (0), calls (0), ewma_us (0)
+        {
+        }
+
+        size_t pending () const { return sent_us.size () + calls; }
+
+        uint32_t weight;
+        int64_t current_weight;
+        std::deque<uint64_t> sent_us;
+        size_t calls;
+        uint64_t ewma_us;
+    };
+
+    // The providers of a service as one shard sees them, and the
+    // balancing state over them. Guarded by the lock of that shard.
+    struct shard_pool_t
     {
-        std::string service_name;
         std::vector<zlink_routing_id_t> routing_ids;
+        // Routing id frame of each provider, copied into every request so
+        // that sending never builds the frame anew.
+        std::vector<msg_t> envelopes;
+        // Hash of each routing id, for rendezvous hashing of keyed sends.
+        std::vector<uint64_t> rid_hashes;
         std::vector<std::string> endpoints;
+        std::vector<provider_stats_t> stats;
         size_t rr_index;
         int lb_strategy;
+        uint32_t rng;
         uint64_t last_seen_seq;
-        bool dirty;
+
+        // Request policy of the service. Hedges are paid from a budget
+        // that each request tops up by hedge_budget hundredths of a hedge,
+        // and go out once a call is older than the 95th percentile of the
+        // recent call latencies.
+        int hedge_budget;
+        int max_retries;
+        int hedge_tokens;
+        std::vector<uint32_t> latencies_us;
+        size_t latency_count;
+        uint64_t hedge_after_ms;
+    };
+
+    // Pools are never erased before destroy and std::map does not move its
+    // elements, so a pool doubles as the service handle handed out.
+    struct service_pool_t
+    {
+        gateway_t *owner;
+        std::string service_name;
+        std::vector<shard_pool_t> shards;
+    };
+
+    struct shard_t;
+
+    // An asynchronous request waiting for its reply. The correlation id
+    // travels as the first frame of the request and of the reply.
+    struct call_t
+    {
+        timer_wheel_t::timer_t timer;
+        timer_wheel_t::timer_t hedge_timer;
+        shard_t *shard;
+        service_pool_t *pool;
+        uint64_t id;
+        uint64_t sent_us;
+        // When the request went to rid and to hedge_rid.
+        uint64_t rid_sent_us;
+        uint64_t hedge_sent_us;
+        zlink_gateway_completion_fn *callback;
+        void *userdata;
+        // The providers the call waits on; hedge_rid is empty unless a
+        // hedge is out.
+        zlink_routing_id_t rid;
+        zlink_routing_id_t hedge_rid;
+        // Copies of the request, kept when the service hedges or retries.
+        std::vector<msg_t> parts;
+        int retries;
+    };
+
+    // A finished call, to be handed to its callback by the completion
+    // thread without any lock held.
+    struct completion_t
+    {
+        zlink_gateway_completion_fn *callback;
+        void *userdata;
+        int status;
+        zlink_msg_t *parts;
+        size_t part_count;
+    };
+
+    // A plain reply read by the completion thread, kept for recv.
+    struct reply_t
+    {
+        service_pool_t *pool;
+        zlink_msg_t *parts;
+        size_t part_count;
+    };
+
+    struct shard_t
+    {
+        shard_t ();
+
+        size_t index;
+        mutex_t sync;
+        socket_base_t *router;
+        void *monitor;
+        fd_t fd;
+        std::map<std::string, service_pool_t *> pools;
+        std::string last_service_name;
+        service_pool_t *last_pool;
+        std::map<std::string, service_pool_t *> endpoint_to_pool;
+        blob_map_t<service_pool_t *> routing_id_to_pool;
+        std::set<std::string> ready_endpoints;
+        std::set<std::string> down_endpoints;
+        std::map<std::string, uint64_t> down_until_ms;
+        std::set<service_pool_t *> pending;
+        bool force_refresh_all;
+        clock_t clock;
+        // Frames of the request or reply in flight, reused across calls.
+        std::vector<msg_t> frames;
+
+        // Asynchronous requests sent through this shard. Ids are handed
+        // out from a random base, so a reply can tell an id of this shard
+        // from a plain reply whose first frame happens to be 8 bytes. Id 0
+        // is skipped; it means no id.
+        std::unordered_map<uint64_t, call_t *> calls;
+        std::vector<call_t *> free_calls;
+        timer_wheel_t timers;
+        uint64_t first_call_id;
+        uint64_t next_call_id;
+        std::vector<completion_t> completed;
+        std::deque<reply_t> replies;
+        // Scratch space for resending a call and for the hedge delay.
+        std::vector<msg_t> resend_parts;
+        std::vector<uint32_t> latency_scratch;
+        // Set once the completion thread has been woken for this shard,
+        // cleared when it looks at the shard again.
+        bool async_woken;
+
+        ZLINK_NON_COPYABLE_NOR_MOVABLE (shard_t)
     };
 
     service_pool_t *get_or_create_pool (const std::string &service_name_);
-    service_pool_t *get_or_create_pool_cached (const char *service_name_);
-    int init_router_socket ();
-    int ensure_router_socket ();
-    void refresh_pool (service_pool_t *pool_,
+    service_pool_t *get_or_create_pool_cached (shard_t *shard_,
+                                               const char *service_name_);
+    shard_t *caller_shard ();
+    int init_router_socket (shard_t *shard_);
+    void refresh_pool (shard_t *shard_,
+                       service_pool_t *pool_,
                        const std::vector<provider_info_t> &providers_,
                        uint64_t seq_);
-    bool select_provider (service_pool_t *pool_, size_t *index_out_);
-    bool find_provider_index (service_pool_t *pool_,
-                              const zlink_routing_id_t *rid_,
-                              size_t *index_out_);
-    int send_request_frames (service_pool_t *pool_,
+    int send_to_pool (shard_t *shard_,
+                      service_pool_t *pool_,
+                      zlink_msg_t *parts_,
+                      size_t part_count_,
+                      int flags_,
+                      uint64_t call_id_ = 0,
+                      size_t *provider_index_ = NULL,
+                      const uint64_t *key_hash_ = NULL);
+    bool select_other_provider (shard_t *shard_,
+                                shard_pool_t *pool_,
+                                const zlink_routing_id_t &exclude_,
+                                size_t *index_out_);
+    void mark_down (shard_t *shard_,
+                    service_pool_t *pool_,
+                    const std::string &endpoint_);
+    bool select_provider (shard_pool_t *pool_, size_t *index_out_);
+    bool select_keyed (shard_t *shard_,
+                       shard_pool_t *pool_,
+                       uint64_t key_hash_,
+                       size_t *index_out_);
+    size_t select_weighted (shard_pool_t *pool_);
+    size_t select_least_outstanding (shard_pool_t *pool_);
+    size_t select_p2c_ewma (shard_pool_t *pool_);
+    static void on_request_sent (shard_pool_t *pool_,
+                                 size_t provider_index_,
+                                 uint64_t call_id_);
+    void on_reply (shard_t *shard_,
+                   service_pool_t *pool_,
+                   const zlink_routing_id_t &rid_);
+    static void record_ewma (provider_stats_t *stats_, uint64_t sent_us_);
+    static void drop_call (shard_pool_t *pool_,
+                           const zlink_routing_id_t &rid_);
+    static void settle_call (call_t *call_,
+                             const zlink_routing_id_t *replied_);
+    static bool find_provider_index (shard_pool_t *pool_,
+                                     const zlink_routing_id_t *rid_,
+                                     size_t *index_out_);
+    int send_request_frames (shard_t *shard_,
+                             shard_pool_t *pool_,
                              size_t provider_index_,
                              zlink_msg_t *parts_,
                              size_t part_count_,
-                             int flags_);
+                             int flags_,
+                             uint64_t call_id_ = 0);
+    static void close_envelopes (shard_pool_t *pool_);
+    int recv_from (shard_t *shard_,
+                   zlink_msg_t **parts_,
+                   size_t *part_count_,
+                   int flags_,
+                   char *service_name_out_);
+    int read_reply (shard_t *shard_,
+                    int flags_,
+                    service_pool_t **pool_out_,
+                    zlink_routing_id_t *rid_out_,
+                    size_t *frame_count_);
+    int take_frames (shard_t *shard_,
+                     size_t first_,
+                     size_t count_,
+                     zlink_msg_t **parts_out_);
+    bool complete_call (shard_t *shard_,
+                        service_pool_t *pool_,
+                        const zlink_routing_id_t &rid_,
+                        size_t frame_count_);
+    static void finish_call (call_t *call_,
+                             int status_,
+                             zlink_msg_t *parts_,
+                             size_t part_count_);
+    static void call_expired (timer_wheel_t::timer_t *timer_);
+    static void hedge_due (timer_wheel_t::timer_t *timer_);
+    bool resend_call (call_t *call_,
+                      const zlink_routing_id_t &exclude_,
+                      zlink_routing_id_t *sent_to_);
+    void retry_calls (shard_t *shard_,
+                      service_pool_t *pool_,
+                      const zlink_routing_id_t &rid_);
+    static void record_latency (shard_t *shard_,
+                                shard_pool_t *pool_,
+                                uint64_t sample_us_);
+    void wake_async (shard_t *shard_);
+    int start_async ();
+    bool drain_replies (shard_t *shard_);
+    static void async_run (void *arg_);
+    void async_loop ();
+    void cancel_calls ();
 
-    void process_monitor_events ();
+    void process_monitor_events (shard_t *shard_);
     static void refresh_run (void *arg_);
     void refresh_loop ();
 
@@ -96,23 +339,30 @@ class gateway_t : public discovery_observer_t
     discovery_t *_discovery;
     uint32_t _tag;
 
+    // Lock order: a shard lock may be held while taking _sync, never the
+    // other way round.
+    std::vector<shard_t *> _shards;
+    atomic_counter_t _recv_shard;
+    // ZLINK_RCVTIMEO as last set, bounding a blocking recv across shards.
+    int _rcvtimeo;
+
     std::map<std::string, service_pool_t> _pools;
-    std::string _last_service_name;
-    service_pool_t *_last_pool;
-    std::map<std::string, std::string> _endpoint_to_service;
-    std::map<std::string, std::string> _routing_id_to_service;
-    std::set<std::string> _ready_endpoints;
-    std::set<std::string> _down_endpoints;
-    std::map<std::string, uint64_t> _down_until_ms;
-    bool _force_refresh_all;
     std::set<std::string> _pending_updates;
-    void *_monitor_socket;
-    socket_base_t *_router_socket;
-    bool _use_lock;
     atomic_counter_t _stop;
     thread_t _refresh_worker;
     mutex_t _sync;
-    clock_t _clock;
+
+    // Completion thread of the asynchronous requests, started by the
+    // first one. It reads the replies of shards with calls pending,
+    // expires their deadlines and runs the callbacks.
+    thread_t _async_worker;
+    std::atomic<bool> _async_started;
+    signaler_t _async_signaler;
+    // Raised when the completion thread keeps a plain reply for recv.
+    signaler_t _recv_signaler;
+    // ZLINK_REQUEST_TIMEOUT as last set, the deadline of a request sent
+    // with timeout 0.
+    std::atomic<int> _request_timeout;
 
     std::string _tls_ca;
     std::string _tls_hostname;
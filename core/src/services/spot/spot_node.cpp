@@ -6,10 +6,12 @@
 #include "services/spot/spot_pub.hpp"
 #include "services/spot/spot_sub.hpp"
 
+#include "protocol/wire.hpp"
 #include "services/discovery/discovery_protocol.hpp"
 #include "sockets/socket_base.hpp"
 #include "utils/clock.hpp"
 #include "utils/err.hpp"
+#include "utils/generic_mtrie_impl.hpp"
 #include "utils/random.hpp"
 
 #include <algorithm>
@@ -26,6 +28,22 @@ namespace zlink
 static const uint32_t spot_node_tag_value = 0x1e6700d9;
 static const uint32_t default_heartbeat_ms = 5000;
 static const uint64_t discovery_refresh_ms = 500;
+//  Received messages dispatched before the subs they went to are flushed.
+static const int received_flush_batch = 64;
+
+//  Exact subscriptions match on a key prefix instead of the topic name: a
+//  zero byte, which no topic starts with, then a 64-bit hash of the name.
+//  Both ends derive the key from the name, so PUB/SUB needs no handshake
+//  to agree on it. The key frame carries the name after the prefix, so a
+//  receiver can tell a topic whose key merely collides with the one it
+//  resolved. Pattern subscriptions still match on the name.
+static const size_t topic_key_prefix_size = 9;
+
+static void encode_topic_key (uint64_t key_, unsigned char *frame_)
+{
+    frame_[0] = 0;
+    put_uint64 (frame_ + 1, key_);
+}
 
 static void sleep_ms (int ms_)
 {
@@ -90,16 +108,6 @@ static bool copy_parts_from_vec (const std::vector<msg_t> &src_,
     return true;
 }
 
-static void release_shared_message (spot_shared_message_t *shared_)
-{
-    if (!shared_)
-        return;
-    if (shared_->refs.sub (1))
-        return;
-    close_parts (&shared_->parts);
-    delete shared_;
-}
-
 static void close_msgv (std::vector<zlink_msg_t> *parts_)
 {
     if (!parts_)
@@ -185,10 +193,18 @@ spot_node_t::spot_node_t (ctx_t *ctx_) :
     _last_heartbeat_ms (0),
     _discovery (NULL),
     _next_discovery_refresh_ms (0),
+    _dispatch_seq (0),
+    _index_version (0),
+    _index (new (std::nothrow) spot_index_t ()),
+    _index_epoch (0),
     _tls_trust_system (0),
     _stop (0)
 {
     zlink_assert (_ctx);
+    alloc_assert (_index.load ());
+    _index.load ()->version = 0;
+    _index_readers[0] = 0;
+    _index_readers[1] = 0;
 
     _routing_id.size = 0;
     _node_id = zlink::generate_random ();
@@ -202,6 +218,7 @@ spot_node_t::spot_node_t (ctx_t *ctx_) :
 
 spot_node_t::~spot_node_t ()
 {
+    delete _index.load ();
     _tag = 0xdeadbeef;
 }
 
@@ -298,6 +315,185 @@ void spot_node_t::remove_filter (const std::string &filter_)
     --it->second;
 }
 
+uint64_t spot_node_t::topic_key (const char *topic_, size_t size_)
+{
+    //  FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size_; ++i) {
+        hash ^= static_cast<unsigned char> (topic_[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string spot_node_t::topic_filter (uint64_t key_)
+{
+    unsigned char frame[topic_key_prefix_size];
+    encode_topic_key (key_, frame);
+    return std::string (reinterpret_cast<const char *> (frame),
+                        sizeof frame);
+}
+
+spot_node_t::topic_entry_t *spot_node_t::find_topic (uint64_t key_)
+{
+    unsigned char key[8];
+    put_uint64 (key, key_);
+    const uint32_t *id = _topic_keys.find (key, sizeof key);
+    return id ? &_topics[*id] : NULL;
+}
+
+spot_node_t::topic_entry_t *spot_node_t::find_topic (const char *topic_,
+                                                     size_t size_)
+{
+    topic_entry_t *entry = find_topic (topic_key (topic_, size_));
+    if (!entry || entry->name->size () != size_
+        || memcmp (entry->name->data (), topic_, size_) != 0)
+        return NULL;
+    return entry;
+}
+
+//  Returns NULL if another topic already has the same key.
+spot_node_t::topic_entry_t *
+spot_node_t::intern_topic (const std::string &topic_)
+{
+    const uint64_t key = topic_key (topic_.data (), topic_.size ());
+    topic_entry_t *entry = find_topic (key);
+    if (entry)
+        return *entry->name == topic_ ? entry : NULL;
+
+    uint32_t id;
+    if (!_free_topic_ids.empty ()) {
+        id = _free_topic_ids.back ();
+        _free_topic_ids.pop_back ();
+    } else {
+        id = static_cast<uint32_t> (_topics.size ());
+        _topics.push_back (topic_entry_t ());
+    }
+    entry = &_topics[id];
+    entry->name = std::make_shared<const std::string> (topic_);
+    entry->key = key;
+    unsigned char key_data[8];
+    put_uint64 (key_data, key);
+    _topic_keys.insert (blob_t (key_data, sizeof key_data), id);
+    _index_version.add (1);
+    return entry;
+}
+
+void spot_node_t::remove_topic_sub (topic_entry_t *entry_, spot_sub_t *sub_)
+{
+    entry_->subs.erase (
+      std::remove (entry_->subs.begin (), entry_->subs.end (), sub_),
+      entry_->subs.end ());
+    if (!entry_->subs.empty ())
+        return;
+    unsigned char key[8];
+    put_uint64 (key, entry_->key);
+    _topic_keys.erase (key, sizeof key);
+    _free_topic_ids.push_back (static_cast<uint32_t> (entry_ - &_topics[0]));
+    entry_->name.reset ();
+    _index_version.add (1);
+}
+
+void spot_node_t::remove_pattern_subs (spot_sub_t *sub_)
+{
+    for (std::set<std::string>::const_iterator it = sub_->_patterns.begin ();
+         it != sub_->_patterns.end (); ++it) {
+        _pattern_trie.rm (
+          reinterpret_cast<const unsigned char *> (it->data ()), it->size (),
+          sub_);
+        remove_filter (*it);
+    }
+    if (!sub_->_patterns.empty ())
+        _index_version.add (1);
+    sub_->_patterns.clear ();
+}
+
+//  Republishes the index if the subscriptions changed since it was built.
+//  Runs on the worker thread, so subscribe bursts cost one rebuild.
+void spot_node_t::refresh_index ()
+{
+    if (_index.load ()->version == _index_version.get ())
+        return;
+
+    spot_index_t *index = new (std::nothrow) spot_index_t ();
+    alloc_assert (index);
+    {
+        scoped_lock_t lock (_sync);
+        index->version = _index_version.get ();
+        for (size_t i = 0; i < _topics.size (); ++i)
+            if (_topics[i].name)
+                index->topic_keys.push_back (_topics[i].key);
+        for (std::set<spot_sub_t *>::const_iterator it = _subs.begin ();
+             it != _subs.end (); ++it) {
+            const std::set<std::string> &patterns = (*it)->_patterns;
+            for (std::set<std::string>::const_iterator p = patterns.begin ();
+                 p != patterns.end (); ++p)
+                index->patterns.add (
+                  reinterpret_cast<const unsigned char *> (p->data ()),
+                  p->size (), *it);
+        }
+    }
+    std::sort (index->topic_keys.begin (), index->topic_keys.end ());
+
+    //  Flip twice: a reader that read the epoch just before a flip may
+    //  count itself in the old slot after the wait and still load the new
+    //  index, so the old one is only safe once both slots drained.
+    spot_index_t *old = _index.exchange (index);
+    for (int flip = 0; flip < 2; ++flip) {
+        const uint32_t slot = _index_epoch.fetch_add (1) & 1;
+        while (_index_readers[slot].load () != 0)
+            sleep_ms (0);
+    }
+    delete old;
+}
+
+//  False only if no local sub can match the topic. Lock free while the
+//  published index is current; otherwise asks the live tables under _sync.
+bool spot_node_t::may_match_locally (const char *topic_, size_t size_)
+{
+    const unsigned char *data = reinterpret_cast<const unsigned char *> (topic_);
+    bool found = false;
+    bool current = false;
+    {
+        const uint32_t slot = _index_epoch.load () & 1;
+        _index_readers[slot].fetch_add (1);
+        const spot_index_t *index = _index.load ();
+        if (index->version == _index_version.get ()) {
+            current = true;
+            found = std::binary_search (index->topic_keys.begin (),
+                                        index->topic_keys.end (),
+                                        topic_key (topic_, size_));
+            if (!found)
+                const_cast<spot_index_t *> (index)->patterns.match (
+                  data, size_, find_pattern_sub, &found);
+        }
+        _index_readers[slot].fetch_sub (1, std::memory_order_release);
+    }
+    if (current)
+        return found;
+
+    scoped_lock_t lock (_sync);
+    if (find_topic (topic_, size_))
+        return true;
+    _pattern_trie.match (data, size_, find_pattern_sub, &found);
+    return found;
+}
+
+//  Match callback of dispatch_local: a sub may match through several of
+//  its patterns, or already be an exact subscriber, but is picked once.
+void spot_node_t::collect_pattern_sub (spot_sub_t *sub_, spot_node_t *self_)
+{
+    if (sub_->_dispatch_mark == self_->_dispatch_seq)
+        return;
+    sub_->_dispatch_mark = self_->_dispatch_seq;
+    self_->_dispatch_targets.push_back (sub_);
+}
+
+void spot_node_t::find_pattern_sub (spot_sub_t *, bool *found_)
+{
+    *found_ = true;
+}
+
 int spot_node_t::bind (const char *endpoint_)
 {
     if (!endpoint_) {
@@ -805,30 +1001,21 @@ void spot_node_t::remove_spot_sub (spot_sub_t *sub_)
 
     for (std::set<std::string>::const_iterator it = sub_->_topics.begin ();
          it != sub_->_topics.end (); ++it) {
-        std::map<std::string, std::set<spot_sub_t *> >::iterator idx =
-          _topic_index.find (*it);
-        if (idx != _topic_index.end ()) {
-            idx->second.erase (sub_);
-            if (idx->second.empty ())
-                _topic_index.erase (idx);
+        topic_entry_t *entry = find_topic (it->data (), it->size ());
+        if (entry) {
+            const uint64_t key = entry->key;
+            remove_topic_sub (entry, sub_);
+            remove_filter (topic_filter (key));
         }
-        remove_filter (*it);
     }
 
-    for (std::set<std::string>::const_iterator it =
-           sub_->_patterns.begin ();
-         it != sub_->_patterns.end (); ++it) {
-        remove_filter (*it);
-    }
-    _pattern_subs.erase (sub_);
+    remove_pattern_subs (sub_);
 
     sub_->_topics.clear ();
-    sub_->_patterns.clear ();
-    while (!sub_->_queue.empty ()) {
-        spot_sub_t::queue_entry_t &entry = sub_->_queue.front ();
-        release_shared_message (entry.shared);
-        sub_->_queue.pop_front ();
-    }
+    _unflushed_subs.erase (
+      std::remove (_unflushed_subs.begin (), _unflushed_subs.end (), sub_),
+      _unflushed_subs.end ());
+    sub_->drain_messages ();
 }
 
 int spot_node_t::subscribe (spot_sub_t *sub_, const char *topic_)
@@ -844,11 +1031,17 @@ int spot_node_t::subscribe (spot_sub_t *sub_, const char *topic_)
     }
 
     scoped_lock_t lock (_sync);
-    if (!sub_->_topics.insert (topic).second)
+    if (sub_->_topics.count (topic))
         return 0;
-    _topic_index[topic].insert (sub_);
+    topic_entry_t *entry = intern_topic (topic);
+    if (!entry) {
+        errno = EINVAL;
+        return -1;
+    }
+    sub_->_topics.insert (topic);
+    entry->subs.push_back (sub_);
 
-    add_filter (topic);
+    add_filter (topic_filter (entry->key));
     return 0;
 }
 
@@ -867,7 +1060,9 @@ int spot_node_t::subscribe_pattern (spot_sub_t *sub_, const char *pattern_)
     scoped_lock_t lock (_sync);
     if (!sub_->_patterns.insert (prefix).second)
         return 0;
-    _pattern_subs.insert (sub_);
+    _pattern_trie.add (reinterpret_cast<const unsigned char *> (prefix.data ()),
+                       prefix.size (), sub_);
+    _index_version.add (1);
     add_filter (prefix);
     return 0;
 }
@@ -886,8 +1081,10 @@ int spot_node_t::unsubscribe (spot_sub_t *sub_, const char *topic_or_pattern_)
             errno = EINVAL;
             return -1;
         }
-        if (sub_->_patterns.empty ())
-            _pattern_subs.erase (sub_);
+        _pattern_trie.rm (
+          reinterpret_cast<const unsigned char *> (prefix.data ()),
+          prefix.size (), sub_);
+        _index_version.add (1);
         remove_filter (prefix);
         return 0;
     }
@@ -903,14 +1100,12 @@ int spot_node_t::unsubscribe (spot_sub_t *sub_, const char *topic_or_pattern_)
         errno = EINVAL;
         return -1;
     }
-    std::map<std::string, std::set<spot_sub_t *> >::iterator idx =
-      _topic_index.find (topic);
-    if (idx != _topic_index.end ()) {
-        idx->second.erase (sub_);
-        if (idx->second.empty ())
-            _topic_index.erase (idx);
+    topic_entry_t *entry = find_topic (topic.data (), topic.size ());
+    if (entry) {
+        const uint64_t key = entry->key;
+        remove_topic_sub (entry, sub_);
+        remove_filter (topic_filter (key));
     }
-    remove_filter (topic);
     return 0;
 }
 
@@ -919,8 +1114,7 @@ int spot_node_t::publish (const char *topic_,
                           size_t part_count_,
                           int flags_)
 {
-    std::string topic;
-    if (!validate_topic (topic_, &topic)) {
+    if (!validate_topic (topic_, NULL)) {
         errno = EINVAL;
         return -1;
     }
@@ -932,125 +1126,151 @@ int spot_node_t::publish (const char *topic_,
         errno = ENOTSUP;
         return -1;
     }
+    const size_t topic_size = strlen (topic_);
 
     std::vector<msg_t> payload;
-    bool needs_local_dispatch = false;
-    {
-        scoped_lock_t lock (_sync);
-        std::map<std::string, std::set<spot_sub_t *> >::const_iterator exact =
-          _topic_index.find (topic);
-        if (exact != _topic_index.end () && !exact->second.empty ())
-            needs_local_dispatch = true;
-        if (!needs_local_dispatch) {
-            for (std::set<spot_sub_t *>::const_iterator it =
-                   _pattern_subs.begin ();
-                 it != _pattern_subs.end (); ++it) {
-                if ((*it)->matches (topic)) {
-                    needs_local_dispatch = true;
-                    break;
-                }
-            }
-        }
-    }
-
-    if (needs_local_dispatch) {
+    if (may_match_locally (topic_, topic_size)) {
         if (!copy_parts_from_msgv (parts_, part_count_, &payload))
             return -1;
 
         scoped_lock_t lock (_sync);
-        dispatch_local (topic, payload);
+        dispatch_local (topic_, topic_size, find_topic (topic_, topic_size),
+                        true, true, payload);
+        flush_deliveries ();
     }
+    close_parts (&payload);
 
+    //  Peers with exact subscriptions take the key form, peers with
+    //  pattern subscriptions the named one; the PUB socket drops the form
+    //  nobody subscribed to. The topic frames are built before taking
+    //  _pub_sync so that concurrent publishers only serialize on the sends.
+    msg_t key_frame;
+    msg_t name_frame;
+    if (key_frame.init_size (topic_key_prefix_size + topic_size) != 0)
+        return -1;
+    unsigned char *key_data = static_cast<unsigned char *> (key_frame.data ());
+    encode_topic_key (topic_key (topic_, topic_size), key_data);
+    memcpy (key_data + topic_key_prefix_size, topic_, topic_size);
+    if (name_frame.init_size (topic_size) != 0) {
+        key_frame.close ();
+        return -1;
+    }
+    memcpy (name_frame.data (), topic_, topic_size);
+
+    int rc = 0;
     {
         scoped_lock_t pub_lock (_pub_sync);
-        if (!_pub) {
-            close_parts (&payload);
-            for (size_t i = 0; i < part_count_; ++i)
-                zlink_msg_close (&parts_[i]);
-            return 0;
-        }
-
-        msg_t topic_frame;
-        if (topic_frame.init_size (topic.size ()) != 0) {
-            close_parts (&payload);
-            return -1;
-        }
-        if (!topic.empty ())
-            memcpy (topic_frame.data (), topic.data (), topic.size ());
-
-        int flags = part_count_ > 0 ? ZLINK_SNDMORE : 0;
-        if (_pub->send (&topic_frame, flags) != 0) {
-            topic_frame.close ();
-            close_parts (&payload);
-            return -1;
-        }
-        topic_frame.close ();
-
-        for (size_t i = 0; i < part_count_; ++i) {
-            msg_t &part = *reinterpret_cast<msg_t *> (&parts_[i]);
-            flags = (i + 1 < part_count_) ? ZLINK_SNDMORE : 0;
-            if (_pub->send (&part, flags) != 0) {
-                close_parts (&payload);
-                return -1;
-            }
-        }
+        if (_pub
+            && (send_topic_message (&key_frame, parts_, part_count_, true) != 0
+                || send_topic_message (&name_frame, parts_, part_count_, false)
+                     != 0))
+            rc = -1;
     }
+    key_frame.close ();
+    name_frame.close ();
+    if (rc != 0)
+        return -1;
 
-    close_parts (&payload);
     for (size_t i = 0; i < part_count_; ++i)
         zlink_msg_close (&parts_[i]);
 
     return 0;
 }
 
-void spot_node_t::dispatch_local (const std::string &topic_,
-                                  const std::vector<msg_t> &payload_)
+//  Sends the topic frame, then copies of the parts or the parts themselves.
+//  The topic frame is left empty once sent; the caller closes it.
+int spot_node_t::send_topic_message (msg_t *topic_frame_,
+                                     zlink_msg_t *parts_,
+                                     size_t part_count_,
+                                     bool copy_parts_)
 {
-    std::vector<spot_sub_t *> handler_targets;
-    std::set<spot_sub_t *> matched;
-    spot_shared_message_t *shared = NULL;
-
-    std::map<std::string, std::set<spot_sub_t *> >::iterator exact =
-      _topic_index.find (topic_);
-    if (exact != _topic_index.end ())
-        matched.insert (exact->second.begin (), exact->second.end ());
+    if (_pub->send (topic_frame_, ZLINK_SNDMORE) != 0)
+        return -1;
 
-    for (std::set<spot_sub_t *>::iterator it = _pattern_subs.begin ();
-         it != _pattern_subs.end (); ++it) {
-        spot_sub_t *sub = *it;
-        if (matched.count (sub))
-            continue;
-        if (!sub->matches (topic_))
+    for (size_t i = 0; i < part_count_; ++i) {
+        msg_t &part = *reinterpret_cast<msg_t *> (&parts_[i]);
+        const int flags = (i + 1 < part_count_) ? ZLINK_SNDMORE : 0;
+        if (!copy_parts_) {
+            if (_pub->send (&part, flags) != 0)
+                return -1;
             continue;
-        matched.insert (sub);
+        }
+        msg_t copy;
+        if (copy.init () != 0 || copy.copy (part) != 0)
+            return -1;
+        if (_pub->send (&copy, flags) != 0) {
+            copy.close ();
+            return -1;
+        }
     }
+    return 0;
+}
 
-    for (std::set<spot_sub_t *>::iterator it = matched.begin ();
-         it != matched.end (); ++it) {
-        spot_sub_t *sub = *it;
+//  Delivers the message to the exact subscribers of entry_ if exact_ is
+//  set, and to the pattern subscribers matching the topic if patterns_ is
+//  set. A pattern subscriber that also has the exact subscription gets the
+//  message through that one only.
+void spot_node_t::dispatch_local (const char *topic_,
+                                  size_t size_,
+                                  const topic_entry_t *entry_,
+                                  bool exact_,
+                                  bool patterns_,
+                                  const std::vector<msg_t> &payload_)
+{
+    std::vector<spot_sub_t *> &matched = _dispatch_targets;
+    matched.clear ();
+    ++_dispatch_seq;
+    if (entry_) {
+        //  Exact subscribers are marked even when only patterns are
+        //  dispatched, so that they are skipped by the pattern match.
+        for (size_t i = 0; i < entry_->subs.size (); ++i)
+            entry_->subs[i]->_dispatch_mark = _dispatch_seq;
+        if (exact_)
+            matched.insert (matched.end (), entry_->subs.begin (),
+                            entry_->subs.end ());
+    }
+    if (patterns_)
+        _pattern_trie.match (reinterpret_cast<const unsigned char *> (topic_),
+                             size_, collect_pattern_sub, this);
+    if (matched.empty ())
+        return;
+
+    const spot_topic_ptr topic =
+      entry_ ? entry_->name
+             : std::make_shared<const std::string> (topic_, size_);
+    std::vector<spot_sub_t *> &handler_targets = _handler_targets;
+    handler_targets.clear ();
+    spot_shared_message_t *shared = NULL;
+    for (size_t i = 0; i < matched.size (); ++i) {
+        spot_sub_t *sub = matched[i];
         if (sub->callback_enabled ())
             handler_targets.push_back (sub);
         else {
             if (!shared) {
-                shared = new (std::nothrow) spot_shared_message_t ();
+                shared = spot_shared_message_t::create (topic, payload_);
                 if (!shared)
                     break;
-                shared->topic = topic_;
-                if (!copy_parts_from_vec (payload_, &shared->parts)) {
-                    delete shared;
-                    shared = NULL;
-                    break;
-                }
             }
-            sub->enqueue_shared_message (shared);
+            if (sub->enqueue_shared_message (shared))
+                _unflushed_subs.push_back (sub);
         }
     }
-    release_shared_message (shared);
-    enqueue_handler_delivery (topic_, payload_, handler_targets);
+    if (shared)
+        shared->release ();
+    enqueue_handler_delivery (topic, payload_, handler_targets);
+}
+
+//  Makes what dispatch_local queued visible to recv, waking the subs that
+//  wait for it. Callers dispatching several messages in a row flush once.
+void spot_node_t::flush_deliveries ()
+{
+    for (size_t i = 0; i < _unflushed_subs.size (); ++i)
+        _unflushed_subs[i]->flush_messages ();
+    _unflushed_subs.clear ();
 }
 
 void spot_node_t::enqueue_handler_delivery (
-  const std::string &topic_,
+  const spot_topic_ptr &topic_,
   const std::vector<msg_t> &payload_,
   const std::vector<spot_sub_t *> &targets_)
 {
@@ -1082,7 +1302,7 @@ bool spot_node_t::pop_handler_delivery (handler_delivery_t *out_)
 }
 
 void spot_node_t::invoke_pending_callbacks (
-  const std::string &topic_,
+  const spot_topic_ptr &topic_,
   const std::vector<msg_t> &payload_,
   const std::vector<spot_sub_t *> &targets_)
 {
@@ -1133,7 +1353,7 @@ void spot_node_t::invoke_pending_callbacks (
     const zlink_msg_t *parts = msgv.empty () ? NULL : &msgv[0];
     for (size_t i = 0; i < callbacks.size (); ++i) {
         pending_callback_t cb = callbacks[i];
-        cb.handler (topic_.data (), topic_.size (), parts, msgv.size (),
+        cb.handler (topic_->data (), topic_->size (), parts, msgv.size (),
                     cb.userdata);
 
         scoped_lock_t lock (_sync);
@@ -1302,28 +1522,23 @@ void spot_node_t::process_sub ()
     if (!_sub)
         return;
 
+    std::vector<msg_t> &payload = _recv_payload;
+    int unflushed = 0;
     while (true) {
         msg_t topic_frame;
         if (topic_frame.init () != 0)
-            return;
+            break;
         if (_sub->recv (&topic_frame, ZLINK_DONTWAIT) != 0) {
             topic_frame.close ();
-            return;
-        }
-
-        const bool more = (topic_frame.flags () & msg_t::more) != 0;
-        std::string topic;
-        if (topic_frame.size () > 0) {
-            const char *data = static_cast<const char *> (topic_frame.data ());
-            topic.assign (data, data + topic_frame.size ());
+            break;
         }
-        topic_frame.close ();
 
-        if (!more)
+        bool has_more = (topic_frame.flags () & msg_t::more) != 0;
+        if (!has_more) {
+            topic_frame.close ();
             continue;
+        }
 
-        std::vector<msg_t> payload;
-        bool has_more = more;
         while (has_more) {
             msg_t part;
             if (part.init () != 0) {
@@ -1341,12 +1556,48 @@ void spot_node_t::process_sub ()
             payload.back ().move (part);
         }
 
-        if (!topic.empty ()) {
+        //  The key form reaches exact subscribers, the named form pattern
+        //  subscribers; see publish.
+        const unsigned char *data =
+          static_cast<const unsigned char *> (topic_frame.data ());
+        const size_t size = topic_frame.size ();
+        if (size >= topic_key_prefix_size && data[0] == 0) {
+            const char *topic =
+              reinterpret_cast<const char *> (data + topic_key_prefix_size);
+            const size_t topic_size = size - topic_key_prefix_size;
             scoped_lock_t lock (_sync);
-            dispatch_local (topic, payload);
+            const topic_entry_t *entry = find_topic (get_uint64 (data + 1));
+            if (entry
+                && (entry->name->size () != topic_size
+                    || memcmp (entry->name->data (), topic, topic_size) != 0))
+                //  Another topic with the same key: look it up by name,
+                //  which finds no entry rather than the colliding one.
+                entry = find_topic (topic, topic_size);
+            if (entry)
+                dispatch_local (entry->name->data (), entry->name->size (),
+                                entry, true, false, payload);
+            if (++unflushed == received_flush_batch) {
+                flush_deliveries ();
+                unflushed = 0;
+            }
+        } else if (size > 0) {
+            const char *topic = reinterpret_cast<const char *> (data);
+            scoped_lock_t lock (_sync);
+            dispatch_local (topic, size, find_topic (topic, size), false, true,
+                            payload);
+            if (++unflushed == received_flush_batch) {
+                flush_deliveries ();
+                unflushed = 0;
+            }
         }
+        topic_frame.close ();
         close_parts (&payload);
     }
+
+    if (unflushed > 0) {
+        scoped_lock_t lock (_sync);
+        flush_deliveries ();
+    }
 }
 
 void spot_node_t::refresh_peers ()
@@ -1361,8 +1612,8 @@ void spot_node_t::refresh_peers ()
     if (!disc || !_sub)
         return;
 
-    std::vector<provider_info_t> providers;
-    disc->snapshot_providers (service, &providers);
+    const provider_snapshot_ptr snapshot = disc->providers (service);
+    const std::vector<provider_info_t> &providers = snapshot->providers;
 
     std::set<std::string> next;
     for (size_t i = 0; i < providers.size (); ++i) {
@@ -1436,6 +1687,7 @@ void spot_node_t::loop ()
 
         ensure_worker_sockets ();
         flush_pending ();
+        refresh_index ();
 
         process_sub ();
         while (process_handler_delivery ())
@@ -1491,9 +1743,18 @@ int spot_node_t::destroy ()
         for (std::set<spot_pub_t *>::iterator it = _pubs.begin ();
              it != _pubs.end (); ++it)
             (*it)->_node = NULL;
+        flush_deliveries ();
         for (std::set<spot_sub_t *>::iterator it = _subs.begin ();
-             it != _subs.end (); ++it)
-            (*it)->_node = NULL;
+             it != _subs.end (); ++it) {
+            spot_sub_t *sub_handle = *it;
+            for (std::set<std::string>::const_iterator p =
+                   sub_handle->_patterns.begin ();
+                 p != sub_handle->_patterns.end (); ++p)
+                _pattern_trie.rm (
+                  reinterpret_cast<const unsigned char *> (p->data ()),
+                  p->size (), sub_handle);
+            sub_handle->_node = NULL;
+        }
         _pubs.clear ();
         _subs.clear ();
         for (std::deque<handler_delivery_t>::iterator it =
@@ -1503,8 +1764,9 @@ int spot_node_t::destroy ()
         }
         _pending_handler_delivery.clear ();
         _filter_refcount.clear ();
-        _topic_index.clear ();
-        _pattern_subs.clear ();
+        _topics.clear ();
+        _free_topic_ids.clear ();
+        _topic_keys.clear ();
         _peer_endpoints.clear ();
         _registry_endpoints.clear ();
         _bind_endpoints.clear ();
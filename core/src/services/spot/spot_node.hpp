@@ -7,10 +7,14 @@
 #include "core/msg.hpp"
 #include "core/thread.hpp"
 #include "services/discovery/discovery.hpp"
+#include "services/spot/spot_sub.hpp"
 #include "utils/atomic_counter.hpp"
+#include "utils/blob_map.hpp"
+#include "utils/generic_mtrie.hpp"
 #include "utils/mutex.hpp"
 
 #include <deque>
+#include <atomic>
 #include <map>
 #include <set>
 #include <string>
@@ -19,7 +23,6 @@
 namespace zlink
 {
 class spot_pub_t;
-class spot_sub_t;
 
 class spot_node_t
 {
@@ -70,18 +73,32 @@ class spot_node_t
     friend class spot_sub_t;
     struct handler_delivery_t;
 
+    //  A topic with exact subscribers on this node. Its id indexes
+    //  _topics and is reused once the topic loses its last subscriber.
+    struct topic_entry_t
+    {
+        spot_topic_ptr name;
+        uint64_t key;
+        std::vector<spot_sub_t *> subs;
+    };
+
     static void run (void *arg_);
     void loop ();
     void process_sub ();
     bool process_handler_delivery ();
-    void dispatch_local (const std::string &topic_,
+    void dispatch_local (const char *topic_,
+                         size_t size_,
+                         const topic_entry_t *entry_,
+                         bool exact_,
+                         bool patterns_,
                          const std::vector<msg_t> &payload_);
-    void enqueue_handler_delivery (const std::string &topic_,
+    void flush_deliveries ();
+    void enqueue_handler_delivery (const spot_topic_ptr &topic_,
                                    const std::vector<msg_t> &payload_,
                                    const std::vector<spot_sub_t *> &targets_);
     bool pop_handler_delivery (handler_delivery_t *out_);
     void invoke_pending_callbacks (
-      const std::string &topic_,
+      const spot_topic_ptr &topic_,
       const std::vector<msg_t> &payload_,
       const std::vector<spot_sub_t *> &targets_);
     void refresh_peers ();
@@ -97,6 +114,22 @@ class spot_node_t
     void add_filter (const std::string &filter_);
     void remove_filter (const std::string &filter_);
 
+    static uint64_t topic_key (const char *topic_, size_t size_);
+    static std::string topic_filter (uint64_t key_);
+    topic_entry_t *find_topic (uint64_t key_);
+    topic_entry_t *find_topic (const char *topic_, size_t size_);
+    topic_entry_t *intern_topic (const std::string &topic_);
+    void remove_topic_sub (topic_entry_t *entry_, spot_sub_t *sub_);
+    void remove_pattern_subs (spot_sub_t *sub_);
+    void refresh_index ();
+    bool may_match_locally (const char *topic_, size_t size_);
+    static void collect_pattern_sub (spot_sub_t *sub_, spot_node_t *self_);
+    static void find_pattern_sub (spot_sub_t *sub_, bool *found_);
+    int send_topic_message (msg_t *topic_frame_,
+                            zlink_msg_t *parts_,
+                            size_t part_count_,
+                            bool copy_parts_);
+
     ctx_t *_ctx;
     uint32_t _tag;
 
@@ -133,11 +166,46 @@ class spot_node_t
     std::set<spot_pub_t *> _pubs;
     std::set<spot_sub_t *> _subs;
     std::map<std::string, size_t> _filter_refcount;
-    std::map<std::string, std::set<spot_sub_t *> > _topic_index;
-    std::set<spot_sub_t *> _pattern_subs;
+    std::vector<topic_entry_t> _topics;
+    std::vector<uint32_t> _free_topic_ids;
+    blob_map_t<uint32_t> _topic_keys;
+    //  Pattern prefixes, each holding the subs that subscribed to it.
+    generic_mtrie_t<spot_sub_t> _pattern_trie;
+    //  Bumped per dispatch; a sub whose _dispatch_mark equals it has been
+    //  picked already.
+    uint64_t _dispatch_seq;
+
+    //  What the subscriptions looked like at some version: the keys of the
+    //  interned topics, sorted, and the pattern prefixes. Publishers read it
+    //  without _sync to skip local dispatch for topics no local sub can
+    //  match; the patterns trie is only matched against, never modified.
+    struct spot_index_t
+    {
+        uint32_t version;
+        std::vector<uint64_t> topic_keys;
+        generic_mtrie_t<spot_sub_t> patterns;
+    };
+    //  Bumped under _sync whenever a topic or pattern comes or goes; the
+    //  worker republishes _index when the two differ, and until then
+    //  publishers take the locked path.
+    atomic_counter_t _index_version;
+    //  Replaced by the worker only. A reader counts itself in the reader
+    //  slot of the current epoch while it uses the index; the worker frees
+    //  a replaced index once both slots drained after flipping the epoch.
+    std::atomic<spot_index_t *> _index;
+    std::atomic<uint32_t> _index_epoch;
+    std::atomic<uint32_t> _index_readers[2];
+
+    //  Reused by dispatch_local so that it does not allocate per message.
+    std::vector<spot_sub_t *> _dispatch_targets;
+    std::vector<spot_sub_t *> _handler_targets;
+    //  Subs with messages queued since the last flush_deliveries.
+    std::vector<spot_sub_t *> _unflushed_subs;
+    //  Parts of the message process_sub is receiving; worker thread only.
+    std::vector<msg_t> _recv_payload;
     struct handler_delivery_t
     {
-        std::string topic;
+        spot_topic_ptr topic;
         std::vector<msg_t> payload;
         std::vector<spot_sub_t *> targets;
     };
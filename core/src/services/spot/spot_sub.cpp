@@ -5,6 +5,7 @@
 #include "services/spot/spot_sub.hpp"
 #include "services/spot/spot_node.hpp"
 
+#include "utils/allocator.hpp"
 #include "utils/err.hpp"
 
 #include <string.h>
@@ -14,56 +15,62 @@ namespace zlink
 static const uint32_t spot_sub_tag_value = 0x1e6700da;
 static const size_t spot_queue_hwm_default = 100000;
 
-static void close_parts_local (std::vector<msg_t> *parts_)
+//  The parts follow the header in the same block.
+static const size_t shared_parts_offset =
+  (sizeof (spot_shared_message_t) + alignof (msg_t) - 1)
+  & ~(alignof (msg_t) - 1);
+
+spot_shared_message_t::spot_shared_message_t (const spot_topic_ptr &topic_,
+                                              size_t part_count_) :
+    topic (topic_), part_count (part_count_), refs (1)
 {
-    if (!parts_)
-        return;
-    for (size_t i = 0; i < parts_->size (); ++i)
-        (*parts_)[i].close ();
-    parts_->clear ();
 }
 
-static bool copy_parts_from_vec (const std::vector<msg_t> &src_,
-                                 std::vector<msg_t> *out_)
+spot_shared_message_t *
+spot_shared_message_t::create (const spot_topic_ptr &topic_,
+                               const std::vector<msg_t> &parts_)
 {
-    out_->clear ();
-    if (src_.empty ())
-        return true;
-    out_->resize (src_.size ());
-    for (size_t i = 0; i < src_.size (); ++i) {
-        msg_t &dst = (*out_)[i];
-        if (dst.init () != 0) {
-            close_parts_local (out_);
-            return false;
-        }
-        msg_t &src = const_cast<msg_t &> (src_[i]);
-        if (dst.copy (src) != 0) {
-            close_parts_local (out_);
-            return false;
+    void *block =
+      alloc_tl (shared_parts_offset + parts_.size () * sizeof (msg_t));
+    if (!block)
+        return NULL;
+    spot_shared_message_t *shared =
+      new (block) spot_shared_message_t (topic_, parts_.size ());
+    msg_t *parts = shared->parts ();
+    for (size_t i = 0; i < parts_.size (); ++i) {
+        msg_t &src = const_cast<msg_t &> (parts_[i]);
+        if (parts[i].init () != 0 || parts[i].copy (src) != 0) {
+            shared->part_count = i;
+            shared->release ();
+            return NULL;
         }
     }
-    return true;
+    return shared;
 }
 
-static void retain_shared_message (spot_shared_message_t *shared_)
+void spot_shared_message_t::release ()
 {
-    if (shared_)
-        shared_->refs.add (1);
+    if (refs.sub (1))
+        return;
+    msg_t *msgs = parts ();
+    for (size_t i = 0; i < part_count; ++i)
+        msgs[i].close ();
+    this->~spot_shared_message_t ();
+    dealloc_tl (this);
 }
 
-static void release_shared_message (spot_shared_message_t *shared_)
+msg_t *spot_shared_message_t::parts ()
 {
-    if (!shared_)
-        return;
-    if (shared_->refs.sub (1))
-        return;
-    close_parts_local (&shared_->parts);
-    delete shared_;
+    return reinterpret_cast<msg_t *> (reinterpret_cast<unsigned char *> (this)
+                                      + shared_parts_offset);
 }
 
 spot_sub_t::spot_sub_t (spot_node_t *node_) :
     _node (node_),
     _tag (spot_sub_tag_value),
+    _dispatch_mark (0),
+    _unflushed (false),
+    _queued (0),
     _queue_hwm (spot_queue_hwm_default),
     _handler (NULL),
     _handler_userdata (NULL),
@@ -74,11 +81,7 @@ spot_sub_t::spot_sub_t (spot_node_t *node_) :
 
 spot_sub_t::~spot_sub_t ()
 {
-    while (!_queue.empty ()) {
-        queue_entry_t &entry = _queue.front ();
-        release_shared_message (entry.shared);
-        _queue.pop_front ();
-    }
+    drain_messages ();
     _tag = 0xdeadbeef;
 }
 
@@ -155,66 +158,57 @@ int spot_sub_t::set_handler (zlink_spot_sub_handler_fn handler_,
     return 0;
 }
 
-bool spot_sub_t::matches (const std::string &topic_) const
-{
-    if (_topics.count (topic_))
-        return true;
-
-    for (std::set<std::string>::const_iterator it = _patterns.begin ();
-         it != _patterns.end (); ++it) {
-        const std::string &prefix = *it;
-        if (topic_.compare (0, prefix.size (), prefix) == 0)
-            return true;
-    }
-    return false;
-}
-
-bool spot_sub_t::enqueue_message (const std::string &topic_,
-                                  const std::vector<msg_t> &payload_)
+//  Called by the node under its _sync. The message is not visible to recv
+//  until flush_messages; returns true if this sub now needs a flush.
+bool spot_sub_t::enqueue_shared_message (spot_shared_message_t *shared_)
 {
-    spot_shared_message_t *shared =
-      new (std::nothrow) spot_shared_message_t ();
-    if (!shared) {
-        errno = ENOMEM;
+    if (!shared_)
         return false;
-    }
-    shared->topic = topic_;
-    if (!copy_parts_from_vec (payload_, &shared->parts)) {
-        delete shared;
+    if (_queued.get () >= _queue_hwm)
         return false;
-    }
-    const bool ok = enqueue_shared_message (shared);
-    release_shared_message (shared);
-    return ok;
+    shared_->retain ();
+    _queued.add (1);
+    _pipe.write (shared_, false);
+    if (_unflushed)
+        return false;
+    _unflushed = true;
+    return true;
 }
 
-bool spot_sub_t::enqueue_shared_message (spot_shared_message_t *shared_)
+//  Called by the node under its _sync once per dispatched batch.
+void spot_sub_t::flush_messages ()
 {
-    if (!shared_)
-        return false;
-    if (_queue.size () >= _queue_hwm)
-        return false;
-    _queue.push_back (queue_entry_t ());
-    queue_entry_t &entry = _queue.back ();
-    retain_shared_message (shared_);
-    entry.shared = shared_;
+    _unflushed = false;
+    if (_pipe.flush ())
+        return;
+    //  recv found the pipe empty and is, or is about to be, waiting.
+    scoped_lock_t lock (_recv_sync);
     _cv.broadcast ();
-    return true;
 }
 
+//  Called by the receiving thread under _recv_sync.
 bool spot_sub_t::dequeue_message (spot_shared_message_t **out_)
 {
     if (!out_)
         return false;
-    if (_queue.empty ())
+    if (!_pipe.read (out_))
         return false;
-    queue_entry_t &front = _queue.front ();
-    *out_ = front.shared;
-    front.shared = NULL;
-    _queue.pop_front ();
+    _queued.sub (1);
     return true;
 }
 
+//  Releases whatever is still queued, flushed or not. Called when nothing
+//  writes to the pipe any more.
+void spot_sub_t::drain_messages ()
+{
+    _pipe.flush ();
+    _unflushed = false;
+    scoped_lock_t lock (_recv_sync);
+    spot_shared_message_t *shared = NULL;
+    while (dequeue_message (&shared))
+        shared->release ();
+}
+
 bool spot_sub_t::callback_enabled () const
 {
     return _handler_state == handler_active && _handler != NULL;
@@ -253,16 +247,16 @@ zlink_msg_t *spot_sub_t::alloc_msgv_from_parts (std::vector<msg_t> *parts_,
     return out;
 }
 
-zlink_msg_t *spot_sub_t::alloc_msgv_from_parts_ref (
-  const std::vector<msg_t> &parts_,
-  size_t *count_)
+zlink_msg_t *spot_sub_t::alloc_msgv_from_parts_ref (msg_t *parts_,
+                                                    size_t part_count_,
+                                                    size_t *count_)
 {
     if (count_)
         *count_ = 0;
-    if (parts_.empty ())
+    if (part_count_ == 0)
         return NULL;
 
-    const size_t count = parts_.size ();
+    const size_t count = part_count_;
     zlink_msg_t *out =
       static_cast<zlink_msg_t *> (malloc (count * sizeof (zlink_msg_t)));
     if (!out) {
@@ -279,8 +273,7 @@ zlink_msg_t *spot_sub_t::alloc_msgv_from_parts_ref (
             return NULL;
         }
 
-        msg_t &src = const_cast<msg_t &> (parts_[i]);
-        if (dst->copy (src) != 0) {
+        if (dst->copy (parts_[i]) != 0) {
             zlink_msg_close (&out[i]);
             for (size_t j = 0; j < i; ++j)
                 zlink_msg_close (&out[j]);
@@ -317,13 +310,14 @@ int spot_sub_t::recv (zlink_msg_t **parts_,
         return -1;
     }
 
+    if (_handler_state != handler_none) {
+        errno = EINVAL;
+        return -1;
+    }
+
     spot_shared_message_t *shared = NULL;
     {
-        scoped_lock_t lock (_node->_sync);
-        if (_handler_state != handler_none) {
-            errno = EINVAL;
-            return -1;
-        }
+        scoped_lock_t lock (_recv_sync);
         while (true) {
             if (dequeue_message (&shared))
                 break;
@@ -331,27 +325,28 @@ int spot_sub_t::recv (zlink_msg_t **parts_,
                 errno = EAGAIN;
                 return -1;
             }
-            _cv.wait (&_node->_sync, -1);
+            _cv.wait (&_recv_sync, -1);
         }
     }
 
     if (topic_out_) {
         memset (topic_out_, 0, 256);
-        strncpy (topic_out_, shared->topic.c_str (), 255);
+        strncpy (topic_out_, shared->topic->c_str (), 255);
     }
     if (topic_len_)
-        *topic_len_ = shared->topic.size ();
+        *topic_len_ = shared->topic->size ();
 
     zlink_msg_t *out_parts = NULL;
     size_t out_count = 0;
-    if (!shared->parts.empty ()) {
-        out_parts = alloc_msgv_from_parts_ref (shared->parts, &out_count);
+    if (shared->part_count > 0) {
+        out_parts = alloc_msgv_from_parts_ref (shared->parts (),
+                                               shared->part_count, &out_count);
         if (!out_parts) {
             if (parts_)
                 *parts_ = NULL;
             if (part_count_)
                 *part_count_ = 0;
-            release_shared_message (shared);
+            shared->release ();
             return -1;
         }
     }
@@ -360,7 +355,7 @@ int spot_sub_t::recv (zlink_msg_t **parts_,
         *parts_ = out_parts;
     if (part_count_)
         *part_count_ = out_count;
-    release_shared_message (shared);
+    shared->release ();
 
     return 0;
 }
@@ -4,11 +4,15 @@
 #define __ZLINK_SPOT_SUB_HPP_INCLUDED__
 
 #include "core/msg.hpp"
+#include "core/ypipe.hpp"
 #include "utils/atomic_counter.hpp"
 #include "utils/condition_variable.hpp"
+#include "utils/config.hpp"
 #include "utils/macros.hpp"
+#include "utils/mutex.hpp"
 
-#include <deque>
+#include <atomic>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -18,13 +22,35 @@ namespace zlink
 class spot_node_t;
 class socket_base_t;
 
+//  Topic names are shared between the node's topic table and the messages
+//  delivered for a topic, so delivering a message does not copy its name.
+typedef std::shared_ptr<const std::string> spot_topic_ptr;
+
+//  A message queued to one or more subs. The header and the parts share
+//  one block of the message allocator, taken and given back through its
+//  per-thread cache, so with the pool allocator a delivery does not reach
+//  malloc. The last release closes the parts and frees the block.
 struct spot_shared_message_t
 {
-    std::string topic;
-    std::vector<msg_t> parts;
+    //  Returns a message holding copies of parts_ and one reference, or
+    //  NULL if out of memory.
+    static spot_shared_message_t *create (const spot_topic_ptr &topic_,
+                                          const std::vector<msg_t> &parts_);
+
+    void retain () { refs.add (1); }
+    void release ();
+
+    msg_t *parts ();
+
+    spot_topic_ptr topic;
+    size_t part_count;
     atomic_counter_t refs;
 
-    spot_shared_message_t () : refs (1) {}
+  private:
+    spot_shared_message_t (const spot_topic_ptr &topic_, size_t part_count_);
+    ~spot_shared_message_t () {}
+
+    ZLINK_NON_COPYABLE_NOR_MOVABLE (spot_shared_message_t)
 };
 
 class spot_sub_t
@@ -56,11 +82,6 @@ class spot_sub_t
 
   private:
     friend class spot_node_t;
-    struct queue_entry_t
-    {
-        spot_shared_message_t *shared;
-        queue_entry_t () : shared (NULL) {}
-    };
 
     enum handler_state_t
     {
@@ -69,16 +90,16 @@ class spot_sub_t
         handler_clearing
     };
 
-    bool matches (const std::string &topic_) const;
-    bool enqueue_message (const std::string &topic_,
-                          const std::vector<msg_t> &payload_);
     bool enqueue_shared_message (spot_shared_message_t *shared_);
+    void flush_messages ();
     bool dequeue_message (spot_shared_message_t **out_);
+    void drain_messages ();
     bool callback_enabled () const;
 
     zlink_msg_t *alloc_msgv_from_parts (std::vector<msg_t> *parts_,
                                         size_t *count_);
-    zlink_msg_t *alloc_msgv_from_parts_ref (const std::vector<msg_t> &parts_,
+    zlink_msg_t *alloc_msgv_from_parts_ref (msg_t *parts_,
+                                            size_t part_count_,
                                             size_t *count_);
     void close_parts (std::vector<msg_t> *parts_);
 
@@ -86,14 +107,27 @@ class spot_sub_t
     uint32_t _tag;
     std::set<std::string> _topics;
     std::set<std::string> _patterns;
-
-    std::deque<queue_entry_t> _queue;
+    //  Dispatch in which the node last picked this sub; guarded by the
+    //  node's _sync.
+    uint64_t _dispatch_mark;
+
+    //  Messages for recv. Only the node writes, holding its _sync, and
+    //  only recv reads, holding _recv_sync, so the pipe needs no lock of
+    //  its own. Written messages become visible on flush_messages, which
+    //  wakes recv only if it went to sleep on an empty pipe.
+    ypipe_t<spot_shared_message_t *, spot_pipe_granularity> _pipe;
+    //  Whether the pipe has writes not yet flushed; guarded by the node's
+    //  _sync.
+    bool _unflushed;
+    atomic_counter_t _queued;
     size_t _queue_hwm;
+    mutex_t _recv_sync;
     condition_variable_t _cv;
 
     zlink_spot_sub_handler_fn _handler;
     void *_handler_userdata;
-    handler_state_t _handler_state;
+    //  Written under the node's _sync; recv reads it without.
+    std::atomic<handler_state_t> _handler_state;
     atomic_counter_t _callback_inflight;
     condition_variable_t _callback_cv;
 
@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "utils/precompiled.hpp"
+#include <string.h>
+
+#include "sockets/lvc.hpp"
+#include "utils/err.hpp"
+
+zlink::lvc_t::lvc_t () : _size (0), _max_size (0), _pending_size (0)
+{
+}
+
+zlink::lvc_t::~lvc_t ()
+{
+    set_max_size (0);
+}
+
+void zlink::lvc_t::set_max_size (size_t max_size_)
+{
+    _max_size = max_size_;
+    while (_size > _max_size)
+        erase (_lru.back ());
+    if (!_max_size)
+        rollback ();
+}
+
+void zlink::lvc_t::add (msg_t *msg_)
+{
+    _pending.push_back (*msg_);
+    _pending_size += msg_->size ();
+    const int rc = msg_->init ();
+    errno_assert (rc == 0);
+}
+
+void zlink::lvc_t::commit ()
+{
+    if (_pending.empty ())
+        return;
+
+    unsigned char *topic = static_cast<unsigned char *> (_pending[0].data ());
+    const size_t topic_size = _pending[0].size ();
+    entries_t::iterator it =
+      _entries.find (blob_t (topic, topic_size, reference_tag_t ()));
+
+    //  A value too large to ever fit must still not leave the previous one
+    //  behind.
+    if (_pending_size > _max_size) {
+        if (it != _entries.end ())
+            erase (it);
+        rollback ();
+        return;
+    }
+
+    if (it == _entries.end ()) {
+        it = _entries
+               .ZLINK_MAP_INSERT_OR_EMPLACE (
+                 ZLINK_MOVE (blob_t (topic, topic_size)), entry_t ())
+               .first;
+        _lru.push_front (it);
+        it->second.lru = _lru.begin ();
+        it->second.size = 0;
+    } else {
+        close (it->second.frames);
+        _lru.splice (_lru.begin (), _lru, it->second.lru);
+    }
+
+    it->second.frames.swap (_pending);
+    _size += _pending_size - it->second.size;
+    it->second.size = _pending_size;
+    _pending_size = 0;
+
+    //  The topic just updated is at the front and fits on its own.
+    while (_size > _max_size)
+        erase (_lru.back ());
+}
+
+void zlink::lvc_t::rollback ()
+{
+    close (_pending);
+    _pending_size = 0;
+}
+
+void zlink::lvc_t::match (const unsigned char *prefix_,
+                          size_t size_,
+                          bool (*func_) (const std::vector<msg_t> &frames_,
+                                         void *arg_),
+                          void *arg_)
+{
+    entries_t::iterator it = _entries.lower_bound (
+      blob_t (const_cast<unsigned char *> (prefix_), size_, reference_tag_t ()));
+    for (; it != _entries.end (); ++it) {
+        const blob_t &topic = it->first;
+        if (topic.size () < size_
+            || (size_ && memcmp (topic.data (), prefix_, size_) != 0))
+            break;
+        _lru.splice (_lru.begin (), _lru, it->second.lru);
+        if (!func_ (it->second.frames, arg_))
+            break;
+    }
+}
+
+void zlink::lvc_t::erase (entries_t::iterator it_)
+{
+    close (it_->second.frames);
+    _size -= it_->second.size;
+    _lru.erase (it_->second.lru);
+    _entries.erase (it_);
+}
+
+void zlink::lvc_t::close (std::vector<msg_t> &frames_)
+{
+    for (std::vector<msg_t>::iterator it = frames_.begin (),
+                                      end = frames_.end ();
+         it != end; ++it) {
+        const int rc = it->close ();
+        errno_assert (rc == 0);
+    }
+    frames_.clear ();
+}
@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZLINK_LVC_HPP_INCLUDED__
+#define __ZLINK_LVC_HPP_INCLUDED__
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include "core/msg.hpp"
+#include "utils/blob.hpp"
+#include "utils/macros.hpp"
+
+namespace zlink
+{
+//  Last value cache of a publisher: the most recent message per topic,
+//  where the topic is the full first frame of the message.
+//
+//  Topics are kept in order so that the ones starting with a subscription
+//  prefix are adjacent. Memory is bounded by the sum of the frame sizes;
+//  when an update would exceed it, the least recently used topics are
+//  evicted. Frames are held as message copies, so large frames are shared
+//  with the pipes rather than duplicated.
+class lvc_t
+{
+  public:
+    lvc_t ();
+    ~lvc_t ();
+
+    //  Sets the memory limit in bytes; 0 disables the cache and drops its
+    //  content.
+    void set_max_size (size_t max_size_);
+    size_t max_size () const { return _max_size; }
+
+    bool enabled () const { return _max_size > 0; }
+
+    //  Takes over a frame of the message being published. The message
+    //  becomes the topic's value once commit is called after its last
+    //  frame.
+    void add (msg_t *msg_);
+    void commit ();
+
+    //  Forgets the frames added since the last commit.
+    void rollback ();
+
+    //  Calls func_ with the frames of each cached message whose topic
+    //  starts with prefix_, stopping when it returns false.
+    void match (const unsigned char *prefix_,
+                size_t size_,
+                bool (*func_) (const std::vector<msg_t> &frames_, void *arg_),
+                void *arg_);
+
+    //  Number of topics and bytes held.
+    size_t topics () const { return _entries.size (); }
+    size_t size () const { return _size; }
+
+  private:
+    struct entry_t;
+    typedef std::map<blob_t, entry_t> entries_t;
+    typedef std::list<entries_t::iterator> lru_t;
+
+    struct entry_t
+    {
+        std::vector<msg_t> frames;
+        size_t size;
+        lru_t::iterator lru;
+    };
+
+    void erase (entries_t::iterator it_);
+    static void close (std::vector<msg_t> &frames_);
+
+    entries_t _entries;
+
+    //  Most recently used topic first.
+    lru_t _lru;
+
+    size_t _size;
+    size_t _max_size;
+
+    //  Frames of the message being published.
+    std::vector<msg_t> _pending;
+    size_t _pending_size;
+
+    ZLINK_NON_COPYABLE_NOR_MOVABLE (lvc_t)
+};
+}
+
+#endif
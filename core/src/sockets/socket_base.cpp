@@ -5,6 +5,7 @@
 #include <string>
 #include <algorithm>
 #include <ctime>
+#include <climits>
 
 #include "utils/macros.hpp"
 
@@ -401,6 +402,9 @@ int zlink::socket_base_t::check_protocol (const std::string &protocol_) const
     if (protocol_ != protocol_name::inproc
 #if defined ZLINK_HAVE_IPC
         && protocol_ != protocol_name::ipc
+#endif
+#if defined ZLINK_HAVE_SHM
+        && protocol_ != protocol_name::shm
 #endif
         && protocol_ != protocol_name::tcp
 #ifdef ZLINK_HAVE_WS
@@ -440,6 +444,7 @@ void zlink::socket_base_t::attach_pipe (pipe_t *pipe_,
 {
     //  First, register the pipe so that we can terminate it later on.
     pipe_->set_event_sink (this);
+    pipe_->set_flush_batch (&_flush_batch);
     _pipes.push_back (pipe_);
 
     //  Let the derived socket type know about new pipe.
@@ -655,11 +660,21 @@ int zlink::socket_base_t::bind (const char *endpoint_uri_)
 #endif
 
 #if defined ZLINK_HAVE_IPC
-    if (protocol == protocol_name::ipc) {
+    if (protocol == protocol_name::ipc
+#if defined ZLINK_HAVE_SHM
+        || protocol == protocol_name::shm
+#endif
+    ) {
+        const bool shm =
+#if defined ZLINK_HAVE_SHM
+          protocol == protocol_name::shm;
+#else
+          false;
+#endif
         asio_ipc_listener_t *listener =
           new (std::nothrow) asio_ipc_listener_t (io_thread, this, options);
         alloc_assert (listener);
-        int rc = listener->set_local_address (address.c_str ());
+        int rc = listener->set_local_address (address.c_str (), shm);
         if (rc != 0) {
             LIBZLINK_DELETE (listener);
             event_bind_failed (make_unconnected_bind_endpoint_pair (address),
@@ -928,7 +943,11 @@ int zlink::socket_base_t::connect_internal (const char *endpoint_uri_)
 #endif
 
 #if defined ZLINK_HAVE_IPC
-    else if (protocol == protocol_name::ipc) {
+    else if (protocol == protocol_name::ipc
+#if defined ZLINK_HAVE_SHM
+             || protocol == protocol_name::shm
+#endif
+    ) {
         paddr->resolved.ipc_addr = new (std::nothrow) ipc_address_t ();
         alloc_assert (paddr->resolved.ipc_addr);
         int rc = paddr->resolved.ipc_addr->resolve (address.c_str ());
@@ -1192,6 +1211,122 @@ int zlink::socket_base_t::send (msg_t *msg_, int flags_)
     return 0;
 }
 
+int zlink::socket_base_t::send_batch (msg_t *msgs_, size_t count_, int flags_)
+{
+    //  Check whether the context hasn't been shut down yet.
+    if (unlikely (_ctx_terminated)) {
+        errno = ETERM;
+        return -1;
+    }
+
+    if (unlikely (!msgs_ && count_)) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (count_ > INT_MAX)
+        count_ = INT_MAX;
+
+    //  Process pending commands, if any. This is done once per batch.
+    if (unlikely (process_commands (0, true) != 0)) {
+        return -1;
+    }
+
+    const bool nonblocking = (flags_ & ZLINK_DONTWAIT) || options.sndtimeo == 0;
+    size_t sent = 0;
+    int err = 0;
+
+    //  Messages are written to the pipes with their flushes deferred, so
+    //  each pipe is flushed and its reader activated once per batch.
+    _flush_batch.begin ();
+    while (sent < count_) {
+        msg_t *msg = &msgs_[sent];
+        if (unlikely (!msg->check ())) {
+            err = EFAULT;
+            break;
+        }
+
+        //  With ZLINK_SNDMORE the batch forms one multipart message.
+        const int part_flags =
+          (flags_ & ZLINK_SNDMORE) && sent + 1 < count_ ? ZLINK_SNDMORE : 0;
+        msg->reset_flags (msg_t::more);
+        if (part_flags)
+            msg->set_flags (msg_t::more);
+        msg->reset_metadata ();
+
+        int rc = xsend (msg);
+        if (rc == 0) {
+            ++sent;
+            continue;
+        }
+        //  Same as in send: a dead pipe in the middle of a multi-part
+        //  message drops the message silently in blocking mode.
+        if (rc == -2 && !nonblocking) {
+            rc = msg->close ();
+            errno_assert (rc == 0);
+            rc = msg->init ();
+            errno_assert (rc == 0);
+            ++sent;
+            continue;
+        }
+        if (errno != EAGAIN || nonblocking) {
+            err = errno;
+            break;
+        }
+
+        //  The pipe is full. Publish what has been written so far before
+        //  waiting, then let the regular send path block for this message.
+        _flush_batch.end ();
+        if (send (msg, part_flags) != 0) {
+            err = errno;
+            break;
+        }
+        ++sent;
+        _flush_batch.begin ();
+    }
+    _flush_batch.end ();
+
+    if (sent == 0) {
+        errno = err ? err : EAGAIN;
+        return -1;
+    }
+    return static_cast<int> (sent);
+}
+
+int zlink::socket_base_t::recv_batch (msg_t *msgs_, size_t count_, int flags_)
+{
+    if (unlikely (!msgs_ && count_)) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (count_ == 0)
+        return 0;
+    if (count_ > INT_MAX)
+        count_ = INT_MAX;
+
+    //  The first message obeys the usual blocking and timeout rules.
+    if (recv (&msgs_[0], flags_) != 0)
+        return -1;
+
+    //  Then drain whatever is already queued without blocking.
+    size_t received = 1;
+    while (received < count_) {
+        msg_t *msg = &msgs_[received];
+        if (unlikely (!msg->check ()))
+            break;
+        if (++_ticks == inbound_poll_rate) {
+            if (unlikely (process_commands (0, false) != 0))
+                break;
+            _ticks = 0;
+        }
+        if (xrecv (msg) != 0)
+            break;
+        ++received;
+    }
+
+    extract_flags (&msgs_[received - 1]);
+    return static_cast<int> (received);
+}
+
 int zlink::socket_base_t::recv (msg_t *msg_, int flags_)
 {
 
@@ -1986,15 +2121,10 @@ int zlink::routing_socket_base_t::xsetsockopt (int option_,
 
 void zlink::routing_socket_base_t::xwrite_activated (pipe_t *pipe_)
 {
-    const out_pipes_t::iterator end = _out_pipes.end ();
-    out_pipes_t::iterator it;
-    for (it = _out_pipes.begin (); it != end; ++it)
-        if (it->second.pipe == pipe_)
-            break;
-
-    zlink_assert (it != end);
-    zlink_assert (!it->second.active);
-    it->second.active = true;
+    out_pipe_t *out_pipe = _out_pipes.find (pipe_->get_routing_id ());
+    zlink_assert (out_pipe && out_pipe->pipe == pipe_);
+    zlink_assert (!out_pipe->active);
+    out_pipe->active = true;
 }
 
 std::string zlink::routing_socket_base_t::extract_connect_routing_id ()
@@ -2014,62 +2144,63 @@ void zlink::routing_socket_base_t::add_out_pipe (blob_t routing_id_,
 {
     //  Add the record into output pipes lookup table
     const out_pipe_t outpipe = {pipe_, true};
-    const bool ok =
-      _out_pipes.ZLINK_MAP_INSERT_OR_EMPLACE (ZLINK_MOVE (routing_id_), outpipe)
-        .second;
+    const bool ok = _out_pipes.insert (ZLINK_MOVE (routing_id_), outpipe);
     zlink_assert (ok);
 }
 
 bool zlink::routing_socket_base_t::has_out_pipe (const blob_t &routing_id_) const
 {
-    return 0 != _out_pipes.count (routing_id_);
+    return _out_pipes.find (routing_id_) != NULL;
 }
 
 zlink::routing_socket_base_t::out_pipe_t *
 zlink::routing_socket_base_t::lookup_out_pipe (const blob_t &routing_id_)
 {
-    // TODO we could probably avoid constructor a temporary blob_t to call this function
-    out_pipes_t::iterator it = _out_pipes.find (routing_id_);
-    if (it != _out_pipes.end ()) {
-        //  Prefetch the out_pipe structure into L1 cache for next access
-        //  This improves cache efficiency as the caller will immediately use the result
-#if !defined _MSC_VER
-        __builtin_prefetch (&it->second, 0, 3);
-#endif
-        return &it->second;
-    }
-    return NULL;
+    return lookup_out_pipe (routing_id_.data (), routing_id_.size ());
 }
 
 const zlink::routing_socket_base_t::out_pipe_t *
 zlink::routing_socket_base_t::lookup_out_pipe (const blob_t &routing_id_) const
 {
-    // TODO we could probably avoid constructor a temporary blob_t to call this function
-    const out_pipes_t::const_iterator it = _out_pipes.find (routing_id_);
-    if (it != _out_pipes.end ()) {
-        //  Prefetch the out_pipe structure into L1 cache for next access
+    return _out_pipes.find (routing_id_);
+}
+
+zlink::routing_socket_base_t::out_pipe_t *
+zlink::routing_socket_base_t::lookup_out_pipe (const void *routing_id_,
+                                               size_t size_)
+{
+    out_pipe_t *out_pipe = _out_pipes.find (
+      static_cast<const unsigned char *> (routing_id_), size_);
 #if !defined _MSC_VER
-        __builtin_prefetch (&it->second, 0, 3);
+    //  The caller dereferences the pipe right away.
+    if (out_pipe)
+        __builtin_prefetch (out_pipe->pipe, 0, 3);
 #endif
-        return &it->second;
-    }
-    return NULL;
+    return out_pipe;
+}
+
+const zlink::routing_socket_base_t::out_pipe_t *
+zlink::routing_socket_base_t::lookup_out_pipe (const void *routing_id_,
+                                               size_t size_) const
+{
+    return _out_pipes.find (static_cast<const unsigned char *> (routing_id_),
+                            size_);
 }
 
 void zlink::routing_socket_base_t::erase_out_pipe (const pipe_t *pipe_)
 {
-    const size_t erased = _out_pipes.erase (pipe_->get_routing_id ());
+    const bool erased = _out_pipes.erase (pipe_->get_routing_id ());
     zlink_assert (erased);
 }
 
 zlink::routing_socket_base_t::out_pipe_t
 zlink::routing_socket_base_t::try_erase_out_pipe (const blob_t &routing_id_)
 {
-    const out_pipes_t::iterator it = _out_pipes.find (routing_id_);
     out_pipe_t res = {NULL, false};
-    if (it != _out_pipes.end ()) {
-        res = it->second;
-        _out_pipes.erase (it);
+    const out_pipe_t *const out_pipe = _out_pipes.find (routing_id_);
+    if (out_pipe) {
+        res = *out_pipe;
+        _out_pipes.erase (routing_id_);
     }
     return res;
 }
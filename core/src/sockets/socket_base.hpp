@@ -10,6 +10,7 @@
 #include "core/own.hpp"
 #include "utils/array.hpp"
 #include "utils/blob.hpp"
+#include "utils/blob_map.hpp"
 #include "utils/stdint.hpp"
 #include "core/poller.hpp"
 #include "core/i_poll_events.hpp"
@@ -62,6 +63,11 @@ class socket_base_t : public own_t,
     int recv (zlink::msg_t *msg_, int flags_);
     int close ();
 
+    //  Batched send/recv. Both return the number of messages transferred,
+    //  or -1 if none could be. Pipes are flushed once per batch.
+    int send_batch (zlink::msg_t *msgs_, size_t count_, int flags_);
+    int recv_batch (zlink::msg_t *msgs_, size_t count_, int flags_);
+
     //  These functions are used by the polling mechanism to determine
     //  which events are to be reported from this socket.
     bool has_in ();
@@ -289,6 +295,9 @@ class socket_base_t : public own_t,
     typedef array_t<pipe_t, 3> pipes_t;
     pipes_t _pipes;
 
+    //  Pipes with flushes deferred by the batch currently being sent.
+    pipe_flush_batch_t _flush_batch;
+
     //  Reaper's poller.
     poller_t *_poller;
 
@@ -353,6 +362,9 @@ class routing_socket_base_t : public socket_base_t
     bool has_out_pipe (const blob_t &routing_id_) const;
     out_pipe_t *lookup_out_pipe (const blob_t &routing_id_);
     const out_pipe_t *lookup_out_pipe (const blob_t &routing_id_) const;
+    out_pipe_t *lookup_out_pipe (const void *routing_id_, size_t size_);
+    const out_pipe_t *lookup_out_pipe (const void *routing_id_,
+                                       size_t size_) const;
     void erase_out_pipe (const pipe_t *pipe_);
     out_pipe_t try_erase_out_pipe (const blob_t &routing_id_);
     template <typename Func> bool any_of_out_pipes (Func func_)
@@ -361,7 +373,7 @@ class routing_socket_base_t : public socket_base_t
         for (out_pipes_t::iterator it = _out_pipes.begin (),
                                    end = _out_pipes.end ();
              it != end && !res; ++it) {
-            res |= func_ (*it->second.pipe);
+            res |= func_ (*it->value.pipe);
         }
 
         return res;
@@ -369,7 +381,7 @@ class routing_socket_base_t : public socket_base_t
 
   private:
     //  Outbound pipes indexed by the peer IDs.
-    typedef std::map<blob_t, out_pipe_t> out_pipes_t;
+    typedef blob_map_t<out_pipe_t> out_pipes_t;
     out_pipes_t _out_pipes;
 
     // Next assigned name on a zlink_connect() call used by ROUTER and STREAM socket types
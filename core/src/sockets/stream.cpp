@@ -80,9 +80,8 @@ int zlink::stream_t::xsend (msg_t *msg_)
                 return -1;
             }
 
-            out_pipe_t *out_pipe = lookup_out_pipe (
-              blob_t (static_cast<unsigned char *> (msg_->data ()),
-                      msg_->size (), reference_tag_t ()));
+            out_pipe_t *out_pipe =
+              lookup_out_pipe (msg_->data (), msg_->size ());
 
             if (out_pipe) {
                 _current_out = out_pipe->pipe;
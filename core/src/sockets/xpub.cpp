@@ -124,6 +124,8 @@ void zlink::xpub_t::xread_activated (pipe_t *pipe_)
                     const bool first_added =
                       _subscriptions.add (data, size, pipe_);
                     notify = first_added || _verbose_subs;
+                    if (_lvc.enabled ())
+                        send_snapshot (pipe_, data, size);
                 }
             }
 
@@ -180,7 +182,8 @@ int zlink::xpub_t::xsetsockopt (int option_,
 {
     if (option_ == ZLINK_XPUB_VERBOSE || option_ == ZLINK_XPUB_VERBOSER
         || option_ == ZLINK_XPUB_MANUAL_LAST_VALUE || option_ == ZLINK_XPUB_NODROP
-        || option_ == ZLINK_XPUB_MANUAL || option_ == ZLINK_ONLY_FIRST_SUBSCRIBE) {
+        || option_ == ZLINK_XPUB_MANUAL || option_ == ZLINK_ONLY_FIRST_SUBSCRIBE
+        || option_ == ZLINK_XPUB_LAST_VALUE_CACHE) {
         if (optvallen_ != sizeof (int)
             || *static_cast<const int *> (optval_) < 0) {
             errno = EINVAL;
@@ -201,10 +204,17 @@ int zlink::xpub_t::xsetsockopt (int option_,
             _manual = (*static_cast<const int *> (optval_) != 0);
         else if (option_ == ZLINK_ONLY_FIRST_SUBSCRIBE)
             _only_first_subscribe = (*static_cast<const int *> (optval_) != 0);
+        else if (option_ == ZLINK_XPUB_LAST_VALUE_CACHE)
+            _lvc.set_max_size (*static_cast<const int *> (optval_));
     } else if (option_ == ZLINK_SUBSCRIBE && _manual) {
-        if (_last_pipe != NULL)
+        if (_last_pipe != NULL) {
             _subscriptions.add ((unsigned char *) optval_, optvallen_,
                                 _last_pipe);
+            if (_lvc.enabled ())
+                send_snapshot (_last_pipe,
+                               static_cast<const unsigned char *> (optval_),
+                               optvallen_);
+        }
     } else if (option_ == ZLINK_UNSUBSCRIBE && _manual) {
         if (_last_pipe != NULL)
             _subscriptions.rm ((unsigned char *) optval_, optvallen_,
@@ -237,6 +247,10 @@ int zlink::xpub_t::xgetsockopt (int option_, void *optval_, size_t *optvallen_)
                                    (int) _subscriptions.num_prefixes ());
     }
 
+    if (option_ == ZLINK_XPUB_LAST_VALUE_CACHE)
+        return do_getsockopt<int> (optval_, optvallen_,
+                                   static_cast<int> (_lvc.max_size ()));
+
     // room for future options here
 
     errno = EINVAL;
@@ -273,6 +287,13 @@ void zlink::xpub_t::xpipe_terminated (pipe_t *pipe_)
         _subscriptions.rm (pipe_, send_unsubscription, this, !_verbose_unsubs);
     }
 
+    for (std::deque<std::pair<pipe_t *, blob_t> >::iterator
+           it = _pending_snapshots.begin (),
+           end = _pending_snapshots.end ();
+         it != end; ++it)
+        if (it->first == pipe_)
+            it->first = NULL;
+
     _dist.pipe_terminated (pipe_);
 }
 
@@ -312,6 +333,16 @@ int zlink::xpub_t::xsend (msg_t *msg_)
 
     int rc = -1; //  Assume we fail
     if (_lossy || _dist.check_hwm ()) {
+        //  The copy must be taken before the distributor consumes the
+        //  message.
+        msg_t copy;
+        const bool cache = _lvc.enabled ();
+        if (cache) {
+            int copy_rc = copy.init ();
+            errno_assert (copy_rc == 0);
+            copy_rc = copy.copy (*msg_);
+            errno_assert (copy_rc == 0);
+        }
         if (_dist.send_to_matching (msg_) == 0) {
             //  If we are at the end of multi-part message we can mark
             //  all the pipes as non-matching.
@@ -319,6 +350,16 @@ int zlink::xpub_t::xsend (msg_t *msg_)
                 _dist.unmatch ();
             _more_send = msg_more;
             rc = 0; //  Yay, sent successfully
+            if (cache) {
+                _lvc.add (&copy);
+                if (!msg_more)
+                    _lvc.commit ();
+            }
+            if (!msg_more && !_pending_snapshots.empty ())
+                send_pending_snapshots ();
+        } else if (cache) {
+            const int copy_rc = copy.close ();
+            errno_assert (copy_rc == 0);
         }
     } else
         errno = EAGAIN;
@@ -397,3 +438,62 @@ void zlink::xpub_t::send_unsubscription (zlink::mtrie_t::prefix_t data_,
         }
     }
 }
+
+void zlink::xpub_t::send_snapshot (pipe_t *pipe_,
+                                   const unsigned char *data_,
+                                   size_t size_)
+{
+    //  Inverted matching would make the snapshot everything else.
+    if (options.invert_matching)
+        return;
+
+    //  Cached messages must not be interleaved with the frames of the
+    //  message being sent.
+    if (_more_send) {
+        _pending_snapshots.push_back (std::make_pair (pipe_, blob_t ()));
+        _pending_snapshots.back ().second.set (data_, size_);
+        return;
+    }
+
+    _lvc.match (data_, size_, write_cached, pipe_);
+    pipe_->flush ();
+}
+
+void zlink::xpub_t::send_pending_snapshots ()
+{
+    while (!_pending_snapshots.empty ()) {
+        const std::pair<pipe_t *, blob_t> &snapshot = _pending_snapshots.front ();
+        if (snapshot.first)
+            send_snapshot (snapshot.first, snapshot.second.data (),
+                           snapshot.second.size ());
+        _pending_snapshots.pop_front ();
+    }
+}
+
+bool zlink::xpub_t::write_cached (const std::vector<msg_t> &frames_,
+                                  void *arg_)
+{
+    pipe_t *pipe = static_cast<pipe_t *> (arg_);
+
+    //  Like any other message, the snapshot is cut short at the high
+    //  water mark rather than blocking the publisher.
+    if (!pipe->check_hwm ())
+        return false;
+
+    for (std::vector<msg_t>::const_iterator it = frames_.begin (),
+                                            end = frames_.end ();
+         it != end; ++it) {
+        msg_t copy;
+        int rc = copy.init ();
+        errno_assert (rc == 0);
+        rc = copy.copy (const_cast<msg_t &> (*it));
+        errno_assert (rc == 0);
+        if (!pipe->write (&copy)) {
+            rc = copy.close ();
+            errno_assert (rc == 0);
+            pipe->rollback ();
+            return false;
+        }
+    }
+    return true;
+}
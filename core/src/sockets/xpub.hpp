@@ -9,6 +9,7 @@
 #include "core/session_base.hpp"
 #include "utils/mtrie.hpp"
 #include "sockets/dist.hpp"
+#include "sockets/lvc.hpp"
 
 namespace zlink
 {
@@ -50,6 +51,16 @@ class xpub_t : public socket_base_t
     //  Function to be applied to each matching pipes.
     static void mark_as_matching (zlink::pipe_t *pipe_, xpub_t *self_);
 
+    //  Sends the cached messages matching the subscription to the pipe,
+    //  or defers it while a multi-part message is being sent.
+    void send_snapshot (zlink::pipe_t *pipe_,
+                        const unsigned char *data_,
+                        size_t size_);
+    void send_pending_snapshots ();
+
+    //  Function to be applied to each cached message of a snapshot.
+    static bool write_cached (const std::vector<msg_t> &frames_, void *arg_);
+
     //  List of all subscriptions mapped to corresponding pipes.
     mtrie_t _subscriptions;
 
@@ -103,6 +114,13 @@ class xpub_t : public socket_base_t
     //  Welcome message to send to pipe when attached
     msg_t _welcome_msg;
 
+    //  Last message per topic, replayed to new subscribers. Enabled with
+    //  ZLINK_XPUB_LAST_VALUE_CACHE.
+    lvc_t _lvc;
+
+    //  Snapshots requested while a multi-part message was being sent.
+    std::deque<std::pair<pipe_t *, blob_t> > _pending_snapshots;
+
     //  List of pending (un)subscriptions, ie. those that were already
     //  applied to the trie, but not yet received by the user.
     std::deque<blob_t> _pending_data;
@@ -8,6 +8,7 @@
 #include "engine/asio/asio_zmp_engine.hpp"
 #include "engine/asio/asio_raw_engine.hpp"
 #include "transports/ipc/ipc_transport.hpp"
+#include "transports/shm/shm_transport.hpp"
 #include "core/address.hpp"
 #include "utils/err.hpp"
 #include "core/io_thread.hpp"
@@ -48,6 +49,16 @@ make_ipc_endpoint (const zlink::ipc_address_t &addr_)
     endpoint.resize (addr_.addrlen ());
     return endpoint;
 }
+
+bool is_shm (const zlink::address_t *addr_)
+{
+#if defined ZLINK_HAVE_SHM
+    return addr_->protocol == zlink::protocol_name::shm;
+#else
+    LIBZLINK_UNUSED (addr_);
+    return false;
+#endif
+}
 }
 
 zlink::asio_ipc_connecter_t::asio_ipc_connecter_t (
@@ -72,7 +83,7 @@ zlink::asio_ipc_connecter_t::asio_ipc_connecter_t (
     _current_reconnect_ivl (-1)
 {
     zlink_assert (_addr);
-    zlink_assert (_addr->protocol == protocol_name::ipc);
+    zlink_assert (_addr->protocol == protocol_name::ipc || is_shm (_addr));
     _addr->to_string (_endpoint_str);
 
     IPC_CONNECTER_DBG ("Constructor called, endpoint=%s, this=%p",
@@ -222,6 +233,8 @@ void zlink::asio_ipc_connecter_t::on_connect (
 
     std::string local_address =
       get_socket_name<ipc_address_t> (fd, socket_end_local);
+    if (is_shm (_addr) && local_address.compare (0, 6, "ipc://") == 0)
+        local_address.replace (0, 6, "shm://");
 
     create_engine (fd, local_address);
 }
@@ -286,8 +299,13 @@ void zlink::asio_ipc_connecter_t::create_engine (fd_t fd_,
     const endpoint_uri_pair_t endpoint_pair (local_address_, _endpoint_str,
                                              endpoint_type_connect);
 
-    std::unique_ptr<i_asio_transport> transport (
-      new (std::nothrow) ipc_transport_t ());
+    std::unique_ptr<i_asio_transport> transport;
+#if defined ZLINK_HAVE_SHM
+    if (is_shm (_addr))
+        transport.reset (new (std::nothrow) shm_transport_t ());
+    else
+#endif
+        transport.reset (new (std::nothrow) ipc_transport_t ());
     alloc_assert (transport.get ());
 
     i_engine *engine = NULL;
@@ -8,6 +8,7 @@
 #include "engine/asio/asio_zmp_engine.hpp"
 #include "engine/asio/asio_raw_engine.hpp"
 #include "transports/ipc/ipc_transport.hpp"
+#include "transports/shm/shm_transport.hpp"
 #include "core/address.hpp"
 #include "utils/err.hpp"
 #include "core/io_thread.hpp"
@@ -69,6 +70,14 @@ make_ipc_endpoint (const zlink::ipc_address_t &addr_)
     endpoint.resize (addr_.addrlen ());
     return endpoint;
 }
+
+std::string socket_name (zlink::fd_t fd_, zlink::socket_end_t end_, bool shm_)
+{
+    std::string name = zlink::get_socket_name<zlink::ipc_address_t> (fd_, end_);
+    if (shm_ && name.compare (0, 6, "ipc://") == 0)
+        name.replace (0, 6, "shm://");
+    return name;
+}
 }
 
 zlink::asio_ipc_listener_t::asio_ipc_listener_t (io_thread_t *io_thread_,
@@ -83,6 +92,7 @@ zlink::asio_ipc_listener_t::asio_ipc_listener_t (io_thread_t *io_thread_,
     _accepting (false),
     _terminating (false),
     _linger (0),
+    _shm (false),
     _has_file (false)
 {
     IPC_LISTENER_DBG ("Constructor called, this=%p",
@@ -95,10 +105,12 @@ zlink::asio_ipc_listener_t::~asio_ipc_listener_t ()
                       static_cast<void *> (this));
 }
 
-int zlink::asio_ipc_listener_t::set_local_address (const char *addr_)
+int zlink::asio_ipc_listener_t::set_local_address (const char *addr_,
+                                                    bool shm_)
 {
     IPC_LISTENER_DBG ("set_local_address: addr=%s", addr_);
 
+    _shm = shm_;
     std::string addr (addr_);
 
     if (options.use_fd == -1 && !addr.empty () && addr[0] == '*') {
@@ -122,6 +134,8 @@ int zlink::asio_ipc_listener_t::set_local_address (const char *addr_)
 
     std::string resolved_endpoint;
     address.to_string (resolved_endpoint);
+    if (_shm && resolved_endpoint.compare (0, 6, "ipc://") == 0)
+        resolved_endpoint.replace (0, 6, "shm://");
 
     boost::system::error_code ec;
     if (options.use_fd != -1) {
@@ -172,8 +186,7 @@ int zlink::asio_ipc_listener_t::set_local_address (const char *addr_)
     }
 
     _endpoint =
-      get_socket_name<ipc_address_t> (_acceptor.native_handle (),
-                                      socket_end_local);
+      socket_name (_acceptor.native_handle (), socket_end_local, _shm);
     if (_endpoint.empty ())
         _endpoint = resolved_endpoint;
 
@@ -276,12 +289,16 @@ void zlink::asio_ipc_listener_t::create_engine (fd_t fd_)
     IPC_LISTENER_DBG ("create_engine: fd=%d", fd_);
 
     const endpoint_uri_pair_t endpoint_pair (
-      get_socket_name<ipc_address_t> (fd_, socket_end_local),
-      get_socket_name<ipc_address_t> (fd_, socket_end_remote),
-      endpoint_type_bind);
-
-    std::unique_ptr<i_asio_transport> transport (
-      new (std::nothrow) ipc_transport_t ());
+      socket_name (fd_, socket_end_local, _shm),
+      socket_name (fd_, socket_end_remote, _shm), endpoint_type_bind);
+
+    std::unique_ptr<i_asio_transport> transport;
+#if defined ZLINK_HAVE_SHM
+    if (_shm)
+        transport.reset (new (std::nothrow) shm_transport_t ());
+    else
+#endif
+        transport.reset (new (std::nothrow) ipc_transport_t ());
     alloc_assert (transport.get ());
 
     i_engine *engine = NULL;
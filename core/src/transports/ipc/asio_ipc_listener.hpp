@@ -28,8 +28,9 @@ class asio_ipc_listener_t ZLINK_FINAL : public own_t, public io_object_t
                          const options_t &options_);
     ~asio_ipc_listener_t ();
 
-    //  Set address to listen on.
-    int set_local_address (const char *addr_);
+    //  Set address to listen on. With shm_ set, accepted connections
+    //  carry their data over the shared memory transport.
+    int set_local_address (const char *addr_, bool shm_);
 
     //  Get last bound endpoint.
     int get_local_address (std::string &addr_) const;
@@ -61,6 +62,7 @@ class asio_ipc_listener_t ZLINK_FINAL : public own_t, public io_object_t
     bool _terminating;
     int _linger;
 
+    bool _shm;
     bool _has_file;
     std::string _tmp_socket_dirname;
     std::string _filename;
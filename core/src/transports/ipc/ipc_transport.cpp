@@ -6,6 +6,7 @@
 #include "transports/ipc/ipc_transport.hpp"
 
 #include "utils/err.hpp"
+#include "engine/asio/io_uring_service.hpp"
 #include <atomic>
 #include <algorithm>
 #include <array>
@@ -91,7 +92,7 @@ void ipc_stats_maybe_register ()
 }
 }
 
-ipc_transport_t::ipc_transport_t ()
+ipc_transport_t::ipc_transport_t () : _uring (NULL)
 {
 }
 
@@ -102,6 +103,13 @@ ipc_transport_t::~ipc_transport_t ()
 
 bool ipc_transport_t::open (boost::asio::io_context &io_context, fd_t fd)
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (io_uring_service_t *service = io_uring_service_t::find (io_context)) {
+        _uring = service->open_stream (fd);
+        return true;
+    }
+#endif
+
     try {
         _socket = std::unique_ptr<boost::asio::local::stream_protocol::socket> (
           new boost::asio::local::stream_protocol::socket (io_context));
@@ -134,23 +142,82 @@ bool ipc_transport_t::open (boost::asio::io_context &io_context, fd_t fd)
 
 bool ipc_transport_t::is_open () const
 {
+    if (_uring)
+        return true;
     return _socket && _socket->is_open ();
 }
 
 void ipc_transport_t::close ()
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring) {
+        _uring->close ();
+        _uring = NULL;
+    }
+#endif
+    //  The socket object stays until the transport is destroyed: a composed
+    //  write whose last step already completed still continues on it when
+    //  the engine drains its handlers, and then fails on the closed socket.
     if (_socket) {
         boost::system::error_code ec;
         _socket->close (ec);
-        _socket.reset ();
+        //  Ignore close errors
     }
 }
 
+bool ipc_transport_t::supports_migration () const
+{
+    return _socket && _socket->is_open () && !_uring;
+}
+
+void ipc_transport_t::cancel ()
+{
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring) {
+        _uring->cancel ();
+        return;
+    }
+#endif
+    if (_socket) {
+        boost::system::error_code ec;
+        _socket->cancel (ec);
+    }
+}
+
+bool ipc_transport_t::migrate (boost::asio::io_context &io_context)
+{
+    zlink_assert (_socket && !_uring);
+
+    //  Take the descriptor away from the old io_context without closing
+    //  it, then register it with the new one. If the descriptor cannot be
+    //  released the transport stays where it is.
+    boost::system::error_code ec;
+    const fd_t fd = _socket->release (ec);
+    if (ec)
+        return false;
+    _socket.reset ();
+    if (open (io_context, fd))
+        return true;
+#ifdef ZLINK_HAVE_WINDOWS
+    closesocket (fd);
+#else
+    ::close (fd);
+#endif
+    return false;
+}
+
 void ipc_transport_t::async_read_some (
   unsigned char *buffer,
   std::size_t buffer_size,
   completion_handler_t handler)
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring) {
+        _uring->async_read_some (buffer, buffer_size, handler);
+        return;
+    }
+#endif
+
     if (ipc_stats_on) {
         ipc_stats_maybe_register ();
         ++ipc_async_read_calls;
@@ -180,6 +247,11 @@ void ipc_transport_t::async_read_some (
 
 std::size_t ipc_transport_t::read_some (std::uint8_t *buffer, std::size_t len)
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring)
+        return _uring->read_some (buffer, len);
+#endif
+
     if (len == 0) {
         errno = 0;
         return 0;
@@ -234,6 +306,15 @@ void ipc_transport_t::async_write_some (
   std::size_t buffer_size,
   completion_handler_t handler)
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring) {
+        const boost::asio::const_buffer buffers[1] = {
+          boost::asio::buffer (buffer, buffer_size)};
+        _uring->async_write (buffers, 1, handler);
+        return;
+    }
+#endif
+
     if (ipc_stats_on) {
         ipc_stats_maybe_register ();
         ++ipc_async_write_calls;
@@ -279,6 +360,16 @@ void ipc_transport_t::async_writev (const unsigned char *header,
                                     std::size_t body_size,
                                     completion_handler_t handler)
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring) {
+        const boost::asio::const_buffer buffers[2] = {
+          boost::asio::buffer (header, header_size),
+          boost::asio::buffer (body, body_size)};
+        _uring->async_write (buffers, 2, handler);
+        return;
+    }
+#endif
+
     if (ipc_stats_on) {
         ipc_stats_maybe_register ();
         ++ipc_async_write_calls;
@@ -468,9 +559,56 @@ void ipc_transport_t::async_writev (const unsigned char *header,
 #endif
 }
 
+void ipc_transport_t::async_write_buffers (
+  const boost::asio::const_buffer *buffers,
+  std::size_t count,
+  completion_handler_t handler)
+{
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring) {
+        _uring->async_write (buffers, count, handler);
+        return;
+    }
+#endif
+
+    if (ipc_stats_on) {
+        ipc_stats_maybe_register ();
+        ++ipc_async_write_calls;
+    }
+
+    if (!_socket) {
+        if (handler)
+            handler (boost::asio::error::bad_descriptor, 0);
+        return;
+    }
+
+    //  async_write issues one sendmsg per run of up to 64 buffers and
+    //  keeps going until everything is written.
+    const const_buffer_span_t sequence (buffers, count);
+    if (ipc_stats_on) {
+        const auto stats_handler =
+          [handler](const boost::system::error_code &ec, std::size_t bytes) {
+              if (ec)
+                  ++ipc_async_write_errors;
+              else
+                  ipc_async_write_bytes += bytes;
+              if (handler)
+                  handler (ec, bytes);
+          };
+        boost::asio::async_write (*_socket, sequence, stats_handler);
+    } else {
+        boost::asio::async_write (*_socket, sequence, handler);
+    }
+}
+
 std::size_t ipc_transport_t::write_some (const std::uint8_t *data,
                                          std::size_t len)
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring)
+        return _uring->write_some (data, len);
+#endif
+
     if (len == 0) {
         return 0;
     }
@@ -14,6 +14,8 @@
 
 namespace zlink
 {
+class io_uring_stream_t;
+
 class ipc_transport_t ZLINK_FINAL : public i_asio_transport
 {
   public:
@@ -41,16 +43,28 @@ class ipc_transport_t ZLINK_FINAL : public i_asio_transport
                        std::size_t body_size,
                        completion_handler_t handler) ZLINK_OVERRIDE;
 
+    void async_write_buffers (const boost::asio::const_buffer *buffers,
+                              std::size_t count,
+                              completion_handler_t handler) ZLINK_OVERRIDE;
+
     std::size_t write_some (const std::uint8_t *data,
                             std::size_t len) ZLINK_OVERRIDE;
 
     bool supports_speculative_write () const ZLINK_OVERRIDE;
     bool supports_gather_write () const ZLINK_OVERRIDE { return true; }
+    bool supports_vectored_write () const ZLINK_OVERRIDE { return true; }
+
+    bool supports_migration () const ZLINK_OVERRIDE;
+    void cancel () ZLINK_OVERRIDE;
+    bool migrate (boost::asio::io_context &io_context) ZLINK_OVERRIDE;
 
     const char *name () const ZLINK_OVERRIDE { return "ipc_transport"; }
 
   private:
     std::unique_ptr<boost::asio::local::stream_protocol::socket> _socket;
+
+    //  Replaces _socket when the I/O thread runs io_uring.
+    io_uring_stream_t *_uring;
 };
 
 }  // namespace zlink
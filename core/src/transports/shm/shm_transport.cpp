@@ -0,0 +1,629 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "utils/precompiled.hpp"
+#if defined ZLINK_IOTHREAD_POLLER_USE_ASIO && defined ZLINK_HAVE_SHM
+
+#include "transports/shm/shm_transport.hpp"
+
+#include "utils/err.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace zlink
+{
+//  Control block of one direction. The producer owns 'head' and the
+//  consumer owns 'tail'; each sits on its own cache line together with the
+//  flag the other side reads when deciding whether to ring the doorbell.
+struct shm_ring_t
+{
+    std::atomic<uint64_t> head;
+    std::atomic<uint32_t> reader_sleeping;
+    unsigned char pad0[64 - sizeof (uint64_t) - sizeof (uint32_t)];
+    std::atomic<uint64_t> tail;
+    std::atomic<uint32_t> writer_sleeping;
+    unsigned char pad1[64 - sizeof (uint64_t) - sizeof (uint32_t)];
+};
+
+namespace
+{
+const uint32_t shm_magic = 0x5a4c5348; //  "ZLSH"
+const uint32_t shm_version = 1;
+
+//  Bytes of ring storage per direction. Must be a power of two.
+const uint64_t ring_capacity = 1024 * 1024;
+
+const std::size_t segment_header_size = 64;
+const std::size_t ring_header_size = 128;
+const std::size_t ring_stride = ring_header_size + ring_capacity;
+const std::size_t segment_size = segment_header_size + 2 * ring_stride;
+
+//  Seals the listener requires before it maps a segment: with them the
+//  peer can no longer shrink the segment under the mapping, which would
+//  raise SIGBUS in the listener on the next ring access.
+const int segment_seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+//  First bytes of the segment, and also the message carrying its
+//  descriptor during the handshake.
+struct shm_hello_t
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+};
+
+inline unsigned char *ring_data (shm_ring_t *ring_)
+{
+    return reinterpret_cast<unsigned char *> (ring_) + ring_header_size;
+}
+
+inline shm_ring_t *ring_at (void *segment_, int index_)
+{
+    return reinterpret_cast<shm_ring_t *> (static_cast<unsigned char *> (
+                                             segment_)
+                                           + segment_header_size
+                                           + index_ * ring_stride);
+}
+
+boost::system::error_code errno_code (int errno_)
+{
+    return boost::system::error_code (errno_, boost::system::system_category ());
+}
+}
+
+shm_transport_t::shm_transport_t () :
+    _io_context (NULL),
+    _segment (NULL),
+    _segment_size (0),
+    _rx (NULL),
+    _tx (NULL),
+    _read_buffer (NULL),
+    _read_size (0),
+    _write_buffer (NULL),
+    _write_size (0),
+    _waiting (false),
+    _peer_closed (false)
+{
+}
+
+shm_transport_t::~shm_transport_t ()
+{
+    close ();
+}
+
+bool shm_transport_t::open (boost::asio::io_context &io_context, fd_t fd)
+{
+    try {
+        _socket = std::unique_ptr<boost::asio::local::stream_protocol::socket> (
+          new boost::asio::local::stream_protocol::socket (io_context));
+        _alive = std::make_shared<bool> (true);
+    } catch (const std::bad_alloc &) {
+        return false;
+    }
+    _io_context = &io_context;
+
+    boost::system::error_code ec;
+    _socket->assign (boost::asio::local::stream_protocol (), fd, ec);
+    //  The socket only ever carries doorbells, which are drained and rung
+    //  with synchronous calls that must never block.
+    if (!ec)
+        _socket->non_blocking (true, ec);
+    if (ec) {
+        errno = ec.value ();
+        _socket.reset ();
+        return false;
+    }
+    return true;
+}
+
+bool shm_transport_t::is_open () const
+{
+    return _socket && _socket->is_open ();
+}
+
+void shm_transport_t::close ()
+{
+    if (_alive) {
+        *_alive = false;
+        _alive.reset ();
+    }
+
+    //  Like a closed socket, fail whatever is still waiting.
+    if (_handshake_handler)
+        complete (_handshake_handler, boost::asio::error::operation_aborted, 0);
+    if (_read_handler)
+        complete (_read_handler, boost::asio::error::operation_aborted, 0);
+    if (_write_handler)
+        complete (_write_handler, boost::asio::error::operation_aborted, 0);
+    _waiting = false;
+
+    if (_socket) {
+        boost::system::error_code ec;
+        _socket->close (ec);
+        _socket.reset ();
+    }
+
+    if (_segment) {
+        const int rc = munmap (_segment, _segment_size);
+        errno_assert (rc == 0);
+        _segment = NULL;
+        _rx = NULL;
+        _tx = NULL;
+    }
+}
+
+void shm_transport_t::async_handshake (int handshake_type,
+                                       completion_handler_t handler)
+{
+    if (!_socket) {
+        complete (handler, boost::asio::error::bad_descriptor, 0);
+        return;
+    }
+
+    //  The connecting side owns the segment.
+    if (handshake_type == 0) {
+        if (create_segment ())
+            complete (handler, boost::system::error_code (), 0);
+        else
+            complete (handler, errno_code (errno), 0);
+        return;
+    }
+
+    _handshake_handler = handler;
+    if (attach_segment ()) {
+        complete (_handshake_handler, boost::system::error_code (), 0);
+        return;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        complete (_handshake_handler, errno_code (errno), 0);
+        return;
+    }
+
+    const std::shared_ptr<bool> alive = _alive;
+    _socket->async_wait (
+      boost::asio::socket_base::wait_read,
+      [this, alive] (const boost::system::error_code &ec) {
+          if (!*alive || !_handshake_handler)
+              return;
+          if (ec) {
+              complete (_handshake_handler, ec, 0);
+              return;
+          }
+          //  The descriptor arrives in one message; a readable socket
+          //  without it is a protocol error.
+          if (attach_segment ())
+              complete (_handshake_handler, boost::system::error_code (), 0);
+          else
+              complete (_handshake_handler,
+                        errno_code (errno == EAGAIN ? EPROTO : errno), 0);
+      });
+}
+
+bool shm_transport_t::create_segment ()
+{
+    const int fd = memfd_create ("zlink-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1)
+        return false;
+
+    if (ftruncate (fd, static_cast<off_t> (segment_size)) != 0
+        || fcntl (fd, F_ADD_SEALS, segment_seals) != 0
+        || !map_segment (fd, segment_size, true)) {
+        const int tmp_errno = errno;
+        ::close (fd);
+        errno = tmp_errno;
+        return false;
+    }
+
+    //  Ring 0 carries connecter -> listener traffic.
+    _tx = ring_at (_segment, 0);
+    _rx = ring_at (_segment, 1);
+
+    shm_hello_t hello;
+    hello.magic = shm_magic;
+    hello.version = shm_version;
+    hello.capacity = ring_capacity;
+
+    struct iovec iov;
+    iov.iov_base = &hello;
+    iov.iov_len = sizeof hello;
+
+    union
+    {
+        struct cmsghdr align;
+        unsigned char buf[CMSG_SPACE (sizeof (int))];
+    } control;
+    memset (&control, 0, sizeof control);
+
+    struct msghdr msg;
+    memset (&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof control.buf;
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+    memcpy (CMSG_DATA (cmsg), &fd, sizeof fd);
+
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+    //  The socket is fresh, so this small message cannot block.
+    const ssize_t rc = sendmsg (_socket->native_handle (), &msg, flags);
+    const int tmp_errno = errno;
+    ::close (fd);
+    if (rc != static_cast<ssize_t> (sizeof hello)) {
+        errno = rc < 0 ? tmp_errno : EPROTO;
+        return false;
+    }
+    return true;
+}
+
+bool shm_transport_t::attach_segment ()
+{
+    shm_hello_t hello;
+    struct iovec iov;
+    iov.iov_base = &hello;
+    iov.iov_len = sizeof hello;
+
+    union
+    {
+        struct cmsghdr align;
+        unsigned char buf[CMSG_SPACE (sizeof (int))];
+    } control;
+    memset (&control, 0, sizeof control);
+
+    struct msghdr msg;
+    memset (&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof control.buf;
+
+    int flags = 0;
+#ifdef MSG_CMSG_CLOEXEC
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+    const ssize_t rc = recvmsg (_socket->native_handle (), &msg, flags);
+    if (rc < 0)
+        return false;
+    if (rc == 0) {
+        errno = ECONNRESET;
+        return false;
+    }
+
+    int fd = -1;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg); cmsg;
+         cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS
+            && cmsg->cmsg_len == CMSG_LEN (sizeof (int)))
+            memcpy (&fd, CMSG_DATA (cmsg), sizeof fd);
+    }
+
+    //  Refuse a segment the peer could still resize, then check that its
+    //  size matches the one the header announces before mapping it.
+    const int seals = fd == -1 ? -1 : fcntl (fd, F_GET_SEALS);
+    struct stat st;
+    if (rc != static_cast<ssize_t> (sizeof hello) || fd == -1
+        || (msg.msg_flags & MSG_CTRUNC) || hello.magic != shm_magic
+        || hello.version != shm_version || hello.capacity != ring_capacity
+        || seals == -1 || (seals & segment_seals) != segment_seals
+        || fstat (fd, &st) != 0
+        || st.st_size
+             != static_cast<off_t> (segment_header_size
+                                    + 2 * (ring_header_size + hello.capacity))
+        || !map_segment (fd, segment_size, false)) {
+        if (fd != -1)
+            ::close (fd);
+        errno = EPROTO;
+        return false;
+    }
+    ::close (fd);
+
+    _rx = ring_at (_segment, 0);
+    _tx = ring_at (_segment, 1);
+    return true;
+}
+
+bool shm_transport_t::map_segment (int fd_, std::size_t size_, bool create_)
+{
+    void *segment =
+      mmap (NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (segment == MAP_FAILED)
+        return false;
+
+    shm_hello_t *header = static_cast<shm_hello_t *> (segment);
+    if (create_) {
+        header->magic = shm_magic;
+        header->version = shm_version;
+        header->capacity = ring_capacity;
+        for (int i = 0; i != 2; ++i) {
+            shm_ring_t *ring = new (ring_at (segment, i)) shm_ring_t ();
+            //  The rings are shared with another process.
+            zlink_assert (ring->head.is_lock_free ()
+                          && ring->reader_sleeping.is_lock_free ());
+        }
+    } else if (header->magic != shm_magic || header->version != shm_version
+               || header->capacity != ring_capacity) {
+        munmap (segment, size_);
+        errno = EPROTO;
+        return false;
+    }
+
+    _segment = segment;
+    _segment_size = size_;
+    return true;
+}
+
+std::size_t shm_transport_t::ring_read (unsigned char *buffer_,
+                                        std::size_t len_)
+{
+    const uint64_t tail = _rx->tail.load (std::memory_order_relaxed);
+    const uint64_t used = _rx->head.load (std::memory_order_acquire) - tail;
+    if (used > ring_capacity) {
+        //  The peer corrupted the ring.
+        _peer_closed = true;
+        return 0;
+    }
+
+    const std::size_t n =
+      static_cast<std::size_t> (std::min<uint64_t> (used, len_));
+    if (n == 0)
+        return 0;
+
+    const std::size_t pos = static_cast<std::size_t> (tail & (ring_capacity - 1));
+    const std::size_t first = std::min<std::size_t> (n, ring_capacity - pos);
+    memcpy (buffer_, ring_data (_rx) + pos, first);
+    memcpy (buffer_ + first, ring_data (_rx), n - first);
+    _rx->tail.store (tail + n, std::memory_order_release);
+
+    //  Pairs with the fence in resume_write: either the writer sees the
+    //  new tail or we see its sleeping flag.
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    if (_rx->writer_sleeping.load (std::memory_order_relaxed)
+        && _rx->writer_sleeping.exchange (0))
+        ring_doorbell ();
+    return n;
+}
+
+std::size_t shm_transport_t::ring_write (const unsigned char *data_,
+                                         std::size_t len_)
+{
+    const uint64_t head = _tx->head.load (std::memory_order_relaxed);
+    const uint64_t used = head - _tx->tail.load (std::memory_order_acquire);
+    if (used > ring_capacity) {
+        _peer_closed = true;
+        return 0;
+    }
+
+    const std::size_t n =
+      static_cast<std::size_t> (std::min<uint64_t> (ring_capacity - used, len_));
+    if (n == 0)
+        return 0;
+
+    const std::size_t pos = static_cast<std::size_t> (head & (ring_capacity - 1));
+    const std::size_t first = std::min<std::size_t> (n, ring_capacity - pos);
+    memcpy (ring_data (_tx) + pos, data_, first);
+    memcpy (ring_data (_tx), data_ + first, n - first);
+    _tx->head.store (head + n, std::memory_order_release);
+
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    if (_tx->reader_sleeping.load (std::memory_order_relaxed)
+        && _tx->reader_sleeping.exchange (0))
+        ring_doorbell ();
+    return n;
+}
+
+void shm_transport_t::ring_doorbell ()
+{
+    //  A full socket buffer already holds doorbells the peer has yet to
+    //  drain, and a dead peer shows up on our own wait; errors are moot.
+    const unsigned char bell = 0;
+    boost::system::error_code ec;
+    _socket->write_some (boost::asio::buffer (&bell, 1), ec);
+}
+
+void shm_transport_t::wait_doorbell ()
+{
+    if (_waiting || !_socket)
+        return;
+    _waiting = true;
+
+    const std::shared_ptr<bool> alive = _alive;
+    _socket->async_wait (boost::asio::socket_base::wait_read,
+                         [this, alive] (const boost::system::error_code &ec) {
+                             if (*alive)
+                                 on_doorbell (ec);
+                         });
+}
+
+void shm_transport_t::on_doorbell (const boost::system::error_code &ec_)
+{
+    _waiting = false;
+    if (ec_ == boost::asio::error::operation_aborted)
+        return;
+
+    if (ec_)
+        _peer_closed = true;
+    else {
+        unsigned char bells[64];
+        while (true) {
+            boost::system::error_code ec;
+            const std::size_t n =
+              _socket->read_some (boost::asio::buffer (bells), ec);
+            if (ec == boost::asio::error::would_block
+                || ec == boost::asio::error::try_again)
+                break;
+            if (ec || n == 0) {
+                _peer_closed = true;
+                break;
+            }
+        }
+    }
+
+    resume_read ();
+    resume_write ();
+    if (_read_handler || _write_handler)
+        wait_doorbell ();
+}
+
+void shm_transport_t::resume_read ()
+{
+    if (!_read_handler)
+        return;
+
+    _rx->reader_sleeping.store (1);
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    const std::size_t n = ring_read (_read_buffer, _read_size);
+    if (n == 0 && !_peer_closed)
+        return;
+
+    _rx->reader_sleeping.store (0);
+    complete (_read_handler,
+              n ? boost::system::error_code ()
+                : boost::system::error_code (boost::asio::error::eof),
+              n);
+}
+
+void shm_transport_t::resume_write ()
+{
+    if (!_write_handler)
+        return;
+
+    if (_peer_closed) {
+        complete (_write_handler, boost::asio::error::broken_pipe, 0);
+        return;
+    }
+
+    _tx->writer_sleeping.store (1);
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    const std::size_t n = ring_write (_write_buffer, _write_size);
+    if (n == 0 && !_peer_closed)
+        return;
+
+    _tx->writer_sleeping.store (0);
+    complete (_write_handler,
+              n ? boost::system::error_code ()
+                : boost::system::error_code (boost::asio::error::broken_pipe),
+              n);
+}
+
+void shm_transport_t::complete (completion_handler_t &handler_,
+                                const boost::system::error_code &ec_,
+                                std::size_t bytes_)
+{
+    completion_handler_t handler;
+    handler.swap (handler_);
+    if (!handler || !_io_context)
+        return;
+    //  Handlers never run from within the initiating call.
+    boost::asio::post (*_io_context,
+                       [handler, ec_, bytes_] () { handler (ec_, bytes_); });
+}
+
+void shm_transport_t::async_read_some (unsigned char *buffer,
+                                       std::size_t buffer_size,
+                                       completion_handler_t handler)
+{
+    if (!_rx) {
+        complete (handler, boost::asio::error::bad_descriptor, 0);
+        return;
+    }
+
+    zlink_assert (!_read_handler);
+    _read_buffer = buffer;
+    _read_size = buffer_size;
+    _read_handler = handler;
+
+    const std::size_t n =
+      buffer_size ? ring_read (buffer, buffer_size) : 0;
+    if (n > 0 || buffer_size == 0) {
+        complete (_read_handler, boost::system::error_code (), n);
+        return;
+    }
+
+    resume_read ();
+    if (_read_handler)
+        wait_doorbell ();
+}
+
+std::size_t shm_transport_t::read_some (std::uint8_t *buffer, std::size_t len)
+{
+    if (!_rx) {
+        errno = EBADF;
+        return 0;
+    }
+    if (len == 0) {
+        errno = 0;
+        return 0;
+    }
+
+    const std::size_t n = ring_read (buffer, len);
+    if (n == 0)
+        errno = _peer_closed ? ECONNRESET : EAGAIN;
+    return n;
+}
+
+void shm_transport_t::async_write_some (const unsigned char *buffer,
+                                        std::size_t buffer_size,
+                                        completion_handler_t handler)
+{
+    if (!_tx) {
+        complete (handler, boost::asio::error::bad_descriptor, 0);
+        return;
+    }
+
+    zlink_assert (!_write_handler);
+    _write_buffer = buffer;
+    _write_size = buffer_size;
+    _write_handler = handler;
+
+    const std::size_t n =
+      buffer_size && !_peer_closed ? ring_write (buffer, buffer_size) : 0;
+    if (n > 0 || buffer_size == 0) {
+        complete (_write_handler, boost::system::error_code (), n);
+        return;
+    }
+
+    resume_write ();
+    if (_write_handler)
+        wait_doorbell ();
+}
+
+std::size_t shm_transport_t::write_some (const std::uint8_t *data,
+                                         std::size_t len)
+{
+    if (!_tx) {
+        errno = EBADF;
+        return 0;
+    }
+    if (len == 0) {
+        errno = 0;
+        return 0;
+    }
+    if (_peer_closed) {
+        errno = EPIPE;
+        return 0;
+    }
+
+    const std::size_t n = ring_write (data, len);
+    if (n == 0)
+        errno = _peer_closed ? EPIPE : EAGAIN;
+    return n;
+}
+
+}  // namespace zlink
+
+#endif  // ZLINK_IOTHREAD_POLLER_USE_ASIO && ZLINK_HAVE_SHM
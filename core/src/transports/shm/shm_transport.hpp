@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZLINK_ASIO_SHM_TRANSPORT_HPP_INCLUDED__
+#define __ZLINK_ASIO_SHM_TRANSPORT_HPP_INCLUDED__
+
+#include "engine/asio/i_asio_transport.hpp"
+#include "utils/macros.hpp"
+
+#if defined ZLINK_IOTHREAD_POLLER_USE_ASIO && defined ZLINK_HAVE_SHM
+
+#include <boost/asio.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+
+#include <memory>
+
+namespace zlink
+{
+struct shm_ring_t;
+
+//  Shared memory transport (shm://).
+//
+//  The connection itself is a local stream socket set up by the IPC
+//  connecter/listener. During the transport handshake the connecting side
+//  creates a shared memory segment holding one single-producer/single-
+//  consumer byte ring per direction and passes its descriptor to the
+//  accepting side (SCM_RIGHTS). From then on the ZMP byte stream is copied
+//  into and out of the rings directly and the socket only carries one byte
+//  "doorbells": a side that finds its ring empty (or full) flags itself as
+//  sleeping and waits for the socket to become readable, and the peer rings
+//  the doorbell only when it sees that flag - much like ypipe's flush/check
+//  protocol. The socket also reports the peer going away.
+class shm_transport_t ZLINK_FINAL : public i_asio_transport
+{
+  public:
+    shm_transport_t ();
+    ~shm_transport_t ();
+
+    bool open (boost::asio::io_context &io_context, fd_t fd) ZLINK_OVERRIDE;
+    bool is_open () const ZLINK_OVERRIDE;
+    void close () ZLINK_OVERRIDE;
+
+    void async_read_some (unsigned char *buffer,
+                          std::size_t buffer_size,
+                          completion_handler_t handler) ZLINK_OVERRIDE;
+
+    std::size_t read_some (std::uint8_t *buffer,
+                           std::size_t len) ZLINK_OVERRIDE;
+
+    void async_write_some (const unsigned char *buffer,
+                           std::size_t buffer_size,
+                           completion_handler_t handler) ZLINK_OVERRIDE;
+
+    std::size_t write_some (const std::uint8_t *data,
+                            std::size_t len) ZLINK_OVERRIDE;
+
+    //  Like the other stream transports, writes go through the async path
+    //  by default; a ring write completes without a syscall either way.
+    bool supports_speculative_write () const ZLINK_OVERRIDE { return false; }
+
+    bool requires_handshake () const ZLINK_OVERRIDE { return true; }
+    void async_handshake (int handshake_type,
+                          completion_handler_t handler) ZLINK_OVERRIDE;
+
+    const char *name () const ZLINK_OVERRIDE { return "shm_transport"; }
+
+  private:
+    //  Creates the segment and sends its descriptor to the peer.
+    bool create_segment ();
+
+    //  Receives the peer's segment descriptor and maps it.
+    bool attach_segment ();
+
+    bool map_segment (int fd_, std::size_t size_, bool create_);
+
+    std::size_t ring_read (unsigned char *buffer_, std::size_t len_);
+    std::size_t ring_write (const unsigned char *data_, std::size_t len_);
+
+    void ring_doorbell ();
+    void wait_doorbell ();
+    void on_doorbell (const boost::system::error_code &ec_);
+
+    //  Retries the pending operations after a doorbell.
+    void resume_read ();
+    void resume_write ();
+
+    void complete (completion_handler_t &handler_,
+                   const boost::system::error_code &ec_,
+                   std::size_t bytes_);
+
+    boost::asio::io_context *_io_context;
+    std::unique_ptr<boost::asio::local::stream_protocol::socket> _socket;
+
+    void *_segment;
+    std::size_t _segment_size;
+    shm_ring_t *_rx;
+    shm_ring_t *_tx;
+
+    //  Operation waiting for the ring; at most one of each.
+    unsigned char *_read_buffer;
+    std::size_t _read_size;
+    completion_handler_t _read_handler;
+    const unsigned char *_write_buffer;
+    std::size_t _write_size;
+    completion_handler_t _write_handler;
+    completion_handler_t _handshake_handler;
+
+    bool _waiting;
+    bool _peer_closed;
+
+    //  Cleared on close so that doorbell handlers still queued in the
+    //  io_context do not touch a destroyed transport.
+    std::shared_ptr<bool> _alive;
+
+    ZLINK_NON_COPYABLE_NOR_MOVABLE (shm_transport_t)
+};
+
+}  // namespace zlink
+
+#endif  // ZLINK_IOTHREAD_POLLER_USE_ASIO && ZLINK_HAVE_SHM
+
+#endif  // __ZLINK_ASIO_SHM_TRANSPORT_HPP_INCLUDED__
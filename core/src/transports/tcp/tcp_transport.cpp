@@ -7,6 +7,8 @@
 
 #include "engine/asio/asio_debug.hpp"
 #include "core/address.hpp"
+#include "utils/err.hpp"
+#include "engine/asio/io_uring_service.hpp"
 #include <atomic>
 #include <algorithm>
 #include <array>
@@ -98,7 +100,7 @@ const bool tcp_writev_single_shot_on =
   env_flag_enabled ("ZLINK_ASIO_WRITEV_SINGLE_SHOT");
 }
 
-tcp_transport_t::tcp_transport_t ()
+tcp_transport_t::tcp_transport_t () : _uring (NULL)
 {
 }
 
@@ -109,6 +111,13 @@ tcp_transport_t::~tcp_transport_t ()
 
 bool tcp_transport_t::open (boost::asio::io_context &io_context, fd_t fd)
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (io_uring_service_t *service = io_uring_service_t::find (io_context)) {
+        _uring = service->open_stream (fd);
+        return true;
+    }
+#endif
+
     try {
         _socket = std::unique_ptr<boost::asio::ip::tcp::socket> (
           new boost::asio::ip::tcp::socket (io_context));
@@ -139,23 +148,81 @@ bool tcp_transport_t::open (boost::asio::io_context &io_context, fd_t fd)
 
 bool tcp_transport_t::is_open () const
 {
+    if (_uring)
+        return true;
     return _socket && _socket->is_open ();
 }
 
 void tcp_transport_t::close ()
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring) {
+        _uring->close ();
+        _uring = NULL;
+    }
+#endif
+    //  The socket object stays until the transport is destroyed: a composed
+    //  write whose last step already completed still continues on it when
+    //  the engine drains its handlers, and then fails on the closed socket.
     if (_socket) {
         boost::system::error_code ec;
         _socket->close (ec);
         //  Ignore close errors
-        _socket.reset ();
     }
 }
 
+bool tcp_transport_t::supports_migration () const
+{
+    return _socket && _socket->is_open () && !_uring;
+}
+
+void tcp_transport_t::cancel ()
+{
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring) {
+        _uring->cancel ();
+        return;
+    }
+#endif
+    if (_socket) {
+        boost::system::error_code ec;
+        _socket->cancel (ec);
+    }
+}
+
+bool tcp_transport_t::migrate (boost::asio::io_context &io_context)
+{
+    zlink_assert (_socket && !_uring);
+
+    //  Take the descriptor away from the old io_context without closing
+    //  it, then register it with the new one. If the descriptor cannot be
+    //  released the transport stays where it is.
+    boost::system::error_code ec;
+    const fd_t fd = _socket->release (ec);
+    if (ec)
+        return false;
+    _socket.reset ();
+    if (open (io_context, fd))
+        return true;
+#ifdef ZLINK_HAVE_WINDOWS
+    closesocket (fd);
+#else
+    ::close (fd);
+#endif
+    return false;
+}
+
 void tcp_transport_t::async_read_some (unsigned char *buffer,
                                        std::size_t buffer_size,
                                        completion_handler_t handler)
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring) {
+        _uring->async_read_some (buffer, buffer_size, handler);
+        return;
+    }
+#endif
+
     if (tcp_stats_on) {
         tcp_stats_maybe_register ();
         ++tcp_async_read_calls;
@@ -185,6 +252,11 @@ void tcp_transport_t::async_read_some (unsigned char *buffer,
 
 std::size_t tcp_transport_t::read_some (std::uint8_t *buffer, std::size_t len)
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring)
+        return _uring->read_some (buffer, len);
+#endif
+
     if (len == 0) {
         errno = 0;
         return 0;
@@ -238,6 +310,15 @@ void tcp_transport_t::async_write_some (const unsigned char *buffer,
                                         std::size_t buffer_size,
                                         completion_handler_t handler)
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring) {
+        const boost::asio::const_buffer buffers[1] = {
+          boost::asio::buffer (buffer, buffer_size)};
+        _uring->async_write (buffers, 1, handler);
+        return;
+    }
+#endif
+
     if (tcp_stats_on) {
         tcp_stats_maybe_register ();
         ++tcp_async_write_calls;
@@ -283,6 +364,16 @@ void tcp_transport_t::async_writev (const unsigned char *header,
                                     std::size_t body_size,
                                     completion_handler_t handler)
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring) {
+        const boost::asio::const_buffer buffers[2] = {
+          boost::asio::buffer (header, header_size),
+          boost::asio::buffer (body, body_size)};
+        _uring->async_write (buffers, 2, handler);
+        return;
+    }
+#endif
+
     if (tcp_stats_on) {
         tcp_stats_maybe_register ();
         ++tcp_async_write_calls;
@@ -472,9 +563,56 @@ void tcp_transport_t::async_writev (const unsigned char *header,
 #endif
 }
 
+void tcp_transport_t::async_write_buffers (
+  const boost::asio::const_buffer *buffers,
+  std::size_t count,
+  completion_handler_t handler)
+{
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring) {
+        _uring->async_write (buffers, count, handler);
+        return;
+    }
+#endif
+
+    if (tcp_stats_on) {
+        tcp_stats_maybe_register ();
+        ++tcp_async_write_calls;
+    }
+
+    if (!_socket) {
+        if (handler)
+            handler (boost::asio::error::bad_descriptor, 0);
+        return;
+    }
+
+    //  async_write issues one sendmsg per run of up to 64 buffers and
+    //  keeps going until everything is written.
+    const const_buffer_span_t sequence (buffers, count);
+    if (tcp_stats_on) {
+        const auto stats_handler =
+          [handler](const boost::system::error_code &ec, std::size_t bytes) {
+              if (ec)
+                  ++tcp_async_write_errors;
+              else
+                  tcp_async_write_bytes += bytes;
+              if (handler)
+                  handler (ec, bytes);
+          };
+        boost::asio::async_write (*_socket, sequence, stats_handler);
+    } else {
+        boost::asio::async_write (*_socket, sequence, handler);
+    }
+}
+
 std::size_t tcp_transport_t::write_some (const std::uint8_t *data,
                                          std::size_t len)
 {
+#if defined ZLINK_HAVE_IO_URING
+    if (_uring)
+        return _uring->write_some (data, len);
+#endif
+
     if (len == 0) {
         return 0;
     }
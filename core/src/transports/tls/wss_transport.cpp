@@ -129,12 +129,14 @@ void wss_transport_t::close ()
     if (_wss_stream) {
         boost::system::error_code ec;
 
+        _wss_stream->next_layer ().next_layer ().cancel (ec);
+
         //  Avoid blocking WebSocket/SSL shutdown; just close the TCP layer.
+        //  The stream itself stays until the transport is destroyed, as
+        //  the handlers of cancelled operations still run on it.
         _wss_stream->next_layer ().next_layer ().shutdown (
           boost::asio::ip::tcp::socket::shutdown_both, ec);
         _wss_stream->next_layer ().next_layer ().close (ec);
-
-        _wss_stream.reset ();
     }
 
     _ssl_handshake_complete = false;
@@ -141,6 +141,7 @@ zlink::asio_ws_engine_t::asio_ws_engine_t (
     _peer_routing_id_size (0),
     _subscription_required (false),
     _heartbeat_timeout (0),
+    _poller (NULL),
     _current_timer_id (-1),
     _has_handshake_timer (false),
     _has_ttl_timer (false),
@@ -229,6 +230,7 @@ zlink::asio_ws_engine_t::asio_ws_engine_t (
     _peer_routing_id_size (0),
     _subscription_required (false),
     _heartbeat_timeout (0),
+    _poller (NULL),
     _current_timer_id (-1),
     _has_handshake_timer (false),
     _has_ttl_timer (false),
@@ -325,12 +327,11 @@ void zlink::asio_ws_engine_t::plug (io_thread_t *io_thread_,
     _socket = _session->get_socket ();
 
     //  Get reference to io_context
-    asio_poller_t *poller =
-      static_cast<asio_poller_t *> (io_thread_->get_poller ());
-    _io_context = &poller->get_io_context ();
+    _poller = io_thread_->get_poller ();
+    _io_context = &_poller->get_io_context ();
 
-    //  Create timer
-    _timer.reset (new boost::asio::steady_timer (*_io_context));
+    _timer.callback = timer_expired;
+    _timer.arg = this;
 
     //  Initialize WebSocket transport with the socket
     if (!_transport->open (*_io_context, _fd)) {
@@ -529,6 +530,8 @@ void zlink::asio_ws_engine_t::on_read_complete (
         return;
     }
 
+    _session->add_traffic (poller_t::traffic_bytes_in, bytes_transferred);
+
     if (_handshaking) {
         _inpos = _read_buffer.data ();
         _insize = bytes_transferred;
@@ -668,6 +671,8 @@ void zlink::asio_ws_engine_t::on_write_complete (
         return;
     }
 
+    _session->add_traffic (poller_t::traffic_bytes_out, bytes_transferred);
+
     if (_async_gather)
         finish_gather_output ();
 
@@ -1258,6 +1263,7 @@ void zlink::asio_ws_engine_t::speculative_write ()
 
     //  For WebSocket, frame-based write means we either wrote the entire
     //  frame or got would_block. Update buffer pointers.
+    _session->add_traffic (poller_t::traffic_bytes_out, bytes);
     _outpos += bytes;
     _outsize -= bytes;
 
@@ -1298,6 +1304,7 @@ void zlink::asio_ws_engine_t::speculative_write ()
                 return;
             }
 
+            _session->add_traffic (poller_t::traffic_bytes_out, more_bytes);
             _outpos += more_bytes;
             _outsize -= more_bytes;
 
@@ -1443,6 +1450,9 @@ void zlink::asio_ws_engine_t::terminate ()
         _has_heartbeat_timer = false;
     }
 
+    if (_poller)
+        _poller->cancel_timer (&_timer);
+
     //  Close transport - this will cause pending async ops to fail
     if (_transport) {
         _transport->close ();
@@ -1521,32 +1531,35 @@ void zlink::asio_ws_engine_t::cancel_handshake_timer ()
 
 void zlink::asio_ws_engine_t::add_timer (int timeout_, int id_)
 {
-    if (!_timer)
+    if (!_poller)
         return;
 
+    //  The engine has a single timer; a new one replaces the current one.
+    _poller->cancel_timer (&_timer);
     _current_timer_id = id_;
-
-    _timer->expires_after (std::chrono::milliseconds (timeout_));
-    _timer->async_wait ([this, id_] (const boost::system::error_code &ec) {
-        on_timer (id_, ec);
-    });
+    _timer.id = id_;
+    _poller->add_timer (&_timer, timeout_);
 }
 
 void zlink::asio_ws_engine_t::cancel_timer (int id_)
 {
-    if (!_timer)
+    if (!_poller)
         return;
 
     if (_current_timer_id == id_) {
-        _timer->cancel ();
+        _poller->cancel_timer (&_timer);
         _current_timer_id = -1;
     }
 }
 
-void zlink::asio_ws_engine_t::on_timer (int id_,
-                                       const boost::system::error_code &ec)
+void zlink::asio_ws_engine_t::timer_expired (timer_wheel_t::timer_t *timer_)
 {
-    if (_terminating || ec == boost::asio::error::operation_aborted)
+    static_cast<asio_ws_engine_t *> (timer_->arg)->on_timer (timer_->id);
+}
+
+void zlink::asio_ws_engine_t::on_timer (int id_)
+{
+    if (_terminating)
         return;
 
     WS_ENGINE_DBG ("on_timer: id=%d", id_);
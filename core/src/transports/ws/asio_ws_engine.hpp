@@ -158,7 +158,8 @@ class asio_ws_engine_t ZLINK_FINAL : public i_engine
     void cancel_timer (int id_);
     void set_handshake_timer ();
     void cancel_handshake_timer ();
-    void on_timer (int id_, const boost::system::error_code &ec);
+    void on_timer (int id_);
+    static void timer_expired (timer_wheel_t::timer_t *timer_);
 
     //  WebSocket transport layer
     std::unique_ptr<i_asio_transport> _transport;
@@ -261,8 +262,9 @@ class asio_ws_engine_t ZLINK_FINAL : public i_engine
     std::unique_ptr<boost::asio::ssl::context> _ssl_context;
 #endif
 
-    //  Timer
-    std::unique_ptr<boost::asio::steady_timer> _timer;
+    //  Timer, scheduled on the timer wheel of the I/O thread's poller
+    poller_t *_poller;
+    timer_wheel_t::timer_t _timer;
     int _current_timer_id;
 
     //  Timer IDs
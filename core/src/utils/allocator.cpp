@@ -3,28 +3,325 @@
 #include "utils/precompiled.hpp"
 #include "utils/allocator.hpp"
 #include "utils/macros.hpp"
+#include "utils/atomic_ptr.hpp"
+#include "utils/mutex.hpp"
+#include "utils/err.hpp"
+#include "utils/stdint.hpp"
+#include "utils/likely.hpp"
 
 #include <cstdlib>
+#include <new>
 
 namespace zlink
 {
+namespace
+{
+//  Header placed in front of every block handed out by this module. While
+//  a block sits in a free list the 'next' field links it to its neighbour;
+//  'size_class' is valid for the whole lifetime of the block.
+struct block_header_t
+{
+    block_header_t *next;
+    uint32_t size_class;
+};
+
+//  Keep user data 16-byte aligned, the same as malloc on 64-bit targets.
+const std::size_t header_size = 16;
+
+//  Size classes are powers of two from 64 B to 32 KB, header included.
+//  That covers small message bodies up to the decoder's receive buffers.
+const int size_class_count = 10;
+const std::size_t min_block_size = 64;
+const std::size_t max_block_size = min_block_size << (size_class_count - 1);
+
+//  Marks blocks obtained straight from malloc (too large, or allocated
+//  while the malloc allocator was selected).
+const uint32_t malloc_class = 0xffffffff;
+
+//  Bytes moved between a thread cache and the depot in one transfer.
+const std::size_t batch_bytes = 64 * 1024;
+
+//  Upper bound of memory parked in the depot per size class. Anything
+//  above is handed back to the system allocator.
+const std::size_t depot_max_bytes = 4 * 1024 * 1024;
+
+inline std::size_t class_size (int class_)
+{
+    return min_block_size << class_;
+}
+
+inline std::size_t batch_size (int class_)
+{
+    const std::size_t n = batch_bytes / class_size (class_);
+    return n < 2 ? 2 : (n > 32 ? 32 : n);
+}
+
+inline int size_class_for (std::size_t size_)
+{
+    if (size_ > max_block_size - header_size)
+        return -1;
+    const std::size_t total = size_ + header_size;
+    int c = 0;
+    while (class_size (c) < total)
+        ++c;
+    return c;
+}
+
+inline void *to_user (block_header_t *block_)
+{
+    return reinterpret_cast<unsigned char *> (block_) + header_size;
+}
+
+inline block_header_t *to_block (void *ptr_)
+{
+    return reinterpret_cast<block_header_t *> (static_cast<unsigned char *> (ptr_)
+                                               - header_size);
+}
+
+void *malloc_block (std::size_t size_)
+{
+    if (size_ + header_size < size_)
+        return NULL;
+    block_header_t *block =
+      static_cast<block_header_t *> (std::malloc (size_ + header_size));
+    if (unlikely (!block))
+        return NULL;
+    block->next = NULL;
+    block->size_class = malloc_class;
+    return to_user (block);
+}
+
+block_header_t *new_block (int class_)
+{
+    block_header_t *block =
+      static_cast<block_header_t *> (std::malloc (class_size (class_)));
+    if (unlikely (!block))
+        return NULL;
+    block->next = NULL;
+    block->size_class = static_cast<uint32_t> (class_);
+    return block;
+}
+
+void free_chain (block_header_t *head_)
+{
+    while (head_) {
+        block_header_t *next = head_->next;
+        std::free (head_);
+        head_ = next;
+    }
+}
+
+//  Shared per-class free lists. Intentionally leaked so that threads which
+//  exit during static destruction can still return their caches.
+struct depot_t
+{
+    depot_t () : head (NULL), count (0) {}
+
+    mutex_t sync;
+    block_header_t *head;
+    std::size_t count;
+};
+
+depot_t *depots ()
+{
+    static depot_t *instance = new (std::nothrow) depot_t[size_class_count];
+    alloc_assert (instance);
+    return instance;
+}
+
+block_header_t *depot_pop (int class_)
+{
+    depot_t &depot = depots ()[class_];
+    {
+        scoped_lock_t locker (depot.sync);
+        block_header_t *block = depot.head;
+        if (block) {
+            depot.head = block->next;
+            depot.count--;
+            return block;
+        }
+    }
+    return new_block (class_);
+}
+
+//  Returns a chain of 'count_' blocks ending with 'tail_' to the depot.
+void depot_push (int class_,
+                 block_header_t *head_,
+                 block_header_t *tail_,
+                 std::size_t count_)
+{
+    depot_t &depot = depots ()[class_];
+    {
+        scoped_lock_t locker (depot.sync);
+        if ((depot.count + count_) * class_size (class_) <= depot_max_bytes) {
+            tail_->next = depot.head;
+            depot.head = head_;
+            depot.count += count_;
+            return;
+        }
+    }
+    tail_->next = NULL;
+    free_chain (head_);
+}
+
+struct thread_cache_t
+{
+    block_header_t *head[size_class_count];
+    std::size_t count[size_class_count];
+};
+
+void refill (thread_cache_t *cache_, int class_)
+{
+    depot_t &depot = depots ()[class_];
+    const std::size_t batch = batch_size (class_);
+
+    scoped_lock_t locker (depot.sync);
+    while (depot.head && cache_->count[class_] < batch) {
+        block_header_t *block = depot.head;
+        depot.head = block->next;
+        depot.count--;
+        block->next = cache_->head[class_];
+        cache_->head[class_] = block;
+        cache_->count[class_]++;
+    }
+}
+
+void spill (thread_cache_t *cache_, int class_, std::size_t count_)
+{
+    block_header_t *head = cache_->head[class_];
+    if (!head)
+        return;
+    block_header_t *tail = head;
+    std::size_t n = 1;
+    while (n < count_ && tail->next) {
+        tail = tail->next;
+        ++n;
+    }
+    cache_->head[class_] = tail->next;
+    cache_->count[class_] -= n;
+    depot_push (class_, head, tail, n);
+}
+
+//  The per-thread cache itself is POD so that it stays usable until the
+//  very end of the thread; the guard only exists to flush it on exit.
+enum
+{
+    cache_uninitialised = 0,
+    cache_live = 1,
+    cache_dead = 2
+};
+
+thread_local thread_cache_t tl_cache;
+thread_local int tl_cache_state = cache_uninitialised;
+
+struct thread_cache_guard_t
+{
+    ~thread_cache_guard_t ()
+    {
+        for (int c = 0; c != size_class_count; ++c)
+            spill (&tl_cache, c, tl_cache.count[c]);
+        tl_cache_state = cache_dead;
+    }
+};
+
+thread_local thread_cache_guard_t tl_cache_guard;
+
+inline thread_cache_t *local_cache ()
+{
+    if (likely (tl_cache_state == cache_live))
+        return &tl_cache;
+    if (tl_cache_state == cache_dead)
+        return NULL;
+    //  Touching the guard registers its destructor for this thread.
+    LIBZLINK_UNUSED (&tl_cache_guard);
+    tl_cache_state = cache_live;
+    return &tl_cache;
+}
+
+atomic_value_t selected_allocator (allocator_malloc);
+}
+
+int set_allocator (int allocator_)
+{
+    if (allocator_ != allocator_malloc && allocator_ != allocator_pool) {
+        errno = EINVAL;
+        return -1;
+    }
+    selected_allocator.store (allocator_);
+    return 0;
+}
+
+int get_allocator ()
+{
+    return selected_allocator.load ();
+}
+
 void *alloc (std::size_t size_)
 {
-    return std::malloc (size_);
+    const int c = size_class_for (size_);
+    if (selected_allocator.load () != allocator_pool || c < 0)
+        return malloc_block (size_);
+
+    block_header_t *block = depot_pop (c);
+    return block ? to_user (block) : NULL;
 }
 
 void dealloc (void *ptr_)
 {
-    std::free (ptr_);
+    if (!ptr_)
+        return;
+    block_header_t *block = to_block (ptr_);
+    if (block->size_class == malloc_class) {
+        std::free (block);
+        return;
+    }
+    depot_push (static_cast<int> (block->size_class), block, block, 1);
 }
 
 void *alloc_tl (std::size_t size_)
 {
-    return std::malloc (size_);
+    const int c = size_class_for (size_);
+    if (selected_allocator.load () != allocator_pool || c < 0)
+        return malloc_block (size_);
+
+    thread_cache_t *cache = local_cache ();
+    if (unlikely (!cache)) {
+        block_header_t *block = depot_pop (c);
+        return block ? to_user (block) : NULL;
+    }
+
+    if (!cache->head[c])
+        refill (cache, c);
+    block_header_t *block = cache->head[c];
+    if (!block) {
+        block = new_block (c);
+        return block ? to_user (block) : NULL;
+    }
+    cache->head[c] = block->next;
+    cache->count[c]--;
+    return to_user (block);
 }
 
 void dealloc_tl (void *ptr_)
 {
-    std::free (ptr_);
+    if (!ptr_)
+        return;
+    block_header_t *block = to_block (ptr_);
+    if (block->size_class == malloc_class) {
+        std::free (block);
+        return;
+    }
+
+    const int c = static_cast<int> (block->size_class);
+    thread_cache_t *cache = local_cache ();
+    if (unlikely (!cache)) {
+        depot_push (c, block, block, 1);
+        return;
+    }
+
+    block->next = cache->head[c];
+    cache->head[c] = block;
+    if (++cache->count[c] > 2 * batch_size (c))
+        spill (cache, c, batch_size (c));
 }
 }
@@ -7,6 +7,31 @@
 
 namespace zlink
 {
+//  Memory used for message content, long groups and decoder buffers.
+//
+//  With the malloc allocator every call maps to std::malloc/std::free.
+//  With the pool allocator blocks up to max_block_size (allocator.cpp,
+//  32 KB including a 16-byte header) are served from power-of-two size
+//  classes; larger ones go to malloc. alloc_tl/dealloc_tl go through a
+//  per-thread cache that refills from and spills to a shared depot in
+//  batches, so a block freed by another thread (e.g. message content
+//  allocated by an I/O thread and released by the application) simply
+//  lands in the freeing thread's cache. alloc/dealloc bypass the
+//  per-thread cache and talk to the depot directly.
+//
+//  Every block carries a small header recording its size class, so any
+//  block may be released through either dealloc or dealloc_tl regardless
+//  of the allocator selected at the time it was freed.
+enum
+{
+    allocator_malloc = 0,
+    allocator_pool = 1
+};
+
+//  Selects the allocator used for subsequent allocations (process-wide).
+int set_allocator (int allocator_);
+int get_allocator ();
+
 void *alloc (std::size_t size_);
 void dealloc (void *ptr_);
 void *alloc_tl (std::size_t size_);
@@ -0,0 +1,240 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZLINK_BLOB_MAP_HPP_INCLUDED__
+#define __ZLINK_BLOB_MAP_HPP_INCLUDED__
+
+#include <string.h>
+#include <vector>
+
+#include "utils/blob.hpp"
+#include "utils/blob_hash.hpp"
+#include "utils/err.hpp"
+#include "utils/macros.hpp"
+#include "utils/stdint.hpp"
+
+namespace zlink
+{
+//  Hash table keyed by blob_t with O(1) lookup, insertion and removal.
+//
+//  Entries live in a dense vector, which is what iteration walks; removal
+//  moves the last entry into the freed position. A separate power-of-two
+//  open addressing index (linear probing, backward-shift deletion) maps
+//  hashes to entry positions.
+//
+//  Keys of up to 8 bytes - which covers the 4 and 5 byte routing ids that
+//  ROUTER and STREAM sockets assign automatically - are packed into an
+//  integer and compared without touching the key bytes. Longer keys are
+//  hashed with FNV-1a and compared with memcmp.
+//
+//  Pointers and iterators are invalidated by insert and erase.
+template <typename T> class blob_map_t
+{
+  public:
+    struct entry_t
+    {
+        blob_t key;
+        T value;
+        uint64_t packed;
+        uint64_t hash;
+    };
+
+    typedef typename std::vector<entry_t>::iterator iterator;
+    typedef typename std::vector<entry_t>::const_iterator const_iterator;
+
+    blob_map_t () : _mask (0) {}
+
+    size_t size () const { return _entries.size (); }
+    bool empty () const { return _entries.empty (); }
+
+    iterator begin () { return _entries.begin (); }
+    iterator end () { return _entries.end (); }
+    const_iterator begin () const { return _entries.begin (); }
+    const_iterator end () const { return _entries.end (); }
+
+    //  Adds the entry. Returns false, leaving the table unchanged, if the
+    //  key is already present.
+    bool insert (blob_t key_, const T &value_)
+    {
+        uint64_t packed;
+        const uint64_t hash = hash_key (key_.data (), key_.size (), &packed);
+        if (find_slot (key_.data (), key_.size (), hash, packed) >= 0)
+            return false;
+
+        if ((_entries.size () + 1) * 2 > _slots.size ())
+            rehash (_slots.empty () ? min_slots : _slots.size () * 2);
+
+        _entries.push_back (entry_t ());
+        entry_t &entry = _entries.back ();
+        entry.key = ZLINK_MOVE (key_);
+        entry.value = value_;
+        entry.packed = packed;
+        entry.hash = hash;
+        place (hash, static_cast<uint32_t> (_entries.size ()));
+        return true;
+    }
+
+    T *find (const unsigned char *data_, size_t size_)
+    {
+        uint64_t packed;
+        const uint64_t hash = hash_key (data_, size_, &packed);
+        const long slot = find_slot (data_, size_, hash, packed);
+        return slot < 0 ? NULL : &_entries[_slots[slot] - 1].value;
+    }
+
+    const T *find (const unsigned char *data_, size_t size_) const
+    {
+        uint64_t packed;
+        const uint64_t hash = hash_key (data_, size_, &packed);
+        const long slot = find_slot (data_, size_, hash, packed);
+        return slot < 0 ? NULL : &_entries[_slots[slot] - 1].value;
+    }
+
+    T *find (const blob_t &key_) { return find (key_.data (), key_.size ()); }
+    const T *find (const blob_t &key_) const
+    {
+        return find (key_.data (), key_.size ());
+    }
+
+    //  Removes the entry; returns false if the key is not present.
+    bool erase (const unsigned char *data_, size_t size_)
+    {
+        uint64_t packed;
+        const uint64_t hash = hash_key (data_, size_, &packed);
+        const long slot = find_slot (data_, size_, hash, packed);
+        if (slot < 0)
+            return false;
+
+        const uint32_t pos = _slots[slot] - 1;
+        unplace (static_cast<size_t> (slot));
+
+        //  Fill the hole in the dense array with the last entry.
+        const uint32_t last = static_cast<uint32_t> (_entries.size () - 1);
+        if (pos != last) {
+            size_t i = _entries[last].hash & _mask;
+            while (_slots[i] != last + 1)
+                i = (i + 1) & _mask;
+            _slots[i] = pos + 1;
+            _entries[pos] = ZLINK_MOVE (_entries[last]);
+        }
+        _entries.pop_back ();
+        return true;
+    }
+
+    bool erase (const blob_t &key_) { return erase (key_.data (), key_.size ()); }
+
+    void clear ()
+    {
+        _entries.clear ();
+        _slots.clear ();
+        _mask = 0;
+    }
+
+  private:
+    enum
+    {
+        min_slots = 16
+    };
+
+    static uint64_t mix (uint64_t h_)
+    {
+        h_ ^= h_ >> 33;
+        h_ *= 0xff51afd7ed558ccdULL;
+        h_ ^= h_ >> 33;
+        h_ *= 0xc4ceb9fe1a85ec53ULL;
+        h_ ^= h_ >> 33;
+        return h_;
+    }
+
+    static uint64_t
+    hash_key (const unsigned char *data_, size_t size_, uint64_t *packed_)
+    {
+        if (size_ <= sizeof (uint64_t)) {
+            uint64_t packed = 0;
+            if (size_)
+                memcpy (&packed, data_, size_);
+            *packed_ = packed;
+            return mix (packed ^ (static_cast<uint64_t> (size_) << 59));
+        }
+        *packed_ = 0;
+        return mix (blob_hash ().hash_bytes (data_, size_));
+    }
+
+    bool matches (const entry_t &entry_,
+                  const unsigned char *data_,
+                  size_t size_,
+                  uint64_t hash_,
+                  uint64_t packed_) const
+    {
+        if (entry_.hash != hash_ || entry_.key.size () != size_)
+            return false;
+        if (size_ <= sizeof (uint64_t))
+            return entry_.packed == packed_;
+        return memcmp (entry_.key.data (), data_, size_) == 0;
+    }
+
+    //  Returns the index slot holding the key, or -1.
+    long find_slot (const unsigned char *data_,
+                    size_t size_,
+                    uint64_t hash_,
+                    uint64_t packed_) const
+    {
+        if (_slots.empty ())
+            return -1;
+        for (size_t i = hash_ & _mask;; i = (i + 1) & _mask) {
+            const uint32_t ref = _slots[i];
+            if (!ref)
+                return -1;
+            if (matches (_entries[ref - 1], data_, size_, hash_, packed_))
+                return static_cast<long> (i);
+        }
+    }
+
+    void place (uint64_t hash_, uint32_t ref_)
+    {
+        size_t i = hash_ & _mask;
+        while (_slots[i])
+            i = (i + 1) & _mask;
+        _slots[i] = ref_;
+    }
+
+    //  Clears the slot and shifts the rest of the probe run back so that
+    //  lookups never need tombstones.
+    void unplace (size_t hole_)
+    {
+        size_t j = hole_;
+        while (true) {
+            j = (j + 1) & _mask;
+            if (!_slots[j])
+                break;
+            const size_t home = _entries[_slots[j] - 1].hash & _mask;
+            //  The entry at j may move into the hole only if its home slot
+            //  does not lie cyclically within (hole, j].
+            const bool stays = hole_ <= j ? (hole_ < home && home <= j)
+                                          : (hole_ < home || home <= j);
+            if (!stays) {
+                _slots[hole_] = _slots[j];
+                hole_ = j;
+            }
+        }
+        _slots[hole_] = 0;
+    }
+
+    void rehash (size_t slots_)
+    {
+        _slots.assign (slots_, 0);
+        _mask = slots_ - 1;
+        for (size_t i = 0, n = _entries.size (); i != n; ++i)
+            place (_entries[i].hash, static_cast<uint32_t> (i + 1));
+    }
+
+    std::vector<entry_t> _entries;
+
+    //  Entry position plus one; zero marks an empty slot.
+    std::vector<uint32_t> _slots;
+    size_t _mask;
+
+    ZLINK_NON_COPYABLE_NOR_MOVABLE (blob_map_t)
+};
+}
+
+#endif
@@ -17,6 +17,14 @@ enum
     //  Commands in pipe per allocation event.
     command_pipe_granularity = 16,
 
+    //  Messages queued to a SPOT sub per allocation event. Kept small as
+    //  every sub holds at least one chunk.
+    spot_pipe_granularity = 64,
+
+    //  Commands a mailbox holds before senders fall back to a locked
+    //  queue. Must be a power of two.
+    command_pipe_size = 64,
+
     //  Determines how often does socket poll for new commands when it
     //  still has unprocessed messages to handle. Thus, if it is set to 100,
     //  socket will process 100 inbound messages before doing the poll.
@@ -31,6 +39,25 @@ enum
     //  Maximum number of events the I/O thread can process in one go.
     max_io_events = 256,
 
+    //  Interval, in milliseconds, at which I/O threads measure the
+    //  traffic they handle.
+    io_thread_sample_ivl = 100,
+
+    //  Bytes a message counts for in the traffic load of an I/O thread,
+    //  which covers the per-message work that byte counts miss.
+    io_thread_msg_cost = 64,
+
+    //  I/O threads with less traffic load than this (bytes per second)
+    //  count as idle when placing new connections.
+    io_thread_idle_load = 65536,
+
+    //  An I/O thread moves a connection to the least loaded I/O thread
+    //  once its traffic load has been at least io_thread_balance_min_load
+    //  and twice the other thread's for io_thread_balance_samples
+    //  intervals in a row.
+    io_thread_balance_min_load = 1048576,
+    io_thread_balance_samples = 5,
+
     //  Maximal batch size of packets forwarded by a ZLINK proxy.
     //  Increasing this value improves throughput at the expense of
     //  latency and fairness.
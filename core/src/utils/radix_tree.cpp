@@ -4,7 +4,9 @@
 #include "utils/macros.hpp"
 #include "utils/err.hpp"
 #include "utils/radix_tree.hpp"
+#include "utils/simd.hpp"
 
+#include <algorithm>
 #include <stdlib.h>
 #include <string.h>
 #include <iterator>
@@ -211,12 +213,10 @@ match_result_t zlink::radix_tree_t::match (const unsigned char *key_,
         const unsigned char *const prefix = current_node.prefix ();
         const size_t prefix_length = current_node.prefix_length ();
 
-        for (prefix_byte_index = 0;
-             prefix_byte_index < prefix_length && key_byte_index < key_size_;
-             ++prefix_byte_index, ++key_byte_index) {
-            if (prefix[prefix_byte_index] != key_[key_byte_index])
-                break;
-        }
+        prefix_byte_index = zlink::common_prefix (
+          prefix, key_ + key_byte_index,
+          std::min (prefix_length, key_size_ - key_byte_index));
+        key_byte_index += prefix_byte_index;
 
         // Even if a prefix of the key matches and we're doing a
         // lookup, this means we've found a matching subscription.
@@ -233,19 +233,14 @@ match_result_t zlink::radix_tree_t::match (const unsigned char *key_,
 
         // We need to match the rest of the key. Check if there's an
         // outgoing edge from this node.
-        node_t next_node = current_node;
-        for (size_t i = 0, edgecount = current_node.edgecount (); i < edgecount;
-             ++i) {
-            if (current_node.first_byte_at (i) == key_[key_byte_index]) {
-                parent_edge_index = edge_index;
-                edge_index = i;
-                next_node = current_node.node_at (i);
-                break;
-            }
-        }
-
-        if (next_node == current_node)
+        const size_t edgecount = current_node.edgecount ();
+        const size_t i = zlink::find_byte (current_node.first_bytes (),
+                                           edgecount, key_[key_byte_index]);
+        if (i == edgecount)
             break; // No outgoing edge.
+        parent_edge_index = edge_index;
+        edge_index = i;
+        const node_t next_node = current_node.node_at (i);
         grandparent_node = parent_node;
         parent_node = current_node;
         current_node = next_node;
@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#ifndef __ZLINK_SIMD_HPP_INCLUDED__
+#define __ZLINK_SIMD_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#if defined __AVX2__
+#include <immintrin.h>
+#define ZLINK_SIMD_AVX2
+#elif defined __SSE2__ || defined _M_X64                                       \
+  || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ZLINK_SIMD_SSE2
+#endif
+
+#if defined _MSC_VER && (defined ZLINK_SIMD_AVX2 || defined ZLINK_SIMD_SSE2)
+#include <intrin.h>
+#endif
+
+//  Byte scans used on the subscription matching paths.
+//
+//  The vector width is chosen at compile time: AVX2 when the compiler
+//  targets it (e.g. ENABLE_NATIVE_OPTIMIZATIONS on a capable host), SSE2
+//  on any x86-64 build, plain loops elsewhere. Loads never go past the
+//  given length; the remainder is handled one byte at a time.
+
+namespace zlink
+{
+namespace simd
+{
+inline unsigned int lowest_bit (unsigned int mask_)
+{
+#if defined _MSC_VER
+    unsigned long index;
+    _BitScanForward (&index, mask_);
+    return static_cast<unsigned int> (index);
+#else
+    return static_cast<unsigned int> (__builtin_ctz (mask_));
+#endif
+}
+}
+
+//  Returns the index of the first occurrence of byte_ in bytes_, or
+//  size_ if there is none.
+inline size_t find_byte (const unsigned char *bytes_,
+                         size_t size_,
+                         unsigned char byte_)
+{
+    size_t i = 0;
+#if defined ZLINK_SIMD_AVX2
+    const __m256i needle = _mm256_set1_epi8 (static_cast<char> (byte_));
+    for (; i + 32 <= size_; i += 32) {
+        const __m256i chunk =
+          _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (bytes_ + i));
+        const unsigned int mask = static_cast<unsigned int> (
+          _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (chunk, needle)));
+        if (mask)
+            return i + simd::lowest_bit (mask);
+    }
+#endif
+#if defined ZLINK_SIMD_AVX2 || defined ZLINK_SIMD_SSE2
+    const __m128i needle16 = _mm_set1_epi8 (static_cast<char> (byte_));
+    for (; i + 16 <= size_; i += 16) {
+        const __m128i chunk =
+          _mm_loadu_si128 (reinterpret_cast<const __m128i *> (bytes_ + i));
+        const unsigned int mask = static_cast<unsigned int> (
+          _mm_movemask_epi8 (_mm_cmpeq_epi8 (chunk, needle16)));
+        if (mask)
+            return i + simd::lowest_bit (mask);
+    }
+#endif
+    for (; i < size_; ++i)
+        if (bytes_[i] == byte_)
+            return i;
+    return size_;
+}
+
+//  Returns the length of the common prefix of a_ and b_, both at least
+//  size_ bytes long.
+inline size_t common_prefix (const unsigned char *a_,
+                             const unsigned char *b_,
+                             size_t size_)
+{
+    size_t i = 0;
+#if defined ZLINK_SIMD_AVX2
+    for (; i + 32 <= size_; i += 32) {
+        const __m256i x =
+          _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (a_ + i));
+        const __m256i y =
+          _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (b_ + i));
+        const unsigned int mask = ~static_cast<unsigned int> (
+          _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (x, y)));
+        if (mask)
+            return i + simd::lowest_bit (mask);
+    }
+#endif
+#if defined ZLINK_SIMD_AVX2 || defined ZLINK_SIMD_SSE2
+    for (; i + 16 <= size_; i += 16) {
+        const __m128i x =
+          _mm_loadu_si128 (reinterpret_cast<const __m128i *> (a_ + i));
+        const __m128i y =
+          _mm_loadu_si128 (reinterpret_cast<const __m128i *> (b_ + i));
+        const unsigned int mask =
+          ~static_cast<unsigned int> (_mm_movemask_epi8 (_mm_cmpeq_epi8 (x, y)))
+          & 0xffffu;
+        if (mask)
+            return i + simd::lowest_bit (mask);
+    }
+#endif
+    for (; i < size_; ++i)
+        if (a_[i] != b_[i])
+            return i;
+    return size_;
+}
+}
+
+#endif
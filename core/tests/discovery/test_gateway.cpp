@@ -10,6 +10,8 @@
 
 #include <string.h>
 #include <atomic>
+#include <set>
+#include <string>
 #include <vector>
 #include <thread>
 
@@ -230,7 +232,7 @@ static bool recv_provider_message (void *router)
 {
     zlink_msg_t rid;
     zlink_msg_init (&rid);
-    if (zlink_msg_recv (&rid, router, 0) != 0) {
+    if (zlink_msg_recv (&rid, router, 0) < 0) {
         zlink_msg_close (&rid);
         return false;
     }
@@ -241,14 +243,14 @@ static bool recv_provider_message (void *router)
 
     zlink_msg_t payload;
     zlink_msg_init (&payload);
-    if (zlink_msg_recv (&payload, router, 0) != 0) {
+    if (zlink_msg_recv (&payload, router, 0) < 0) {
         zlink_msg_close (&payload);
         return false;
     }
     while (zlink_msg_more (&payload)) {
         zlink_msg_t part;
         zlink_msg_init (&part);
-        if (zlink_msg_recv (&part, router, 0) != 0) {
+        if (zlink_msg_recv (&part, router, 0) < 0) {
             zlink_msg_close (&part);
             break;
         }
@@ -1445,6 +1447,840 @@ void test_gateway_load_balancing ()
     TEST_ASSERT_SUCCESS_ERRNO (zlink_registry_destroy (&registry));
 }
 
+// Setup a provider with the given routing id and weight
+static void *setup_lb_provider (void *ctx,
+                                const char *registry_router_ep,
+                                const char *service_name,
+                                const char *rid,
+                                uint32_t weight,
+                                void **router_out)
+{
+    void *provider = zlink_receiver_new (ctx, NULL);
+    TEST_ASSERT_NOT_NULL (provider);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_receiver_bind (provider, "tcp://127.0.0.1:*"));
+    void *router = zlink_receiver_router (provider);
+    TEST_ASSERT_NOT_NULL (router);
+    int probe = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_setsockopt (router, ZLINK_PROBE_ROUTER, &probe, sizeof (probe)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_setsockopt (router, ZLINK_ROUTING_ID, rid, strlen (rid)));
+    int timeout_ms = 2000;
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_setsockopt (router, ZLINK_RCVTIMEO,
+                                                 &timeout_ms,
+                                                 sizeof (timeout_ms)));
+    char ep[256] = {0};
+    size_t len = sizeof (ep);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_getsockopt (router, ZLINK_LAST_ENDPOINT, ep, &len));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_receiver_connect_registry (provider, registry_router_ep));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_receiver_register (provider, service_name, ep, weight));
+    *router_out = router;
+    return provider;
+}
+
+static void wait_gateway_connections (void *gateway,
+                                      const char *service_name,
+                                      int expected,
+                                      int timeout_ms)
+{
+    const int sleep_ms_step = 5;
+    const int attempts = timeout_ms / sleep_ms_step;
+    for (int i = 0; i < attempts; ++i) {
+        if (zlink_gateway_connection_count (gateway, service_name)
+            == expected)
+            return;
+        msleep (sleep_ms_step);
+    }
+    TEST_FAIL_MESSAGE ("gateway connection timeout");
+}
+
+// Sends one request and returns the index of the provider that got it.
+// The request is echoed back when reply is set for that provider.
+static int send_and_route (void *gateway,
+                           const char *service_name,
+                           void **routers,
+                           const bool *reply)
+{
+    zlink_msg_t msg;
+    zlink_msg_init_size (&msg, 3);
+    memcpy (zlink_msg_data (&msg), "req", 3);
+    send_gateway_with_timeout (gateway, service_name, &msg, 1, 2000);
+
+    zlink_pollitem_t items[2];
+    for (int i = 0; i < 2; ++i) {
+        items[i].socket = routers[i];
+        items[i].fd = 0;
+        items[i].events = ZLINK_POLLIN;
+        items[i].revents = 0;
+    }
+    TEST_ASSERT_EQUAL_INT (1, zlink_poll (items, 2, 2000));
+    const int index = (items[0].revents & ZLINK_POLLIN) ? 0 : 1;
+
+    zlink_msg_t rid;
+    zlink_msg_init (&rid);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_recv (&rid, routers[index], 0));
+    TEST_ASSERT_TRUE (zlink_msg_more (&rid));
+    zlink_msg_t body;
+    zlink_msg_init (&body);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_recv (&body, routers[index], 0));
+    if (!reply[index]) {
+        zlink_msg_close (&body);
+        zlink_msg_close (&rid);
+        return index;
+    }
+
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_msg_send (&rid, routers[index], ZLINK_SNDMORE));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_send (&body, routers[index], 0));
+    zlink_msg_t *parts = NULL;
+    size_t part_count = 0;
+    char service_out[256];
+    int rc = -1;
+    for (int attempt = 0; attempt < 1000 && rc != 0; ++attempt) {
+        rc = zlink_gateway_recv (gateway, &parts, &part_count,
+                                 ZLINK_DONTWAIT, service_out);
+        if (rc != 0) {
+            msleep (2);
+        } else if (part_count == 1 && zlink_msg_size (&parts[0]) == 0) {
+            // Probe from a provider that connected
+            zlink_msgv_close (parts, part_count);
+            rc = -1;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT (0, rc);
+    TEST_ASSERT_EQUAL_STRING (service_name, service_out);
+    zlink_msgv_close (parts, part_count);
+    return index;
+}
+
+// Sends one keyed request and returns the index of the provider that got
+// it; probes from the gateway are skipped.
+static int send_keyed_and_route (void *gateway,
+                                 const char *service_name,
+                                 void **routers,
+                                 int router_count,
+                                 int key)
+{
+    zlink_msg_t msg;
+    zlink_msg_init_size (&msg, 3);
+    memcpy (zlink_msg_data (&msg), "req", 3);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_send_keyed (
+      gateway, service_name, &key, sizeof (key), &msg, 1, 0));
+
+    zlink_pollitem_t items[4];
+    TEST_ASSERT_TRUE (router_count <= 4);
+    while (true) {
+        for (int i = 0; i < router_count; ++i) {
+            items[i].socket = routers[i];
+            items[i].fd = 0;
+            items[i].events = ZLINK_POLLIN;
+            items[i].revents = 0;
+        }
+        TEST_ASSERT_TRUE (zlink_poll (items, router_count, 2000) > 0);
+        int index = 0;
+        while (!(items[index].revents & ZLINK_POLLIN))
+            ++index;
+        zlink_msg_t rid;
+        zlink_msg_init (&rid);
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_recv (&rid, routers[index], 0));
+        zlink_msg_t body;
+        zlink_msg_init (&body);
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_recv (&body, routers[index], 0));
+        const size_t size = zlink_msg_size (&body);
+        zlink_msg_close (&body);
+        zlink_msg_close (&rid);
+        if (size > 0)
+            return index;
+    }
+}
+
+// Test: Keyed sends stick to one provider per key across strategies, and
+// when a provider goes away only the keys it held move
+void test_gateway_send_keyed ()
+{
+    void *ctx = get_test_context ();
+    const char *service_name = "keyed-svc";
+    const int keys = 60;
+
+    void *registry = NULL;
+    setup_registry (ctx, &registry, "inproc://reg-pub-keyed",
+                    "inproc://reg-router-keyed");
+    void *discovery = zlink_discovery_new_typed (ctx, ZLINK_SERVICE_TYPE_GATEWAY);
+    TEST_ASSERT_NOT_NULL (discovery);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_connect_registry (discovery, "inproc://reg-pub-keyed"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_subscribe (discovery, service_name));
+
+    void *routers[3] = {NULL, NULL, NULL};
+    void *providers[3];
+    const char *rids[3] = {"KPROV1", "KPROV2", "KPROV3"};
+    for (int i = 0; i < 3; ++i)
+        providers[i] = setup_lb_provider (ctx, "inproc://reg-router-keyed",
+                                          service_name, rids[i], 1,
+                                          &routers[i]);
+    void *gateway = zlink_gateway_new (ctx, discovery, NULL);
+    TEST_ASSERT_NOT_NULL (gateway);
+    wait_gateway_connections (gateway, service_name, 3, 5000);
+
+    zlink_msg_t msg;
+    zlink_msg_init_size (&msg, 3);
+    const int key = 1;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zlink_gateway_send_keyed (gateway, service_name, NULL, 0, &msg,
+                                        1, 0));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zlink_gateway_send_keyed (gateway, service_name, &key, 0, &msg,
+                                        1, 0));
+    zlink_msg_close (&msg);
+
+    // The strategy does not move keys around.
+    int owner[keys];
+    int per_provider[3] = {0, 0, 0};
+    for (int k = 0; k < keys; ++k) {
+        owner[k] = send_keyed_and_route (gateway, service_name, routers, 3, k);
+        ++per_provider[owner[k]];
+    }
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_set_lb_strategy (
+      gateway, service_name, ZLINK_GATEWAY_LB_LEAST_OUTSTANDING));
+    for (int k = 0; k < keys; ++k)
+        TEST_ASSERT_EQUAL_INT (
+          owner[k],
+          send_keyed_and_route (gateway, service_name, routers, 3, k));
+    for (int i = 0; i < 3; ++i)
+        TEST_ASSERT_TRUE (per_provider[i] > 0);
+
+    // The keys of the provider that left are spread over the others;
+    // every other key stays where it was.
+    const int gone = owner[0];
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&providers[gone]));
+    void *left[2];
+    int left_index[2];
+    for (int i = 0, n = 0; i < 3; ++i)
+        if (i != gone) {
+            left[n] = routers[i];
+            left_index[n++] = i;
+        }
+    wait_gateway_connections (gateway, service_name, 2, 5000);
+    for (int k = 0; k < keys; ++k) {
+        const int now = left_index[send_keyed_and_route (
+          gateway, service_name, left, 2, k)];
+        if (owner[k] != gone)
+            TEST_ASSERT_EQUAL_INT (owner[k], now);
+    }
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_destroy (&gateway));
+    for (int i = 0; i < 3; ++i)
+        if (i != gone)
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&providers[i]));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_discovery_destroy (&discovery));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_registry_destroy (&registry));
+}
+
+// Test: Weighted strategy splits traffic by provider weight, evenly
+void test_gateway_lb_weighted ()
+{
+    void *ctx = get_test_context ();
+    const char *service_name = "lb-weighted-svc";
+
+    void *registry = NULL;
+    setup_registry (ctx, &registry, "inproc://reg-pub-lbw",
+                    "inproc://reg-router-lbw");
+    void *discovery = zlink_discovery_new_typed (ctx, ZLINK_SERVICE_TYPE_GATEWAY);
+    TEST_ASSERT_NOT_NULL (discovery);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_connect_registry (discovery, "inproc://reg-pub-lbw"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_subscribe (discovery, service_name));
+
+    void *routers[2];
+    void *provider_1 = setup_lb_provider (ctx, "inproc://reg-router-lbw",
+                                          service_name, "WPROV1", 3,
+                                          &routers[0]);
+    void *provider_2 = setup_lb_provider (ctx, "inproc://reg-router-lbw",
+                                          service_name, "WPROV2", 1,
+                                          &routers[1]);
+
+    void *gateway = zlink_gateway_new (ctx, discovery, NULL);
+    TEST_ASSERT_NOT_NULL (gateway);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_set_lb_strategy (
+      gateway, service_name, ZLINK_GATEWAY_LB_WEIGHTED));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zlink_gateway_set_lb_strategy (gateway, service_name, 99));
+    wait_gateway_connections (gateway, service_name, 2, 5000);
+
+    // Every window of four requests goes three to one, whatever the order.
+    const bool reply[2] = {false, false};
+    int received[2] = {0, 0};
+    for (int window = 0; window < 10; ++window) {
+        int in_window[2] = {0, 0};
+        for (int i = 0; i < 4; ++i)
+            ++in_window[send_and_route (gateway, service_name, routers,
+                                        reply)];
+        TEST_ASSERT_EQUAL_INT (3, in_window[0]);
+        TEST_ASSERT_EQUAL_INT (1, in_window[1]);
+        received[0] += in_window[0];
+        received[1] += in_window[1];
+    }
+    TEST_ASSERT_EQUAL_INT (30, received[0]);
+    TEST_ASSERT_EQUAL_INT (10, received[1]);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_destroy (&gateway));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&provider_1));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&provider_2));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_discovery_destroy (&discovery));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_registry_destroy (&registry));
+}
+
+// Test: Least-outstanding and P2C strategies avoid a provider that
+// stopped answering
+void test_gateway_lb_outstanding ()
+{
+    void *ctx = get_test_context ();
+    const char *service_name = "lb-outstanding-svc";
+
+    void *registry = NULL;
+    setup_registry (ctx, &registry, "inproc://reg-pub-lbo",
+                    "inproc://reg-router-lbo");
+    void *discovery = zlink_discovery_new_typed (ctx, ZLINK_SERVICE_TYPE_GATEWAY);
+    TEST_ASSERT_NOT_NULL (discovery);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_connect_registry (discovery, "inproc://reg-pub-lbo"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_subscribe (discovery, service_name));
+
+    void *routers[2];
+    void *provider_1 = setup_lb_provider (ctx, "inproc://reg-router-lbo",
+                                          service_name, "OPROV1", 1,
+                                          &routers[0]);
+    void *provider_2 = setup_lb_provider (ctx, "inproc://reg-router-lbo",
+                                          service_name, "OPROV2", 1,
+                                          &routers[1]);
+
+    void *gateway = zlink_gateway_new (ctx, discovery, NULL);
+    TEST_ASSERT_NOT_NULL (gateway);
+    wait_gateway_connections (gateway, service_name, 2, 5000);
+
+    // The first provider never answers. Once it holds a request, every
+    // other request goes to the second one, which answers each in turn.
+    const bool reply[2] = {false, true};
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_set_lb_strategy (
+      gateway, service_name, ZLINK_GATEWAY_LB_LEAST_OUTSTANDING));
+    int received[2] = {0, 0};
+    for (int i = 0; i < 20; ++i)
+        ++received[send_and_route (gateway, service_name, routers, reply)];
+    TEST_ASSERT_EQUAL_INT (1, received[0]);
+    TEST_ASSERT_EQUAL_INT (19, received[1]);
+
+    // The stuck provider keeps its pending request, so P2C never prefers
+    // it over the one that answers.
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_set_lb_strategy (
+      gateway, service_name, ZLINK_GATEWAY_LB_P2C_EWMA));
+    received[0] = received[1] = 0;
+    for (int i = 0; i < 20; ++i)
+        ++received[send_and_route (gateway, service_name, routers, reply)];
+    TEST_ASSERT_EQUAL_INT (0, received[0]);
+    TEST_ASSERT_EQUAL_INT (20, received[1]);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_destroy (&gateway));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&provider_1));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&provider_2));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_discovery_destroy (&discovery));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_registry_destroy (&registry));
+}
+
+// Test: A service handle resolved before any provider exists keeps working
+// as providers come and go
+void test_gateway_service_handle ()
+{
+    void *ctx = get_test_context ();
+    const char *service_name = "handle-svc";
+
+    void *registry = NULL;
+    setup_registry (ctx, &registry, "inproc://reg-pub-handle",
+                    "inproc://reg-router-handle");
+    void *discovery = zlink_discovery_new_typed (ctx, ZLINK_SERVICE_TYPE_GATEWAY);
+    TEST_ASSERT_NOT_NULL (discovery);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_connect_registry (discovery, "inproc://reg-pub-handle"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_subscribe (discovery, service_name));
+
+    void *gateway = zlink_gateway_new (ctx, discovery, NULL);
+    TEST_ASSERT_NOT_NULL (gateway);
+    void *other_gateway = zlink_gateway_new (ctx, discovery, NULL);
+    TEST_ASSERT_NOT_NULL (other_gateway);
+
+    TEST_ASSERT_NULL (zlink_gateway_service (gateway, ""));
+    TEST_ASSERT_EQUAL_INT (EINVAL, errno);
+    zlink_gateway_service_t *service =
+      zlink_gateway_service (gateway, service_name);
+    TEST_ASSERT_NOT_NULL (service);
+    TEST_ASSERT_EQUAL_PTR (service,
+                           zlink_gateway_service (gateway, service_name));
+
+    zlink_msg_t msg;
+    zlink_msg_init_size (&msg, 3);
+    memcpy (zlink_msg_data (&msg), "req", 3);
+    TEST_ASSERT_FAILURE_ERRNO (
+      EHOSTUNREACH,
+      zlink_gateway_send_service (gateway, service, &msg, 1, ZLINK_DONTWAIT));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zlink_gateway_send_service (other_gateway, service, &msg, 1,
+                                          ZLINK_DONTWAIT));
+    zlink_msg_close (&msg);
+
+    // Providers show up after the handle was resolved.
+    void *routers[2];
+    void *provider_1 = setup_lb_provider (ctx, "inproc://reg-router-handle",
+                                          service_name, "HPROV1", 1,
+                                          &routers[0]);
+    void *provider_2 = setup_lb_provider (ctx, "inproc://reg-router-handle",
+                                          service_name, "HPROV2", 1,
+                                          &routers[1]);
+    wait_gateway_connections (gateway, service_name, 2, 5000);
+
+    int received[2] = {0, 0};
+    for (int i = 0; i < 10; ++i) {
+        zlink_msg_init_size (&msg, 3);
+        memcpy (zlink_msg_data (&msg), "req", 3);
+        int rc = -1;
+        for (int attempt = 0; attempt < 1000 && rc != 0; ++attempt) {
+            rc = zlink_gateway_send_service (gateway, service, &msg, 1,
+                                             ZLINK_DONTWAIT);
+            if (rc != 0)
+                msleep (2);
+        }
+        TEST_ASSERT_EQUAL_INT (0, rc);
+
+        zlink_pollitem_t items[2];
+        for (int k = 0; k < 2; ++k) {
+            items[k].socket = routers[k];
+            items[k].fd = 0;
+            items[k].events = ZLINK_POLLIN;
+            items[k].revents = 0;
+        }
+        TEST_ASSERT_EQUAL_INT (1, zlink_poll (items, 2, 2000));
+        const int index = (items[0].revents & ZLINK_POLLIN) ? 0 : 1;
+        TEST_ASSERT_TRUE (recv_provider_message (routers[index]));
+        ++received[index];
+    }
+    TEST_ASSERT_EQUAL_INT (5, received[0]);
+    TEST_ASSERT_EQUAL_INT (5, received[1]);
+
+    // One provider leaves; the handle follows the refreshed pool.
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&provider_2));
+    wait_gateway_connections (gateway, service_name, 1, 5000);
+    for (int i = 0; i < 4; ++i) {
+        zlink_msg_init_size (&msg, 3);
+        memcpy (zlink_msg_data (&msg), "req", 3);
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zlink_gateway_send_service (gateway, service, &msg, 1, 0));
+        TEST_ASSERT_TRUE (recv_provider_message (routers[0]));
+    }
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_destroy (&other_gateway));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_destroy (&gateway));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&provider_1));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_discovery_destroy (&discovery));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_registry_destroy (&registry));
+}
+
+// Test: Sharded gateway spreads sending threads over its shards and
+// receives the replies of all of them
+void test_gateway_sharded ()
+{
+    void *ctx = get_test_context ();
+    const char *service_name = "sharded-svc";
+    const int shards = 4;
+    const int send_threads = 4;
+    const int send_per_thread = 25;
+
+    void *registry = NULL;
+    setup_registry (ctx, &registry, "inproc://reg-pub-sharded",
+                    "inproc://reg-router-sharded");
+    void *discovery = zlink_discovery_new_typed (ctx, ZLINK_SERVICE_TYPE_GATEWAY);
+    TEST_ASSERT_NOT_NULL (discovery);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_connect_registry (discovery, "inproc://reg-pub-sharded"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_subscribe (discovery, service_name));
+
+    TEST_ASSERT_NULL (zlink_gateway_new_sharded (ctx, discovery, NULL, 0));
+    TEST_ASSERT_EQUAL_INT (EINVAL, errno);
+
+    void *router = NULL;
+    void *provider = setup_lb_provider (ctx, "inproc://reg-router-sharded",
+                                        service_name, "SPROV", 1, &router);
+    void *gateway = zlink_gateway_new_sharded (ctx, discovery, NULL, shards);
+    TEST_ASSERT_NOT_NULL (gateway);
+    wait_gateway_connections (gateway, service_name, 1, 5000);
+
+    int timeout_ms = 2000;
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_setsockopt (
+      gateway, ZLINK_RCVTIMEO, &timeout_ms, sizeof (timeout_ms)));
+
+    // The provider echoes every request back to the shard that sent it.
+    const int total = send_threads * send_per_thread;
+    std::set<std::string> peers;
+    std::thread echo_thread ([&] () {
+        for (int n = 0; n < total;) {
+            zlink_msg_t rid;
+            zlink_msg_init (&rid);
+            if (zlink_msg_recv (&rid, router, 0) < 0) {
+                zlink_msg_close (&rid);
+                return;
+            }
+            zlink_msg_t body;
+            zlink_msg_init (&body);
+            zlink_msg_recv (&body, router, 0);
+            if (zlink_msg_size (&body) == 0) {
+                zlink_msg_close (&body);
+                zlink_msg_close (&rid);
+                continue;
+            }
+            peers.insert (std::string (
+              static_cast<const char *> (zlink_msg_data (&rid)),
+              zlink_msg_size (&rid)));
+            zlink_msg_send (&rid, router, ZLINK_SNDMORE);
+            zlink_msg_send (&body, router, 0);
+            ++n;
+        }
+    });
+
+    std::vector<std::thread> senders;
+    for (int t = 0; t < send_threads; ++t) {
+        senders.push_back (std::thread ([&] () {
+            for (int i = 0; i < send_per_thread; ++i) {
+                zlink_msg_t msg;
+                zlink_msg_init_size (&msg, 3);
+                memcpy (zlink_msg_data (&msg), "req", 3);
+                send_gateway_with_timeout (gateway, service_name, &msg, 1,
+                                           2000);
+            }
+        }));
+    }
+
+    int replies = 0;
+    for (int attempt = 0; attempt < total * 2 && replies < total;
+         ++attempt) {
+        zlink_msg_t *parts = NULL;
+        size_t part_count = 0;
+        char service_out[256];
+        if (zlink_gateway_recv (gateway, &parts, &part_count, 0, service_out)
+            != 0)
+            break;
+        if (part_count == 1 && zlink_msg_size (&parts[0]) == 3) {
+            TEST_ASSERT_EQUAL_STRING (service_name, service_out);
+            ++replies;
+        }
+        zlink_msgv_close (parts, part_count);
+    }
+
+    for (size_t t = 0; t < senders.size (); ++t)
+        senders[t].join ();
+    echo_thread.join ();
+    TEST_ASSERT_EQUAL_INT (total, replies);
+    // Each sending thread went out through a shard of its own.
+    TEST_ASSERT_EQUAL_INT (shards, static_cast<int> (peers.size ()));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_destroy (&gateway));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&provider));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_discovery_destroy (&discovery));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_registry_destroy (&registry));
+}
+
+// Echoes every request frame by frame until stop is set; probes from the
+// gateway are skipped, and so are all requests while stall is set.
+static void echo_until_stopped (void *router,
+                                const std::atomic<bool> *stop,
+                                const std::atomic<bool> *stall)
+{
+    while (!stop->load ()) {
+        zlink_msg_t parts[8];
+        size_t count = 0;
+        bool more = true;
+        while (more && count < 8) {
+            zlink_msg_init (&parts[count]);
+            if (zlink_msg_recv (&parts[count], router, 0) < 0) {
+                zlink_msg_close (&parts[count]);
+                break;
+            }
+            more = zlink_msg_more (&parts[count]) != 0;
+            ++count;
+        }
+        if (more || (count == 2 && zlink_msg_size (&parts[1]) == 0)
+            || (stall && stall->load ())) {
+            for (size_t i = 0; i < count; ++i)
+                zlink_msg_close (&parts[i]);
+            continue;
+        }
+        for (size_t i = 0; i < count; ++i)
+            zlink_msg_send (&parts[i], router,
+                            i + 1 < count ? ZLINK_SNDMORE : 0);
+    }
+}
+
+struct async_result_t
+{
+    std::atomic<int> status;
+    std::atomic<bool> done;
+    int value;
+};
+
+static void async_done (int status, zlink_msg_t *parts, size_t part_count,
+                        void *userdata)
+{
+    async_result_t *result = static_cast<async_result_t *> (userdata);
+    result->value = -1;
+    if (status == 0 && part_count == 1 && zlink_msg_size (&parts[0]) == 4)
+        memcpy (&result->value, zlink_msg_data (&parts[0]), 4);
+    result->status = status;
+    result->done = true;
+}
+
+static int request_async_int (void *gateway,
+                              const char *service_name,
+                              int value,
+                              int timeout_ms,
+                              async_result_t *result)
+{
+    zlink_msg_t msg;
+    zlink_msg_init_size (&msg, 4);
+    memcpy (zlink_msg_data (&msg), &value, 4);
+    const int rc = zlink_gateway_request_async (
+      gateway, service_name, &msg, 1, timeout_ms, async_done, result);
+    if (rc != 0)
+        zlink_msg_close (&msg);
+    return rc;
+}
+
+static bool wait_async (async_result_t *results, int count, int timeout_ms)
+{
+    for (int waited = 0; waited < timeout_ms; waited += 2) {
+        int done = 0;
+        for (int i = 0; i < count; ++i)
+            done += results[i].done ? 1 : 0;
+        if (done == count)
+            return true;
+        msleep (2);
+    }
+    return false;
+}
+
+// Test: Asynchronous requests are matched with their replies while many
+// are in flight, plain replies still reach recv, and calls that get no
+// reply time out or are cancelled when the gateway goes away
+void test_gateway_request_async ()
+{
+    void *ctx = get_test_context ();
+    const char *service_name = "async-svc";
+    const int in_flight = 500;
+
+    void *registry = NULL;
+    setup_registry (ctx, &registry, "inproc://reg-pub-async",
+                    "inproc://reg-router-async");
+    void *discovery = zlink_discovery_new_typed (ctx, ZLINK_SERVICE_TYPE_GATEWAY);
+    TEST_ASSERT_NOT_NULL (discovery);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_connect_registry (discovery, "inproc://reg-pub-async"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_subscribe (discovery, service_name));
+
+    void *router = NULL;
+    void *provider = setup_lb_provider (ctx, "inproc://reg-router-async",
+                                        service_name, "APROV", 1, &router);
+    void *gateway = zlink_gateway_new (ctx, discovery, NULL);
+    TEST_ASSERT_NOT_NULL (gateway);
+    wait_gateway_connections (gateway, service_name, 1, 5000);
+
+    async_result_t unused;
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zlink_gateway_request_async (
+                                        gateway, service_name, NULL, 0, 0,
+                                        async_done, &unused));
+    zlink_msg_t msg;
+    zlink_msg_init_size (&msg, 3);
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zlink_gateway_request_async (
+                                 gateway, service_name, &msg, 1, 0, NULL, NULL));
+    zlink_msg_close (&msg);
+
+    std::atomic<bool> stop (false);
+    const std::atomic<bool> *no_stall = NULL;
+    std::thread echo_thread (echo_until_stopped, router, &stop, no_stall);
+
+    // Every reply finds its own call, with a plain request mixed in.
+    std::vector<async_result_t> results (in_flight);
+    for (int i = 0; i < in_flight; ++i) {
+        results[i].done = false;
+        TEST_ASSERT_SUCCESS_ERRNO (request_async_int (
+          gateway, service_name, 1000 + i, 5000, &results[i]));
+        if (i == in_flight / 2) {
+            zlink_msg_init_size (&msg, 5);
+            memcpy (zlink_msg_data (&msg), "plain", 5);
+            send_gateway_with_timeout (gateway, service_name, &msg, 1, 2000);
+        }
+    }
+    TEST_ASSERT_TRUE (wait_async (&results[0], in_flight, 5000));
+    for (int i = 0; i < in_flight; ++i) {
+        TEST_ASSERT_EQUAL_INT (0, results[i].status);
+        TEST_ASSERT_EQUAL_INT (1000 + i, results[i].value);
+    }
+    int timeout_ms = 2000;
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_setsockopt (
+      gateway, ZLINK_RCVTIMEO, &timeout_ms, sizeof (timeout_ms)));
+    zlink_msg_t *parts = NULL;
+    size_t part_count = 0;
+    char service_out[256];
+    while (true) {
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zlink_gateway_recv (gateway, &parts, &part_count, 0, service_out));
+        if (part_count != 1 || zlink_msg_size (&parts[0]) != 0)
+            break;
+        // Probe from the provider that connected
+        zlink_msgv_close (parts, part_count);
+    }
+    TEST_ASSERT_EQUAL_INT (1, static_cast<int> (part_count));
+    TEST_ASSERT_EQUAL_INT (5, static_cast<int> (zlink_msg_size (&parts[0])));
+    TEST_ASSERT_EQUAL_MEMORY ("plain", zlink_msg_data (&parts[0]), 5);
+    TEST_ASSERT_EQUAL_STRING (service_name, service_out);
+    zlink_msgv_close (parts, part_count);
+
+    // Without a reply the deadline completes the call, here the one set
+    // with ZLINK_REQUEST_TIMEOUT.
+    stop = true;
+    echo_thread.join ();
+    int request_timeout = 50;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_gateway_setsockopt (gateway, ZLINK_REQUEST_TIMEOUT,
+                                &request_timeout, sizeof (request_timeout)));
+    async_result_t expired;
+    expired.done = false;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      request_async_int (gateway, service_name, 1, 0, &expired));
+    TEST_ASSERT_TRUE (wait_async (&expired, 1, 2000));
+    TEST_ASSERT_EQUAL_INT (ETIMEDOUT, expired.status);
+
+    async_result_t cancelled;
+    cancelled.done = false;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      request_async_int (gateway, service_name, 2, -1, &cancelled));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_destroy (&gateway));
+    TEST_ASSERT_TRUE (cancelled.done);
+    TEST_ASSERT_EQUAL_INT (ECANCELED, cancelled.status);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&provider));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_discovery_destroy (&discovery));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_registry_destroy (&registry));
+}
+
+static void request_async_batch (void *gateway,
+                                 const char *service_name,
+                                 int first,
+                                 int timeout_ms,
+                                 std::vector<async_result_t> *results)
+{
+    for (size_t i = 0; i < results->size (); ++i) {
+        (*results)[i].done = false;
+        TEST_ASSERT_SUCCESS_ERRNO (
+          request_async_int (gateway, service_name, first + static_cast<int> (i),
+                             timeout_ms, &(*results)[i]));
+    }
+}
+
+static void expect_async_batch (std::vector<async_result_t> *results,
+                                int first,
+                                int timeout_ms)
+{
+    TEST_ASSERT_TRUE (wait_async (&(*results)[0],
+                                  static_cast<int> (results->size ()),
+                                  timeout_ms));
+    for (size_t i = 0; i < results->size (); ++i) {
+        TEST_ASSERT_EQUAL_INT (0, (*results)[i].status);
+        TEST_ASSERT_EQUAL_INT (first + static_cast<int> (i),
+                               (*results)[i].value);
+    }
+}
+
+// Test: With a request policy set, asynchronous requests waiting on a
+// stalled provider are hedged to the other one well before their deadline,
+// and requests left on a provider that goes away are retried elsewhere
+void test_gateway_request_policy ()
+{
+    void *ctx = get_test_context ();
+    const char *service_name = "policy-svc";
+    const int batch = 20;
+
+    void *registry = NULL;
+    setup_registry (ctx, &registry, "inproc://reg-pub-policy",
+                    "inproc://reg-router-policy");
+    void *discovery = zlink_discovery_new_typed (ctx, ZLINK_SERVICE_TYPE_GATEWAY);
+    TEST_ASSERT_NOT_NULL (discovery);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_connect_registry (discovery, "inproc://reg-pub-policy"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_subscribe (discovery, service_name));
+
+    void *routers[2] = {NULL, NULL};
+    void *provider_a = setup_lb_provider (ctx, "inproc://reg-router-policy",
+                                          service_name, "PPROV1", 1,
+                                          &routers[0]);
+    void *provider_b = setup_lb_provider (ctx, "inproc://reg-router-policy",
+                                          service_name, "PPROV2", 1,
+                                          &routers[1]);
+    void *gateway = zlink_gateway_new (ctx, discovery, NULL);
+    TEST_ASSERT_NOT_NULL (gateway);
+    wait_gateway_connections (gateway, service_name, 2, 5000);
+
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zlink_gateway_set_request_policy (gateway, service_name, 101, 0));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zlink_gateway_set_request_policy (gateway, service_name, 0, -1));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_gateway_set_request_policy (gateway, service_name, 100, 2));
+
+    std::atomic<bool> stop_a (false);
+    std::atomic<bool> stop_b (false);
+    std::atomic<bool> stall_a (false);
+    std::thread echo_a (echo_until_stopped, routers[0], &stop_a, &stall_a);
+    const std::atomic<bool> *no_stall = NULL;
+    std::thread echo_b (echo_until_stopped, routers[1], &stop_b, no_stall);
+
+    // Both providers answer while the gateway learns the latency.
+    std::vector<async_result_t> warmup (40);
+    request_async_batch (gateway, service_name, 0, 5000, &warmup);
+    expect_async_batch (&warmup, 0, 5000);
+
+    // Half of these wait on the stalled provider until their hedge to
+    // the other one is answered, long before the deadline.
+    stall_a = true;
+    std::vector<async_result_t> hedged (batch);
+    request_async_batch (gateway, service_name, 100, 4000, &hedged);
+    expect_async_batch (&hedged, 100, 2000);
+
+    // Without hedging, the requests left on the provider that goes away
+    // are sent to the one that is left.
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_gateway_set_request_policy (gateway, service_name, 0, 2));
+    std::vector<async_result_t> retried (batch);
+    request_async_batch (gateway, service_name, 200, 10000, &retried);
+    stop_a = true;
+    echo_a.join ();
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&provider_a));
+    expect_async_batch (&retried, 200, 6000);
+
+    stop_b = true;
+    echo_b.join ();
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_gateway_destroy (&gateway));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&provider_b));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_discovery_destroy (&discovery));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_registry_destroy (&registry));
+}
+
 void test_gateway_concurrent_send_and_updates ()
 {
     void *ctx = get_test_context ();
@@ -1592,5 +2428,12 @@ int main (void)
     RUN_TEST (test_gateway_protocol_wss);
     RUN_TEST (test_gateway_provider_setsockopt);
     RUN_TEST (test_gateway_load_balancing);
+    RUN_TEST (test_gateway_lb_weighted);
+    RUN_TEST (test_gateway_lb_outstanding);
+    RUN_TEST (test_gateway_send_keyed);
+    RUN_TEST (test_gateway_service_handle);
+    RUN_TEST (test_gateway_sharded);
+    RUN_TEST (test_gateway_request_async);
+    RUN_TEST (test_gateway_request_policy);
     return UNITY_END ();
 }
@@ -2,11 +2,16 @@
 
 #include "../testutil_unity.hpp"
 #include "../testutil.hpp"
+#include "../../src/services/discovery/discovery_protocol.hpp"
 
 #include <errno.h>
 #include <string.h>
 #include <stdlib.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 SETUP_TEARDOWN_TESTCONTEXT
 
 // Debug logging enabled by ZLINK_TEST_DEBUG environment variable
@@ -496,6 +501,241 @@ static void test_discovery_weight_update ()
     step_log ("=== test_discovery_weight_update done ===");
 }
 
+// Test: Readers see whole provider snapshots while updates are published
+static void test_discovery_concurrent_readers ()
+{
+    step_log ("=== test_discovery_concurrent_readers ===");
+
+    void *ctx = get_test_context ();
+    void *registry = NULL;
+    setup_registry (ctx, &registry, "inproc://reg-pub-readers",
+                    "inproc://reg-router-readers");
+
+    void *discovery = zlink_discovery_new_typed (ctx, ZLINK_SERVICE_TYPE_GATEWAY);
+    TEST_ASSERT_NOT_NULL (discovery);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_connect_registry (discovery, "inproc://reg-pub-readers"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_subscribe (discovery, "readers-svc"));
+
+    void *provider = zlink_receiver_new (ctx, NULL);
+    TEST_ASSERT_NOT_NULL (provider);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_receiver_bind (provider, "tcp://127.0.0.1:*"));
+    char advertise_ep[256] = {0};
+    size_t advertise_len = sizeof (advertise_ep);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_getsockopt (zlink_receiver_router (provider), ZLINK_LAST_ENDPOINT,
+                        advertise_ep, &advertise_len));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_connect_registry (
+      provider, "inproc://reg-router-readers"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_receiver_register (provider, "readers-svc", advertise_ep, 1));
+    TEST_ASSERT_TRUE (wait_for_provider (discovery, "readers-svc", 2000));
+
+    const uint32_t last_weight = 40;
+    std::atomic<bool> stop (false);
+    std::atomic<int> bad (0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.push_back (std::thread ([&] () {
+            while (!stop.load ()) {
+                zlink_receiver_info_t info[2];
+                size_t count = 2;
+                if (zlink_discovery_get_receivers (discovery, "readers-svc",
+                                                   info, &count)
+                      != 0
+                    || count != 1 || info[0].weight < 1
+                    || info[0].weight > last_weight
+                    || strcmp (info[0].service_name, "readers-svc") != 0
+                    || zlink_discovery_receiver_count (discovery,
+                                                       "readers-svc")
+                         != 1)
+                    ++bad;
+            }
+        }));
+    }
+
+    step_log ("update weights while reading");
+    for (uint32_t weight = 2; weight <= last_weight; ++weight) {
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zlink_receiver_update_weight (provider, "readers-svc", weight));
+        msleep (5);
+    }
+
+    uint32_t seen = 0;
+    for (int i = 0; i < 80 && seen != last_weight; ++i) {
+        zlink_receiver_info_t info;
+        size_t count = 1;
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_discovery_get_receivers (
+          discovery, "readers-svc", &info, &count));
+        seen = count == 1 ? info.weight : 0;
+        if (seen != last_weight)
+            msleep (25);
+    }
+    stop.store (true);
+    for (size_t t = 0; t < readers.size (); ++t)
+        readers[t].join ();
+    TEST_ASSERT_EQUAL_INT (0, bad.load ());
+    TEST_ASSERT_EQUAL_UINT32 (last_weight, seen);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&provider));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_discovery_destroy (&discovery));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_registry_destroy (&registry));
+
+    step_log ("=== test_discovery_concurrent_readers done ===");
+}
+
+// Receive the next service list or delta published by a registry
+static void recv_service_update (void *sub_,
+                                 zlink::discovery_protocol::service_update_t
+                                   *update_)
+{
+    zlink_msg_t msg;
+    zlink_msg_init (&msg);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_recv (&msg, sub_, 0));
+    TEST_ASSERT_FALSE (zlink_msg_more (&msg));
+    TEST_ASSERT_TRUE (zlink::discovery_protocol::decode_service_update (
+      zlink_msg_data (&msg), zlink_msg_size (&msg), update_));
+    zlink_msg_close (&msg);
+}
+
+// Test: Changes are published as deltas, whole lists only on request
+static void test_discovery_registry_deltas ()
+{
+    step_log ("=== test_discovery_registry_deltas ===");
+    namespace protocol = zlink::discovery_protocol;
+
+    void *ctx = get_test_context ();
+    TEST_ASSERT_NOT_NULL (ctx);
+
+    void *registry = NULL;
+    setup_registry (ctx, &registry, "inproc://reg-pub-delta",
+                    "inproc://reg-router-delta");
+    msleep (50);
+
+    // Subscribing gets the whole list, empty so far
+    step_log ("subscribe");
+    void *sub = test_context_socket (ZLINK_SUB);
+    int timeout = 2000;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_setsockopt (sub, ZLINK_RCVTIMEO, &timeout, sizeof (timeout)));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_setsockopt (sub, ZLINK_SUBSCRIBE, "", 0));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (sub, "inproc://reg-pub-delta"));
+
+    protocol::service_update_t update;
+    recv_service_update (sub, &update);
+    TEST_ASSERT_EQUAL_UINT16 (protocol::msg_service_list, update.msg_id);
+    TEST_ASSERT_EQUAL_UINT (0, update.changes.size ());
+    uint64_t seq = update.seq;
+
+    // A discovery client applies the deltas
+    void *discovery = zlink_discovery_new_typed (ctx, ZLINK_SERVICE_TYPE_GATEWAY);
+    TEST_ASSERT_NOT_NULL (discovery);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_discovery_connect_registry (discovery, "inproc://reg-pub-delta"));
+    recv_service_update (sub, &update);
+    TEST_ASSERT_EQUAL_UINT16 (protocol::msg_service_list, update.msg_id);
+    TEST_ASSERT_EQUAL_UINT64 (seq, update.seq);
+
+    // Registering two providers publishes them only
+    step_log ("register");
+    void *providers[2];
+    char endpoints[2][256];
+    for (int i = 0; i < 2; ++i) {
+        providers[i] = zlink_receiver_new (ctx, NULL);
+        TEST_ASSERT_NOT_NULL (providers[i]);
+        char bind_ep[64];
+        snprintf (bind_ep, sizeof (bind_ep), "tcp://127.0.0.1:%d",
+                  test_port (5706 + i));
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_bind (providers[i], bind_ep));
+        size_t len = sizeof (endpoints[i]);
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zlink_getsockopt (zlink_receiver_router (providers[i]),
+                            ZLINK_LAST_ENDPOINT, endpoints[i], &len));
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_connect_registry (
+          providers[i], "inproc://reg-router-delta"));
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_register (
+          providers[i], "delta-svc", endpoints[i], 1));
+
+        recv_service_update (sub, &update);
+        TEST_ASSERT_EQUAL_UINT16 (protocol::msg_service_delta, update.msg_id);
+        TEST_ASSERT_EQUAL_UINT64 (seq, update.base_seq);
+        TEST_ASSERT_TRUE (update.seq > seq);
+        seq = update.seq;
+        TEST_ASSERT_EQUAL_UINT (1, update.changes.size ());
+        TEST_ASSERT_EQUAL_UINT8 (protocol::delta_add, update.changes[0].op);
+        TEST_ASSERT_EQUAL_STRING ("delta-svc",
+                                  update.changes[0].service_name.c_str ());
+        TEST_ASSERT_EQUAL_STRING (endpoints[i],
+                                  update.changes[0].endpoint.c_str ());
+    }
+    TEST_ASSERT_TRUE (wait_for_provider (discovery, "delta-svc", 2000));
+
+    // A weight change carries the one provider
+    step_log ("update weight");
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_receiver_update_weight (providers[1], "delta-svc", 7));
+    recv_service_update (sub, &update);
+    TEST_ASSERT_EQUAL_UINT16 (protocol::msg_service_delta, update.msg_id);
+    TEST_ASSERT_EQUAL_UINT64 (seq, update.base_seq);
+    seq = update.seq;
+    TEST_ASSERT_EQUAL_UINT (1, update.changes.size ());
+    TEST_ASSERT_EQUAL_UINT8 (protocol::delta_weight, update.changes[0].op);
+    TEST_ASSERT_EQUAL_STRING (endpoints[1],
+                              update.changes[0].endpoint.c_str ());
+    TEST_ASSERT_EQUAL_UINT32 (7, update.changes[0].weight);
+
+    // A subscriber that missed updates asks for the whole list
+    step_log ("request list");
+    protocol::request_service_list (sub);
+    recv_service_update (sub, &update);
+    TEST_ASSERT_EQUAL_UINT16 (protocol::msg_service_list, update.msg_id);
+    TEST_ASSERT_EQUAL_UINT64 (seq, update.seq);
+    TEST_ASSERT_EQUAL_UINT (2, update.changes.size ());
+
+    zlink_receiver_info_t info[4];
+    size_t count = 4;
+    for (int i = 0; i < 100; ++i) {
+        count = 4;
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zlink_discovery_get_receivers (discovery, "delta-svc", info, &count));
+        if (count == 2 && (info[0].weight == 7 || info[1].weight == 7))
+            break;
+        msleep (20);
+    }
+    TEST_ASSERT_EQUAL_UINT (2, count);
+    TEST_ASSERT_EQUAL_UINT32 (7, strcmp (info[0].endpoint, endpoints[1]) == 0
+                                   ? info[0].weight
+                                   : info[1].weight);
+
+    // Unregistering removes the provider from the client
+    step_log ("unregister");
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_receiver_unregister (providers[0], "delta-svc"));
+    recv_service_update (sub, &update);
+    TEST_ASSERT_EQUAL_UINT16 (protocol::msg_service_delta, update.msg_id);
+    TEST_ASSERT_EQUAL_UINT64 (seq, update.base_seq);
+    TEST_ASSERT_EQUAL_UINT (1, update.changes.size ());
+    TEST_ASSERT_EQUAL_UINT8 (protocol::delta_remove, update.changes[0].op);
+    for (int i = 0; i < 100
+                    && zlink_discovery_receiver_count (discovery, "delta-svc")
+                         != 1;
+         ++i)
+        msleep (20);
+    TEST_ASSERT_EQUAL_INT (1,
+                           zlink_discovery_receiver_count (discovery, "delta-svc"));
+
+    step_log ("cleanup");
+    test_context_socket_close (sub);
+    for (int i = 0; i < 2; ++i)
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_receiver_destroy (&providers[i]));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_discovery_destroy (&discovery));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_registry_destroy (&registry));
+
+    step_log ("=== test_discovery_registry_deltas done ===");
+}
+
 int main (void)
 {
     setup_test_environment ();
@@ -505,5 +745,7 @@ int main (void)
     RUN_TEST (test_discovery_service_filtering);
     RUN_TEST (test_discovery_heartbeat_timeout);
     RUN_TEST (test_discovery_weight_update);
+    RUN_TEST (test_discovery_concurrent_readers);
+    RUN_TEST (test_discovery_registry_deltas);
     return UNITY_END ();
 }
@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <thread>
 
 #if defined(_WIN32)
 #include <direct.h>
@@ -251,6 +252,260 @@ static void test_spot_peer_wss ()
     run_spot_peer_transport_test (peer_transport_wss);
 }
 
+// Receives one message and checks its topic; returns false on timeout
+static bool recv_spot_topic (void *sub_, const char *expected_topic_)
+{
+    zlink_msg_t *parts = NULL;
+    size_t count = 0;
+    char topic[256];
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        if (zlink_spot_sub_recv (sub_, &parts, &count, ZLINK_DONTWAIT, topic,
+                                 NULL)
+            == 0) {
+            TEST_ASSERT_EQUAL_STRING (expected_topic_, topic);
+            zlink_msgv_close (parts, count);
+            return true;
+        }
+        msleep (10);
+    }
+    return false;
+}
+
+static void publish_spot_topic (void *pub_, const char *topic_)
+{
+    zlink_msg_t part;
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init_size (&part, 4));
+    memcpy (zlink_msg_data (&part), "data", 4);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_pub_publish (pub_, topic_, &part, 1, 0));
+}
+
+// Exact subscribers get the key form of a remote message, pattern
+// subscribers the named form, and a subscriber with both gets it once
+static void test_spot_peer_exact_and_pattern ()
+{
+    void *ctx = zlink_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    void *node_a = zlink_spot_node_new (ctx);
+    TEST_ASSERT_NOT_NULL (node_a);
+    void *node_b = zlink_spot_node_new (ctx);
+    TEST_ASSERT_NOT_NULL (node_b);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_node_bind (node_a, "tcp://127.0.0.1:*"));
+    char endpoint_a[MAX_SOCKET_STRING] = {0};
+    size_t endpoint_len = sizeof (endpoint_a);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_getsockopt (zlink_spot_node_pub_socket (node_a), ZLINK_LAST_ENDPOINT,
+                        endpoint_a, &endpoint_len));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_node_connect_peer_pub (node_b, endpoint_a));
+
+    const char *move = "world:zone:0001:sector:0042:entity:move";
+    const char *chat = "world:zone:0001:sector:0042:entity:chat";
+    void *exact = zlink_spot_sub_new (node_b);
+    void *pattern = zlink_spot_sub_new (node_b);
+    void *both = zlink_spot_sub_new (node_b);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_subscribe (exact, move));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_spot_sub_subscribe_pattern (pattern, "world:zone:0001:*"));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_subscribe (both, move));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_spot_sub_subscribe_pattern (both, "world:zone:0001:*"));
+    msleep (200);
+
+    void *pub = zlink_spot_pub_new (node_a);
+    TEST_ASSERT_NOT_NULL (pub);
+    publish_spot_topic (pub, move);
+    publish_spot_topic (pub, chat);
+
+    TEST_ASSERT_TRUE (recv_spot_topic (exact, move));
+    TEST_ASSERT_TRUE (recv_spot_topic (pattern, move));
+    TEST_ASSERT_TRUE (recv_spot_topic (pattern, chat));
+    TEST_ASSERT_TRUE (recv_spot_topic (both, move));
+    TEST_ASSERT_TRUE (recv_spot_topic (both, chat));
+    msleep (100);
+    zlink_msg_t *parts = NULL;
+    size_t count = 0;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zlink_spot_sub_recv (exact, &parts, &count, ZLINK_DONTWAIT, NULL, NULL));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zlink_spot_sub_recv (both, &parts, &count, ZLINK_DONTWAIT, NULL, NULL));
+
+    // After the last exact subscriber leaves, the pattern still applies
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_unsubscribe (exact, move));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_unsubscribe (both, move));
+    msleep (200);
+    publish_spot_topic (pub, move);
+    TEST_ASSERT_TRUE (recv_spot_topic (pattern, move));
+    TEST_ASSERT_TRUE (recv_spot_topic (both, move));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_pub_destroy (&pub));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_destroy (&exact));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_destroy (&pattern));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_destroy (&both));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_node_destroy (&node_a));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_node_destroy (&node_b));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_term (ctx));
+}
+
+// A sub whose patterns overlap gets a local message once, and keeps
+// getting it until its last matching pattern is gone
+// Sends a key frame (0x00, the FNV-1a hash of key_topic_, then name_) and
+// one payload part from a plain PUB socket
+static void send_key_frame (void *pub_, const char *key_topic_, const char *name_)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char *c = key_topic_; *c; ++c) {
+        hash ^= static_cast<unsigned char> (*c);
+        hash *= 1099511628211ULL;
+    }
+    unsigned char frame[256];
+    frame[0] = 0;
+    for (int i = 0; i < 8; ++i)
+        frame[1 + i] = static_cast<unsigned char> (hash >> (56 - 8 * i));
+    const size_t name_size = strlen (name_);
+    memcpy (frame + 9, name_, name_size);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_send (pub_, frame, 9 + name_size, ZLINK_SNDMORE));
+    send_string_expect_success (pub_, "data", 0);
+}
+
+// A key frame is delivered only if the name it carries is the topic the
+// key resolves to, so a colliding key cannot reach the wrong subscribers
+static void test_spot_key_frame_checks_name ()
+{
+    void *ctx = zlink_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    void *node = zlink_spot_node_new (ctx);
+    TEST_ASSERT_NOT_NULL (node);
+
+    void *pub = zlink_socket (ctx, ZLINK_PUB);
+    TEST_ASSERT_NOT_NULL (pub);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_bind (pub, "tcp://127.0.0.1:*"));
+    char endpoint[MAX_SOCKET_STRING] = {0};
+    size_t endpoint_len = sizeof (endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_getsockopt (pub, ZLINK_LAST_ENDPOINT, endpoint, &endpoint_len));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_node_connect_peer_pub (node, endpoint));
+
+    const char *topic = "world:zone:0001:entity:move";
+    void *sub = zlink_spot_sub_new (node);
+    TEST_ASSERT_NOT_NULL (sub);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_subscribe (sub, topic));
+    msleep (200);
+
+    send_key_frame (pub, topic, "world:zone:0001:entity:chat");
+    send_key_frame (pub, topic, topic);
+    TEST_ASSERT_TRUE (recv_spot_topic (sub, topic));
+    msleep (100);
+    zlink_msg_t *parts = NULL;
+    size_t count = 0;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zlink_spot_sub_recv (sub, &parts, &count, ZLINK_DONTWAIT, NULL, NULL));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_destroy (&sub));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_close (pub));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_node_destroy (&node));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_term (ctx));
+}
+
+static void test_spot_overlapping_patterns ()
+{
+    void *ctx = zlink_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    void *node = zlink_spot_node_new (ctx);
+    TEST_ASSERT_NOT_NULL (node);
+
+    void *pub = NULL;
+    void *sub = NULL;
+    TEST_ASSERT_SUCCESS_ERRNO (create_spot_pub_sub (node, &pub, &sub));
+    void *other = zlink_spot_sub_new (node);
+    TEST_ASSERT_NOT_NULL (other);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_subscribe_pattern (sub, "*"));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_subscribe_pattern (sub, "zone:*"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_spot_sub_subscribe_pattern (sub, "zone:1:*"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_spot_sub_subscribe_pattern (other, "zone:2:*"));
+
+    publish_spot_topic (pub, "zone:1:move");
+    TEST_ASSERT_TRUE (recv_spot_topic (sub, "zone:1:move"));
+    zlink_msg_t *parts = NULL;
+    size_t count = 0;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zlink_spot_sub_recv (sub, &parts, &count, ZLINK_DONTWAIT, NULL, NULL));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zlink_spot_sub_recv (other, &parts, &count, ZLINK_DONTWAIT, NULL, NULL));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_unsubscribe (sub, "zone:1:*"));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_unsubscribe (sub, "*"));
+    publish_spot_topic (pub, "zone:1:move");
+    TEST_ASSERT_TRUE (recv_spot_topic (sub, "zone:1:move"));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_unsubscribe (sub, "zone:*"));
+    publish_spot_topic (pub, "zone:1:move");
+    publish_spot_topic (pub, "zone:2:move");
+    TEST_ASSERT_TRUE (recv_spot_topic (other, "zone:2:move"));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zlink_spot_sub_recv (sub, &parts, &count, ZLINK_DONTWAIT, NULL, NULL));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_destroy (&other));
+    TEST_ASSERT_SUCCESS_ERRNO (destroy_spot_pub_sub (&pub, &sub));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_node_destroy (&node));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_term (ctx));
+}
+
+// Publisher threads share one node while another thread keeps changing
+// the subscriptions; every message on the subscribed topic arrives
+static void test_spot_concurrent_publish_and_subscribe ()
+{
+    const int publishers = 4;
+    const int per_publisher = 2000;
+
+    void *ctx = zlink_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    void *node = zlink_spot_node_new (ctx);
+    TEST_ASSERT_NOT_NULL (node);
+    void *sub = zlink_spot_sub_new (node);
+    TEST_ASSERT_NOT_NULL (sub);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_subscribe (sub, "mt:hit"));
+
+    std::atomic<bool> done (false);
+    std::thread churn ([&] () {
+        void *other = zlink_spot_sub_new (node);
+        while (!done.load ()) {
+            zlink_spot_sub_subscribe (other, "mt:churn");
+            zlink_spot_sub_subscribe_pattern (other, "mt:c*");
+            zlink_spot_sub_unsubscribe (other, "mt:churn");
+            zlink_spot_sub_unsubscribe (other, "mt:c*");
+        }
+        zlink_spot_sub_destroy (&other);
+    });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < publishers; ++t)
+        threads.push_back (std::thread ([&] () {
+            void *pub = zlink_spot_pub_new (node);
+            for (int i = 0; i < per_publisher; ++i) {
+                publish_spot_topic (pub, "mt:hit");
+                publish_spot_topic (pub, "mt:miss");
+            }
+            zlink_spot_pub_destroy (&pub);
+        }));
+    for (size_t t = 0; t < threads.size (); ++t)
+        threads[t].join ();
+    done.store (true);
+    churn.join ();
+
+    for (int i = 0; i < publishers * per_publisher; ++i)
+        TEST_ASSERT_TRUE (recv_spot_topic (sub, "mt:hit"));
+    zlink_msg_t *parts = NULL;
+    size_t count = 0;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zlink_spot_sub_recv (sub, &parts, &count, ZLINK_DONTWAIT, NULL, NULL));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_sub_destroy (&sub));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_spot_node_destroy (&node));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_term (ctx));
+}
+
 static void test_spot_multi_publisher ()
 {
     void *ctx = zlink_ctx_new ();
@@ -885,6 +1140,48 @@ static bool wait_for_spot_message (void *spot_sub_,
     return false;
 }
 
+// Receives every message the zones dst_ % threads_ == index_ expect with
+// blocking recv, as a game server thread owning those zones would. Returns
+// the number of messages that were not what the zone expects.
+static int drain_zones_blocking (const std::vector<void *> &subs_,
+                                 const std::vector<int> &expected_counts_,
+                                 const std::vector<std::string> &topics_,
+                                 int field_width_,
+                                 int payload_size_,
+                                 int threads_,
+                                 int index_)
+{
+    const int zone_count = (int) subs_.size ();
+    int bad = 0;
+    for (int dst_idx = index_; dst_idx < zone_count; dst_idx += threads_) {
+        std::vector<unsigned char> seen (zone_count, 0);
+        for (int received = 0; received < expected_counts_[dst_idx];
+             ++received) {
+            zlink_msg_t *recv_parts = NULL;
+            size_t recv_count = 0;
+            char recv_topic[256];
+            if (zlink_spot_sub_recv (subs_[dst_idx], &recv_parts, &recv_count, 0,
+                                     recv_topic, NULL)
+                != 0)
+                return bad + expected_counts_[dst_idx] - received;
+            int src_idx = -1;
+            if (recv_count == 1
+                && (int) zlink_msg_size (&recv_parts[0]) == payload_size_)
+                memcpy (&src_idx, zlink_msg_data (&recv_parts[0]), sizeof (int));
+            if (src_idx < 0 || src_idx >= zone_count || seen[src_idx]
+                || !zone_is_adjacent_or_self (
+                  src_idx % field_width_, src_idx / field_width_,
+                  dst_idx % field_width_, dst_idx / field_width_)
+                || topics_[src_idx] != recv_topic)
+                ++bad;
+            else
+                seen[src_idx] = 1;
+            zlink_msgv_close (recv_parts, recv_count);
+        }
+    }
+    return bad;
+}
+
 static void test_spot_mmorpg_zone_adjacency_scale ()
 {
     if (env_int_or_default ("ZLINK_SPOT_RUN_MMORPG_SCALE", 0) == 0) {
@@ -897,6 +1194,9 @@ static void test_spot_mmorpg_zone_adjacency_scale ()
     const int field_height = env_int_or_default ("ZLINK_SPOT_FIELD_HEIGHT", 16);
     const int zone_count = field_width * field_height;
     const int inflight = env_int_or_default ("ZLINK_SPOT_INFLIGHT", zone_count);
+    //  0 drains the zones after publishing; N starts N threads that block
+    //  in recv while the zones are published.
+    const int recv_threads = env_int_or_default ("ZLINK_SPOT_RECV_THREADS", 0);
     int payload_size = env_int_or_default ("ZLINK_SPOT_PAYLOAD_SIZE", 4);
     if (payload_size < (int) sizeof (int))
         payload_size = (int) sizeof (int);
@@ -962,6 +1262,15 @@ static void test_spot_mmorpg_zone_adjacency_scale ()
       std::chrono::steady_clock::now ();
     const std::chrono::steady_clock::time_point pub_begin = phase_begin;
 
+    std::atomic<int> bad_deliveries (0);
+    std::vector<std::thread> receivers;
+    for (int t = 0; t < recv_threads; ++t)
+        receivers.push_back (std::thread ([&, t] () {
+            bad_deliveries += drain_zones_blocking (
+              spot_subs, expected_counts, topics, field_width, payload_size,
+              recv_threads, t);
+        }));
+
     for (int y = 0; y < field_height; ++y) {
         for (int x = 0; x < field_width; ++x) {
             const int src_idx = zone_idx (x, y, field_width);
@@ -981,7 +1290,11 @@ static void test_spot_mmorpg_zone_adjacency_scale ()
     const std::chrono::steady_clock::time_point pub_end =
       std::chrono::steady_clock::now ();
 
-    for (int y = 0; y < field_height; ++y) {
+    for (size_t t = 0; t < receivers.size (); ++t)
+        receivers[t].join ();
+    TEST_ASSERT_EQUAL_INT (0, bad_deliveries.load ());
+
+    for (int y = 0; y < field_height && recv_threads == 0; ++y) {
         for (int x = 0; x < field_width; ++x) {
             const int dst_idx = zone_idx (x, y, field_width);
             std::vector<unsigned char> seen (zone_count, 0);
@@ -1076,13 +1389,13 @@ static void test_spot_mmorpg_zone_adjacency_scale ()
     char metrics_line[1024];
     snprintf (
       metrics_line, sizeof (metrics_line),
-      "SPOT_SCALE_RESULT,width=%d,height=%d,zones=%d,inflight=%d,payload_bytes=%d,subscriptions=%d,"
+      "SPOT_SCALE_RESULT,width=%d,height=%d,zones=%d,inflight=%d,recv_threads=%d,payload_bytes=%d,subscriptions=%d,"
       "published=%d,expected_deliveries=%d,publish_ms=%.3f,receive_ms=%.3f,"
       "total_ms=%.3f,throughput_delivery_per_sec=%.3f,throughput_publish_per_sec=%.3f,"
       "throughput_publish_per_spot_per_sec=%.3f,throughput_delivery_per_spot_per_sec=%.3f,"
       "cpu_user_ms=%.3f,cpu_sys_ms=%.3f,cpu_total_ms=%.3f,cpu_usage_pct=%.3f,"
       "rss_begin_kb=%.3f,rss_end_kb=%.3f,rss_delta_kb=%.3f,peak_rss_kb=%.3f",
-      field_width, field_height, zone_count, inflight, payload_size,
+      field_width, field_height, zone_count, inflight, recv_threads, payload_size,
       total_expected_messages, zone_count, total_expected_messages, publish_ms,
       receive_ms, total_ms, throughput_delivery_per_sec,
       throughput_publish_per_sec, throughput_publish_per_spot_per_sec,
@@ -1308,6 +1621,10 @@ int main (int, char **)
     RUN_TEST (test_spot_peer_ws);
     RUN_TEST (test_spot_peer_tls);
     RUN_TEST (test_spot_peer_wss);
+    RUN_TEST (test_spot_peer_exact_and_pattern);
+    RUN_TEST (test_spot_key_frame_checks_name);
+    RUN_TEST (test_spot_overlapping_patterns);
+    RUN_TEST (test_spot_concurrent_publish_and_subscribe);
     RUN_TEST (test_spot_multi_publisher);
     RUN_TEST (test_spot_sub_handler_basic);
     RUN_TEST (test_spot_sub_handler_recv_conflict);
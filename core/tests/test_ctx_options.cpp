@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: MPL-2.0 */
 
 #include <limits>
+#include <string.h>
 #include "testutil.hpp"
 #include "testutil_unity.hpp"
 
@@ -241,6 +242,64 @@ void test_ctx_option_blocky ()
     test_context_socket_close (router);
 }
 
+void test_ctx_option_msg_allocator ()
+{
+    TEST_ASSERT_EQUAL_INT (
+      ZLINK_MSG_ALLOCATOR_MALLOC,
+      zlink_ctx_get (get_test_context (), ZLINK_MSG_ALLOCATOR));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zlink_ctx_set (get_test_context (), ZLINK_MSG_ALLOCATOR, 42));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_set (
+      get_test_context (), ZLINK_MSG_ALLOCATOR, ZLINK_MSG_ALLOCATOR_POOL));
+    TEST_ASSERT_EQUAL_INT (
+      ZLINK_MSG_ALLOCATOR_POOL,
+      zlink_ctx_get (get_test_context (), ZLINK_MSG_ALLOCATOR));
+
+    //  Message content is allocated by the I/O thread's decoder and released
+    //  by the application thread, so this exercises cross-thread return.
+    void *pull = test_context_socket (ZLINK_DEALER);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (pull, endpoint, sizeof endpoint);
+    void *push = test_context_socket (ZLINK_DEALER);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (push, endpoint));
+
+    char buf[4096];
+    const size_t sizes[] = {40, 300, 1500, sizeof buf};
+    for (int i = 0; i < 200; ++i) {
+        const size_t size = sizes[i % 4];
+        memset (buf, 'a' + i % 26, size);
+        TEST_ASSERT_EQUAL_INT (static_cast<int> (size),
+                               zlink_send (push, buf, size, 0));
+    }
+    for (int i = 0; i < 200; ++i) {
+        const size_t size = sizes[i % 4];
+        zlink_msg_t msg;
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init (&msg));
+        TEST_ASSERT_EQUAL_INT (static_cast<int> (size),
+                               zlink_msg_recv (&msg, pull, 0));
+        const char *data = static_cast<const char *> (zlink_msg_data (&msg));
+        TEST_ASSERT_EQUAL_INT ('a' + i % 26, data[0]);
+        TEST_ASSERT_EQUAL_INT ('a' + i % 26, data[size - 1]);
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_close (&msg));
+    }
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_set (
+      get_test_context (), ZLINK_MSG_ALLOCATOR, ZLINK_MSG_ALLOCATOR_MALLOC));
+}
+
+void test_ctx_option_io_uring ()
+{
+    TEST_ASSERT_EQUAL_INT (0, zlink_ctx_get (get_test_context (), ZLINK_IO_URING));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_ctx_set (get_test_context (), ZLINK_IO_URING, 1));
+    TEST_ASSERT_EQUAL_INT (1, zlink_ctx_get (get_test_context (), ZLINK_IO_URING));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zlink_ctx_set (get_test_context (), ZLINK_IO_URING, -1));
+}
+
 void test_ctx_option_invalid ()
 {
     TEST_ASSERT_EQUAL_INT (-1, zlink_ctx_set (get_test_context (), -1, 0));
@@ -263,6 +322,8 @@ int main (void)
     RUN_TEST (test_ctx_thread_opts);
     RUN_TEST (test_ctx_zero_copy);
     RUN_TEST (test_ctx_option_blocky);
+    RUN_TEST (test_ctx_option_msg_allocator);
+    RUN_TEST (test_ctx_option_io_uring);
     RUN_TEST (test_ctx_option_invalid);
     return UNITY_END ();
 }
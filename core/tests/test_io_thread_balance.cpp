@@ -0,0 +1,276 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <string.h>
+
+SETUP_TEARDOWN_TESTCONTEXT
+
+static const int io_threads = 2;
+
+static size_t get_stats (void *ctx_, zlink_io_thread_stats_t *stats_)
+{
+    size_t count = io_threads;
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_io_thread_stats (ctx_, stats_, &count));
+    return count;
+}
+
+static uint32_t total_sessions (void *ctx_)
+{
+    zlink_io_thread_stats_t stats[io_threads];
+    const size_t count = get_stats (ctx_, stats);
+    uint32_t sessions = 0;
+    for (size_t i = 0; i < count; ++i)
+        sessions += stats[i].sessions;
+    return sessions;
+}
+
+static uint32_t total_migrations (void *ctx_)
+{
+    zlink_io_thread_stats_t stats[io_threads];
+    const size_t count = get_stats (ctx_, stats);
+    uint32_t migrations = 0;
+    for (size_t i = 0; i < count; ++i)
+        migrations += stats[i].migrations;
+    return migrations;
+}
+
+static void test_option ()
+{
+    void *ctx = zlink_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+
+    TEST_ASSERT_EQUAL_INT (1, zlink_ctx_get (ctx, ZLINK_IO_THREAD_BALANCE));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_set (ctx, ZLINK_IO_THREAD_BALANCE, 0));
+    TEST_ASSERT_EQUAL_INT (0, zlink_ctx_get (ctx, ZLINK_IO_THREAD_BALANCE));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zlink_ctx_set (ctx, ZLINK_IO_THREAD_BALANCE, -1));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_term (ctx));
+}
+
+static void test_stats_count ()
+{
+    void *ctx = zlink_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_set (ctx, ZLINK_IO_THREADS, 3));
+
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zlink_ctx_io_thread_stats (ctx, NULL, NULL));
+
+    //  No I/O thread runs before the first socket.
+    size_t count = 99;
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_io_thread_stats (ctx, NULL, &count));
+    TEST_ASSERT_EQUAL_UINT (0, count);
+
+    void *socket = zlink_socket (ctx, ZLINK_PAIR);
+    TEST_ASSERT_NOT_NULL (socket);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_io_thread_stats (ctx, NULL, &count));
+    TEST_ASSERT_EQUAL_UINT (3, count);
+
+    zlink_io_thread_stats_t stats[3];
+    count = 2;
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_io_thread_stats (ctx, stats, &count));
+    TEST_ASSERT_EQUAL_UINT (2, count);
+    TEST_ASSERT_EQUAL_UINT (0, stats[0].sessions);
+    TEST_ASSERT_EQUAL_UINT (0, stats[0].migrations);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_close (socket));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_term (ctx));
+}
+
+struct peer_t
+{
+    char id[256];
+    int id_size;
+};
+
+//  Receives batch_ messages from each of the senders and checks that the
+//  messages of every sender arrive in order.
+static void receive_batch (void *router_,
+                           peer_t *peers_,
+                           int sender_count_,
+                           int batch_,
+                           int *next_seq_)
+{
+    for (int n = 0; n < batch_ * sender_count_; ++n) {
+        char id[256];
+        const int id_size = zlink_recv (router_, id, sizeof id, 0);
+        TEST_ASSERT_GREATER_THAN_INT (0, id_size);
+
+        char body[1024];
+        TEST_ASSERT_EQUAL_INT (static_cast<int> (sizeof body),
+                               zlink_recv (router_, body, sizeof body, 0));
+        const int sender = body[0];
+        TEST_ASSERT_TRUE (sender >= 0 && sender < sender_count_);
+        int seq;
+        memcpy (&seq, body + 1, sizeof seq);
+        TEST_ASSERT_EQUAL_INT (next_seq_[sender], seq);
+        ++next_seq_[sender];
+
+        memcpy (peers_[sender].id, id, id_size);
+        peers_[sender].id_size = id_size;
+    }
+}
+
+//  Sends a reply through the router and waits for it at the dealer.
+static void reply (void *router_, const peer_t &peer_, void *dealer_)
+{
+    TEST_ASSERT_EQUAL_INT (
+      peer_.id_size,
+      zlink_send (router_, peer_.id, peer_.id_size, ZLINK_SNDMORE));
+    send_string_expect_success (router_, "reply", 0);
+    recv_string_expect_success (dealer_, "reply", 0);
+}
+
+static void send_batch (void **senders_,
+                        int sender_count_,
+                        int batch_,
+                        int *seq_)
+{
+    char body[1024];
+    memset (body, 'x', sizeof body);
+    for (int i = 0; i < batch_; ++i)
+        for (int s = 0; s < sender_count_; ++s) {
+            body[0] = static_cast<char> (s);
+            memcpy (body + 1, &seq_[s], sizeof seq_[s]);
+            ++seq_[s];
+            TEST_ASSERT_EQUAL_INT (
+              static_cast<int> (sizeof body),
+              zlink_send (senders_[s], body, sizeof body, 0));
+        }
+}
+
+//  Four connections are spread over two I/O threads, then only the two
+//  sharing the first thread carry traffic. One of them is moved to the
+//  other thread without losing or reordering messages.
+static void test_busy_connection_moves ()
+{
+    void *ctx = zlink_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_set (ctx, ZLINK_IO_THREADS, io_threads));
+
+    void *router = zlink_socket (ctx, ZLINK_ROUTER);
+    TEST_ASSERT_NOT_NULL (router);
+    char endpoint[MAX_SOCKET_STRING];
+    test_bind (router, "tcp://127.0.0.1:*", endpoint, sizeof endpoint);
+
+    //  Connect one at a time so that every accepted connection sees the
+    //  placement of the previous ones.
+    void *dealers[4];
+    for (int i = 0; i < 4; ++i) {
+        dealers[i] = test_context_socket (ZLINK_DEALER);
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (dealers[i], endpoint));
+        while (total_sessions (ctx) < static_cast<uint32_t> (i + 1))
+            msleep (10);
+    }
+
+    zlink_io_thread_stats_t stats[io_threads];
+    TEST_ASSERT_EQUAL_UINT (io_threads, get_stats (ctx, stats));
+    TEST_ASSERT_EQUAL_UINT (2, stats[0].sessions);
+    TEST_ASSERT_EQUAL_UINT (2, stats[1].sessions);
+
+    //  Connections were placed round robin, so the first and the third
+    //  one share a thread.
+    void *busy[2] = {dealers[0], dealers[2]};
+    peer_t peers[2];
+    int sent[2] = {0, 0};
+    int received[2] = {0, 0};
+    const int batch = 100;
+
+    void *deadline = zlink_stopwatch_start ();
+    while (total_migrations (ctx) == 0) {
+        send_batch (busy, 2, batch, sent);
+        receive_batch (router, peers, 2, batch, received);
+        TEST_ASSERT_LESS_THAN_UINT (10000000, zlink_stopwatch_intermediate (
+                                                deadline));
+    }
+    zlink_stopwatch_stop (deadline);
+
+    //  Traffic keeps flowing in order after the move, both ways.
+    for (int round = 0; round < 20; ++round) {
+        send_batch (busy, 2, batch, sent);
+        receive_batch (router, peers, 2, batch, received);
+    }
+    TEST_ASSERT_EQUAL_INT (sent[0], received[0]);
+    TEST_ASSERT_EQUAL_INT (sent[1], received[1]);
+    reply (router, peers[0], busy[0]);
+    reply (router, peers[1], busy[1]);
+
+    //  Let the threads take another sample.
+    msleep (250);
+    TEST_ASSERT_EQUAL_UINT (io_threads, get_stats (ctx, stats));
+    TEST_ASSERT_EQUAL_UINT (4, stats[0].sessions + stats[1].sessions);
+    TEST_ASSERT_EQUAL_UINT (1, stats[0].migrations + stats[1].migrations);
+    TEST_ASSERT_TRUE (stats[0].sessions != stats[1].sessions);
+    for (int i = 0; i < io_threads; ++i) {
+        TEST_ASSERT_TRUE (stats[i].msgs_in > 0);
+        TEST_ASSERT_TRUE (stats[i].bytes_in > stats[i].msgs_in * 1024);
+        TEST_ASSERT_TRUE (stats[i].msgs_out > 0);
+    }
+
+    //  The other connections are unaffected.
+    send_string_expect_success (dealers[1], "hello", 0);
+    peer_t peer;
+    peer.id_size = zlink_recv (router, peer.id, sizeof peer.id, 0);
+    TEST_ASSERT_GREATER_THAN_INT (0, peer.id_size);
+    recv_string_expect_success (router, "hello", 0);
+    reply (router, peer, dealers[1]);
+
+    for (int i = 0; i < 4; ++i)
+        test_context_socket_close (dealers[i]);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_close (router));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_term (ctx));
+}
+
+//  Without balancing the connections stay where they were placed.
+static void test_balance_disabled ()
+{
+    void *ctx = zlink_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_set (ctx, ZLINK_IO_THREADS, io_threads));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_set (ctx, ZLINK_IO_THREAD_BALANCE, 0));
+
+    void *router = zlink_socket (ctx, ZLINK_ROUTER);
+    TEST_ASSERT_NOT_NULL (router);
+    char endpoint[MAX_SOCKET_STRING];
+    test_bind (router, "tcp://127.0.0.1:*", endpoint, sizeof endpoint);
+
+    void *dealers[4];
+    for (int i = 0; i < 4; ++i) {
+        dealers[i] = test_context_socket (ZLINK_DEALER);
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (dealers[i], endpoint));
+        while (total_sessions (ctx) < static_cast<uint32_t> (i + 1))
+            msleep (10);
+    }
+
+    void *busy[2] = {dealers[0], dealers[2]};
+    peer_t peers[2];
+    int sent[2] = {0, 0};
+    int received[2] = {0, 0};
+    void *watch = zlink_stopwatch_start ();
+    while (zlink_stopwatch_intermediate (watch) < 1000000) {
+        send_batch (busy, 2, 100, sent);
+        receive_batch (router, peers, 2, 100, received);
+    }
+    zlink_stopwatch_stop (watch);
+    TEST_ASSERT_EQUAL_UINT (0, total_migrations (ctx));
+
+    for (int i = 0; i < 4; ++i)
+        test_context_socket_close (dealers[i]);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_close (router));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_ctx_term (ctx));
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_option);
+    RUN_TEST (test_stats_count);
+    RUN_TEST (test_busy_connection_moves);
+    RUN_TEST (test_balance_disabled);
+    return UNITY_END ();
+}
@@ -0,0 +1,232 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+//  The option only takes effect for I/O threads started afterwards, so it
+//  is set right after the context is created. On kernels without io_uring
+//  the context silently keeps the default path and the tests still pass.
+void setUp ()
+{
+    setup_test_context ();
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_ctx_set (get_test_context (), ZLINK_IO_URING, 1));
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+static void bind_endpoint (void *socket_,
+                           const char *transport_,
+                           char *endpoint_,
+                           size_t endpoint_len_)
+{
+    if (strcmp (transport_, "tcp") == 0)
+        test_bind (socket_, "tcp://127.0.0.1:*", endpoint_, endpoint_len_);
+    else
+        test_bind (socket_, "ipc://*", endpoint_, endpoint_len_);
+}
+
+//  Small, medium and large messages in both directions; the large ones
+//  span several receive buffers and take more than one send.
+static void run_pair_mixed_sizes (const char *transport_)
+{
+    void *server = test_context_socket (ZLINK_PAIR);
+    void *client = test_context_socket (ZLINK_PAIR);
+
+    char endpoint[MAX_SOCKET_STRING];
+    bind_endpoint (server, transport_, endpoint, sizeof endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (client, endpoint));
+
+    const size_t sizes[] = {0, 5, 300, 1500, 16384, 70000, 1000000};
+    const size_t size_count = sizeof sizes / sizeof sizes[0];
+    const int count = 140;
+    void *sockets[2] = {client, server};
+    for (int dir = 0; dir < 2; ++dir) {
+        for (int i = 0; i < count; ++i) {
+            const size_t size = sizes[i % size_count];
+            zlink_msg_t msg;
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init_size (&msg, size));
+            memset (zlink_msg_data (&msg), 'a' + i % 26, size);
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_send (
+              &msg, sockets[dir], i % 3 == 0 ? ZLINK_SNDMORE : 0));
+        }
+        for (int i = 0; i < count; ++i) {
+            const size_t size = sizes[i % size_count];
+            zlink_msg_t msg;
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init (&msg));
+            TEST_ASSERT_SUCCESS_ERRNO (
+              zlink_msg_recv (&msg, sockets[1 - dir], 0));
+            TEST_ASSERT_EQUAL_UINT (size, zlink_msg_size (&msg));
+            TEST_ASSERT_EQUAL_INT (i % 3 == 0 ? 1 : 0, zlink_msg_more (&msg));
+            if (size > 0) {
+                const char *data =
+                  static_cast<const char *> (zlink_msg_data (&msg));
+                TEST_ASSERT_EQUAL_INT ('a' + i % 26, data[0]);
+                TEST_ASSERT_EQUAL_INT ('a' + i % 26, data[size / 2]);
+                TEST_ASSERT_EQUAL_INT ('a' + i % 26, data[size - 1]);
+            }
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_close (&msg));
+        }
+    }
+
+    test_context_socket_close (client);
+    test_context_socket_close (server);
+}
+
+//  Many connections on the same I/O threads share the buffer ring, and
+//  peers that go away with data still unread must not leak or stall it.
+static void run_many_connections (const char *transport_)
+{
+    void *server = test_context_socket (ZLINK_ROUTER);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_endpoint (server, transport_, endpoint, sizeof endpoint);
+
+    const int rounds = 3;
+    const int clients = 16;
+    const int per_client = 50;
+    char buf[4096];
+    memset (buf, 'x', sizeof buf);
+
+    for (int round = 0; round < rounds; ++round) {
+        void *dealers[clients];
+        for (int i = 0; i < clients; ++i) {
+            dealers[i] = test_context_socket (ZLINK_DEALER);
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (dealers[i], endpoint));
+        }
+        for (int j = 0; j < per_client; ++j)
+            for (int i = 0; i < clients; ++i)
+                TEST_ASSERT_EQUAL_INT (
+                  static_cast<int> (sizeof buf),
+                  zlink_send (dealers[i], buf, sizeof buf, 0));
+
+        for (int n = 0; n < clients * per_client; ++n) {
+            zlink_msg_t id, body;
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init (&id));
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init (&body));
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_recv (&id, server, 0));
+            TEST_ASSERT_EQUAL_INT (static_cast<int> (sizeof buf),
+                                   zlink_msg_recv (&body, server, 0));
+            //  Answer so that the dealers close with unread data.
+            TEST_ASSERT_SUCCESS_ERRNO (
+              zlink_msg_send (&id, server, ZLINK_SNDMORE));
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_send (&body, server, 0));
+        }
+
+        for (int i = 0; i < clients; ++i)
+            test_context_socket_close_zero_linger (dealers[i]);
+    }
+
+    test_context_socket_close_zero_linger (server);
+}
+
+#if !defined _WIN32
+//  With rings of two submission and eight completion entries, the
+//  submission queue runs full while the completion queue overflows: large
+//  messages keep sends in flight and make receives stop and re-arm at the
+//  stream's limit, so operations are started while the kernel holds
+//  completions. None of them may be dispatched from within that call.
+static void run_backed_up_completions (const char *transport_)
+{
+    //  Read when the I/O threads start, on the first socket.
+    setenv ("ZLINK_IO_URING_SQ_DEPTH", "2", 1);
+    void *server = test_context_socket (ZLINK_ROUTER);
+    unsetenv ("ZLINK_IO_URING_SQ_DEPTH");
+    char endpoint[MAX_SOCKET_STRING];
+    bind_endpoint (server, transport_, endpoint, sizeof endpoint);
+
+    const int clients = 16;
+    const int per_client = 20;
+    const size_t size = 256 * 1024;
+    void *dealers[clients];
+    for (int i = 0; i < clients; ++i) {
+        dealers[i] = test_context_socket (ZLINK_DEALER);
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (dealers[i], endpoint));
+    }
+    for (int j = 0; j < per_client; ++j)
+        for (int i = 0; i < clients; ++i) {
+            zlink_msg_t msg;
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init_size (&msg, size));
+            memset (zlink_msg_data (&msg), 'a' + j % 26, size);
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_send (&msg, dealers[i], 0));
+        }
+
+    //  Every request goes straight back to its dealer.
+    for (int n = 0; n < clients * per_client; ++n) {
+        zlink_msg_t id, body;
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init (&id));
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init (&body));
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_recv (&id, server, 0));
+        TEST_ASSERT_EQUAL_INT (static_cast<int> (size),
+                               zlink_msg_recv (&body, server, 0));
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_send (&id, server, ZLINK_SNDMORE));
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_send (&body, server, 0));
+    }
+    for (int i = 0; i < clients; ++i)
+        for (int j = 0; j < per_client; ++j) {
+            zlink_msg_t msg;
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init (&msg));
+            TEST_ASSERT_EQUAL_INT (static_cast<int> (size),
+                                   zlink_msg_recv (&msg, dealers[i], 0));
+            const char *data = static_cast<const char *> (zlink_msg_data (&msg));
+            TEST_ASSERT_EQUAL_INT ('a' + j % 26, data[0]);
+            TEST_ASSERT_EQUAL_INT ('a' + j % 26, data[size - 1]);
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_close (&msg));
+        }
+
+    for (int i = 0; i < clients; ++i)
+        test_context_socket_close_zero_linger (dealers[i]);
+    test_context_socket_close_zero_linger (server);
+}
+#endif
+
+void test_tcp_pair_mixed_sizes ()
+{
+    run_pair_mixed_sizes ("tcp");
+}
+
+void test_tcp_many_connections ()
+{
+    run_many_connections ("tcp");
+}
+
+#if !defined _WIN32
+void test_tcp_backed_up_completions ()
+{
+    run_backed_up_completions ("tcp");
+}
+#endif
+
+#if defined ZLINK_HAVE_IPC
+void test_ipc_pair_mixed_sizes ()
+{
+    run_pair_mixed_sizes ("ipc");
+}
+
+void test_ipc_many_connections ()
+{
+    run_many_connections ("ipc");
+}
+#endif
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_tcp_pair_mixed_sizes);
+    RUN_TEST (test_tcp_many_connections);
+#if !defined _WIN32
+    RUN_TEST (test_tcp_backed_up_completions);
+#endif
+#if defined ZLINK_HAVE_IPC
+    RUN_TEST (test_ipc_pair_mixed_sizes);
+    RUN_TEST (test_ipc_many_connections);
+#endif
+    return UNITY_END ();
+}
@@ -0,0 +1,220 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+#include <string.h>
+
+SETUP_TEARDOWN_TESTCONTEXT
+
+static const size_t batch_size = 64;
+
+static void init_batch (zlink_msg_t *msgs_, size_t count_, size_t msg_size_)
+{
+    for (size_t i = 0; i < count_; ++i) {
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init_size (&msgs_[i], msg_size_));
+        memset (zlink_msg_data (&msgs_[i]), static_cast<int> ('a' + i % 26),
+                msg_size_);
+    }
+}
+
+static void init_empty (zlink_msg_t *msgs_, size_t count_)
+{
+    for (size_t i = 0; i < count_; ++i)
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init (&msgs_[i]));
+}
+
+static void close_batch (zlink_msg_t *msgs_, size_t count_)
+{
+    for (size_t i = 0; i < count_; ++i)
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_close (&msgs_[i]));
+}
+
+//  Receives exactly 'count_' messages through zlink_recvmmsg and checks
+//  their content and MORE flags.
+static void recv_batch_expect (void *socket_,
+                               size_t count_,
+                               size_t msg_size_,
+                               bool multipart_)
+{
+    zlink_msg_t msgs[batch_size];
+    size_t received = 0;
+    while (received < count_) {
+        init_empty (msgs, batch_size);
+        const int rc = TEST_ASSERT_SUCCESS_ERRNO (
+          zlink_recvmmsg (socket_, msgs, count_ - received, 0));
+        TEST_ASSERT_GREATER_THAN_INT (0, rc);
+        for (int i = 0; i < rc; ++i, ++received) {
+            TEST_ASSERT_EQUAL_UINT (msg_size_, zlink_msg_size (&msgs[i]));
+            const char *data =
+              static_cast<const char *> (zlink_msg_data (&msgs[i]));
+            TEST_ASSERT_EQUAL_INT ('a' + received % 26, data[0]);
+            TEST_ASSERT_EQUAL_INT (
+              multipart_ && received + 1 < count_ ? 1 : 0,
+              zlink_msg_more (&msgs[i]));
+        }
+        close_batch (msgs, batch_size);
+    }
+}
+
+static void bounce_batch (void *sender_, void *receiver_, size_t msg_size_)
+{
+    zlink_msg_t msgs[batch_size];
+    init_batch (msgs, batch_size, msg_size_);
+    TEST_ASSERT_EQUAL_INT (
+      batch_size, TEST_ASSERT_SUCCESS_ERRNO (
+                    zlink_sendmmsg (sender_, msgs, batch_size, 0)));
+    //  Sent messages are released by the library.
+    for (size_t i = 0; i < batch_size; ++i)
+        TEST_ASSERT_EQUAL_UINT (0, zlink_msg_size (&msgs[i]));
+    close_batch (msgs, batch_size);
+
+    recv_batch_expect (receiver_, batch_size, msg_size_, false);
+}
+
+void test_pair_inproc_batch ()
+{
+    void *sb = test_context_socket (ZLINK_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_bind (sb, "inproc://batch"));
+    void *sc = test_context_socket (ZLINK_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (sc, "inproc://batch"));
+
+    bounce_batch (sc, sb, 8);
+    bounce_batch (sb, sc, 512);
+
+    test_context_socket_close (sc);
+    test_context_socket_close (sb);
+}
+
+void test_pair_tcp_batch ()
+{
+    void *sb = test_context_socket (ZLINK_PAIR);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (sb, endpoint, sizeof endpoint);
+    void *sc = test_context_socket (ZLINK_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (sc, endpoint));
+
+    bounce_batch (sc, sb, 16);
+    bounce_batch (sb, sc, 2048);
+
+    test_context_socket_close (sc);
+    test_context_socket_close (sb);
+}
+
+void test_multipart_batch ()
+{
+    void *sb = test_context_socket (ZLINK_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_bind (sb, "inproc://batch-multipart"));
+    void *sc = test_context_socket (ZLINK_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (sc, "inproc://batch-multipart"));
+
+    zlink_msg_t msgs[4];
+    init_batch (msgs, 4, 3);
+    TEST_ASSERT_EQUAL_INT (
+      4, TEST_ASSERT_SUCCESS_ERRNO (zlink_sendmmsg (sc, msgs, 4, ZLINK_SNDMORE)));
+    close_batch (msgs, 4);
+
+    recv_batch_expect (sb, 4, 3, true);
+
+    test_context_socket_close (sc);
+    test_context_socket_close (sb);
+}
+
+void test_dealer_router_batch ()
+{
+    void *router = test_context_socket (ZLINK_ROUTER);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_bind (router, "inproc://batch-router"));
+    void *dealer = test_context_socket (ZLINK_DEALER);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_setsockopt (dealer, ZLINK_ROUTING_ID, "D", 1));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (dealer, "inproc://batch-router"));
+
+    zlink_msg_t msgs[batch_size];
+    init_batch (msgs, batch_size, 100);
+    TEST_ASSERT_EQUAL_INT (
+      batch_size, TEST_ASSERT_SUCCESS_ERRNO (
+                    zlink_sendmmsg (dealer, msgs, batch_size, 0)));
+    close_batch (msgs, batch_size);
+
+    //  ROUTER delivers [routing id, body] per message.
+    for (size_t i = 0; i < batch_size; ++i) {
+        zlink_msg_t frames[2];
+        init_empty (frames, 2);
+        TEST_ASSERT_EQUAL_INT (
+          2, TEST_ASSERT_SUCCESS_ERRNO (zlink_recvmmsg (router, frames, 2, 0)));
+        TEST_ASSERT_EQUAL_UINT (1, zlink_msg_size (&frames[0]));
+        TEST_ASSERT_EQUAL_INT (1, zlink_msg_more (&frames[0]));
+        TEST_ASSERT_EQUAL_UINT (100, zlink_msg_size (&frames[1]));
+        TEST_ASSERT_EQUAL_INT (0, zlink_msg_more (&frames[1]));
+        close_batch (frames, 2);
+    }
+
+    //  And routes a batched multipart reply.
+    zlink_msg_t reply[2];
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init_size (&reply[0], 1));
+    memcpy (zlink_msg_data (&reply[0]), "D", 1);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init_size (&reply[1], 5));
+    memcpy (zlink_msg_data (&reply[1]), "hello", 5);
+    TEST_ASSERT_EQUAL_INT (2, TEST_ASSERT_SUCCESS_ERRNO (zlink_sendmmsg (
+                                router, reply, 2, ZLINK_SNDMORE)));
+    close_batch (reply, 2);
+    recv_string_expect_success (dealer, "hello", 0);
+
+    test_context_socket_close (dealer);
+    test_context_socket_close (router);
+}
+
+void test_dontwait_partial ()
+{
+    void *sb = test_context_socket (ZLINK_PAIR);
+    int hwm = 4;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_setsockopt (sb, ZLINK_RCVHWM, &hwm, sizeof hwm));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_bind (sb, "inproc://batch-hwm"));
+    void *sc = test_context_socket (ZLINK_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_setsockopt (sc, ZLINK_SNDHWM, &hwm, sizeof hwm));
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (sc, "inproc://batch-hwm"));
+
+    zlink_msg_t msgs[batch_size];
+    init_batch (msgs, batch_size, 1);
+    const int sent = TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_sendmmsg (sc, msgs, batch_size, ZLINK_DONTWAIT));
+    TEST_ASSERT_GREATER_THAN_INT (0, sent);
+    TEST_ASSERT_LESS_THAN_INT (static_cast<int> (batch_size), sent);
+
+    //  Unsent messages keep their content.
+    TEST_ASSERT_EQUAL_UINT (1, zlink_msg_size (&msgs[sent]));
+
+    //  The full pipe refuses a further batch outright.
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zlink_sendmmsg (sc, msgs + sent, batch_size - sent,
+                              ZLINK_DONTWAIT));
+    close_batch (msgs, batch_size);
+
+    recv_batch_expect (sb, static_cast<size_t> (sent), 1, false);
+
+    //  Nothing left: a non-blocking batch receive fails with EAGAIN.
+    zlink_msg_t empty[2];
+    init_empty (empty, 2);
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN,
+                               zlink_recvmmsg (sb, empty, 2, ZLINK_DONTWAIT));
+    close_batch (empty, 2);
+
+    test_context_socket_close (sc);
+    test_context_socket_close (sb);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_pair_inproc_batch);
+    RUN_TEST (test_pair_tcp_batch);
+    RUN_TEST (test_multipart_batch);
+    RUN_TEST (test_dealer_router_batch);
+    RUN_TEST (test_dontwait_partial);
+    return UNITY_END ();
+}
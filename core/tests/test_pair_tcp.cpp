@@ -79,6 +79,49 @@ void test_pair_tcp_connect_by_name ()
     test_context_socket_close (sb);
 }
 
+void test_pair_tcp_large_messages ()
+{
+    void *sb = test_context_socket (ZLINK_PAIR);
+    int batch_max = 512 * 1024;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_setsockopt (sb, ZLINK_IN_BATCH_MAX, &batch_max, sizeof batch_max));
+    int value = 0;
+    size_t value_size = sizeof value;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_getsockopt (sb, ZLINK_IN_BATCH_MAX, &value, &value_size));
+    TEST_ASSERT_EQUAL_INT (batch_max, value);
+
+    char my_endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (sb, my_endpoint, sizeof my_endpoint);
+    void *sc = test_context_socket (ZLINK_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (sc, my_endpoint));
+
+    //  A stream of 64KB..256KB messages lets the receive buffer grow;
+    //  small ones afterwards must still decode correctly while it shrinks.
+    const size_t sizes[] = {65536, 131072, 262144, 100, 65536};
+    const int count = 64;
+    for (size_t s = 0; s < sizeof sizes / sizeof sizes[0]; ++s) {
+        for (int i = 0; i < count; ++i) {
+            zlink_msg_t msg;
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init_size (&msg, sizes[s]));
+            memset (zlink_msg_data (&msg), 'a' + i % 26, sizes[s]);
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_send (&msg, sc, 0));
+        }
+        for (int i = 0; i < count; ++i) {
+            zlink_msg_t msg;
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init (&msg));
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_recv (&msg, sb, 0));
+            TEST_ASSERT_EQUAL_UINT (sizes[s], zlink_msg_size (&msg));
+            const char *data = static_cast<const char *> (zlink_msg_data (&msg));
+            TEST_ASSERT_EQUAL_INT ('a' + i % 26, data[0]);
+            TEST_ASSERT_EQUAL_INT ('a' + i % 26, data[sizes[s] - 1]);
+            TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_close (&msg));
+        }
+    }
+
+    test_context_socket_close (sc);
+    test_context_socket_close (sb);
+}
 
 #ifdef ZLINK_BUILD_DRAFT
 void test_pair_tcp_fastpath ()
@@ -123,6 +166,7 @@ int main ()
     UNITY_BEGIN ();
     RUN_TEST (test_pair_tcp_regular);
     RUN_TEST (test_pair_tcp_connect_by_name);
+    RUN_TEST (test_pair_tcp_large_messages);
 #ifdef ZLINK_BUILD_DRAFT
     RUN_TEST (test_pair_tcp_fastpath);
 #endif
@@ -5,6 +5,13 @@
 
 #include <cstring>
 
+#if defined ZLINK_HAVE_SHM
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/un.h>
+#endif
+
 SETUP_TEARDOWN_TESTCONTEXT
 
 static bool is_transport_available (const char *transport_)
@@ -19,7 +26,8 @@ static bool is_transport_available (const char *transport_)
         return true;
 #endif
 
-    //  WebSocket and TLS transports are optional and reported by zlink_has()
+    //  Shared memory, WebSocket and TLS transports are optional and
+    //  reported by zlink_has()
     return zlink_has (transport_) != 0;
 }
 
@@ -72,6 +80,11 @@ static void bind_endpoint (void *socket_,
         return;
     }
 
+    if (strcmp (transport_, "shm") == 0) {
+        test_bind (socket_, "shm://*", endpoint_, endpoint_len_);
+        return;
+    }
+
     if (strcmp (transport_, "ws") == 0) {
         test_bind (socket_, "ws://127.0.0.1:*", endpoint_, endpoint_len_);
         return;
@@ -121,6 +134,62 @@ static void run_pair (const char *transport_)
         cleanup_tls_test_files (tls_files);
 }
 
+//  Streams a burst of small, medium and large messages (some of them
+//  multipart) so that engines batch several of them per write.
+static void run_pair_mixed_sizes (const char *transport_)
+{
+    if (!is_transport_available (transport_))
+        TEST_IGNORE_MESSAGE ("transport not available");
+
+    void *server = test_context_socket (ZLINK_PAIR);
+    void *client = test_context_socket (ZLINK_PAIR);
+
+    tls_test_files_t tls_files;
+    if (is_tls_transport (transport_)) {
+        tls_files = make_tls_test_files ();
+        configure_tls (server, client, tls_files);
+    }
+
+    char endpoint[MAX_SOCKET_STRING];
+    bind_endpoint (server, transport_, "matrix_pair_mixed", endpoint,
+                   sizeof (endpoint));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (client, endpoint));
+    msleep (SETTLE_TIME);
+
+    const size_t sizes[] = {0, 5, 300, 1500, 4096, 16384, 70000};
+    const size_t size_count = sizeof sizes / sizeof sizes[0];
+    const int count = 210;
+    for (int i = 0; i < count; ++i) {
+        const size_t size = sizes[i % size_count];
+        zlink_msg_t msg;
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init_size (&msg, size));
+        memset (zlink_msg_data (&msg), 'a' + i % 26, size);
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zlink_msg_send (&msg, client, i % 3 == 0 ? ZLINK_SNDMORE : 0));
+    }
+    for (int i = 0; i < count; ++i) {
+        const size_t size = sizes[i % size_count];
+        zlink_msg_t msg;
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_init (&msg));
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_recv (&msg, server, 0));
+        TEST_ASSERT_EQUAL_UINT (size, zlink_msg_size (&msg));
+        TEST_ASSERT_EQUAL_INT (i % 3 == 0 ? 1 : 0, zlink_msg_more (&msg));
+        if (size > 0) {
+            const char *data =
+              static_cast<const char *> (zlink_msg_data (&msg));
+            TEST_ASSERT_EQUAL_INT ('a' + i % 26, data[0]);
+            TEST_ASSERT_EQUAL_INT ('a' + i % 26, data[size - 1]);
+        }
+        TEST_ASSERT_SUCCESS_ERRNO (zlink_msg_close (&msg));
+    }
+
+    test_context_socket_close (client);
+    test_context_socket_close (server);
+    if (is_tls_transport (transport_))
+        cleanup_tls_test_files (tls_files);
+}
+
 static void run_pubsub (const char *transport_)
 {
     if (!is_transport_available (transport_))
@@ -254,6 +323,10 @@ static void test_transport_matrix (const char *transport_)
     fprintf (stderr, "  PAIR complete\n");
     fflush (stderr);
 
+    run_pair_mixed_sizes (transport_);
+    fprintf (stderr, "  PAIR mixed sizes complete\n");
+    fflush (stderr);
+
     run_pubsub (transport_);
     fprintf (stderr, "  PUB/SUB complete\n");
     fflush (stderr);
@@ -282,6 +355,84 @@ void test_matrix_ipc ()
     test_transport_matrix ("ipc");
 }
 
+void test_matrix_shm ()
+{
+    test_transport_matrix ("shm");
+}
+
+#if defined ZLINK_HAVE_SHM
+//  A peer that hands over a segment it can still resize is refused: the
+//  listener drops the connection instead of mapping the segment.
+void test_shm_rejects_unsealed_segment ()
+{
+    void *server = test_context_socket (ZLINK_PAIR);
+    char endpoint[MAX_SOCKET_STRING];
+    test_bind (server, "shm://*", endpoint, sizeof endpoint);
+    const char *path = strstr (endpoint, "://") + 3;
+
+    const int sock = socket (AF_UNIX, SOCK_STREAM, 0);
+    TEST_ASSERT_NOT_EQUAL (-1, sock);
+    struct sockaddr_un addr;
+    memset (&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    strncpy (addr.sun_path, path, sizeof addr.sun_path - 1);
+    TEST_ASSERT_SUCCESS_RAW_ERRNO (
+      connect (sock, reinterpret_cast<struct sockaddr *> (&addr), sizeof addr));
+
+    //  Same layout as a real segment: 64-byte header, then two rings of
+    //  a 128-byte control block and 1 MB of storage, but without seals.
+    const uint64_t capacity = 1024 * 1024;
+    const int fd = memfd_create ("zlink-shm-test", MFD_CLOEXEC);
+    TEST_ASSERT_NOT_EQUAL (-1, fd);
+    TEST_ASSERT_SUCCESS_RAW_ERRNO (
+      ftruncate (fd, static_cast<off_t> (64 + 2 * (128 + capacity))));
+    struct
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t capacity;
+    } hello = {0x5a4c5348, 1, capacity};
+    void *segment = mmap (NULL, sizeof hello, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+    TEST_ASSERT_TRUE (segment != MAP_FAILED);
+    memcpy (segment, &hello, sizeof hello);
+    munmap (segment, sizeof hello);
+
+    struct iovec iov;
+    iov.iov_base = &hello;
+    iov.iov_len = sizeof hello;
+    union
+    {
+        struct cmsghdr align;
+        unsigned char buf[CMSG_SPACE (sizeof (int))];
+    } control;
+    memset (&control, 0, sizeof control);
+    struct msghdr msg;
+    memset (&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof control.buf;
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+    memcpy (CMSG_DATA (cmsg), &fd, sizeof fd);
+    TEST_ASSERT_EQUAL_INT (static_cast<int> (sizeof hello),
+                           static_cast<int> (sendmsg (sock, &msg, 0)));
+    close (fd);
+
+    //  An accepted segment would keep the connection open.
+    struct pollfd item = {sock, POLLIN, 0};
+    TEST_ASSERT_EQUAL_INT (1, poll (&item, 1, 5000));
+    char byte;
+    TEST_ASSERT_TRUE (recv (sock, &byte, 1, 0) <= 0);
+
+    close (sock);
+    test_context_socket_close (server);
+}
+#endif
+
 void test_matrix_ws ()
 {
     test_transport_matrix ("ws");
@@ -305,6 +456,10 @@ int main ()
     RUN_TEST (test_matrix_tcp);
     RUN_TEST (test_matrix_inproc);
     RUN_TEST (test_matrix_ipc);
+    RUN_TEST (test_matrix_shm);
+#if defined ZLINK_HAVE_SHM
+    RUN_TEST (test_shm_rejects_unsealed_segment);
+#endif
     RUN_TEST (test_matrix_ws);
     RUN_TEST (test_matrix_wss);
     RUN_TEST (test_matrix_tls);
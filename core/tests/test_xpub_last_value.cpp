@@ -0,0 +1,184 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <string.h>
+
+SETUP_TEARDOWN_TESTCONTEXT
+
+static void *create_xpub (int cache_size_, char *endpoint_)
+{
+    void *xpub = test_context_socket (ZLINK_XPUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_setsockopt (
+      xpub, ZLINK_XPUB_LAST_VALUE_CACHE, &cache_size_, sizeof cache_size_));
+    bind_loopback_ipv4 (xpub, endpoint_, MAX_SOCKET_STRING);
+    return xpub;
+}
+
+static void publish (void *xpub_, const char *topic_, const char *value_)
+{
+    send_string_expect_success (xpub_, topic_, ZLINK_SNDMORE);
+    send_string_expect_success (xpub_, value_, 0);
+}
+
+static void expect (void *sub_, const char *topic_, const char *value_)
+{
+    recv_string_expect_success (sub_, topic_, 0);
+    recv_string_expect_success (sub_, value_, 0);
+}
+
+//  Subscribes and lets the publisher process the subscription, which is
+//  when the snapshot is sent.
+static void subscribe (void *xpub_, void *sub_, const char *prefix_)
+{
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_setsockopt (sub_, ZLINK_SUBSCRIBE, prefix_, strlen (prefix_)));
+    char buffer[64];
+    const int rc =
+      TEST_ASSERT_SUCCESS_ERRNO (zlink_recv (xpub_, buffer, sizeof buffer, 0));
+    TEST_ASSERT_EQUAL_INT (strlen (prefix_) + 1, rc);
+    TEST_ASSERT_EQUAL_UINT8 (1, buffer[0]);
+}
+
+static void expect_nothing (void *sub_)
+{
+    char buffer[64];
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zlink_recv (sub_, buffer, sizeof buffer, ZLINK_DONTWAIT));
+}
+
+void test_option ()
+{
+    void *xpub = test_context_socket (ZLINK_XPUB);
+    int value = -1;
+    size_t size = sizeof value;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_getsockopt (xpub, ZLINK_XPUB_LAST_VALUE_CACHE, &value, &size));
+    TEST_ASSERT_EQUAL_INT (0, value);
+
+    value = 1 << 20;
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_setsockopt (
+      xpub, ZLINK_XPUB_LAST_VALUE_CACHE, &value, sizeof value));
+    value = 0;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zlink_getsockopt (xpub, ZLINK_XPUB_LAST_VALUE_CACHE, &value, &size));
+    TEST_ASSERT_EQUAL_INT (1 << 20, value);
+
+    value = -1;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zlink_setsockopt (xpub, ZLINK_XPUB_LAST_VALUE_CACHE, &value,
+                                sizeof value));
+    test_context_socket_close (xpub);
+}
+
+void test_snapshot_on_subscribe ()
+{
+    char endpoint[MAX_SOCKET_STRING];
+    void *xpub = create_xpub (1 << 20, endpoint);
+
+    publish (xpub, "A.2", "old");
+    publish (xpub, "A.1", "one");
+    publish (xpub, "B.1", "bee");
+    publish (xpub, "A.2", "two");
+
+    void *sub = test_context_socket (ZLINK_SUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (sub, endpoint));
+    subscribe (xpub, sub, "A.");
+
+    //  Latest value per matching topic, in topic order.
+    expect (sub, "A.1", "one");
+    expect (sub, "A.2", "two");
+
+    //  Live messages follow the snapshot.
+    publish (xpub, "A.3", "three");
+    publish (xpub, "B.1", "skip");
+    expect (sub, "A.3", "three");
+
+    //  A second subscription replays only its own topics.
+    subscribe (xpub, sub, "B");
+    expect (sub, "B.1", "skip");
+    msleep (SETTLE_TIME);
+    expect_nothing (sub);
+
+    test_context_socket_close (sub);
+    test_context_socket_close (xpub);
+}
+
+void test_lru_eviction ()
+{
+    //  Room for three topics of 2 + 8 bytes.
+    char endpoint[MAX_SOCKET_STRING];
+    void *xpub = create_xpub (30, endpoint);
+
+    publish (xpub, "T1", "value--1");
+    publish (xpub, "T2", "value--2");
+    publish (xpub, "T3", "value--3");
+    publish (xpub, "T1", "value-11");
+    publish (xpub, "T4", "value--4");
+
+    void *sub = test_context_socket (ZLINK_SUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (sub, endpoint));
+    subscribe (xpub, sub, "");
+
+    //  T2 was the least recently updated.
+    expect (sub, "T1", "value-11");
+    expect (sub, "T3", "value--3");
+    expect (sub, "T4", "value--4");
+    msleep (SETTLE_TIME);
+    expect_nothing (sub);
+
+    test_context_socket_close (sub);
+    test_context_socket_close (xpub);
+}
+
+void test_oversized_value_replaces_cached ()
+{
+    char endpoint[MAX_SOCKET_STRING];
+    void *xpub = create_xpub (16, endpoint);
+
+    publish (xpub, "T", "small");
+    publish (xpub, "T", "far too large to be cached");
+
+    void *sub = test_context_socket (ZLINK_SUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (sub, endpoint));
+    subscribe (xpub, sub, "T");
+
+    //  The stale value must not be replayed.
+    msleep (SETTLE_TIME);
+    expect_nothing (sub);
+
+    test_context_socket_close (sub);
+    test_context_socket_close (xpub);
+}
+
+void test_disabled_by_default ()
+{
+    void *xpub = test_context_socket (ZLINK_XPUB);
+    char endpoint[MAX_SOCKET_STRING];
+    bind_loopback_ipv4 (xpub, endpoint, sizeof endpoint);
+
+    publish (xpub, "T", "value");
+
+    void *sub = test_context_socket (ZLINK_SUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zlink_connect (sub, endpoint));
+    subscribe (xpub, sub, "T");
+    msleep (SETTLE_TIME);
+    expect_nothing (sub);
+
+    test_context_socket_close (sub);
+    test_context_socket_close (xpub);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_option);
+    RUN_TEST (test_snapshot_on_subscribe);
+    RUN_TEST (test_lru_eviction);
+    RUN_TEST (test_oversized_value_replaces_cached);
+    RUN_TEST (test_disabled_by_default);
+    return UNITY_END ();
+}
@@ -0,0 +1,142 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../tests/testutil.hpp"
+
+#include "utils/blob_map.hpp"
+#include "protocol/wire.hpp"
+
+#include <map>
+#include <string>
+#include <string.h>
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+static zlink::blob_t integral_id (uint32_t id_)
+{
+    unsigned char buf[5];
+    buf[0] = 0;
+    zlink::put_uint32 (buf + 1, id_);
+    return zlink::blob_t (buf, sizeof buf);
+}
+
+static zlink::blob_t string_id (const std::string &id_)
+{
+    return zlink::blob_t (reinterpret_cast<const unsigned char *> (id_.data ()),
+                          id_.size ());
+}
+
+void test_empty ()
+{
+    zlink::blob_map_t<int> map;
+    TEST_ASSERT_TRUE (map.empty ());
+    TEST_ASSERT_NULL (map.find (integral_id (1)));
+    TEST_ASSERT_FALSE (map.erase (integral_id (1)));
+    TEST_ASSERT_TRUE (map.begin () == map.end ());
+}
+
+void test_insert_find_erase ()
+{
+    zlink::blob_map_t<int> map;
+    TEST_ASSERT_TRUE (map.insert (integral_id (1), 10));
+    TEST_ASSERT_TRUE (map.insert (string_id ("a-long-routing-id"), 20));
+    TEST_ASSERT_TRUE (map.insert (string_id (""), 30));
+    TEST_ASSERT_EQUAL_UINT (3, map.size ());
+
+    //  Duplicates are refused and leave the value alone.
+    TEST_ASSERT_FALSE (map.insert (integral_id (1), 11));
+    TEST_ASSERT_EQUAL_INT (10, *map.find (integral_id (1)));
+    TEST_ASSERT_EQUAL_INT (20, *map.find (string_id ("a-long-routing-id")));
+    TEST_ASSERT_EQUAL_INT (30, *map.find (string_id ("")));
+
+    //  Same bytes, different length.
+    TEST_ASSERT_NULL (map.find (string_id ("a-long-routing-i")));
+    const unsigned char prefix[4] = {0, 0, 0, 0};
+    TEST_ASSERT_NULL (map.find (prefix, sizeof prefix));
+
+    TEST_ASSERT_TRUE (map.erase (integral_id (1)));
+    TEST_ASSERT_NULL (map.find (integral_id (1)));
+    TEST_ASSERT_FALSE (map.erase (integral_id (1)));
+    TEST_ASSERT_EQUAL_UINT (2, map.size ());
+}
+
+//  Randomised insert/erase checked against std::map, with both short
+//  (packed) and long keys.
+void test_against_std_map ()
+{
+    zlink::blob_map_t<int> map;
+    std::map<std::string, int> reference;
+
+    uint32_t seed = 12345;
+    for (int i = 0; i < 20000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        const uint32_t n = (seed >> 8) % 600;
+        std::string key (reinterpret_cast<const char *> (&n), sizeof n);
+        if (n % 3 == 0)
+            key += "-with-a-longer-suffix";
+
+        if ((seed >> 20) % 3 == 0) {
+            const bool erased = map.erase (string_id (key));
+            TEST_ASSERT_EQUAL (reference.erase (key) == 1, erased);
+        } else {
+            const bool inserted = map.insert (string_id (key), i);
+            TEST_ASSERT_EQUAL (
+              reference.insert (std::make_pair (key, i)).second, inserted);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT (reference.size (), map.size ());
+    for (std::map<std::string, int>::const_iterator it = reference.begin ();
+         it != reference.end (); ++it) {
+        const int *value = map.find (string_id (it->first));
+        TEST_ASSERT_NOT_NULL (value);
+        TEST_ASSERT_EQUAL_INT (it->second, *value);
+    }
+
+    //  Iteration visits every entry exactly once.
+    size_t visited = 0;
+    for (zlink::blob_map_t<int>::const_iterator it = map.begin ();
+         it != map.end (); ++it, ++visited) {
+        const std::string key (reinterpret_cast<const char *> (it->key.data ()),
+                               it->key.size ());
+        TEST_ASSERT_EQUAL_INT (reference[key], it->value);
+    }
+    TEST_ASSERT_EQUAL_UINT (reference.size (), visited);
+}
+
+void test_erase_all ()
+{
+    zlink::blob_map_t<int> map;
+    const uint32_t count = 10000;
+    for (uint32_t i = 0; i < count; ++i)
+        TEST_ASSERT_TRUE (map.insert (integral_id (i), static_cast<int> (i)));
+    for (uint32_t i = 0; i < count; i += 2)
+        TEST_ASSERT_TRUE (map.erase (integral_id (i)));
+    for (uint32_t i = 0; i < count; ++i) {
+        const int *value = map.find (integral_id (i));
+        if (i % 2)
+            TEST_ASSERT_EQUAL_INT (static_cast<int> (i), *value);
+        else
+            TEST_ASSERT_NULL (value);
+    }
+    for (uint32_t i = 1; i < count; i += 2)
+        TEST_ASSERT_TRUE (map.erase (integral_id (i)));
+    TEST_ASSERT_TRUE (map.empty ());
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_empty);
+    RUN_TEST (test_insert_find_erase);
+    RUN_TEST (test_against_std_map);
+    RUN_TEST (test_erase_all);
+    return UNITY_END ();
+}
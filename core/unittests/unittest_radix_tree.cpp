@@ -177,6 +177,40 @@ void test_check_null_entry_added ()
     TEST_ASSERT_TRUE (tree_check (tree, "all queries return true"));
 }
 
+void test_check_long_prefix ()
+{
+    zlink::radix_tree_t tree;
+
+    //  Long enough to be compared in several vector-sized chunks, with the
+    //  mismatch placed on and around the chunk boundaries.
+    const std::string key (70, 'k');
+    tree_add (tree, key);
+    TEST_ASSERT_TRUE (tree_check (tree, key));
+    TEST_ASSERT_TRUE (tree_check (tree, key + "tail"));
+    for (size_t i = 0; i < key.size (); ++i) {
+        std::string query = key;
+        query[i] = 'x';
+        TEST_ASSERT_FALSE (tree_check (tree, query));
+    }
+    TEST_ASSERT_FALSE (tree_check (tree, key.substr (0, 69)));
+}
+
+void test_check_many_edges ()
+{
+    zlink::radix_tree_t tree;
+
+    //  A node with more children than fit in one vector register.
+    for (int c = 0; c < 200; ++c)
+        tree_add (tree, std::string ("p") + static_cast<char> (c + 1) + "s");
+
+    for (int c = 0; c < 200; ++c) {
+        const std::string edge (1, static_cast<char> (c + 1));
+        TEST_ASSERT_TRUE (tree_check (tree, "p" + edge + "s"));
+        TEST_ASSERT_FALSE (tree_check (tree, "p" + edge + "t"));
+    }
+    TEST_ASSERT_FALSE (tree_check (tree, std::string ("p") + '\xff' + "s"));
+}
+
 void test_size ()
 {
     zlink::radix_tree_t tree;
@@ -264,6 +298,8 @@ int main (void)
     RUN_TEST (test_check_nonexistent_entry);
     RUN_TEST (test_check_query_longer_than_entry);
     RUN_TEST (test_check_null_entry_added);
+    RUN_TEST (test_check_long_prefix);
+    RUN_TEST (test_check_many_edges);
 
     RUN_TEST (test_size);
 
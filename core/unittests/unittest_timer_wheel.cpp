@@ -0,0 +1,238 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+
+#include "../tests/testutil.hpp"
+
+#include "core/timer_wheel.hpp"
+
+#include <vector>
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+typedef zlink::timer_wheel_t::timer_t wheel_timer_t;
+
+struct expiry_t
+{
+    int id;
+    uint64_t at;
+};
+
+static uint64_t now;
+static std::vector<expiry_t> expired;
+
+static void record (wheel_timer_t *timer_)
+{
+    const expiry_t expiry = {timer_->id, now};
+    expired.push_back (expiry);
+}
+
+static void init_timer (wheel_timer_t &timer_, int id_)
+{
+    timer_.callback = record;
+    timer_.id = id_;
+}
+
+//  Advances the wheel one millisecond at a time up to until_.
+static void run_until (zlink::timer_wheel_t &wheel_, uint64_t until_)
+{
+    while (now < until_) {
+        ++now;
+        wheel_.advance (now);
+    }
+}
+
+void test_expire_in_order ()
+{
+    now = 1000;
+    expired.clear ();
+    zlink::timer_wheel_t wheel (now);
+
+    wheel_timer_t timers[4];
+    const int timeouts[4] = {30, 10, 20, 10};
+    for (int i = 0; i < 4; ++i) {
+        init_timer (timers[i], i);
+        wheel.add (&timers[i], now + timeouts[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT (4, wheel.size ());
+    TEST_ASSERT_EQUAL_UINT64 (10, wheel.timeout (now));
+
+    run_until (wheel, 1030);
+    TEST_ASSERT_EQUAL_UINT (4, expired.size ());
+    TEST_ASSERT_EQUAL_UINT64 (1010, expired[0].at);
+    TEST_ASSERT_EQUAL_UINT64 (1010, expired[1].at);
+    TEST_ASSERT_EQUAL_INT (2, expired[2].id);
+    TEST_ASSERT_EQUAL_UINT64 (1020, expired[2].at);
+    TEST_ASSERT_EQUAL_INT (0, expired[3].id);
+    TEST_ASSERT_EQUAL_UINT64 (1030, expired[3].at);
+    TEST_ASSERT_EQUAL_UINT (0, wheel.size ());
+    TEST_ASSERT_EQUAL_UINT64 (0, wheel.timeout (now));
+    for (int i = 0; i < 4; ++i)
+        TEST_ASSERT_FALSE (timers[i].active ());
+}
+
+void test_cancel ()
+{
+    now = 0;
+    expired.clear ();
+    zlink::timer_wheel_t wheel (now);
+
+    wheel_timer_t first, second;
+    init_timer (first, 1);
+    init_timer (second, 2);
+    wheel.add (&first, 5);
+    wheel.add (&second, 5);
+    TEST_ASSERT_TRUE (first.active ());
+
+    wheel.cancel (&first);
+    TEST_ASSERT_FALSE (first.active ());
+    wheel.cancel (&first);
+    TEST_ASSERT_EQUAL_UINT (1, wheel.size ());
+
+    run_until (wheel, 10);
+    TEST_ASSERT_EQUAL_UINT (1, expired.size ());
+    TEST_ASSERT_EQUAL_INT (2, expired[0].id);
+}
+
+//  Timers far enough to sit on the upper levels expire exactly on time,
+//  also when the wheel is advanced in large steps.
+void test_upper_levels ()
+{
+    const uint64_t timeouts[] = {255,       256,      300,     65535,
+                                 65536,     70000,    1 << 24, (1 << 24) + 7,
+                                 123456789};
+    const int count = sizeof timeouts / sizeof timeouts[0];
+
+    now = 12345;
+    expired.clear ();
+    zlink::timer_wheel_t wheel (now);
+    wheel_timer_t timers[count];
+    for (int i = 0; i < count; ++i) {
+        init_timer (timers[i], i);
+        wheel.add (&timers[i], now + timeouts[i]);
+    }
+
+    //  Jump to wherever the wheel asks to be advanced next.
+    const uint64_t start = now;
+    while (wheel.size ()) {
+        const uint64_t timeout = wheel.timeout (now);
+        TEST_ASSERT_TRUE (timeout > 0);
+        now += timeout;
+        wheel.advance (now);
+    }
+
+    TEST_ASSERT_EQUAL_UINT (count, expired.size ());
+    for (int i = 0; i < count; ++i) {
+        TEST_ASSERT_EQUAL_INT (i, expired[i].id);
+        TEST_ASSERT_EQUAL_UINT64 (start + timeouts[i], expired[i].at);
+    }
+}
+
+//  Timers that are due already expire on the next advance, and a late
+//  advance expires everything that fell due meanwhile.
+void test_late_advance ()
+{
+    now = 500;
+    expired.clear ();
+    zlink::timer_wheel_t wheel (now);
+
+    wheel_timer_t timers[3];
+    init_timer (timers[0], 0);
+    init_timer (timers[1], 1);
+    init_timer (timers[2], 2);
+    wheel.add (&timers[0], 400);
+    wheel.add (&timers[1], 700);
+    wheel.add (&timers[2], 2000);
+
+    now = 501;
+    wheel.advance (now);
+    TEST_ASSERT_EQUAL_UINT (1, expired.size ());
+
+    now = 1000;
+    const uint64_t timeout = wheel.advance (now);
+    TEST_ASSERT_TRUE (timeout > 0 && timeout <= 1000);
+    TEST_ASSERT_EQUAL_UINT (2, expired.size ());
+    TEST_ASSERT_EQUAL_INT (1, expired[1].id);
+
+    now = 5000;
+    TEST_ASSERT_EQUAL_UINT64 (0, wheel.advance (now));
+    TEST_ASSERT_EQUAL_UINT (3, expired.size ());
+}
+
+static zlink::timer_wheel_t *rearm_wheel;
+static int rearms;
+
+static void rearm (wheel_timer_t *timer_)
+{
+    record (timer_);
+    if (++rearms < 5)
+        rearm_wheel->add (timer_, now + 256);
+}
+
+//  A callback may schedule its timer again, also into the slot that is
+//  being expired.
+void test_rearm_from_callback ()
+{
+    now = 0;
+    expired.clear ();
+    zlink::timer_wheel_t wheel (now);
+    rearm_wheel = &wheel;
+    rearms = 0;
+
+    wheel_timer_t timer;
+    timer.callback = rearm;
+    wheel.add (&timer, 256);
+
+    run_until (wheel, 2000);
+    TEST_ASSERT_EQUAL_UINT (5, expired.size ());
+    for (int i = 0; i < 5; ++i)
+        TEST_ASSERT_EQUAL_UINT64 (256 * (i + 1), expired[i].at);
+}
+
+static void cancel_other (wheel_timer_t *timer_)
+{
+    record (timer_);
+    rearm_wheel->cancel (static_cast<wheel_timer_t *> (timer_->arg));
+}
+
+//  A callback may cancel a timer that is due at the same time.
+void test_cancel_from_callback ()
+{
+    now = 0;
+    expired.clear ();
+    zlink::timer_wheel_t wheel (now);
+    rearm_wheel = &wheel;
+
+    //  Whichever expires first cancels the other one.
+    wheel_timer_t first, second;
+    first.callback = cancel_other;
+    first.arg = &second;
+    second.callback = cancel_other;
+    second.arg = &first;
+    wheel.add (&first, 10);
+    wheel.add (&second, 10);
+
+    run_until (wheel, 10);
+    TEST_ASSERT_EQUAL_UINT (1, expired.size ());
+    TEST_ASSERT_EQUAL_UINT (0, wheel.size ());
+    TEST_ASSERT_FALSE (first.active ());
+    TEST_ASSERT_FALSE (second.active ());
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_expire_in_order);
+    RUN_TEST (test_cancel);
+    RUN_TEST (test_upper_levels);
+    RUN_TEST (test_late_advance);
+    RUN_TEST (test_rearm_from_callback);
+    RUN_TEST (test_cancel_from_callback);
+    return UNITY_END ();
+}
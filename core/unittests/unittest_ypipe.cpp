@@ -3,9 +3,14 @@
 #include "../tests/testutil.hpp"
 
 #include <ypipe.hpp>
+#include <ypipe_mpsc.hpp>
 
 #include <unity.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 void setUp ()
 {
 }
@@ -55,6 +60,153 @@ void test_write_complete_and_flush_and_check_read_and_read ()
     TEST_ASSERT_EQUAL_INT (value, read_value);
 }
 
+typedef zlink::ypipe_mpsc_t<int, 4, 2> mpsc_pipe_t;
+
+void test_mpsc_check_read_empty ()
+{
+    mpsc_pipe_t pipe;
+    TEST_ASSERT_FALSE (pipe.check_read ());
+    int read_value = -1;
+    TEST_ASSERT_FALSE (pipe.read (&read_value));
+    TEST_ASSERT_EQUAL_INT (-1, read_value);
+}
+
+void test_mpsc_write_wakes_sleeping_reader_once ()
+{
+    mpsc_pipe_t pipe;
+
+    //  The reader is awake until it finds the pipe empty.
+    TEST_ASSERT_TRUE (pipe.write (1));
+    TEST_ASSERT_TRUE (pipe.check_read ());
+
+    int read_value = -1;
+    TEST_ASSERT_TRUE (pipe.read (&read_value));
+    TEST_ASSERT_EQUAL_INT (1, read_value);
+    TEST_ASSERT_FALSE (pipe.read (&read_value));
+
+    TEST_ASSERT_FALSE (pipe.write (2));
+    TEST_ASSERT_TRUE (pipe.write (3));
+    TEST_ASSERT_TRUE (pipe.read (&read_value));
+    TEST_ASSERT_EQUAL_INT (2, read_value);
+    TEST_ASSERT_TRUE (pipe.read (&read_value));
+    TEST_ASSERT_EQUAL_INT (3, read_value);
+}
+
+void test_mpsc_overflow_keeps_order ()
+{
+    mpsc_pipe_t pipe;
+    TEST_ASSERT_FALSE (pipe.check_read ());
+
+    //  Four items fill the ring, the rest go to the overflow queue. Only
+    //  the first write finds the reader asleep.
+    TEST_ASSERT_FALSE (pipe.write (0));
+    for (int i = 1; i < 10; ++i)
+        TEST_ASSERT_TRUE (pipe.write (i));
+
+    int read_value = -1;
+    for (int i = 0; i < 10; ++i) {
+        TEST_ASSERT_TRUE (pipe.read (&read_value));
+        TEST_ASSERT_EQUAL_INT (i, read_value);
+
+        //  Room in the ring does not let new items overtake queued ones.
+        if (i == 2)
+            TEST_ASSERT_TRUE (pipe.write (10));
+    }
+    TEST_ASSERT_TRUE (pipe.read (&read_value));
+    TEST_ASSERT_EQUAL_INT (10, read_value);
+    TEST_ASSERT_FALSE (pipe.read (&read_value));
+
+    //  Back on the ring once the overflow queue has drained.
+    TEST_ASSERT_FALSE (pipe.write (11));
+    TEST_ASSERT_TRUE (pipe.read (&read_value));
+    TEST_ASSERT_EQUAL_INT (11, read_value);
+}
+
+void test_mpsc_overflow_wakes_sleeping_reader ()
+{
+    mpsc_pipe_t pipe;
+    for (int i = 0; i < 6; ++i)
+        pipe.write (i);
+
+    //  Drain the ring only; the reader finds the rest in the overflow
+    //  queue and must not go to sleep.
+    int read_value = -1;
+    for (int i = 0; i < 6; ++i) {
+        TEST_ASSERT_TRUE (pipe.read (&read_value));
+        TEST_ASSERT_EQUAL_INT (i, read_value);
+    }
+    TEST_ASSERT_FALSE (pipe.read (&read_value));
+
+    //  Fill the ring again without the reader; the item that overflows
+    //  while the reader sleeps on the ring is not the one waking it.
+    TEST_ASSERT_FALSE (pipe.write (6));
+    for (int i = 7; i < 12; ++i)
+        TEST_ASSERT_TRUE (pipe.write (i));
+    for (int i = 6; i < 12; ++i) {
+        TEST_ASSERT_TRUE (pipe.read (&read_value));
+        TEST_ASSERT_EQUAL_INT (i, read_value);
+    }
+    TEST_ASSERT_FALSE (pipe.check_read ());
+}
+
+const int mpsc_writers = 8;
+const int mpsc_items = 100000;
+
+struct mpsc_stress_t
+{
+    mpsc_pipe_t pipe;
+    std::atomic<int> wakeups;
+};
+
+void mpsc_writer (mpsc_stress_t *stress_, int id_)
+{
+    for (int i = 0; i < mpsc_items; ++i)
+        if (!stress_->pipe.write (id_ * mpsc_items + i))
+            stress_->wakeups.fetch_add (1);
+}
+
+void test_mpsc_multiple_writers ()
+{
+    mpsc_stress_t stress;
+    stress.wakeups.store (0);
+    TEST_ASSERT_FALSE (stress.pipe.check_read ());
+    std::vector<std::thread> writers;
+    for (int id = 0; id < mpsc_writers; ++id)
+        writers.push_back (std::thread (mpsc_writer, &stress, id));
+
+    //  Reads like mailbox_t::recv: after finding the pipe empty, the reader
+    //  waits for the writer that found it asleep.
+    std::vector<int> next (mpsc_writers, 0);
+    int received = 0;
+    int waits = 0;
+    bool active = false;
+    while (received < mpsc_writers * mpsc_items) {
+        if (!active) {
+            while (stress.wakeups.load () == waits)
+                std::this_thread::yield ();
+            ++waits;
+            active = true;
+        }
+        int value;
+        if (!stress.pipe.read (&value)) {
+            active = false;
+            continue;
+        }
+        const int id = value / mpsc_items;
+        TEST_ASSERT_EQUAL_INT (next[id], value % mpsc_items);
+        ++next[id];
+        ++received;
+    }
+
+    for (size_t i = 0; i < writers.size (); ++i)
+        writers[i].join ();
+
+    //  Every wakeup was waited for, and nothing is left.
+    int value;
+    TEST_ASSERT_FALSE (stress.pipe.read (&value));
+    TEST_ASSERT_EQUAL_INT (waits, stress.wakeups.load ());
+}
+
 int main (void)
 {
     setup_test_environment ();
@@ -66,5 +218,11 @@ int main (void)
     RUN_TEST (test_write_complete_and_check_read_and_read);
     RUN_TEST (test_write_complete_and_flush_and_check_read_and_read);
 
+    RUN_TEST (test_mpsc_check_read_empty);
+    RUN_TEST (test_mpsc_write_wakes_sleeping_reader_once);
+    RUN_TEST (test_mpsc_overflow_keeps_order);
+    RUN_TEST (test_mpsc_overflow_wakes_sleeping_reader);
+    RUN_TEST (test_mpsc_multiple_writers);
+
     return UNITY_END ();
 }
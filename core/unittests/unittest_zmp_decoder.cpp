@@ -111,6 +111,39 @@ void test_more_identity_allowed ()
     TEST_ASSERT_TRUE (flags & zlink::msg_t::routing_id);
 }
 
+void test_set_buffer_size ()
+{
+    zlink::zmp_decoder_t decoder (64, -1);
+    unsigned char *buf;
+    size_t size;
+    decoder.get_buffer (&buf, &size);
+    TEST_ASSERT_EQUAL_UINT (64, size);
+
+    //  Once grown, a body that fits the buffer is decoded in place.
+    decoder.set_buffer_size (4096);
+    decoder.get_buffer (&buf, &size);
+    TEST_ASSERT_EQUAL_UINT (4096, size);
+
+    const uint32_t body_len = 1024;
+    build_header (buf, 0, body_len);
+    memset (buf + zlink::zmp_header_size, 'x', body_len);
+    size_t processed = 0;
+    const int rc =
+      decoder.decode (buf, zlink::zmp_header_size + body_len, processed);
+    TEST_ASSERT_EQUAL_INT (1, rc);
+    TEST_ASSERT_EQUAL_UINT (zlink::zmp_header_size + body_len, processed);
+    zlink::msg_t *msg = decoder.msg ();
+    TEST_ASSERT_TRUE (msg->is_zcmsg ());
+    TEST_ASSERT_EQUAL_PTR (buf + zlink::zmp_header_size, msg->data ());
+
+    //  Shrinking replaces the buffer, the decoded message keeps its data.
+    decoder.set_buffer_size (128);
+    decoder.get_buffer (&buf, &size);
+    TEST_ASSERT_EQUAL_UINT (128, size);
+    TEST_ASSERT_EQUAL_UINT (body_len, msg->size ());
+    TEST_ASSERT_EQUAL_INT ('x', static_cast<char *> (msg->data ())[body_len - 1]);
+}
+
 void test_metadata_parse_valid ()
 {
     std::vector<unsigned char> buf;
@@ -175,6 +208,7 @@ int main (void)
     RUN_TEST (test_subscribe_cancel_invalid);
     RUN_TEST (test_body_too_large);
     RUN_TEST (test_more_identity_allowed);
+    RUN_TEST (test_set_buffer_size);
     RUN_TEST (test_metadata_parse_valid);
     RUN_TEST (test_metadata_parse_invalid);
     RUN_TEST (test_metadata_add_basic_properties);